@@ -66,10 +66,12 @@
 #include "FileEntry.h"
 #include "error_code.h"
 #include "SocketRecvBuffer.h"
+#include "DNSCache.h"
 #include "ChecksumCheckIntegrityEntry.h"
 #ifdef ENABLE_ASYNC_DNS
 #include "AsyncNameResolver.h"
 #include "AsyncNameResolverMan.h"
+#include "DNSCacheRefreshCommand.h"
 #endif // ENABLE_ASYNC_DNS
 
 namespace aria2 {
@@ -95,7 +97,8 @@ AbstractCommand::AbstractCommand(
       timeout_(requestGroup->getTimeout()),
       checkSocketIsReadable_(false),
       checkSocketIsWritable_(false),
-      incNumConnection_(incNumConnection)
+      incNumConnection_(incNumConnection),
+      segmentStolen_(false)
 {
   if (socket_ && socket_->isOpen()) {
     setReadCheckSocket(socket_);
@@ -200,6 +203,15 @@ bool AbstractCommand::execute()
     if (getPieceStorage()) {
       segments_.clear();
       sm->getInFlightSegment(segments_, getCuid());
+      if (req_ && req_->getMaxRanges() > 1 && !req_->isPipeliningHint()) {
+        // Segments requested in one multiple range request are
+        // received in the order of their positions.
+        std::sort(std::begin(segments_), std::end(segments_),
+                  [](const std::shared_ptr<Segment>& lhs,
+                     const std::shared_ptr<Segment>& rhs) {
+                    return lhs->getPosition() < rhs->getPosition();
+                  });
+      }
 
       if (req_ && segments_.empty()) {
         // This command previously has assigned segments, but it is
@@ -269,6 +281,15 @@ bool AbstractCommand::execute()
           }
           segments_.push_back(segment);
         }
+        if (segments_.empty()) {
+          // No free segment is left. Take over the remaining part of
+          // the segment held by a much slower connection.
+          auto segment = sm->stealSegment(getCuid());
+          if (segment) {
+            segments_.push_back(segment);
+            segmentStolen_ = true;
+          }
+        }
         if (segments_.empty()) {
           // TODO socket could be pooled here if pipelining is
           // enabled...  Hmm, I don't think if pipelining is enabled
@@ -313,6 +334,9 @@ bool AbstractCommand::execute()
       auto ss = e_->getRequestGroupMan()->getOrCreateServerStat(
           req_->getHost(), req_->getProtocol());
       ss->setError();
+      if (auto modelSs = getModelServerStat()) {
+        modelSs->addFailure();
+      }
       // When DNS query was timeout, req_->getConnectedAddr() is
       // empty.
       if (!req_->getConnectedAddr().empty()) {
@@ -426,6 +450,14 @@ void AbstractCommand::tryReserved()
   e_->addCommand(std::move(commands));
 }
 
+void AbstractCommand::acquireMoreSegments(size_t maxSegments)
+{
+  if (segments_.size() < maxSegments) {
+    getSegmentMan()->getSegment(segments_, getCuid(), calculateMinSplitSize(),
+                                fileEntry_, maxSegments);
+  }
+}
+
 bool AbstractCommand::prepareForRetry(time_t wait)
 {
   if (getPieceStorage()) {
@@ -725,6 +757,16 @@ bool AbstractCommand::isProxyDefined() const
          !inNoProxy(req_, getOption()->get(PREF_NO_PROXY));
 }
 
+std::shared_ptr<ServerStat> AbstractCommand::getModelServerStat() const
+{
+  if (!req_ || getOption()->get(PREF_URI_SELECTOR) != V_BANDIT ||
+      isProxyRequest(req_->getProtocol(), getOption())) {
+    return nullptr;
+  }
+  return e_->getRequestGroupMan()->getOrCreateServerStat(req_->getHost(),
+                                                         req_->getProtocol());
+}
+
 std::shared_ptr<Request> AbstractCommand::createProxyRequest() const
 {
   std::shared_ptr<Request> proxyRequest;
@@ -756,15 +798,35 @@ std::string AbstractCommand::resolveHostname(std::vector<std::string>& addrs,
     return hostname;
   }
 
-  e_->findAllCachedIPAddresses(std::back_inserter(addrs), hostname, port);
+  auto& dnsCache = e_->getDNSCache();
+  dnsCache->findAll(std::back_inserter(addrs), hostname, port);
   if (!addrs.empty()) {
     auto ipaddr = addrs.front();
     A2_LOG_INFO(fmt(MSG_DNS_CACHE_HIT, getCuid(), hostname.c_str(),
                     strjoin(std::begin(addrs), std::end(addrs), ", ").c_str()));
+#ifdef ENABLE_ASYNC_DNS
+    // Refresh the entry in background before it expires, so that
+    // subsequent connections do not have to wait for name resolution.
+    if (getOption()->getAsBool(PREF_ASYNC_DNS) &&
+        dnsCache->startRefresh(hostname, port)) {
+      A2_LOG_INFO(fmt(MSG_DNS_CACHE_REFRESH, getCuid(), hostname.c_str()));
+      e_->addCommand(make_unique<DNSCacheRefreshCommand>(e_->newCUID(), e_,
+                                                         hostname, port));
+    }
+#endif // ENABLE_ASYNC_DNS
     return ipaddr;
   }
 
+  auto negative = dnsCache->findNegative(hostname, port);
+  if (negative) {
+    A2_LOG_INFO(fmt(MSG_DNS_NEGATIVE_CACHE_HIT, getCuid(), hostname.c_str()));
+    throw DL_ABORT_EX2(fmt(MSG_NAME_RESOLUTION_FAILED, getCuid(),
+                           hostname.c_str(), negative->c_str()),
+                       error_code::NAME_RESOLVE_ERROR);
+  }
+
   std::string ipaddr;
+  int ttl = 0;
 #ifdef ENABLE_ASYNC_DNS
   if (getOption()->getAsBool(PREF_ASYNC_DNS)) {
     if (!asyncNameResolverMan_->started()) {
@@ -777,6 +839,11 @@ std::string AbstractCommand::resolveHostname(std::vector<std::string>& addrs,
             ->getOrCreateServerStat(req_->getHost(), req_->getProtocol())
             ->setError();
       }
+      if (auto ss = getModelServerStat()) {
+        ss->addFailure();
+      }
+      dnsCache->putNegative(hostname, port,
+                            asyncNameResolverMan_->getLastError());
       throw DL_ABORT_EX2(fmt(MSG_NAME_RESOLUTION_FAILED, getCuid(),
                              hostname.c_str(),
                              asyncNameResolverMan_->getLastError().c_str()),
@@ -786,6 +853,7 @@ std::string AbstractCommand::resolveHostname(std::vector<std::string>& addrs,
 
     case 1:
       asyncNameResolverMan_->getResolvedAddress(addrs);
+      ttl = asyncNameResolverMan_->getResolvedTTL();
       if (addrs.empty()) {
         throw DL_ABORT_EX2(fmt(MSG_NAME_RESOLUTION_FAILED, getCuid(),
                                hostname.c_str(), "No address returned"),
@@ -802,14 +870,18 @@ std::string AbstractCommand::resolveHostname(std::vector<std::string>& addrs,
     if (e_->getOption()->getAsBool(PREF_DISABLE_IPV6)) {
       res.setFamily(AF_INET);
     }
-    res.resolve(addrs, hostname);
+    try {
+      res.resolve(addrs, hostname);
+    }
+    catch (RecoverableException& e) {
+      dnsCache->putNegative(hostname, port, e.what());
+      throw;
+    }
   }
   A2_LOG_INFO(fmt(MSG_NAME_RESOLUTION_COMPLETE, getCuid(), hostname.c_str(),
                   strjoin(std::begin(addrs), std::end(addrs), ", ").c_str()));
-  for (const auto& addr : addrs) {
-    e_->cacheIPAddress(hostname, addr, port);
-  }
-  ipaddr = e_->findCachedIPAddress(hostname, port);
+  dnsCache->update(hostname, addrs, port, std::chrono::seconds(ttl));
+  ipaddr = dnsCache->find(hostname, port);
   return ipaddr;
 }
 
@@ -844,6 +916,9 @@ bool AbstractCommand::checkIfConnectionEstablished(
           ->getOrCreateServerStat(req_->getHost(), req_->getProtocol())
           ->setError();
     }
+    if (auto ss = getModelServerStat()) {
+      ss->addFailure();
+    }
     throw DL_RETRY_EX(fmt(MSG_ESTABLISHING_CONNECTION_FAILED, error.c_str()));
   }
 
@@ -920,7 +995,7 @@ const std::shared_ptr<PieceStorage>& AbstractCommand::getPieceStorage() const
 
 void AbstractCommand::checkSocketRecvBuffer()
 {
-  if (socketRecvBuffer_->bufferEmpty() &&
+  if ((!socketRecvBuffer_ || socketRecvBuffer_->bufferEmpty()) &&
       socket_->getRecvBufferedLength() == 0) {
     return;
   }
@@ -57,6 +57,7 @@ class Segment;
 class SocketCore;
 class Option;
 class SocketRecvBuffer;
+class ServerStat;
 #ifdef ENABLE_ASYNC_DNS
 class AsyncNameResolver;
 class AsyncNameResolverMan;
@@ -89,6 +90,10 @@ private:
 
   bool incNumConnection_;
 
+  // true if segments_ was stolen from other connection in this
+  // execution.
+  bool segmentStolen_;
+
   int32_t calculateMinSplitSize() const;
 
   void useFasterRequest(const std::shared_ptr<Request>& fasterRequest);
@@ -130,6 +135,12 @@ public:
     return segments_;
   }
 
+  // Acquires more segments of the current file until this command
+  // holds |maxSegments| segments.
+  void acquireMoreSegments(size_t maxSegments);
+
+  bool isSegmentStolen() const { return segmentStolen_; }
+
   // Resolves hostname.  The resolved addresses are stored in addrs
   // and first element is returned.  If resolve is not finished,
   // return empty string. In this case, call this function with same
@@ -202,6 +213,12 @@ public:
 
   const std::shared_ptr<Option>& getOption() const;
 
+  // Returns ServerStat of the current request to which performance
+  // model samples are fed.  Returns nullptr if the model is not used
+  // (--uri-selector is not bandit), or the request goes through
+  // proxy, which makes samples meaningless for the origin server.
+  std::shared_ptr<ServerStat> getModelServerStat() const;
+
   const std::shared_ptr<DownloadContext>& getDownloadContext() const;
   const std::shared_ptr<SegmentMan>& getSegmentMan() const;
   const std::shared_ptr<PieceStorage>& getPieceStorage() const;
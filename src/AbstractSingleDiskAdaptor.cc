@@ -97,44 +97,50 @@ ssize_t AbstractSingleDiskAdaptor::readDataDropCache(unsigned char* data,
 void AbstractSingleDiskAdaptor::writeCache(const WrDiskCacheEntry* entry)
 {
   // Write cached data in 4KiB aligned offset. This reduces disk
-  // activity especially on Windows 7 NTFS. In this code, we assume
-  // that maximum length of DataCell data is 16KiB to simplify the
-  // code.
+  // activity especially on Windows 7 NTFS.  The aligned part of large
+  // DataCell is written without copy.
   unsigned char buf[16_k];
+  // The offset where buf + buffoffset is written.
   int64_t start = 0;
   size_t buflen = 0;
   size_t buffoffset = 0;
   const WrDiskCacheEntry::DataCellSet& dataSet = entry->getDataSet();
   for (auto& d : dataSet) {
-    if (start + static_cast<ssize_t>(buflen) < d->goff) {
+    if (start + static_cast<int64_t>(buflen - buffoffset) < d->goff) {
       A2_LOG_DEBUG(fmt("Cache flush goff=%" PRId64 ", len=%lu", start,
-                       static_cast<unsigned long>(buflen)));
+                       static_cast<unsigned long>(buflen - buffoffset)));
       writeData(buf + buffoffset, buflen - buffoffset, start);
       start = d->goff;
       buflen = buffoffset = 0;
     }
-    if (buflen == 0 && (d->goff & 0xfff) == 0 && (d->len & 0xfff) == 0) {
-      // Already aligned. Write it without copy.
-      A2_LOG_DEBUG(fmt("Cache flush goff=%" PRId64 ", len=%lu", start,
-                       static_cast<unsigned long>(d->len)));
-      writeData(d->data + d->offset, d->len, start);
-      start += d->len;
+    if (buflen == 0) {
+      buflen = buffoffset = d->goff & 0xfff;
     }
-    else {
-      if (buflen == 0) {
-        buflen = buffoffset = d->goff & 0xfff;
+    const unsigned char* data = d->data + d->offset;
+    size_t len = d->len;
+    while (len > 0) {
+      if (buflen == 0 && len >= 4_k) {
+        // Already aligned. Write it without copy.
+        size_t wlen = len & ~static_cast<size_t>(0xfff);
+        A2_LOG_DEBUG(fmt("Cache flush goff=%" PRId64 ", len=%lu", start,
+                         static_cast<unsigned long>(wlen)));
+        writeData(data, wlen, start);
+        start += wlen;
+        data += wlen;
+        len -= wlen;
+        continue;
       }
-      size_t wlen = std::min(sizeof(buf) - buflen, d->len);
-      memcpy(buf + buflen, d->data + d->offset, wlen);
+      size_t wlen = std::min(sizeof(buf) - buflen, len);
+      memcpy(buf + buflen, data, wlen);
       buflen += wlen;
+      data += wlen;
+      len -= wlen;
       if (buflen == sizeof(buf)) {
         A2_LOG_DEBUG(fmt("Cache flush goff=%" PRId64 ", len=%lu", start,
-                         static_cast<unsigned long>(buflen)));
+                         static_cast<unsigned long>(buflen - buffoffset)));
         writeData(buf + buffoffset, buflen - buffoffset, start);
-        memcpy(buf, d->data + d->offset + wlen, d->len - wlen);
-        start += sizeof(buf) - buffoffset;
-        buflen = d->len - wlen;
-        buffoffset = 0;
+        start += buflen - buffoffset;
+        buflen = buffoffset = 0;
       }
     }
   }
@@ -0,0 +1,184 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2015 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "AdaptiveConnectionControl.h"
+
+#include <algorithm>
+
+#include "ServerStatMan.h"
+#include "ServerStat.h"
+#include "Logger.h"
+#include "LogFactory.h"
+#include "fmt.h"
+
+namespace aria2 {
+
+namespace {
+// The number of connections for a server without history.
+constexpr int INITIAL_LEVEL = 2;
+// The time to wait after changing level so that new connections get
+// up to speed.
+constexpr auto SETTLE_TIME = 3_s;
+// The time to hold level before probing again.
+constexpr auto PROBE_INTERVAL = 30_s;
+// Adding a connection must raise aggregate speed by this ratio to be
+// accepted.
+constexpr double MIN_GAIN = 0.1;
+// If speed of each connection falls below this ratio of the base
+// without gain in aggregate speed, the server is throttling.
+constexpr double PER_CONNECTION_DROP = 0.5;
+} // namespace
+
+AdaptiveConnectionControl::AdaptiveConnectionControl(
+    int maxLevel, const std::shared_ptr<ServerStatMan>& serverStatMan)
+    : maxLevel_(std::max(1, maxLevel)), serverStatMan_(serverStatMan)
+{
+}
+
+AdaptiveConnectionControl::~AdaptiveConnectionControl() {}
+
+AdaptiveConnectionControl::HostState&
+AdaptiveConnectionControl::getState(const std::string& host,
+                                    const std::string& protocol)
+{
+  auto i = states_.find(host);
+  if (i != std::end(states_)) {
+    return (*i).second;
+  }
+  auto ss = serverStatMan_->find(host, protocol);
+  if (!ss) {
+    ss = std::make_shared<ServerStat>(host, protocol);
+    serverStatMan_->add(ss);
+  }
+  int level = ss->getConnectionLevel();
+  if (level == 0) {
+    level = INITIAL_LEVEL;
+  }
+  level = std::min(level, maxLevel_);
+  A2_LOG_DEBUG(fmt("Adaptive connection: %s starts with %d connections",
+                   host.c_str(), level));
+  return states_[host] = HostState{ss, level, 0, 0, true, Timer::zero()};
+}
+
+int AdaptiveConnectionControl::getLevel(const std::string& host,
+                                        const std::string& protocol)
+{
+  return getState(host, protocol).level;
+}
+
+void AdaptiveConnectionControl::setLevel(const std::string& host,
+                                         HostState& st, int level,
+                                         const Timer& now)
+{
+  if (st.level != level) {
+    A2_LOG_INFO(fmt("Adaptive connection: %s: %d -> %d connections",
+                    host.c_str(), st.level, level));
+  }
+  st.level = level;
+  st.lastChange = now;
+  st.serverStat->setConnectionLevel(level);
+}
+
+void AdaptiveConnectionControl::decrease(const std::string& host,
+                                         HostState& st, const Timer& now)
+{
+  st.baseSpeed = 0;
+  st.basePerConnectionSpeed = 0;
+  st.probing = false;
+  setLevel(host, st, std::max(1, st.level / 2), now);
+}
+
+bool AdaptiveConnectionControl::update(const std::string& host,
+                                       const std::string& protocol, int speed,
+                                       int numConnections, const Timer& now)
+{
+  auto& st = getState(host, protocol);
+  if (numConnections == 0 || st.lastChange.difference(now) < SETTLE_TIME) {
+    return false;
+  }
+  int perConnectionSpeed = speed / numConnections;
+  if (st.basePerConnectionSpeed > 0 && speed < st.baseSpeed &&
+      perConnectionSpeed < st.basePerConnectionSpeed * PER_CONNECTION_DROP) {
+    A2_LOG_INFO(fmt("Adaptive connection: %s: speed per connection dropped"
+                    " from %d to %d",
+                    host.c_str(), st.basePerConnectionSpeed,
+                    perConnectionSpeed));
+    decrease(host, st, now);
+    return false;
+  }
+  if (numConnections < st.level) {
+    // We cannot judge the level unless all allowed connections are
+    // active.
+    return false;
+  }
+  if (!st.probing) {
+    if (st.lastChange.difference(now) < PROBE_INTERVAL) {
+      return false;
+    }
+    st.probing = true;
+    st.baseSpeed = 0;
+  }
+  if (st.baseSpeed == 0 || speed >= st.baseSpeed * (1 + MIN_GAIN)) {
+    st.baseSpeed = speed;
+    st.basePerConnectionSpeed = perConnectionSpeed;
+    if (st.level < maxLevel_) {
+      setLevel(host, st, st.level + 1, now);
+      return true;
+    }
+    st.probing = false;
+    st.lastChange = now;
+    return false;
+  }
+  // The last added connection did not increase speed.  Take it back.
+  st.probing = false;
+  setLevel(host, st, std::max(1, st.level - 1), now);
+  return false;
+}
+
+void AdaptiveConnectionControl::onOverload(const std::string& host,
+                                           const std::string& protocol,
+                                           const Timer& now)
+{
+  auto& st = getState(host, protocol);
+  // Many connections may get the same response at once.  Halve the
+  // level only once for them.
+  if (!st.probing && st.baseSpeed == 0 &&
+      st.lastChange.difference(now) < SETTLE_TIME) {
+    return;
+  }
+  A2_LOG_INFO(fmt("Adaptive connection: %s is overloaded", host.c_str()));
+  decrease(host, st, now);
+}
+
+} // namespace aria2
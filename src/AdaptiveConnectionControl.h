@@ -0,0 +1,113 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2015 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_ADAPTIVE_CONNECTION_CONTROL_H
+#define D_ADAPTIVE_CONNECTION_CONTROL_H
+
+#include "common.h"
+
+#include <string>
+#include <map>
+#include <memory>
+
+#include "TimerA2.h"
+
+namespace aria2 {
+
+class ServerStat;
+class ServerStatMan;
+
+// Adjusts the number of connections to each server for a download in
+// additive increase, multiplicative decrease manner.  While all
+// allowed connections to a server are active and the aggregate
+// download speed from it keeps rising, one connection is added at a
+// time.  When the last added connection does not increase the speed,
+// it is taken back and the level is held for a while before probing
+// again.  When the server signals overload, or the speed of each
+// connection drops sharply without any gain in aggregate speed, the
+// level is halved.  The level is stored in ServerStat so that later
+// downloads start from it.
+class AdaptiveConnectionControl {
+private:
+  struct HostState {
+    std::shared_ptr<ServerStat> serverStat;
+    int level;
+    // Aggregate and per connection download speed measured at the
+    // last accepted level.  0 means not measured yet.
+    int baseSpeed;
+    int basePerConnectionSpeed;
+    // true if we are raising level.
+    bool probing;
+    Timer lastChange;
+  };
+
+  int maxLevel_;
+
+  std::shared_ptr<ServerStatMan> serverStatMan_;
+
+  std::map<std::string, HostState> states_;
+
+  HostState& getState(const std::string& host, const std::string& protocol);
+
+  void setLevel(const std::string& host, HostState& st, int level,
+                const Timer& now);
+
+  void decrease(const std::string& host, HostState& st, const Timer& now);
+
+public:
+  AdaptiveConnectionControl(int maxLevel,
+                            const std::shared_ptr<ServerStatMan>& serverStatMan);
+
+  ~AdaptiveConnectionControl();
+
+  // Returns the number of connections allowed to host.
+  int getLevel(const std::string& host, const std::string& protocol);
+
+  // Feeds the aggregate download speed from host and the number of
+  // active connections to it.  Returns true if the level is raised,
+  // which means caller should create another connection.
+  bool update(const std::string& host, const std::string& protocol,
+              int speed, int numConnections, const Timer& now);
+
+  // Called when host responded with the status which tells it is
+  // overloaded, such as HTTP 429 and 503.
+  void onOverload(const std::string& host, const std::string& protocol,
+                  const Timer& now);
+
+  int getMaxLevel() const { return maxLevel_; }
+};
+
+} // namespace aria2
+
+#endif // D_ADAPTIVE_CONNECTION_CONTROL_H
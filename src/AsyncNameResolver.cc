@@ -35,6 +35,7 @@
 #include "AsyncNameResolver.h"
 
 #include <cstring>
+#include <algorithm>
 
 #include "A2STR.h"
 #include "LogFactory.h"
@@ -66,13 +67,63 @@ void callback(void* arg, int status, int timeouts, struct hostent* host)
   }
 }
 
+#ifdef HAVE_ARES_GETADDRINFO
+
+void addrinfoCallback(void* arg, int status, int timeouts,
+                      struct ares_addrinfo* res)
+{
+  AsyncNameResolver* resolverPtr = reinterpret_cast<AsyncNameResolver*>(arg);
+  if (status != ARES_SUCCESS) {
+    resolverPtr->error_ = ares_strerror(status);
+    resolverPtr->status_ = AsyncNameResolver::STATUS_ERROR;
+    return;
+  }
+  int ttl = -1;
+  for (auto node = res->nodes; node; node = node->ai_next) {
+    const void* src;
+    if (node->ai_family == AF_INET) {
+      src = &reinterpret_cast<sockaddr_in*>(node->ai_addr)->sin_addr;
+    }
+    else if (node->ai_family == AF_INET6) {
+      src = &reinterpret_cast<sockaddr_in6*>(node->ai_addr)->sin6_addr;
+    }
+    else {
+      continue;
+    }
+    char addrstring[NI_MAXHOST];
+    if (inetNtop(node->ai_family, src, addrstring, sizeof(addrstring)) == 0) {
+      resolverPtr->resolvedAddresses_.push_back(addrstring);
+      if (ttl == -1 || node->ai_ttl < ttl) {
+        ttl = node->ai_ttl;
+      }
+    }
+  }
+  // CNAME chain can have shorter TTL than the addresses.
+  for (auto cname = res->cnames; cname; cname = cname->next) {
+    if (ttl != -1 && cname->ttl < ttl) {
+      ttl = cname->ttl;
+    }
+  }
+  ares_freeaddrinfo(res);
+  if (resolverPtr->resolvedAddresses_.empty()) {
+    resolverPtr->error_ = "no address returned or address conversion failed";
+    resolverPtr->status_ = AsyncNameResolver::STATUS_ERROR;
+  }
+  else {
+    resolverPtr->ttl_ = std::max(0, ttl);
+    resolverPtr->status_ = AsyncNameResolver::STATUS_SUCCESS;
+  }
+}
+
+#endif // HAVE_ARES_GETADDRINFO
+
 AsyncNameResolver::AsyncNameResolver(int family
 #ifdef HAVE_ARES_ADDR_NODE
                                      ,
                                      ares_addr_node* servers
 #endif // HAVE_ARES_ADDR_NODE
                                      )
-    : status_(STATUS_READY), family_(family)
+    : status_(STATUS_READY), family_(family), ttl_(0)
 {
   // TODO evaluate return value
   ares_init(&channel_);
@@ -92,7 +143,17 @@ void AsyncNameResolver::resolve(const std::string& name)
 {
   hostname_ = name;
   status_ = STATUS_QUERYING;
+#ifdef HAVE_ARES_GETADDRINFO
+  // ares_getaddrinfo() tells us TTL of the records, which
+  // ares_gethostbyname() does not.
+  ares_addrinfo_hints hints;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = family_;
+  ares_getaddrinfo(channel_, name.c_str(), nullptr, &hints, addrinfoCallback,
+                   this);
+#else  // !HAVE_ARES_GETADDRINFO
   ares_gethostbyname(channel_, name.c_str(), family_, callback, this);
+#endif // !HAVE_ARES_GETADDRINFO
 }
 
 int AsyncNameResolver::getFds(fd_set* rfdsPtr, fd_set* wfdsPtr) const
@@ -129,6 +190,7 @@ void AsyncNameResolver::reset()
 {
   hostname_ = A2STR::NIL;
   resolvedAddresses_.clear();
+  ttl_ = 0;
   status_ = STATUS_READY;
   ares_destroy(channel_);
   // TODO evaluate return value
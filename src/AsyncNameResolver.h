@@ -49,6 +49,10 @@ namespace aria2 {
 class AsyncNameResolver {
   friend void callback(void* arg, int status, int timeouts,
                        struct hostent* host);
+#ifdef HAVE_ARES_GETADDRINFO
+  friend void addrinfoCallback(void* arg, int status, int timeouts,
+                               struct ares_addrinfo* res);
+#endif // HAVE_ARES_GETADDRINFO
 
 public:
   enum STATUS {
@@ -64,6 +68,9 @@ private:
   ares_channel channel_;
 
   std::vector<std::string> resolvedAddresses_;
+  // The minimum TTL of resolved addresses in seconds.  0 if DNS
+  // server did not tell us.
+  int ttl_;
   std::string error_;
   std::string hostname_;
 
@@ -84,6 +91,8 @@ public:
     return resolvedAddresses_;
   }
 
+  int getTTL() const { return ttl_; }
+
   const std::string& getError() const { return error_; }
 
   STATUS getStatus() const { return status_; }
@@ -111,6 +111,21 @@ void AsyncNameResolverMan::getResolvedAddress(
   return;
 }
 
+int AsyncNameResolverMan::getResolvedTTL() const
+{
+  int ttl = 0;
+  for (size_t i = 0; i < numResolver_; ++i) {
+    if (asyncNameResolver_[i]->getStatus() ==
+        AsyncNameResolver::STATUS_SUCCESS) {
+      auto t = asyncNameResolver_[i]->getTTL();
+      if (t > 0 && (ttl == 0 || t < ttl)) {
+        ttl = t;
+      }
+    }
+  }
+  return ttl;
+}
+
 void AsyncNameResolverMan::setNameResolverCheck(DownloadEngine* e,
                                                 Command* command)
 {
@@ -65,6 +65,9 @@ public:
                   Command* command);
   // Appends resolved addresses to |res|.
   void getResolvedAddress(std::vector<std::string>& res) const;
+  // Returns the minimum TTL of resolved addresses in seconds, or 0 if
+  // it is unknown.
+  int getResolvedTTL() const;
   // Adds resolvers to DownloadEngine to check event notification.
   void setNameResolverCheck(DownloadEngine* e, Command* command);
   // Removes resolvers from DownloadEngine.
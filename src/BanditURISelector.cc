@@ -0,0 +1,180 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2015 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "BanditURISelector.h"
+
+#include <cmath>
+#include <algorithm>
+
+#include "ServerStatMan.h"
+#include "ServerStat.h"
+#include "A2STR.h"
+#include "FileEntry.h"
+#include "Logger.h"
+#include "LogFactory.h"
+#include "a2algo.h"
+#include "a2functional.h"
+#include "uri.h"
+#include "fmt.h"
+
+namespace aria2 {
+
+namespace {
+// The length of data used to convert latency into throughput.
+constexpr double REFERENCE_LENGTH = 1_m;
+// Weight of exploration bonus
+constexpr double EXPLORATION = 0.5;
+} // namespace
+
+BanditURISelector::BanditURISelector(
+    const std::shared_ptr<ServerStatMan>& serverStatMan)
+    : serverStatMan_(serverStatMan)
+{
+}
+
+BanditURISelector::~BanditURISelector() {}
+
+std::string BanditURISelector::select(
+    FileEntry* fileEntry,
+    const std::vector<std::pair<size_t, std::string>>& usedHosts)
+{
+  std::deque<std::string>& uris = fileEntry->getRemainingUris();
+  if (uris.empty()) {
+    return A2STR::NIL;
+  }
+  // Prefer hosts not in usedHosts.  If no URI is selected, then do it
+  // again without usedHosts.
+  std::string uri = selectBest(uris, usedHosts, true);
+  if (uri.empty()) {
+    uri = selectBest(uris, usedHosts, false);
+  }
+  if (uri.empty()) {
+    // All hosts are in error state.
+    uri = uris.front();
+  }
+  uris.erase(std::find(uris.begin(), uris.end(), uri));
+  A2_LOG_DEBUG(fmt("BanditURISelector selected %s", uri.c_str()));
+  return uri;
+}
+
+namespace {
+struct Candidate {
+  std::string uri;
+  std::shared_ptr<ServerStat> ss;
+};
+
+// Returns expected throughput of a connection to the server, taking
+// latency and failure rate into account.  downloadSpeed must be
+// positive.
+double
+estimateValue(const std::shared_ptr<ServerStat>& ss, double downloadSpeed)
+{
+  double t = REFERENCE_LENGTH / downloadSpeed;
+  double failureRate = 0;
+  if (ss) {
+    t += (ss->getConnectTime() + ss->getTimeToFirstByte()) / 1000.0;
+    failureRate = ss->getFailureRate();
+  }
+  return REFERENCE_LENGTH / t * (1 - failureRate);
+}
+} // namespace
+
+std::string BanditURISelector::selectBest(
+    const std::deque<std::string>& uris,
+    const std::vector<std::pair<size_t, std::string>>& usedHosts,
+    bool skipUsedHosts)
+{
+  std::vector<Candidate> cands;
+  double knownSpeedSum = 0;
+  size_t numKnown = 0;
+  int totalSamples = 0;
+  for (const auto& u : uris) {
+    uri_split_result us;
+    if (uri_split(&us, u.c_str()) == -1) {
+      continue;
+    }
+    auto host = uri::getFieldString(us, USR_HOST, u.c_str());
+    if (skipUsedHosts && findSecond(usedHosts.begin(), usedHosts.end(),
+                                    host) != usedHosts.end()) {
+      A2_LOG_DEBUG(fmt("%s is in usedHosts, not considered", u.c_str()));
+      continue;
+    }
+    auto protocol = uri::getFieldString(us, USR_SCHEME, u.c_str());
+    auto ss = serverStatMan_->find(host, protocol);
+    if (ss && ss->isError()) {
+      A2_LOG_DEBUG(fmt("Error not considered: %s", u.c_str()));
+      continue;
+    }
+    if (ss && ss->getEwmaSpeed() > 0) {
+      knownSpeedSum += ss->getEwmaSpeed();
+      ++numKnown;
+    }
+    if (ss) {
+      totalSamples += ss->getSamples();
+    }
+    cands.push_back(Candidate{u, ss});
+  }
+  if (cands.empty()) {
+    return A2STR::NIL;
+  }
+  if (numKnown == 0) {
+    // Nothing to exploit yet.
+    return cands.front().uri;
+  }
+  // Servers without speed sample are assumed to be average.
+  double priorSpeed = knownSpeedSum / numKnown;
+  double logTotal = std::log(static_cast<double>(totalSamples + 1));
+  const Candidate* best = nullptr;
+  double bestScore = 0;
+  for (const auto& c : cands) {
+    int samples = 1;
+    double speed = priorSpeed;
+    if (c.ss && c.ss->getEwmaSpeed() > 0) {
+      samples = std::max(1, c.ss->getSamples());
+      speed = c.ss->getEwmaSpeed();
+    }
+    double value = estimateValue(c.ss, speed);
+    double score =
+        value * (1 + EXPLORATION * std::sqrt(2 * logTotal / samples));
+    A2_LOG_DEBUG(fmt("%s: value=%.0f, samples=%d, score=%.0f", c.uri.c_str(),
+                     value, samples, score));
+    if (!best || score > bestScore) {
+      best = &c;
+      bestScore = score;
+    }
+  }
+  return best->uri;
+}
+
+} // namespace aria2
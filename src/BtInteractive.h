@@ -69,6 +69,10 @@ public:
   virtual size_t countReceivedMessageInIteration() const = 0;
 
   virtual size_t countOutstandingRequest() = 0;
+
+  // Returns true if no data can be received now because of download
+  // speed limit.
+  virtual bool isDownloadLimitReached() = 0;
 };
 
 } // namespace aria2
@@ -41,6 +41,8 @@
 
 namespace aria2 {
 
+class BitfieldMan;
+
 class BtProgressInfoFile {
 public:
   virtual ~BtProgressInfoFile() {}
@@ -57,6 +59,11 @@ public:
 
   // re-set filename
   virtual void updateFilename() = 0;
+
+  // Returns the pieces in the files which are not changed since the
+  // loaded control file was saved.  Their hash check can be skipped.
+  // Returns nullptr if it is unknown.
+  virtual const BitfieldMan* getUnchangedPieces() = 0;
 };
 
 } // namespace aria2
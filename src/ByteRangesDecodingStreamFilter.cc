@@ -0,0 +1,239 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2015 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "ByteRangesDecodingStreamFilter.h"
+
+#include <cassert>
+#include <algorithm>
+
+#include "Segment.h"
+#include "Range.h"
+#include "HttpHeader.h"
+#include "util.h"
+#include "fmt.h"
+#include "message.h"
+#include "DlAbortEx.h"
+#include "DlRetryEx.h"
+#include "Request.h"
+#include "a2functional.h"
+
+namespace aria2 {
+
+const std::string
+    ByteRangesDecodingStreamFilter::NAME("ByteRangesDecodingStreamFilter");
+
+namespace {
+enum { PREV_DELIMITER, PART_HEADER, PART_BODY, PARTS_COMPLETE };
+} // namespace
+
+namespace {
+// The maximum length of delimiter and part header lines
+constexpr size_t MAX_LINE_LENGTH = 4_k;
+} // namespace
+
+ByteRangesDecodingStreamFilter::ByteRangesDecodingStreamFilter(
+    const std::string& boundary, int64_t fileOffset, int64_t entityLength,
+    std::unique_ptr<StreamFilter> delegate)
+    : StreamFilter{std::move(delegate)},
+      delimiter_{"--" + boundary},
+      fileOffset_{fileOffset},
+      entityLength_{entityLength},
+      state_{PREV_DELIMITER},
+      position_{0},
+      partRemaining_{0},
+      bytesProcessed_{0}
+{
+}
+
+ByteRangesDecodingStreamFilter::~ByteRangesDecodingStreamFilter() {}
+
+void ByteRangesDecodingStreamFilter::init() {}
+
+void ByteRangesDecodingStreamFilter::setSinglePart(const Range& range)
+{
+  delimiter_.clear();
+  startPart(range);
+}
+
+void ByteRangesDecodingStreamFilter::startPart(const Range& range)
+{
+  if (range.entityLength == 0) {
+    throw DL_ABORT_EX("Bad multipart/byteranges response: "
+                      "invalid Content-Range");
+  }
+  if (range.entityLength != entityLength_) {
+    throw DL_ABORT_EX(fmt(EX_SIZE_MISMATCH, entityLength_, range.entityLength));
+  }
+  position_ = fileOffset_ + range.startByte;
+  partRemaining_ = range.getContentLength();
+  if (partRemaining_ > 0) {
+    state_ = PART_BODY;
+  }
+  else if (delimiter_.empty()) {
+    state_ = PARTS_COMPLETE;
+  }
+  else {
+    state_ = PREV_DELIMITER;
+  }
+}
+
+ssize_t ByteRangesDecodingStreamFilter::transform(
+    const std::shared_ptr<BinaryStream>& out,
+    const std::shared_ptr<Segment>& segment, const unsigned char* inbuf,
+    size_t inlen)
+{
+  ssize_t outlen = 0;
+  size_t i = 0;
+  bytesProcessed_ = 0;
+  while (i < inlen) {
+    switch (state_) {
+    case PREV_DELIMITER:
+    case PART_HEADER: {
+      auto last = inbuf + inlen;
+      auto lf = std::find(inbuf + i, last, '\n');
+      line_.append(inbuf + i, lf);
+      if (line_.size() > MAX_LINE_LENGTH) {
+        throw DL_ABORT_EX("Bad multipart/byteranges response: "
+                          "too long line");
+      }
+      if (lf == last) {
+        i = inlen;
+        break;
+      }
+      i = lf - inbuf + 1;
+      if (!line_.empty() && line_.back() == '\r') {
+        line_.pop_back();
+      }
+      if (state_ == PREV_DELIMITER) {
+        // Lines other than delimiter are preamble or CRLF following
+        // the previous part, and ignored.
+        if (line_ == delimiter_) {
+          contentRange_.clear();
+          state_ = PART_HEADER;
+        }
+        else if (line_.size() == delimiter_.size() + 2 &&
+                 util::startsWith(line_, delimiter_) &&
+                 util::endsWith(line_, "--")) {
+          state_ = PARTS_COMPLETE;
+        }
+      }
+      else if (line_.empty()) {
+        if (contentRange_.empty()) {
+          throw DL_ABORT_EX("Bad multipart/byteranges response: "
+                            "missing Content-Range in part");
+        }
+        HttpHeader header;
+        header.put(HttpHeader::CONTENT_RANGE, contentRange_);
+        startPart(header.getRange());
+      }
+      else {
+        auto p = util::divide(std::begin(line_), std::end(line_), ':');
+        if (util::strieq(p.first.first, p.first.second, "content-range")) {
+          contentRange_.assign(p.second.first, p.second.second);
+        }
+      }
+      line_.clear();
+      break;
+    }
+    case PART_BODY: {
+      if (segment->complete()) {
+        // Let the caller proceed to the next segment.
+        goto fin;
+      }
+      auto len = static_cast<size_t>(
+          std::min(partRemaining_, static_cast<int64_t>(inlen - i)));
+      auto target = segment->getPositionToWrite();
+      if (position_ < target) {
+        // This part includes the data we did not ask for, or the part
+        // of the segment already written.
+        auto skiplen = std::min(static_cast<int64_t>(len), target - position_);
+        i += skiplen;
+        position_ += skiplen;
+        partRemaining_ -= skiplen;
+      }
+      else if (position_ == target) {
+        outlen += getDelegate()->transform(out, segment, inbuf + i, len);
+        auto wlen = getDelegate()->getBytesProcessed();
+        i += wlen;
+        position_ += wlen;
+        partRemaining_ -= wlen;
+        if (wlen < len) {
+          // The segment is full.
+          goto fin;
+        }
+      }
+      else {
+        // The server reordered the parts or omitted the data of this
+        // segment.  Both are legal, but we can only write the data in
+        // segment order, so retry with single range requests.
+        if (req_) {
+          req_->setMaxRanges(1);
+        }
+        throw DL_RETRY_EX(
+            fmt("multipart/byteranges response does not continue with the"
+                " data at offset %" PRId64 ".",
+                target - fileOffset_));
+      }
+      if (partRemaining_ == 0) {
+        state_ = delimiter_.empty() ? PARTS_COMPLETE : PREV_DELIMITER;
+      }
+      break;
+    }
+    case PARTS_COMPLETE:
+      // Ignore epilogue
+      i = inlen;
+      break;
+    default:
+      // unreachable
+      assert(0);
+    }
+  }
+fin:
+  bytesProcessed_ = i;
+  return outlen;
+}
+
+bool ByteRangesDecodingStreamFilter::finished()
+{
+  return state_ == PARTS_COMPLETE && getDelegate()->finished();
+}
+
+void ByteRangesDecodingStreamFilter::release() {}
+
+const std::string& ByteRangesDecodingStreamFilter::getName() const
+{
+  return NAME;
+}
+
+} // namespace aria2
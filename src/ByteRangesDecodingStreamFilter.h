@@ -0,0 +1,113 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2015 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_BYTE_RANGES_DECODING_STREAM_FILTER_H
+#define D_BYTE_RANGES_DECODING_STREAM_FILTER_H
+
+#include "StreamFilter.h"
+
+namespace aria2 {
+
+struct Range;
+class Request;
+
+// Decodes the body of multipart/byteranges response and writes each
+// part at its offset in the file.  The part data are passed to the
+// delegate for the given segment only when they start at the
+// segment's write position; data before it, such as gaps coalesced by
+// the server, are skipped.  When the segment becomes full, transform()
+// stops consuming input so that the caller can continue with the next
+// segment.  If the parts are reordered or skip the data of a segment,
+// which RFC 7233 allows, the request falls back to single range
+// requests and is retried.
+class ByteRangesDecodingStreamFilter : public StreamFilter {
+private:
+  // "--" + boundary
+  std::string delimiter_;
+  // Offset of the file in the whole download, used to convert file
+  // local ranges in Content-Range to the positions of segments.
+  int64_t fileOffset_;
+  // The length of the file.  Each part must have this entity length.
+  int64_t entityLength_;
+  int state_;
+  std::string line_;
+  std::string contentRange_;
+  // The position of the next byte of the current part.
+  int64_t position_;
+  int64_t partRemaining_;
+  size_t bytesProcessed_;
+  std::shared_ptr<Request> req_;
+
+  void startPart(const Range& range);
+
+public:
+  ByteRangesDecodingStreamFilter(
+      const std::string& boundary, int64_t fileOffset, int64_t entityLength,
+      std::unique_ptr<StreamFilter> delegate = nullptr);
+
+  virtual ~ByteRangesDecodingStreamFilter();
+
+  virtual void init() CXX11_OVERRIDE;
+
+  virtual ssize_t transform(const std::shared_ptr<BinaryStream>& out,
+                            const std::shared_ptr<Segment>& segment,
+                            const unsigned char* inbuf,
+                            size_t inlen) CXX11_OVERRIDE;
+
+  virtual bool finished() CXX11_OVERRIDE;
+
+  virtual void release() CXX11_OVERRIDE;
+
+  virtual const std::string& getName() const CXX11_OVERRIDE;
+
+  virtual size_t getBytesProcessed() const CXX11_OVERRIDE
+  {
+    return bytesProcessed_;
+  }
+
+  // Treats the whole input as the body of single part of |range|.
+  // This is used when the server answered multiple range request with
+  // an ordinary single range response.
+  void setSinglePart(const Range& range);
+
+  // Sets the request whose maximum number of ranges is lowered to 1
+  // when the response cannot be decoded in segment order.
+  void setRequest(const std::shared_ptr<Request>& req) { req_ = req; }
+
+  static const std::string NAME;
+};
+
+} // namespace aria2
+
+#endif // D_BYTE_RANGES_DECODING_STREAM_FILTER_H
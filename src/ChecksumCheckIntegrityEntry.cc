@@ -37,6 +37,8 @@
 #include "DownloadContext.h"
 #include "FileEntry.h"
 #include "IteratableChecksumValidator.h"
+#include "InlineChecksumValidator.h"
+#include "MessageDigest.h"
 #include "DownloadEngine.h"
 #include "PieceStorage.h"
 #include "FileAllocationEntry.h"
@@ -66,6 +68,13 @@ void ChecksumCheckIntegrityEntry::initValidator()
       getRequestGroup()->getDownloadContext(),
       getRequestGroup()->getPieceStorage());
   validator->init();
+  const auto& inlineValidator = getRequestGroup()->getInlineChecksumValidator();
+  if (inlineValidator && !inlineValidator->finished()) {
+    // Only the part not hashed while downloading has to be read.
+    auto offset = inlineValidator->getOffset();
+    validator->resume(inlineValidator->popMessageDigest(), offset);
+    getRequestGroup()->resetInlineChecksumValidator();
+  }
   setValidator(std::move(validator));
 }
 
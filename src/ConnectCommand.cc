@@ -44,6 +44,8 @@
 #include "Request.h"
 #include "prefs.h"
 #include "SocketRecvBuffer.h"
+#include "ServerStat.h"
+#include "wallclock.h"
 
 namespace aria2 {
 
@@ -108,6 +110,14 @@ bool ConnectCommand::executeInternal()
     backupConnectionInfo_->cancel = true;
     backupConnectionInfo_.reset();
   }
+  if (!proxyRequest_) {
+    auto ss = getModelServerStat();
+    if (ss) {
+      ss->updateConnectTime(
+          std::chrono::duration_cast<std::chrono::milliseconds>(
+              startTime_.difference(global::wallclock())).count());
+    }
+  }
   chain_->run(this, getDownloadEngine());
   return true;
 }
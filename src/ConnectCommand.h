@@ -37,6 +37,7 @@
 
 #include "AbstractCommand.h"
 #include "ControlChain.h"
+#include "TimerA2.h"
 
 namespace aria2 {
 
@@ -63,6 +64,8 @@ private:
   std::shared_ptr<Request> proxyRequest_;
   std::shared_ptr<BackupConnectInfo> backupConnectionInfo_;
   std::shared_ptr<ControlChain<ConnectCommand*>> chain_;
+  // Used to measure connect time for the performance model.
+  Timer startTime_;
 };
 
 } // namespace aria2
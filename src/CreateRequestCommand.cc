@@ -47,6 +47,8 @@
 #include "FileEntry.h"
 #include "SocketRecvBuffer.h"
 #include "LogFactory.h"
+#include "Logger.h"
+#include "fmt.h"
 #include "wallclock.h"
 #include "DownloadFailureException.h"
 
@@ -79,18 +81,38 @@ bool CreateRequestCommand::executeInternal()
   if (getOption()->getAsBool(PREF_SELECT_LEAST_USED_HOST)) {
     getDownloadEngine()->getRequestGroupMan()->getUsedHosts(usedHosts);
   }
-  setRequest(
-      getFileEntry()->getRequest(getRequestGroup()->getURISelector().get(),
-                                 getOption()->getAsBool(PREF_REUSE_URI),
-                                 usedHosts, getOption()->get(PREF_REFERER),
-                                 // Don't use HEAD request when file
-                                 // size is known.
-                                 // Use HEAD for dry-run mode.
-                                 (getFileEntry()->getLength() == 0 &&
-                                  getOption()->getAsBool(PREF_USE_HEAD)) ||
-                                         getOption()->getAsBool(PREF_DRY_RUN)
-                                     ? Request::METHOD_HEAD
-                                     : Request::METHOD_GET));
+  std::shared_ptr<Request> req;
+  if (isSegmentStolen()) {
+    // The segment was taken over from slower connection because this
+    // connection is faster.  Keep downloading from the same source.
+    req = getFileEntry()->getPooledRequest(getCuid());
+  }
+  if (!req) {
+    req = getFileEntry()->getRequest(
+        getRequestGroup()->getURISelector().get(),
+        getOption()->getAsBool(PREF_REUSE_URI), usedHosts,
+        getOption()->get(PREF_REFERER),
+        // Don't use HEAD request when file
+        // size is known.
+        // Use HEAD for dry-run mode.
+        (getFileEntry()->getLength() == 0 &&
+         getOption()->getAsBool(PREF_USE_HEAD)) ||
+                getOption()->getAsBool(PREF_DRY_RUN)
+            ? Request::METHOD_HEAD
+            : Request::METHOD_GET);
+  }
+  setRequest(req);
+  if (!getRequest() && getRequestGroup()->getConnectionControl() &&
+      getFileEntry()->countInFlightRequest() > 0) {
+    // Servers have as many connections as adaptive connection control
+    // allows.  Other connections keep downloading this file.
+    A2_LOG_DEBUG(fmt("CUID#%" PRId64 " - No more connection is allowed.",
+                     getCuid()));
+    if (getSegmentMan()) {
+      getSegmentMan()->cancelSegment(getCuid());
+    }
+    return true;
+  }
   if (!getRequest()) {
     if (getSegmentMan()) {
       getSegmentMan()->ignoreSegmentFor(getFileEntry());
@@ -107,6 +129,20 @@ bool CreateRequestCommand::executeInternal()
     throw DL_ABORT_EX2("No URI available.",
                        getRequestGroup()->getLastErrorCode());
   }
+  else if (getRequestGroup()->getConnectionControl() &&
+           getFileEntry()->isConnectionLimitExceeded(getRequest())) {
+    // Adaptive connection control lowered the number of connections
+    // to this server.  Leave the request for other connections.
+    A2_LOG_INFO(fmt("CUID#%" PRId64 " - Too many connections to %s."
+                    " Closing this connection.",
+                    getCuid(), getRequest()->getHost().c_str()));
+    if (getSegmentMan()) {
+      getSegmentMan()->cancelSegment(getCuid());
+    }
+    getFileEntry()->poolRequest(getRequest());
+    resetRequest();
+    return true;
+  }
   else if (getRequest()->getWakeTime() > global::wallclock()) {
     A2_LOG_DEBUG("This request object is still sleeping.");
     getFileEntry()->poolRequest(getRequest());
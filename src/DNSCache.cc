@@ -33,10 +33,26 @@
  */
 /* copyright --> */
 #include "DNSCache.h"
+
+#include <cstdio>
+
 #include "A2STR.h"
+#include "wallclock.h"
+#include "util.h"
+#include "BufferedFile.h"
+#include "File.h"
+#include "TimeA2.h"
+#include "message.h"
+#include "fmt.h"
+#include "LogFactory.h"
 
 namespace aria2 {
 
+namespace {
+// Expired entries are swept at most once in this interval.
+constexpr auto SWEEP_INTERVAL = 1_min;
+} // namespace
+
 DNSCache::AddrEntry::AddrEntry(const std::string& addr)
     : addr_(addr), good_(true)
 {
@@ -59,12 +75,22 @@ DNSCache::AddrEntry& DNSCache::AddrEntry::operator=(const AddrEntry& c)
 }
 
 DNSCache::CacheEntry::CacheEntry(const std::string& hostname, uint16_t port)
-    : hostname_(hostname), port_(port)
+    : hostname_(hostname),
+      port_(port),
+      ttl_(0),
+      expiry_(Timer::zero()),
+      refreshing_(false)
 {
 }
 
 DNSCache::CacheEntry::CacheEntry(const CacheEntry& c)
-    : hostname_(c.hostname_), port_(c.port_), addrEntries_(c.addrEntries_)
+    : hostname_(c.hostname_),
+      port_(c.port_),
+      addrEntries_(c.addrEntries_),
+      ttl_(c.ttl_),
+      expiry_(c.expiry_),
+      error_(c.error_),
+      refreshing_(c.refreshing_)
 {
 }
 
@@ -76,6 +102,10 @@ DNSCache::CacheEntry& DNSCache::CacheEntry::operator=(const CacheEntry& c)
     hostname_ = c.hostname_;
     port_ = c.port_;
     addrEntries_ = c.addrEntries_;
+    ttl_ = c.ttl_;
+    expiry_ = c.expiry_;
+    error_ = c.error_;
+    refreshing_ = c.refreshing_;
   }
   return *this;
 }
@@ -138,13 +168,20 @@ void DNSCache::CacheEntry::markBad(const std::string& addr)
   }
 }
 
-bool DNSCache::CacheEntry::operator<(const CacheEntry& e) const
+void DNSCache::CacheEntry::renew(const Timer& now,
+                                 const std::chrono::seconds& ttl)
 {
-  int r = hostname_.compare(e.hostname_);
-  if (r != 0) {
-    return r < 0;
-  }
-  return port_ < e.port_;
+  addrEntries_.clear();
+  error_.clear();
+  refreshing_ = false;
+  ttl_ = ttl;
+  expiry_ = now;
+  expiry_.advance(ttl);
+}
+
+bool DNSCache::CacheEntry::isExpired(const Timer& now) const
+{
+  return expiry_ <= now;
 }
 
 bool DNSCache::CacheEntry::operator==(const CacheEntry& e) const
@@ -152,9 +189,24 @@ bool DNSCache::CacheEntry::operator==(const CacheEntry& e) const
   return hostname_ == e.hostname_ && port_ == e.port_;
 }
 
-DNSCache::DNSCache() {}
+size_t DNSCache::CacheKeyHash::operator()(const CacheKey& key) const
+{
+  return std::hash<std::string>()(key.first) ^ key.second;
+}
+
+DNSCache::DNSCache()
+    : defaultTTL_(std::chrono::seconds(300)),
+      negativeTTL_(std::chrono::seconds(0))
+{
+}
 
-DNSCache::DNSCache(const DNSCache& c) : entries_(c.entries_) {}
+DNSCache::DNSCache(const DNSCache& c)
+    : entries_(c.entries_),
+      defaultTTL_(c.defaultTTL_),
+      negativeTTL_(c.negativeTTL_),
+      lastSweep_(c.lastSweep_)
+{
+}
 
 DNSCache::~DNSCache() {}
 
@@ -162,51 +214,310 @@ DNSCache& DNSCache::operator=(const DNSCache& c)
 {
   if (this != &c) {
     entries_ = c.entries_;
+    defaultTTL_ = c.defaultTTL_;
+    negativeTTL_ = c.negativeTTL_;
+    lastSweep_ = c.lastSweep_;
   }
   return *this;
 }
 
+DNSCache::CacheEntry* DNSCache::findEntry(const std::string& hostname,
+                                          uint16_t port) const
+{
+  auto i = entries_.find(CacheKey(hostname, port));
+  if (i == entries_.end() || (*i).second->isNegative() ||
+      (*i).second->isExpired(global::wallclock())) {
+    return nullptr;
+  }
+  return (*i).second.get();
+}
+
 const std::string& DNSCache::find(const std::string& hostname,
                                   uint16_t port) const
 {
-  auto target = std::make_shared<CacheEntry>(hostname, port);
-  auto i = entries_.find(target);
-  if (i == entries_.end()) {
+  auto entry = findEntry(hostname, port);
+  if (!entry) {
     return A2STR::NIL;
   }
   else {
-    return (*i)->getGoodAddr();
+    return entry->getGoodAddr();
   }
 }
 
 void DNSCache::put(const std::string& hostname, const std::string& ipaddr,
-                   uint16_t port)
+                   uint16_t port, std::chrono::seconds ttl)
 {
-  auto target = std::make_shared<CacheEntry>(hostname, port);
-  auto i = entries_.lower_bound(target);
-  if (i != entries_.end() && *(*i) == *target) {
-    (*i)->add(ipaddr);
+  sweep();
+  if (ttl == std::chrono::seconds(0)) {
+    ttl = defaultTTL_;
+  }
+  auto& now = global::wallclock();
+  auto& entry = entries_[CacheKey(hostname, port)];
+  if (!entry) {
+    entry = std::make_shared<CacheEntry>(hostname, port);
+    entry->renew(now, ttl);
+  }
+  else if (entry->isNegative() || entry->isExpired(now)) {
+    entry->renew(now, ttl);
   }
   else {
-    target->add(ipaddr);
-    entries_.insert(i, target);
+    auto expiry = now;
+    expiry.advance(ttl);
+    if (entry->expiry_ < expiry) {
+      entry->ttl_ = ttl;
+      entry->expiry_ = expiry;
+    }
+  }
+  entry->add(ipaddr);
+}
+
+void DNSCache::update(const std::string& hostname,
+                      const std::vector<std::string>& addrs, uint16_t port,
+                      std::chrono::seconds ttl)
+{
+  sweep();
+  if (ttl == std::chrono::seconds(0)) {
+    ttl = defaultTTL_;
+  }
+  auto& entry = entries_[CacheKey(hostname, port)];
+  if (!entry) {
+    entry = std::make_shared<CacheEntry>(hostname, port);
+  }
+  auto old = std::move(entry->addrEntries_);
+  entry->renew(global::wallclock(), ttl);
+  for (auto& addr : addrs) {
+    if (entry->add(addr)) {
+      for (auto& e : old) {
+        if (e.addr_ == addr) {
+          entry->addrEntries_.back().good_ = e.good_;
+          break;
+        }
+      }
+    }
+  }
+  // If all of them are known to be bad, give them another chance.
+  if (entry->getGoodAddr().empty()) {
+    for (auto& e : entry->addrEntries_) {
+      e.good_ = true;
+    }
+  }
+}
+
+void DNSCache::putNegative(const std::string& hostname, uint16_t port,
+                           const std::string& error)
+{
+  if (negativeTTL_ == std::chrono::seconds(0)) {
+    return;
+  }
+  sweep();
+  auto& now = global::wallclock();
+  auto& entry = entries_[CacheKey(hostname, port)];
+  if (!entry) {
+    entry = std::make_shared<CacheEntry>(hostname, port);
+  }
+  else if (!entry->isNegative() && !entry->isExpired(now) &&
+           !entry->getGoodAddr().empty()) {
+    return;
   }
+  entry->renew(now, negativeTTL_);
+  entry->error_ = error.empty() ? std::string("unknown error") : error;
+}
+
+const std::string* DNSCache::findNegative(const std::string& hostname,
+                                          uint16_t port) const
+{
+  auto i = entries_.find(CacheKey(hostname, port));
+  if (i == entries_.end() || !(*i).second->isNegative() ||
+      (*i).second->isExpired(global::wallclock())) {
+    return nullptr;
+  }
+  return &(*i).second->error_;
 }
 
 void DNSCache::markBad(const std::string& hostname, const std::string& ipaddr,
                        uint16_t port)
 {
-  auto target = std::make_shared<CacheEntry>(hostname, port);
-  auto i = entries_.find(target);
-  if (i != entries_.end()) {
-    (*i)->markBad(ipaddr);
+  auto entry = findEntry(hostname, port);
+  if (entry) {
+    entry->markBad(ipaddr);
   }
 }
 
 void DNSCache::remove(const std::string& hostname, uint16_t port)
 {
-  auto target = std::make_shared<CacheEntry>(hostname, port);
-  entries_.erase(target);
+  entries_.erase(CacheKey(hostname, port));
+}
+
+bool DNSCache::startRefresh(const std::string& hostname, uint16_t port)
+{
+  auto entry = findEntry(hostname, port);
+  if (!entry || entry->refreshing_) {
+    return false;
+  }
+  // Refresh when the last 10% of TTL is reached.
+  auto window = std::max(std::chrono::seconds(1), entry->ttl_ / 10);
+  auto threshold = global::wallclock();
+  threshold.advance(window);
+  if (threshold < entry->expiry_) {
+    return false;
+  }
+  entry->refreshing_ = true;
+  return true;
+}
+
+void DNSCache::sweep()
+{
+  if (lastSweep_.difference(global::wallclock()) >= SWEEP_INTERVAL) {
+    removeExpired();
+  }
+}
+
+void DNSCache::removeExpired()
+{
+  auto& now = global::wallclock();
+  for (auto i = std::begin(entries_); i != std::end(entries_);) {
+    if ((*i).second->isExpired(now)) {
+      i = entries_.erase(i);
+    }
+    else {
+      ++i;
+    }
+  }
+  lastSweep_ = now;
+}
+
+bool DNSCache::save(const std::string& filename) const
+{
+  std::string tempfile = filename;
+  tempfile += "__temp";
+  {
+    BufferedFile fp(tempfile.c_str(), BufferedFile::WRITE);
+    if (!fp) {
+      A2_LOG_ERROR(
+          fmt(MSG_OPENING_WRITABLE_DNS_CACHE_FILE_FAILED, filename.c_str()));
+      return false;
+    }
+    auto& now = global::wallclock();
+    auto epoch = Time().getTimeFromEpoch();
+    for (auto& kv : entries_) {
+      auto& e = kv.second;
+      if (e->isNegative() || e->isExpired(now)) {
+        continue;
+      }
+      std::vector<std::string> addrs;
+      e->getAllGoodAddrs(std::back_inserter(addrs));
+      if (addrs.empty()) {
+        continue;
+      }
+      auto remaining = std::chrono::duration_cast<std::chrono::seconds>(
+          now.difference(e->expiry_));
+      auto l = fmt("host=%s,port=%u,expiry=%" PRId64 ",ttl=%" PRId64
+                   ",addrs=%s\n",
+                   e->hostname_.c_str(), e->port_,
+                   static_cast<int64_t>(epoch + remaining.count()),
+                   static_cast<int64_t>(e->ttl_.count()),
+                   strjoin(std::begin(addrs), std::end(addrs), ";").c_str());
+      if (fp.write(l.data(), l.size()) != l.size()) {
+        A2_LOG_ERROR(fmt(MSG_WRITING_DNS_CACHE_FILE_FAILED, filename.c_str()));
+      }
+    }
+    if (fp.close() == EOF) {
+      A2_LOG_ERROR(fmt(MSG_WRITING_DNS_CACHE_FILE_FAILED, filename.c_str()));
+      return false;
+    }
+  }
+  if (File(tempfile).renameTo(filename)) {
+    A2_LOG_NOTICE(fmt(MSG_DNS_CACHE_SAVED, filename.c_str()));
+    return true;
+  }
+  else {
+    A2_LOG_ERROR(fmt(MSG_WRITING_DNS_CACHE_FILE_FAILED, filename.c_str()));
+    return false;
+  }
+}
+
+namespace {
+// Field and FIELD_NAMES must have same order except for MAX_FIELD.
+enum Field { D_ADDRS, D_EXPIRY, D_HOST, D_PORT, D_TTL, MAX_FIELD };
+
+const char* FIELD_NAMES[] = {
+    "addrs", "expiry", "host", "port", "ttl",
+};
+} // namespace
+
+namespace {
+int idField(std::string::const_iterator first, std::string::const_iterator last)
+{
+  int i;
+  for (i = 0; i < MAX_FIELD; ++i) {
+    if (util::streq(first, last, FIELD_NAMES[i])) {
+      return i;
+    }
+  }
+  return i;
+}
+} // namespace
+
+bool DNSCache::load(const std::string& filename)
+{
+  BufferedFile fp(filename.c_str(), BufferedFile::READ);
+  if (!fp) {
+    A2_LOG_ERROR(
+        fmt(MSG_OPENING_READABLE_DNS_CACHE_FILE_FAILED, filename.c_str()));
+    return false;
+  }
+  auto& now = global::wallclock();
+  auto epoch = Time().getTimeFromEpoch();
+  while (1) {
+    std::string line = fp.getLine();
+    if (line.empty()) {
+      if (fp.eof()) {
+        break;
+      }
+      else if (!fp) {
+        A2_LOG_ERROR(fmt(MSG_READING_DNS_CACHE_FILE_FAILED, filename.c_str()));
+        return false;
+      }
+      else {
+        continue;
+      }
+    }
+    auto p = util::stripIter(line.begin(), line.end());
+    if (p.first == p.second) {
+      continue;
+    }
+    std::vector<Scip> items;
+    util::splitIter(p.first, p.second, std::back_inserter(items), ',');
+    std::vector<std::string> m(MAX_FIELD);
+    for (auto& item : items) {
+      auto kv = util::divide(item.first, item.second, '=');
+      int id = idField(kv.first.first, kv.first.second);
+      if (id != MAX_FIELD) {
+        m[id].assign(kv.second.first, kv.second.second);
+      }
+    }
+    uint32_t port;
+    int64_t expiry, ttl;
+    if (m[D_HOST].empty() || m[D_ADDRS].empty() ||
+        !util::parseUIntNoThrow(port, m[D_PORT]) || port > UINT16_MAX ||
+        !util::parseLLIntNoThrow(expiry, m[D_EXPIRY]) ||
+        !util::parseLLIntNoThrow(ttl, m[D_TTL]) || expiry <= epoch) {
+      continue;
+    }
+    std::vector<std::string> addrs;
+    util::split(std::begin(m[D_ADDRS]), std::end(m[D_ADDRS]),
+                std::back_inserter(addrs), ';');
+    if (addrs.empty()) {
+      continue;
+    }
+    update(m[D_HOST], addrs, port, std::chrono::seconds(ttl));
+    // Restore the remaining lifetime, rather than full TTL.
+    auto& entry = entries_[CacheKey(m[D_HOST], port)];
+    entry->expiry_ = now;
+    entry->expiry_.advance(std::chrono::seconds(expiry - epoch));
+  }
+  A2_LOG_NOTICE(fmt(MSG_DNS_CACHE_LOADED, filename.c_str()));
+  return true;
 }
 
 } // namespace aria2
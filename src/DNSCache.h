@@ -38,10 +38,13 @@
 #include "common.h"
 
 #include <string>
-#include <set>
+#include <unordered_map>
 #include <algorithm>
 #include <vector>
+#include <memory>
+#include <chrono>
 
+#include "TimerA2.h"
 #include "a2functional.h"
 
 namespace aria2 {
@@ -63,6 +66,15 @@ private:
     std::string hostname_;
     uint16_t port_;
     std::vector<AddrEntry> addrEntries_;
+    // Time to live given when this entry was last (re)populated.
+    std::chrono::seconds ttl_;
+    // This entry is not used after this time.
+    Timer expiry_;
+    // Non-empty if this is a negative entry, that is name resolution
+    // failed for hostname_.  addrEntries_ is empty in this case.
+    std::string error_;
+    // true if asynchronous refresh of this entry has been started.
+    bool refreshing_;
 
     CacheEntry(const std::string& hostname, uint16_t port);
     CacheEntry(const CacheEntry& c);
@@ -92,14 +104,37 @@ private:
 
     void markBad(const std::string& addr);
 
-    bool operator<(const CacheEntry& e) const;
+    // Makes this entry empty and valid for |ttl| from |now|.
+    void renew(const Timer& now, const std::chrono::seconds& ttl);
+
+    bool isExpired(const Timer& now) const;
+
+    bool isNegative() const { return !error_.empty(); }
 
     bool operator==(const CacheEntry& e) const;
   };
 
-  typedef std::set<std::shared_ptr<CacheEntry>,
-                   DerefLess<std::shared_ptr<CacheEntry>>> CacheEntrySet;
-  CacheEntrySet entries_;
+  typedef std::pair<std::string, uint16_t> CacheKey;
+
+  struct CacheKeyHash {
+    size_t operator()(const CacheKey& key) const;
+  };
+
+  typedef std::unordered_map<CacheKey, std::shared_ptr<CacheEntry>,
+                             CacheKeyHash> CacheEntryMap;
+  CacheEntryMap entries_;
+
+  // TTL used when name resolver does not tell us one.
+  std::chrono::seconds defaultTTL_;
+  // TTL of negative entries.  0 disables negative caching.
+  std::chrono::seconds negativeTTL_;
+
+  Timer lastSweep_;
+
+  // Returns non-expired entry for hostname and port, or nullptr.
+  CacheEntry* findEntry(const std::string& hostname, uint16_t port) const;
+
+  void sweep();
 
 public:
   DNSCache();
@@ -114,20 +149,67 @@ public:
   void findAll(OutputIterator out, const std::string& hostname,
                uint16_t port) const
   {
-    std::shared_ptr<CacheEntry> target(new CacheEntry(hostname, port));
-    auto i = entries_.find(target);
-    if (i != entries_.end()) {
-      (*i)->getAllGoodAddrs(out);
+    auto entry = findEntry(hostname, port);
+    if (entry) {
+      entry->getAllGoodAddrs(out);
     }
   }
 
+  // Adds ipaddr to the entry for hostname and port.  If the entry
+  // does not exist, or it is expired or negative, new entry is
+  // created which lives for |ttl|.  If |ttl| is 0, defaultTTL_ is
+  // used instead.
   void put(const std::string& hostname, const std::string& ipaddr,
-           uint16_t port);
+           uint16_t port,
+           std::chrono::seconds ttl = std::chrono::seconds(0));
+
+  // Replaces addresses of the entry for hostname and port with
+  // |addrs|.  The addresses marked bad before are kept bad.  This is
+  // used to store the result of fresh name resolution.
+  void update(const std::string& hostname,
+              const std::vector<std::string>& addrs, uint16_t port,
+              std::chrono::seconds ttl = std::chrono::seconds(0));
+
+  // Remembers that name resolution of hostname failed with |error|.
+  // Existing valid positive entry is not overwritten.  Does nothing
+  // if negative caching is disabled.
+  void putNegative(const std::string& hostname, uint16_t port,
+                   const std::string& error);
+
+  // Returns the error message of valid negative entry for hostname
+  // and port, or nullptr.
+  const std::string* findNegative(const std::string& hostname,
+                                  uint16_t port) const;
 
   void markBad(const std::string& hostname, const std::string& ipaddr,
                uint16_t port);
 
   void remove(const std::string& hostname, uint16_t port);
+
+  // Returns true if the positive entry for hostname and port is
+  // close to its expiry and nobody has started to refresh it yet.
+  // The entry is then marked as being refreshed, so that subsequent
+  // call returns false until update() is called.
+  bool startRefresh(const std::string& hostname, uint16_t port);
+
+  // Removes expired entries.
+  void removeExpired();
+
+  size_t size() const { return entries_.size(); }
+
+  void setDefaultTTL(const std::chrono::seconds& ttl) { defaultTTL_ = ttl; }
+
+  const std::chrono::seconds& getDefaultTTL() const { return defaultTTL_; }
+
+  void setNegativeTTL(const std::chrono::seconds& ttl) { negativeTTL_ = ttl; }
+
+  // Saves valid positive entries to |filename|.  Returns true if it
+  // succeeds.
+  bool save(const std::string& filename) const;
+
+  // Loads entries saved by save().  Already expired entries are
+  // skipped.  Returns true if it succeeds.
+  bool load(const std::string& filename);
 };
 
 } // namespace aria2
@@ -70,6 +70,7 @@
 #include "BtMessageReceiver.h"
 #include "BtMessageDispatcher.h"
 #include "BtMessageFactory.h"
+#include "RateLimiter.h"
 #include "BtRequestFactory.h"
 #include "PeerConnection.h"
 #include "Logger.h"
@@ -105,6 +106,10 @@ DefaultBtInteractive::DefaultBtInteractive(
       numReceivedMessage_(0),
       maxOutstandingRequest_(DEFAULT_MAX_OUTSTANDING_REQUEST),
       requestGroupMan_(nullptr),
+      downloadLimiter_(make_unique<RateLimiter>(
+          downloadContext->getOwnerRequestGroup()
+              ? downloadContext->getOwnerRequestGroup()->getDownloadLimiter()
+              : nullptr)),
       tcpPort_(0),
       haveLastSent_(global::wallclock())
 {
@@ -309,8 +314,8 @@ size_t DefaultBtInteractive::receiveMessages()
   size_t countOldOutstandingRequest = dispatcher_->countOutstandingRequest();
   size_t msgcount = 0;
   while (1) {
-    if (requestGroupMan_->doesOverallDownloadSpeedExceed() ||
-        downloadContext_->getOwnerRequestGroup()->doesDownloadSpeedExceed()) {
+    if (downloadLimiter_->limited() &&
+        downloadLimiter_->getAllowance(16_k) == 0) {
       break;
     }
     auto message = btMessageReceiver_->receiveMessage();
@@ -334,8 +339,12 @@ size_t DefaultBtInteractive::receiveMessages()
         floodingStat_.incChokeUnchokeCount();
       }
       break;
-    case BtRequestMessage::ID:
     case BtPieceMessage::ID:
+      downloadLimiter_->consume(
+          static_cast<BtPieceMessage*>(message.get())->getBlockLength());
+      inactiveTimer_ = global::wallclock();
+      break;
+    case BtRequestMessage::ID:
       inactiveTimer_ = global::wallclock();
       break;
     case BtKeepAliveMessage::ID:
@@ -607,6 +616,11 @@ size_t DefaultBtInteractive::countReceivedMessageInIteration() const
   return numReceivedMessage_;
 }
 
+bool DefaultBtInteractive::isDownloadLimitReached()
+{
+  return downloadLimiter_->limited() && downloadLimiter_->exhausted();
+}
+
 size_t DefaultBtInteractive::countOutstandingRequest()
 {
   if (metadataGetMode_) {
@@ -60,6 +60,7 @@ class ExtensionMessageFactory;
 class ExtensionMessageRegistry;
 class DHTNode;
 class RequestGroupMan;
+class RateLimiter;
 class UTMetadataRequestFactory;
 class UTMetadataRequestTracker;
 
@@ -142,6 +143,9 @@ private:
 
   RequestGroupMan* requestGroupMan_;
 
+  // Per connection node of download speed limit hierarchy.
+  std::unique_ptr<RateLimiter> downloadLimiter_;
+
   uint16_t tcpPort_;
 
   std::vector<size_t> haveIndexes_;
@@ -193,6 +197,8 @@ public:
 
   virtual size_t countOutstandingRequest() CXX11_OVERRIDE;
 
+  virtual bool isDownloadLimitReached() CXX11_OVERRIDE;
+
   void setCuid(cuid_t cuid) { cuid_ = cuid; }
 
   void setBtRuntime(const std::shared_ptr<BtRuntime>& btRuntime);
@@ -58,6 +58,8 @@
 #include "fmt.h"
 #include "PeerConnection.h"
 #include "BtCancelMessage.h"
+#include "BtPieceMessage.h"
+#include "RateLimiter.h"
 
 namespace aria2 {
 
@@ -89,12 +91,15 @@ void DefaultBtMessageDispatcher::sendMessagesInternal()
   while (!messageQueue_.empty()) {
     auto msg = std::move(messageQueue_.front());
     messageQueue_.pop_front();
-    if (msg->isUploading()) {
-      if (requestGroupMan_->doesOverallUploadSpeedExceed() ||
-          downloadContext_->getOwnerRequestGroup()->doesUploadSpeedExceed()) {
+    if (msg->isUploading() && uploadLimiter_ && uploadLimiter_->limited()) {
+      if (uploadLimiter_->getAllowance(16_k) == 0) {
         tempQueue.push_back(std::move(msg));
         continue;
       }
+      if (msg->getId() == BtPieceMessage::ID) {
+        uploadLimiter_->consume(
+            static_cast<BtPieceMessage*>(msg.get())->getBlockLength());
+      }
     }
     msg->send();
   }
@@ -304,6 +309,9 @@ void DefaultBtMessageDispatcher::setDownloadContext(
     DownloadContext* downloadContext)
 {
   downloadContext_ = downloadContext;
+  auto group = downloadContext_->getOwnerRequestGroup();
+  uploadLimiter_ =
+      make_unique<RateLimiter>(group ? group->getUploadLimiter() : nullptr);
 }
 
 void DefaultBtMessageDispatcher::setBtMessageFactory(BtMessageFactory* factory)
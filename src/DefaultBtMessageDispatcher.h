@@ -50,6 +50,7 @@ class BtMessageFactory;
 class Peer;
 class Piece;
 class RequestGroupMan;
+class RateLimiter;
 class PeerConnection;
 
 class DefaultBtMessageDispatcher : public BtMessageDispatcher {
@@ -62,6 +63,8 @@ private:
   BtMessageFactory* messageFactory_;
   std::shared_ptr<Peer> peer_;
   RequestGroupMan* requestGroupMan_;
+  // Per connection node of upload speed limit hierarchy.
+  std::unique_ptr<RateLimiter> uploadLimiter_;
   std::chrono::seconds requestTimeout_;
 
 public:
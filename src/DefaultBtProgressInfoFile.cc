@@ -36,6 +36,8 @@
 
 #include <cstring>
 #include <cstdio>
+#include <algorithm>
+#include <array>
 
 #include "PieceStorage.h"
 #include "Piece.h"
@@ -56,6 +58,9 @@
 #include "DownloadContext.h"
 #include "BufferedFile.h"
 #include "SHA1IOFile.h"
+#include "MessageDigest.h"
+#include "FileEntry.h"
+#include "a2functional.h"
 #ifdef ENABLE_BITTORRENT
 #include "PeerStorage.h"
 #include "BtRuntime.h"
@@ -80,7 +85,10 @@ DefaultBtProgressInfoFile::DefaultBtProgressInfoFile(
     : dctx_(dctx),
       pieceStorage_(pieceStorage),
       option_(option),
-      filename_(createFilename(dctx_, getSuffix()))
+      filename_(createFilename(dctx_, getSuffix())),
+      savedUploadLength_(0),
+      checkpointLength_(0),
+      journalLength_(0)
 {
 }
 
@@ -105,94 +113,211 @@ bool DefaultBtProgressInfoFile::isTorrentDownload()
     throw DL_ABORT_EX(fmt(EX_SEGMENT_FILE_WRITE, filename_.c_str()));          \
   }
 
+uint64_t DefaultBtProgressInfoFile::getUploadLength()
+{
+#ifdef ENABLE_BITTORRENT
+  if (isTorrentDownload()) {
+    return btRuntime_->getUploadLengthAtStartup() +
+           dctx_->getNetStat().getSessionUploadLength();
+  }
+#endif // ENABLE_BITTORRENT
+  return 0;
+}
+
+namespace {
+// Size of file stamp for the file which is not complete.
+const int64_t NO_FILE_STAMP = -1;
+} // namespace
+
+namespace {
+void appendUint32(std::string& out, uint32_t v)
+{
+  v = htonl(v);
+  out.append(reinterpret_cast<const char*>(&v), sizeof(v));
+}
+
+void appendUint64(std::string& out, uint64_t v)
+{
+  v = hton64(v);
+  out.append(reinterpret_cast<const char*>(&v), sizeof(v));
+}
+} // namespace
+
+std::string DefaultBtProgressInfoFile::createInFlightPieces()
+{
+  std::vector<std::shared_ptr<Piece>> inFlightPieces;
+  inFlightPieces.reserve(pieceStorage_->countInFlightPiece());
+  pieceStorage_->getInFlightPieces(inFlightPieces);
+  std::string out;
+  // the number of in-flight piece: 32 bits
+  appendUint32(out, inFlightPieces.size());
+  for (const auto& piece : inFlightPieces) {
+    appendUint32(out, piece->getIndex());
+    appendUint32(out, piece->getLength());
+    appendUint32(out, piece->getBitfieldLength());
+    out.append(reinterpret_cast<const char*>(piece->getBitfield()),
+               piece->getBitfieldLength());
+  }
+  return out;
+}
+
+std::string DefaultBtProgressInfoFile::createFileStamps()
+{
+  BitfieldMan bitfield(dctx_->getPieceLength(), dctx_->getTotalLength());
+  bitfield.setBitfield(pieceStorage_->getBitfield(),
+                       pieceStorage_->getBitfieldLength());
+  const auto& fileEntries = dctx_->getFileEntries();
+  std::string out;
+  appendUint32(out, fileEntries.size());
+  for (const auto& fileEntry : fileEntries) {
+    int64_t size;
+    int64_t mtime = 0;
+    uint64_t inode = 0;
+    // Files still being written are re-verified anyway, so they are
+    // not stamped.
+    if (!bitfield.isBitSetOffsetRange(fileEntry->getOffset(),
+                                      fileEntry->getLength()) ||
+        !File(fileEntry->getPath()).getStamp(size, mtime, inode) ||
+        size != fileEntry->getLength()) {
+      size = NO_FILE_STAMP;
+    }
+    appendUint64(out, size);
+    appendUint64(out, mtime);
+    appendUint64(out, inode);
+  }
+  return out;
+}
+
 // Since version 0001, Integers are saved in binary form, network byte order.
-void DefaultBtProgressInfoFile::save(IOFile& fp)
+//
+// If bit 1 of extension is set, file stamps and a digest follow the
+// in-flight pieces:
+//
+//   the number of files: 32 bits
+//   size, mtime and inode of each file: 64 bits each, size is
+//                                       0xffffffffffffffff if the
+//                                       file is not complete
+//   SHA-1 digest of all preceding bytes: 160 bits
+//
+// Version 0002 is the journaled control file.  It starts with a
+// checkpoint, which has the same layout as version 0001, followed by
+// zero or more records appended by later saves:
+//
+//   recordLength: 32 bits, the length of the following fields
+//   uploadLength: 64 bits
+//   the number of newly completed pieces: 32 bits
+//   index of completed piece: 32 bits, repeated
+//   in-flight pieces: same layout as checkpoint, replacing the
+//                     previous ones
+//
+// Records never change the file stamps; a new checkpoint is written
+// instead.
+void DefaultBtProgressInfoFile::save(IOFile& fp, int version)
 {
 #ifdef ENABLE_BITTORRENT
   bool torrentDownload = isTorrentDownload();
 #else  // !ENABLE_BITTORRENT
   bool torrentDownload = false;
 #endif // !ENABLE_BITTORRENT
+  std::string data;
   // file version: 16 bits
-  // values: '1'
-  char version[] = {0x00u, 0x01u};
-  WRITE_CHECK(fp, version, sizeof(version));
+  // values: '1' or '2'
+  data += '\0';
+  data += static_cast<char>(version);
   // extension: 32 bits
-  // If this is BitTorrent download, then 0x00000001
-  // Otherwise, 0x00000000
+  // If this is BitTorrent download, then bit 0 is set.
+  // Bit 1 is set if file stamps are saved.
   char extension[4];
   memset(extension, 0, sizeof(extension));
   if (torrentDownload) {
     extension[3] = 1;
   }
-  WRITE_CHECK(fp, extension, sizeof(extension));
+  extension[3] |= 2;
+  data.append(std::begin(extension), std::end(extension));
   if (torrentDownload) {
 #ifdef ENABLE_BITTORRENT
     // infoHashLength:
     // length: 32 bits
-    const unsigned char* infoHash = bittorrent::getInfoHash(dctx_);
-    uint32_t infoHashLengthNL = htonl(INFO_HASH_LENGTH);
-    WRITE_CHECK(fp, &infoHashLengthNL, sizeof(infoHashLengthNL));
+    appendUint32(data, INFO_HASH_LENGTH);
     // infoHash:
-    WRITE_CHECK(fp, infoHash, INFO_HASH_LENGTH);
+    data.append(reinterpret_cast<const char*>(bittorrent::getInfoHash(dctx_)),
+                INFO_HASH_LENGTH);
 #endif // ENABLE_BITTORRENT
   }
   else {
     // infoHashLength:
     // length: 32 bits
-    uint32_t infoHashLength = 0;
-    WRITE_CHECK(fp, &infoHashLength, sizeof(infoHashLength));
+    appendUint32(data, 0);
   }
   // pieceLength: 32 bits
-  uint32_t pieceLengthNL = htonl(dctx_->getPieceLength());
-  WRITE_CHECK(fp, &pieceLengthNL, sizeof(pieceLengthNL));
+  appendUint32(data, dctx_->getPieceLength());
   // totalLength: 64 bits
-  uint64_t totalLengthNL = hton64(dctx_->getTotalLength());
-  WRITE_CHECK(fp, &totalLengthNL, sizeof(totalLengthNL));
+  appendUint64(data, dctx_->getTotalLength());
   // uploadLength: 64 bits
-  uint64_t uploadLengthNL = 0;
-#ifdef ENABLE_BITTORRENT
-  if (torrentDownload) {
-    uploadLengthNL = hton64(btRuntime_->getUploadLengthAtStartup() +
-                            dctx_->getNetStat().getSessionUploadLength());
-  }
-#endif // ENABLE_BITTORRENT
-  WRITE_CHECK(fp, &uploadLengthNL, sizeof(uploadLengthNL));
+  uint64_t uploadLength = getUploadLength();
+  appendUint64(data, uploadLength);
   // bitfieldLength: 32 bits
-  uint32_t bitfieldLengthNL = htonl(pieceStorage_->getBitfieldLength());
-  WRITE_CHECK(fp, &bitfieldLengthNL, sizeof(bitfieldLengthNL));
+  appendUint32(data, pieceStorage_->getBitfieldLength());
   // bitfield
-  WRITE_CHECK(fp, pieceStorage_->getBitfield(),
+  data.append(reinterpret_cast<const char*>(pieceStorage_->getBitfield()),
               pieceStorage_->getBitfieldLength());
-  // the number of in-flight piece: 32 bits
-  // TODO implement this
-  uint32_t numInFlightPieceNL = htonl(pieceStorage_->countInFlightPiece());
-  WRITE_CHECK(fp, &numInFlightPieceNL, sizeof(numInFlightPieceNL));
-  std::vector<std::shared_ptr<Piece>> inFlightPieces;
-  inFlightPieces.reserve(pieceStorage_->countInFlightPiece());
-  pieceStorage_->getInFlightPieces(inFlightPieces);
-  for (std::vector<std::shared_ptr<Piece>>::const_iterator
-           itr = inFlightPieces.begin(),
-           eoi = inFlightPieces.end();
-       itr != eoi; ++itr) {
-    uint32_t indexNL = htonl((*itr)->getIndex());
-    WRITE_CHECK(fp, &indexNL, sizeof(indexNL));
-    uint32_t lengthNL = htonl((*itr)->getLength());
-    WRITE_CHECK(fp, &lengthNL, sizeof(lengthNL));
-    uint32_t bitfieldLengthNL = htonl((*itr)->getBitfieldLength());
-    WRITE_CHECK(fp, &bitfieldLengthNL, sizeof(bitfieldLengthNL));
-    WRITE_CHECK(fp, (*itr)->getBitfield(), (*itr)->getBitfieldLength());
-  }
+  auto inFlightPieces = createInFlightPieces();
+  data += inFlightPieces;
+  auto fileStamps = createFileStamps();
+  data += fileStamps;
+  auto sha1 = MessageDigest::sha1();
+  sha1->update(data.data(), data.size());
+  data += sha1->digest();
+  WRITE_CHECK(fp, data.data(), data.size());
   if (fp.close() == EOF) {
     throw DL_ABORT_EX(fmt(EX_SEGMENT_FILE_WRITE, filename_.c_str()));
   }
+  if (version == 2) {
+    savedBitfield_.assign(
+        reinterpret_cast<const char*>(pieceStorage_->getBitfield()),
+        pieceStorage_->getBitfieldLength());
+    savedInFlightPieces_ = std::move(inFlightPieces);
+    savedUploadLength_ = uploadLength;
+    savedFileStamps_ = std::move(fileStamps);
+  }
+}
+
+void DefaultBtProgressInfoFile::writeFile(int version)
+{
+  A2_LOG_INFO(fmt(MSG_SAVING_SEGMENT_FILE, filename_.c_str()));
+  std::string filenameTemp = filename_;
+  filenameTemp += "__temp";
+  savedBitfield_.clear();
+  {
+    BufferedFile fp(filenameTemp.c_str(), BufferedFile::WRITE);
+    if (!fp) {
+      throw DL_ABORT_EX(fmt(EX_SEGMENT_FILE_WRITE, filename_.c_str()));
+    }
+
+    save(fp, version);
+  }
+
+  A2_LOG_INFO(MSG_SAVED_SEGMENT_FILE);
+
+  File tempFile(filenameTemp);
+  checkpointLength_ = tempFile.size();
+  journalLength_ = 0;
+  if (!tempFile.renameTo(filename_)) {
+    savedBitfield_.clear();
+    throw DL_ABORT_EX(fmt(EX_SEGMENT_FILE_WRITE, filename_.c_str()));
+  }
 }
 
 void DefaultBtProgressInfoFile::save()
 {
+  if (option_->getAsBool(PREF_JOURNAL_CONTROL_FILE)) {
+    saveJournal();
+    return;
+  }
+
   SHA1IOFile sha1io;
 
-  save(sha1io);
+  save(sha1io, 1);
 
   auto digest = sha1io.digest();
   if (digest == lastDigest_) {
@@ -202,23 +327,84 @@ void DefaultBtProgressInfoFile::save()
 
   lastDigest_ = std::move(digest);
 
+  writeFile(1);
+}
+
+void DefaultBtProgressInfoFile::saveJournal()
+{
+  const unsigned char* bitfield = pieceStorage_->getBitfield();
+  size_t bitfieldLength = pieceStorage_->getBitfieldLength();
+  // Without a checkpoint of this download (first save, the file was
+  // renamed or removed, or was loaded from older format), write it
+  // first.
+  if (savedBitfield_.size() != bitfieldLength || !File(filename_).isFile()) {
+    writeFile(2);
+    return;
+  }
+  std::vector<uint32_t> completed;
+  if (memcmp(savedBitfield_.data(), bitfield, bitfieldLength) != 0) {
+    for (size_t i = 0; i < bitfieldLength; ++i) {
+      unsigned char saved = savedBitfield_[i];
+      if (saved & ~bitfield[i]) {
+        // A piece was lost, which the journal cannot express.
+        writeFile(2);
+        return;
+      }
+      unsigned char added = bitfield[i] & ~saved;
+      for (size_t j = 0; added; ++j, added <<= 1) {
+        if (added & 0x80u) {
+          completed.push_back(i * 8 + j);
+        }
+      }
+    }
+  }
+  if (createFileStamps() != savedFileStamps_) {
+    // A file was completed or touched.
+    writeFile(2);
+    return;
+  }
+  auto inFlightPieces = createInFlightPieces();
+  uint64_t uploadLength = getUploadLength();
+  if (completed.empty() && inFlightPieces == savedInFlightPieces_ &&
+      uploadLength == savedUploadLength_) {
+    // We don't write control file if the content is not changed.
+    return;
+  }
+  std::string record;
+  appendUint32(record, 8 + 4 + completed.size() * 4 + inFlightPieces.size());
+  appendUint64(record, uploadLength);
+  appendUint32(record, completed.size());
+  for (auto index : completed) {
+    appendUint32(record, index);
+  }
+  record += inFlightPieces;
+  // Compact the journal into a new checkpoint once it grows larger
+  // than the checkpoint itself, so that load() stays fast.
+  if (journalLength_ + static_cast<int64_t>(record.size()) >
+      std::max(checkpointLength_, static_cast<int64_t>(1_m))) {
+    writeFile(2);
+    return;
+  }
   A2_LOG_INFO(fmt(MSG_SAVING_SEGMENT_FILE, filename_.c_str()));
-  std::string filenameTemp = filename_;
-  filenameTemp += "__temp";
   {
-    BufferedFile fp(filenameTemp.c_str(), BufferedFile::WRITE);
+    BufferedFile fp(filename_.c_str(), BufferedFile::APPEND);
     if (!fp) {
       throw DL_ABORT_EX(fmt(EX_SEGMENT_FILE_WRITE, filename_.c_str()));
     }
-
-    save(fp);
+    if (fp.write(record.data(), record.size()) != record.size() ||
+        fp.close() == EOF) {
+      // The tail of the file may be broken.  Write a checkpoint next
+      // time.
+      savedBitfield_.clear();
+      throw DL_ABORT_EX(fmt(EX_SEGMENT_FILE_WRITE, filename_.c_str()));
+    }
   }
-
   A2_LOG_INFO(MSG_SAVED_SEGMENT_FILE);
-
-  if (!File(filenameTemp).renameTo(filename_)) {
-    throw DL_ABORT_EX(fmt(EX_SEGMENT_FILE_WRITE, filename_.c_str()));
-  }
+  journalLength_ += record.size();
+  savedBitfield_.assign(reinterpret_cast<const char*>(bitfield),
+                        bitfieldLength);
+  savedInFlightPieces_ = std::move(inFlightPieces);
+  savedUploadLength_ = uploadLength;
 }
 
 #define READ_CHECK(fp, ptr, count)                                             \
@@ -226,9 +412,286 @@ void DefaultBtProgressInfoFile::save()
     throw DL_ABORT_EX(fmt(EX_SEGMENT_FILE_READ, filename_.c_str()));           \
   }
 
+std::string DefaultBtProgressInfoFile::readInFlightPieces(IOFile& fp,
+                                                          int version,
+                                                          uint32_t pieceLength)
+{
+  // Returns in-flight pieces in network byte order, so that they are
+  // handled in the same way as the ones in journal records.
+  std::string out;
+  uint32_t numInFlightPiece;
+  READ_CHECK(fp, &numInFlightPiece, sizeof(numInFlightPiece));
+  if (version >= 1) {
+    numInFlightPiece = ntohl(numInFlightPiece);
+  }
+  appendUint32(out, numInFlightPiece);
+  size_t maxBitfieldLength =
+      ((pieceLength + Piece::BLOCK_LENGTH - 1) / Piece::BLOCK_LENGTH + 7) / 8;
+  while (numInFlightPiece--) {
+    uint32_t vals[3];
+    READ_CHECK(fp, vals, sizeof(vals));
+    for (auto& v : vals) {
+      if (version >= 1) {
+        v = ntohl(v);
+      }
+      appendUint32(out, v);
+    }
+    uint32_t bitfieldLength = vals[2];
+    if (bitfieldLength > maxBitfieldLength) {
+      throw DL_ABORT_EX(
+          fmt("piece bitfield length out of range: %u", bitfieldLength));
+    }
+    auto pieceBitfield = make_unique<unsigned char[]>((size_t)bitfieldLength);
+    READ_CHECK(fp, pieceBitfield.get(), bitfieldLength);
+    out.append(reinterpret_cast<const char*>(pieceBitfield.get()),
+               bitfieldLength);
+  }
+  return out;
+}
+
+namespace {
+// Reads integers in network byte order from the journal.
+class JournalReader {
+public:
+  JournalReader(const unsigned char* first, const unsigned char* last)
+      : p_(first), last_(last)
+  {
+  }
+
+  bool readUint32(uint32_t& v)
+  {
+    if (last_ - p_ < 4) {
+      return false;
+    }
+    memcpy(&v, p_, sizeof(v));
+    v = ntohl(v);
+    p_ += 4;
+    return true;
+  }
+
+  bool readUint64(uint64_t& v)
+  {
+    if (last_ - p_ < 8) {
+      return false;
+    }
+    memcpy(&v, p_, sizeof(v));
+    v = ntoh64(v);
+    p_ += 8;
+    return true;
+  }
+
+  bool skip(size_t n)
+  {
+    if (static_cast<size_t>(last_ - p_) < n) {
+      return false;
+    }
+    p_ += n;
+    return true;
+  }
+
+  const unsigned char* pos() const { return p_; }
+
+  bool eof() const { return p_ == last_; }
+
+private:
+  const unsigned char* p_;
+  const unsigned char* last_;
+};
+} // namespace
+
+namespace {
+// Returns true if the in-flight pieces in [first, last) are well
+// formed.
+bool checkInFlightPieces(const unsigned char* first, const unsigned char* last)
+{
+  JournalReader r(first, last);
+  uint32_t num;
+  if (!r.readUint32(num)) {
+    return false;
+  }
+  while (num--) {
+    uint32_t index, length, bitfieldLength;
+    if (!r.readUint32(index) || !r.readUint32(length) ||
+        !r.readUint32(bitfieldLength) || !r.skip(bitfieldLength)) {
+      return false;
+    }
+  }
+  return r.eof();
+}
+} // namespace
+
+std::string DefaultBtProgressInfoFile::readFileStamps(IOFile& fp)
+{
+  std::string out;
+  uint32_t numFile;
+  READ_CHECK(fp, &numFile, sizeof(numFile));
+  out.append(reinterpret_cast<const char*>(&numFile), sizeof(numFile));
+  numFile = ntohl(numFile);
+  while (numFile--) {
+    char stamp[24];
+    READ_CHECK(fp, stamp, sizeof(stamp));
+    out.append(std::begin(stamp), std::end(stamp));
+  }
+  return out;
+}
+
+namespace {
+// Returns SHA-1 digest of the first |length| bytes of |filename|.
+std::string digestFileHead(const std::string& filename, int64_t length)
+{
+  BufferedFile fp(filename.c_str(), BufferedFile::READ);
+  if (!fp) {
+    return "";
+  }
+  auto sha1 = MessageDigest::sha1();
+  std::array<char, 4_k> buf;
+  while (length > 0) {
+    size_t r = fp.read(buf.data(), std::min(static_cast<int64_t>(buf.size()),
+                                            length));
+    if (r == 0) {
+      return "";
+    }
+    sha1->update(buf.data(), r);
+    length -= r;
+  }
+  return sha1->digest();
+}
+} // namespace
+
+void DefaultBtProgressInfoFile::checkFileStamps(const std::string& fileStamps)
+{
+  auto first = reinterpret_cast<const unsigned char*>(fileStamps.data());
+  JournalReader r(first, first + fileStamps.size());
+  const auto& fileEntries = dctx_->getFileEntries();
+  uint32_t numFile;
+  r.readUint32(numFile);
+  if (numFile != fileEntries.size()) {
+    return;
+  }
+  int32_t pieceLength = dctx_->getPieceLength();
+  auto unchangedPieces =
+      make_unique<BitfieldMan>(pieceLength, dctx_->getTotalLength());
+  unchangedPieces->setAllBit();
+  size_t numChanged = 0;
+  for (const auto& fileEntry : fileEntries) {
+    uint64_t savedSize, savedMtime, savedInode;
+    r.readUint64(savedSize);
+    r.readUint64(savedMtime);
+    r.readUint64(savedInode);
+    int64_t size, mtime;
+    uint64_t inode;
+    if (savedSize != static_cast<uint64_t>(NO_FILE_STAMP) &&
+        File(fileEntry->getPath()).getStamp(size, mtime, inode) &&
+        static_cast<uint64_t>(size) == savedSize &&
+        static_cast<uint64_t>(mtime) == savedMtime && inode == savedInode) {
+      continue;
+    }
+    ++numChanged;
+    if (fileEntry->getLength() > 0) {
+      unchangedPieces->unsetBitRange(
+          fileEntry->getOffset() / pieceLength,
+          (fileEntry->getLastOffset() - 1) / pieceLength);
+    }
+  }
+  A2_LOG_INFO(fmt("%lu of %lu files were changed or incomplete since %s was"
+                  " saved.",
+                  static_cast<unsigned long>(numChanged),
+                  static_cast<unsigned long>(fileEntries.size()),
+                  filename_.c_str()));
+  unchangedPieces_ = std::move(unchangedPieces);
+}
+
+bool DefaultBtProgressInfoFile::replayJournal(IOFile& fp,
+                                              unsigned char* bitfield,
+                                              uint32_t pieceLength,
+                                              uint64_t& uploadLength,
+                                              std::string& inFlightPieces)
+{
+  uint64_t numPieces = (dctx_->getTotalLength() + pieceLength - 1) /
+                       pieceLength;
+  std::vector<unsigned char> buf;
+  for (;;) {
+    uint32_t recordLength;
+    size_t rv = fp.read(&recordLength, sizeof(recordLength));
+    if (rv == 0) {
+      return true;
+    }
+    if (rv != sizeof(recordLength)) {
+      return false;
+    }
+    recordLength = ntohl(recordLength);
+    // Don't trust the length of a record torn by crash.
+    if (recordLength < 8 + 4 + 4 || recordLength > 4 * numPieces + 1_m) {
+      return false;
+    }
+    buf.resize(recordLength);
+    if (fp.read(buf.data(), buf.size()) != buf.size()) {
+      return false;
+    }
+    JournalReader r(buf.data(), buf.data() + buf.size());
+    uint64_t upload;
+    uint32_t numCompleted;
+    r.readUint64(upload);
+    r.readUint32(numCompleted);
+    auto indexPos = r.pos();
+    if (!r.skip(static_cast<size_t>(numCompleted) * 4) ||
+        !checkInFlightPieces(r.pos(), buf.data() + buf.size())) {
+      return false;
+    }
+    JournalReader indexReader(indexPos, r.pos());
+    uint32_t index;
+    while (indexReader.readUint32(index)) {
+      if (index >= numPieces) {
+        return false;
+      }
+      bitfield[index / 8] |= 0x80u >> (index % 8);
+    }
+    uploadLength = upload;
+    inFlightPieces.assign(reinterpret_cast<const char*>(r.pos()),
+                          buf.data() + buf.size() - r.pos());
+  }
+}
+
+std::vector<std::shared_ptr<Piece>>
+DefaultBtProgressInfoFile::createInFlightPieceList(const std::string& data)
+{
+  auto first = reinterpret_cast<const unsigned char*>(data.data());
+  JournalReader r(first, first + data.size());
+  uint32_t numInFlightPiece;
+  r.readUint32(numInFlightPiece);
+  std::vector<std::shared_ptr<Piece>> inFlightPieces;
+  inFlightPieces.reserve(numInFlightPiece);
+  while (numInFlightPiece--) {
+    uint32_t index, length, bitfieldLength;
+    r.readUint32(index);
+    r.readUint32(length);
+    r.readUint32(bitfieldLength);
+    if (!(index < dctx_->getNumPieces())) {
+      throw DL_ABORT_EX(fmt("piece index out of range: %u", index));
+    }
+    if (!(length <= static_cast<uint32_t>(dctx_->getPieceLength()))) {
+      throw DL_ABORT_EX(fmt("piece length out of range: %u", length));
+    }
+    auto piece = std::make_shared<Piece>(index, length);
+    if (piece->getBitfieldLength() != bitfieldLength) {
+      throw DL_ABORT_EX(
+          fmt("piece bitfield length mismatch."
+              " expected: %lu actual: %u",
+              static_cast<unsigned long>(piece->getBitfieldLength()),
+              bitfieldLength));
+    }
+    piece->setBitfield(r.pos(), bitfieldLength);
+    r.skip(bitfieldLength);
+    piece->setHashType(dctx_->getPieceHashType());
+
+    inFlightPieces.push_back(piece);
+  }
+  return inFlightPieces;
+}
+
 // It is assumed that integers are saved as:
 // 1) host byte order if version == 0000
-// 2) network byte order if version == 0001
+// 2) network byte order if version == 0001 or 0002
 void DefaultBtProgressInfoFile::load()
 {
   A2_LOG_INFO(fmt(MSG_LOADING_SEGMENT_FILE, filename_.c_str()));
@@ -246,6 +709,9 @@ void DefaultBtProgressInfoFile::load()
   else if ("0001" == versionHex) {
     version = 1;
   }
+  else if ("0002" == versionHex) {
+    version = 2;
+  }
   else {
     throw DL_ABORT_EX(
         fmt("Unsupported ctrl file version: %s", versionHex.c_str()));
@@ -304,11 +770,6 @@ void DefaultBtProgressInfoFile::load()
   if (version >= 1) {
     uploadLength = ntoh64(uploadLength);
   }
-#ifdef ENABLE_BITTORRENT
-  if (isTorrentDownload()) {
-    btRuntime_->setUploadLengthAtStartup(uploadLength);
-  }
-#endif // ENABLE_BITTORRENT
   // TODO implement the conversion mechanism between different piece length.
   uint32_t bitfieldLength;
   READ_CHECK(fp, &bitfieldLength, sizeof(bitfieldLength));
@@ -324,61 +785,75 @@ void DefaultBtProgressInfoFile::load()
 
   auto savedBitfield = make_unique<unsigned char[]>((size_t)bitfieldLength);
   READ_CHECK(fp, savedBitfield.get(), bitfieldLength);
-  if (pieceLength == static_cast<uint32_t>(dctx_->getPieceLength())) {
-    pieceStorage_->setBitfield(savedBitfield.get(), bitfieldLength);
-
-    uint32_t numInFlightPiece;
+  bool samePieceLength =
+      pieceLength == static_cast<uint32_t>(dctx_->getPieceLength());
+  std::string inFlightPieces;
+  uint32_t numInFlightPiece;
+  if (samePieceLength || version == 2) {
+    // The in-flight pieces must be read through to reach the journal
+    // records, even if they are not used.
+    inFlightPieces = readInFlightPieces(fp, version, pieceLength);
+    memcpy(&numInFlightPiece, inFlightPieces.data(), sizeof(numInFlightPiece));
+    numInFlightPiece = ntohl(numInFlightPiece);
+  }
+  else {
     READ_CHECK(fp, &numInFlightPiece, sizeof(numInFlightPiece));
     if (version >= 1) {
       numInFlightPiece = ntohl(numInFlightPiece);
     }
-    std::vector<std::shared_ptr<Piece>> inFlightPieces;
-    inFlightPieces.reserve(numInFlightPiece);
-    while (numInFlightPiece--) {
-      uint32_t index;
-      READ_CHECK(fp, &index, sizeof(index));
-      if (version >= 1) {
-        index = ntohl(index);
-      }
-      if (!(index < dctx_->getNumPieces())) {
-        throw DL_ABORT_EX(fmt("piece index out of range: %u", index));
-      }
-      uint32_t length;
-      READ_CHECK(fp, &length, sizeof(length));
-      if (version >= 1) {
-        length = ntohl(length);
-      }
-      if (!(length <= static_cast<uint32_t>(dctx_->getPieceLength()))) {
-        throw DL_ABORT_EX(fmt("piece length out of range: %u", length));
-      }
-      auto piece = std::make_shared<Piece>(index, length);
-      uint32_t bitfieldLength;
-      READ_CHECK(fp, &bitfieldLength, sizeof(bitfieldLength));
-      if (version >= 1) {
-        bitfieldLength = ntohl(bitfieldLength);
-      }
-      if (piece->getBitfieldLength() != bitfieldLength) {
-        throw DL_ABORT_EX(
-            fmt("piece bitfield length mismatch."
-                " expected: %lu actual: %u",
-                static_cast<unsigned long>(piece->getBitfieldLength()),
-                bitfieldLength));
-      }
-      auto pieceBitfield = make_unique<unsigned char[]>((size_t)bitfieldLength);
-      READ_CHECK(fp, pieceBitfield.get(), bitfieldLength);
-      piece->setBitfield(pieceBitfield.get(), bitfieldLength);
-      piece->setHashType(dctx_->getPieceHashType());
-
-      inFlightPieces.push_back(piece);
+  }
+  int64_t checkpointLength =
+      2 + 4 + 4 + infoHashLength + 4 + 8 + 8 + 4 + bitfieldLength +
+      inFlightPieces.size();
+  std::string fileStamps;
+  if ((samePieceLength || version == 2) && (extension[3] & 2)) {
+    fileStamps = readFileStamps(fp);
+    checkpointLength += fileStamps.size() + 20;
+    unsigned char digest[20];
+    READ_CHECK(fp, digest, sizeof(digest));
+    if (digestFileHead(filename_, checkpointLength - sizeof(digest)) !=
+        std::string(std::begin(digest), std::end(digest))) {
+      A2_LOG_NOTICE(fmt("The digest of the control file %s does not match."
+                        " File stamps were ignored.",
+                        filename_.c_str()));
+      fileStamps.clear();
     }
-    pieceStorage_->addInFlightPiece(inFlightPieces);
   }
-  else {
-    uint32_t numInFlightPiece;
-    READ_CHECK(fp, &numInFlightPiece, sizeof(numInFlightPiece));
-    if (version >= 1) {
-      numInFlightPiece = ntohl(numInFlightPiece);
+  bool journalOk = true;
+  if (version == 2) {
+    journalOk = replayJournal(fp, savedBitfield.get(), pieceLength,
+                              uploadLength, inFlightPieces);
+    if (!journalOk) {
+      A2_LOG_NOTICE(fmt("The control file %s ends with a broken record."
+                        " The record was ignored.",
+                        filename_.c_str()));
     }
+    memcpy(&numInFlightPiece, inFlightPieces.data(), sizeof(numInFlightPiece));
+    numInFlightPiece = ntohl(numInFlightPiece);
+  }
+#ifdef ENABLE_BITTORRENT
+  if (isTorrentDownload()) {
+    btRuntime_->setUploadLengthAtStartup(uploadLength);
+  }
+#endif // ENABLE_BITTORRENT
+  if (samePieceLength) {
+    pieceStorage_->setBitfield(savedBitfield.get(), bitfieldLength);
+    pieceStorage_->addInFlightPiece(createInFlightPieceList(inFlightPieces));
+    if (!fileStamps.empty()) {
+      checkFileStamps(fileStamps);
+    }
+    if (version == 2 && journalOk) {
+      // Continue the journal of the loaded file.
+      savedBitfield_.assign(reinterpret_cast<const char*>(savedBitfield.get()),
+                            bitfieldLength);
+      savedInFlightPieces_ = std::move(inFlightPieces);
+      savedUploadLength_ = uploadLength;
+      savedFileStamps_ = std::move(fileStamps);
+      checkpointLength_ = checkpointLength;
+      journalLength_ = File(filename_).size() - checkpointLength;
+    }
+  }
+  else {
     BitfieldMan src(pieceLength, totalLength);
     src.setBitfield(savedBitfield.get(), bitfieldLength);
     if ((src.getCompletedLength() || numInFlightPiece) &&
@@ -398,6 +873,7 @@ void DefaultBtProgressInfoFile::load()
 
 void DefaultBtProgressInfoFile::removeFile()
 {
+  savedBitfield_.clear();
   if (exists()) {
     File f(filename_);
     f.remove();
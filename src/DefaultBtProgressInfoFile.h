@@ -38,6 +38,8 @@
 #include "BtProgressInfoFile.h"
 
 #include <memory>
+#include <string>
+#include <vector>
 
 namespace aria2 {
 
@@ -47,6 +49,8 @@ class PeerStorage;
 class BtRuntime;
 class Option;
 class IOFile;
+class Piece;
+class BitfieldMan;
 
 class DefaultBtProgressInfoFile : public BtProgressInfoFile {
 private:
@@ -62,9 +66,46 @@ private:
   // is empty string.  This is used to avoid to write same content
   // repeatedly, which could wake up disk that may be sleeping.
   std::string lastDigest_;
+  // State last written to the journaled control file (version 2).
+  // savedBitfield_ is empty until a checkpoint is written or loaded,
+  // which means the next save writes a checkpoint.
+  std::string savedBitfield_;
+  std::string savedInFlightPieces_;
+  uint64_t savedUploadLength_;
+  std::string savedFileStamps_;
+  // Length of the checkpoint and of the records appended after it.
+  int64_t checkpointLength_;
+  int64_t journalLength_;
+  // Pieces in the files whose stamps matched on load.
+  std::unique_ptr<BitfieldMan> unchangedPieces_;
 
   bool isTorrentDownload();
-  void save(IOFile& fp);
+  uint64_t getUploadLength();
+  // Returns the in-flight pieces in the layout of control file.
+  std::string createInFlightPieces();
+  // Returns the file stamps in the layout of control file, without
+  // digest.
+  std::string createFileStamps();
+  void save(IOFile& fp, int version);
+  // Writes the whole control file in |version| format through a
+  // temporary file.
+  void writeFile(int version);
+  void saveJournal();
+  // Reads in-flight pieces written in |version| format and returns
+  // them in the layout of version 0002.
+  std::string readInFlightPieces(IOFile& fp, int version,
+                                 uint32_t pieceLength);
+  std::vector<std::shared_ptr<Piece>>
+  createInFlightPieceList(const std::string& data);
+  std::string readFileStamps(IOFile& fp);
+  // Compares |fileStamps| with the files on disk and sets
+  // unchangedPieces_.
+  void checkFileStamps(const std::string& fileStamps);
+  // Applies the journal records following the checkpoint.  Returns
+  // false if the journal ends with a broken record.
+  bool replayJournal(IOFile& fp, unsigned char* bitfield,
+                     uint32_t pieceLength, uint64_t& uploadLength,
+                     std::string& inFlightPieces);
 
 public:
   DefaultBtProgressInfoFile(const std::shared_ptr<DownloadContext>& btContext,
@@ -86,6 +127,11 @@ public:
   // re-set filename using current dctx_.
   virtual void updateFilename() CXX11_OVERRIDE;
 
+  virtual const BitfieldMan* getUnchangedPieces() CXX11_OVERRIDE
+  {
+    return unchangedPieces_.get();
+  }
+
 #ifdef ENABLE_BITTORRENT
   // for torrents
   void setPeerStorage(const std::shared_ptr<PeerStorage>& peerStorage);
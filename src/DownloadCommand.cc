@@ -60,6 +60,8 @@
 #include "RequestGroupMan.h"
 #include "wallclock.h"
 #include "SinkStreamFilter.h"
+#include "InlineChecksumValidator.h"
+#include "RateLimiter.h"
 #include "FileEntry.h"
 #include "SocketRecvBuffer.h"
 #include "Piece.h"
@@ -67,12 +69,19 @@
 #include "DownloadFailureException.h"
 #include "MessageDigest.h"
 #include "message_digest_helper.h"
+#include "ServerStat.h"
 #ifdef ENABLE_BITTORRENT
 #include "bittorrent_helper.h"
 #endif // ENABLE_BITTORRENT
 
 namespace aria2 {
 
+namespace {
+// The maximum number of bytes read back from disk by
+// InlineChecksumValidator per completed segment.
+const int64_t INLINE_CHECKSUM_CATCH_UP_LENGTH = 4_m;
+} // namespace
+
 DownloadCommand::DownloadCommand(
     cuid_t cuid, const std::shared_ptr<Request>& req,
     const std::shared_ptr<FileEntry>& fileEntry, RequestGroup* requestGroup,
@@ -82,6 +91,7 @@ DownloadCommand::DownloadCommand(
                       socketRecvBuffer),
       startupIdleTime_(10),
       lowestDownloadSpeedLimit_(0),
+      wrCacheBufCapacity_(0),
       pieceHashValidationEnabled_(false)
 {
   {
@@ -94,21 +104,42 @@ DownloadCommand::DownloadCommand(
     }
   }
 
-  peerStat_ = req->initPeerStat();
+  peerStat_ = req->initPeerStat(cuid);
   peerStat_->downloadStart();
   getSegmentMan()->registerPeerStat(peerStat_);
 
-  streamFilter_ = make_unique<SinkStreamFilter>(
+  rateLimiter_ =
+      make_unique<RateLimiter>(getRequestGroup()->getDownloadLimiter());
+
+  getRequestGroup()->initInlineChecksumValidator();
+  inlineChecksumValidator_ = getRequestGroup()->getInlineChecksumValidator();
+
+  auto sinkFilter = make_unique<SinkStreamFilter>(
       getPieceStorage()->getWrDiskCache(), pieceHashValidationEnabled_);
+  sinkFilter->setInlineChecksumValidator(inlineChecksumValidator_);
+  streamFilter_ = std::move(sinkFilter);
   streamFilter_->init();
   sinkFilterOnly_ = true;
   checkSocketRecvBuffer();
 }
 
+namespace {
+// Sessions shorter than this are not fed to the performance model,
+// because their speed is dominated by latency.
+constexpr uint64_t MODEL_MIN_SESSION_LENGTH = 64_k;
+} // namespace
+
 DownloadCommand::~DownloadCommand()
 {
   peerStat_->downloadStop();
   getSegmentMan()->updateFastestPeerStat(peerStat_);
+  if (peerStat_->getSessionDownloadLength() >= MODEL_MIN_SESSION_LENGTH &&
+      peerStat_->getAvgDownloadSpeed() > 0) {
+    auto ss = getModelServerStat();
+    if (ss) {
+      ss->updateEwmaSpeed(peerStat_->getAvgDownloadSpeed());
+    }
+  }
 }
 
 namespace {
@@ -132,68 +163,52 @@ void flushWrDiskCacheEntry(WrDiskCache* wrDiskCache,
 
 bool DownloadCommand::executeInternal()
 {
-  if (getDownloadEngine()
-          ->getRequestGroupMan()
-          ->doesOverallDownloadSpeedExceed() ||
-      getRequestGroup()->doesDownloadSpeedExceed()) {
+  if (rateLimiter_->limited() && rateLimiter_->getAllowance(16_k) == 0) {
+    // Come back as soon as the tokens are refilled, rather than at
+    // the next regular refresh.
+    getDownloadEngine()->shortenRefreshInterval(rateLimiter_->getWaitTime());
     addCommandSelf();
     disableReadCheckSocket();
     disableWriteCheckSocket();
     return false;
   }
   setReadCheckSocket(getSocket());
+  getRequestGroup()->updateConnectionControl(getDownloadEngine());
 
   const std::shared_ptr<DiskAdaptor>& diskAdaptor =
       getPieceStorage()->getDiskAdaptor();
   std::shared_ptr<Segment> segment = getSegments().front();
-  bool eof = false;
-  if (getSocketRecvBuffer()->bufferEmpty()) {
-    // Only read from socket when buffer is empty.  Imagine that When
-    // segment length is *short* and we are using HTTP pilelining.  We
-    // issued 2 requests in pipeline. When reading first response
-    // header, we may read its response body and 2nd response header
-    // and 2nd response body in buffer if they are small enough to fit
-    // in buffer. And then server may sends EOF.  In this case, we
-    // read data from socket here, we will get EOF and leaves 2nd
-    // response unprocessed.  To prevent this, we don't read from
-    // socket when buffer is not empty.
-    eof = getSocketRecvBuffer()->recv() == 0 && !getSocket()->wantRead() &&
-          !getSocket()->wantWrite();
+  bool eof;
+  if (canReceiveToWrCache(segment)) {
+    size_t bufSize = 0;
+    eof = receiveToWrCache(segment, bufSize);
+    rateLimiter_->consume(bufSize);
+    peerStat_->updateDownload(bufSize);
+    getDownloadContext()->updateDownload(bufSize);
   }
-  if (!eof) {
+  else if (!(eof = receiveData())) {
     size_t bufSize;
     if (sinkFilterOnly_) {
       if (segment->getLength() > 0) {
-        if (segment->getPosition() + segment->getLength() <=
-            getFileEntry()->getLastOffset()) {
-          bufSize = std::min(static_cast<size_t>(segment->getLength() -
-                                                 segment->getWrittenLength()),
-                             getSocketRecvBuffer()->getBufferLength());
-        }
-        else {
-          bufSize =
-              std::min(static_cast<size_t>(getFileEntry()->getLastOffset() -
-                                           segment->getPositionToWrite()),
-                       getSocketRecvBuffer()->getBufferLength());
-        }
+        bufSize = std::min(getSegmentSpace(segment), getReceivedDataLength());
       }
       else {
-        bufSize = getSocketRecvBuffer()->getBufferLength();
+        bufSize = getReceivedDataLength();
       }
-      streamFilter_->transform(diskAdaptor, segment,
-                               getSocketRecvBuffer()->getBuffer(), bufSize);
+      streamFilter_->transform(diskAdaptor, segment, getReceivedData(),
+                               bufSize);
     }
     else {
       // It is possible that segment is completed but we have some bytes
       // of stream to read. For example, chunked encoding has "0"+CRLF
       // after data. After we read data(at this moment segment is
       // completed), we need another 3bytes(or more if it has trailers).
-      streamFilter_->transform(diskAdaptor, segment,
-                               getSocketRecvBuffer()->getBuffer(),
-                               getSocketRecvBuffer()->getBufferLength());
+      streamFilter_->transform(diskAdaptor, segment, getReceivedData(),
+                               getReceivedDataLength());
       bufSize = streamFilter_->getBytesProcessed();
     }
-    getSocketRecvBuffer()->drain(bufSize);
+    drainReceivedData(bufSize);
+    rateLimiter_->consume(bufSize);
     peerStat_->updateDownload(bufSize);
     getDownloadContext()->updateDownload(bufSize);
   }
@@ -299,6 +314,108 @@ bool DownloadCommand::shouldEnableWriteCheck()
   return getSocket()->wantWrite();
 }
 
+bool DownloadCommand::receiveData()
+{
+  if (!getSocketRecvBuffer()->bufferEmpty()) {
+    return false;
+  }
+  // Only read from socket when buffer is empty.  Imagine that When
+  // segment length is *short* and we are using HTTP pilelining.  We
+  // issued 2 requests in pipeline. When reading first response
+  // header, we may read its response body and 2nd response header
+  // and 2nd response body in buffer if they are small enough to fit
+  // in buffer. And then server may sends EOF.  In this case, we
+  // read data from socket here, we will get EOF and leaves 2nd
+  // response unprocessed.  To prevent this, we don't read from
+  // socket when buffer is not empty.
+  return getSocketRecvBuffer()->recv() == 0 && !getSocket()->wantRead() &&
+         !getSocket()->wantWrite();
+}
+
+size_t
+DownloadCommand::getSegmentSpace(const std::shared_ptr<Segment>& segment) const
+{
+  if (segment->getPosition() + segment->getLength() <=
+      getFileEntry()->getLastOffset()) {
+    return segment->getLength() - segment->getWrittenLength();
+  }
+  return getFileEntry()->getLastOffset() - segment->getPositionToWrite();
+}
+
+bool DownloadCommand::canReceiveToWrCache(
+    const std::shared_ptr<Segment>& segment) const
+{
+  return sinkFilterOnly_ && getSocketRecvBuffer() &&
+         getSocketRecvBuffer()->bufferEmpty() && segment->getLength() > 0 &&
+         segment->getPiece()->getWrDiskCacheEntry() &&
+         getSegmentSpace(segment) > 0;
+}
+
+bool DownloadCommand::receiveToWrCache(const std::shared_ptr<Segment>& segment,
+                                       size_t& bufSize)
+{
+  WrDiskCache* wrDiskCache = getPieceStorage()->getWrDiskCache();
+  const std::shared_ptr<Piece>& piece = segment->getPiece();
+  size_t maxlen = getSegmentSpace(segment);
+  if (rateLimiter_->limited()) {
+    // Keep the granularity of reads same as SocketRecvBuffer so that
+    // speed limit works smoothly.
+    maxlen = std::min(maxlen, static_cast<size_t>(16_k));
+  }
+  int64_t goff = segment->getPositionToWrite();
+  auto appendBuf = piece->getWrCacheAppendBuffer(goff);
+  unsigned char* buf;
+  size_t n;
+  if (appendBuf.second > 0) {
+    buf = appendBuf.first;
+    n = std::min(maxlen, appendBuf.second);
+  }
+  else {
+    if (!wrCacheBuf_) {
+      wrCacheBufCapacity_ = std::min(maxlen, static_cast<size_t>(256_k));
+      // Not value-initialized; it is overwritten by readData().
+      wrCacheBuf_.reset(new unsigned char[wrCacheBufCapacity_]);
+    }
+    buf = wrCacheBuf_.get();
+    n = std::min(maxlen, wrCacheBufCapacity_);
+  }
+  getSocket()->readData(buf, n);
+  bufSize = n;
+  if (n == 0) {
+    return !getSocket()->wantRead() && !getSocket()->wantWrite();
+  }
+  if (appendBuf.second > 0) {
+    piece->commitWrCacheAppend(wrDiskCache, n);
+  }
+  else {
+    piece->updateWrCache(wrDiskCache, wrCacheBuf_.release(), 0, n,
+                         wrCacheBufCapacity_, goff);
+  }
+  if (pieceHashValidationEnabled_) {
+    segment->updateHash(segment->getWrittenLength(), buf, n);
+  }
+  if (inlineChecksumValidator_) {
+    inlineChecksumValidator_->update(buf, n, goff);
+  }
+  segment->updateWrittenLength(n);
+  return false;
+}
+
+const unsigned char* DownloadCommand::getReceivedData() const
+{
+  return getSocketRecvBuffer()->getBuffer();
+}
+
+size_t DownloadCommand::getReceivedDataLength() const
+{
+  return getSocketRecvBuffer()->getBufferLength();
+}
+
+void DownloadCommand::drainReceivedData(size_t len)
+{
+  getSocketRecvBuffer()->drain(len);
+}
+
 void DownloadCommand::checkLowestDownloadSpeed() const
 {
   if (lowestDownloadSpeedLimit_ > 0 &&
@@ -327,7 +444,8 @@ bool DownloadCommand::prepareForNextSegment()
         getFileEntry()->setLength(getPieceStorage()->getCompletedLength());
       }
     }
-    if (getDownloadContext()->getPieceHashType().empty()) {
+    // The checksum may have been verified while downloading.
+    if (getDownloadContext()->isChecksumVerificationNeeded()) {
       auto entry = make_unique<ChecksumCheckIntegrityEntry>(getRequestGroup());
       if (entry->isValidationReady()) {
         entry->initValidator();
@@ -405,6 +523,11 @@ void DownloadCommand::completeSegment(cuid_t cuid,
 {
   flushWrDiskCacheEntry(getPieceStorage()->getWrDiskCache(), segment);
   getSegmentMan()->completeSegment(cuid, segment);
+  if (inlineChecksumValidator_) {
+    // Hash the pieces completed out of order in small steps so that
+    // the event loop is not blocked.
+    inlineChecksumValidator_->catchUp(INLINE_CHECKSUM_CATCH_UP_LENGTH);
+  }
 }
 
 void DownloadCommand::installStreamFilter(
@@ -44,19 +44,34 @@ namespace aria2 {
 class PeerStat;
 class StreamFilter;
 class MessageDigest;
+class InlineChecksumValidator;
+class RateLimiter;
 
 class DownloadCommand : public AbstractCommand {
 private:
   std::shared_ptr<PeerStat> peerStat_;
 
+  // Per connection node of download speed limit hierarchy.
+  std::unique_ptr<RateLimiter> rateLimiter_;
+
   std::unique_ptr<StreamFilter> streamFilter_;
 
   std::unique_ptr<MessageDigest> messageDigest_;
 
+  // Computes whole file checksum from the received data.  nullptr
+  // if it is not used.
+  std::shared_ptr<InlineChecksumValidator> inlineChecksumValidator_;
+
   std::chrono::seconds startupIdleTime_;
 
   int lowestDownloadSpeedLimit_;
 
+  // Buffer which is handed over to the write disk cache once it is
+  // filled with the data read from socket.
+  std::unique_ptr<unsigned char[]> wrCacheBuf_;
+
+  size_t wrCacheBufCapacity_;
+
   bool pieceHashValidationEnabled_;
 
   bool sinkFilterOnly_;
@@ -67,6 +82,21 @@ private:
 
   void checkLowestDownloadSpeed() const;
 
+  // Returns the number of bytes which can be written to |segment|.
+  // segment->getLength() must be greater than 0.
+  size_t getSegmentSpace(const std::shared_ptr<Segment>& segment) const;
+
+  // Returns true if the data can be read from socket directly into
+  // the write disk cache of |segment|.
+  bool canReceiveToWrCache(const std::shared_ptr<Segment>& segment) const;
+
+  // Reads data from socket directly into the write disk cache of
+  // |segment|, bypassing SocketRecvBuffer and StreamFilter.  The
+  // number of bytes read is assigned to |bufSize|.  Returns true if
+  // the remote endpoint closed the connection.
+  bool receiveToWrCache(const std::shared_ptr<Segment>& segment,
+                        size_t& bufSize);
+
   void completeSegment(cuid_t cuid, const std::shared_ptr<Segment>& segment);
 
 protected:
@@ -82,6 +112,20 @@ protected:
   // getSocket()->wantWrite().
   virtual bool shouldEnableWriteCheck();
 
+  // Receives data from the remote endpoint if the received data are
+  // all processed.  Returns true if the remote endpoint closed the
+  // connection.  The default implementation reads socket into
+  // SocketRecvBuffer.
+  virtual bool receiveData();
+
+  // Returns the received data which are not processed yet.
+  virtual const unsigned char* getReceivedData() const;
+
+  virtual size_t getReceivedDataLength() const;
+
+  // Discards first |len| bytes of the received data.
+  virtual void drainReceivedData(size_t len);
+
 public:
   DownloadCommand(cuid_t cuid, const std::shared_ptr<Request>& req,
                   const std::shared_ptr<FileEntry>& fileEntry,
@@ -73,6 +73,9 @@
 #ifdef ENABLE_WEBSOCKET
 #include "WebSocketSessionMan.h"
 #endif // ENABLE_WEBSOCKET
+#ifdef ENABLE_HTTP2
+#include "Http2Session.h"
+#endif // ENABLE_HTTP2
 #include "Option.h"
 #include "util_security.h"
 
@@ -311,6 +314,18 @@ void DownloadEngine::poolSocket(const std::string& key,
 
 void DownloadEngine::evictSocketPool()
 {
+#ifdef ENABLE_HTTP2
+  for (auto i = std::begin(http2Sessions_); i != std::end(http2Sessions_);) {
+    if ((*i).second->isIdleTimeout(15_s)) {
+      A2_LOG_DEBUG(
+          fmt("Closing idle HTTP/2 session to %s", (*i).first.c_str()));
+      i = http2Sessions_.erase(i);
+    }
+    else {
+      ++i;
+    }
+  }
+#endif // ENABLE_HTTP2
   if (socketPool_.empty()) {
     return;
   }
@@ -553,6 +568,36 @@ void DownloadEngine::removeCachedIPAddress(const std::string& hostname,
   dnsCache_->remove(hostname, port);
 }
 
+#ifdef ENABLE_HTTP2
+namespace {
+std::string createHttp2SessionKey(const std::string& hostname, uint16_t port)
+{
+  return fmt("%s:%u", hostname.c_str(), port);
+}
+} // namespace
+
+std::shared_ptr<Http2Session>
+DownloadEngine::findHttp2Session(const std::string& hostname, uint16_t port)
+{
+  auto i = http2Sessions_.find(createHttp2SessionKey(hostname, port));
+  if (i == std::end(http2Sessions_)) {
+    return nullptr;
+  }
+  auto& session = (*i).second;
+  if (!session->canSubmitRequest()) {
+    return nullptr;
+  }
+  return session;
+}
+
+void DownloadEngine::addHttp2Session(
+    const std::string& hostname, uint16_t port,
+    const std::shared_ptr<Http2Session>& session)
+{
+  http2Sessions_[createHttp2SessionKey(hostname, port)] = session;
+}
+#endif // ENABLE_HTTP2
+
 void DownloadEngine::setAuthConfigFactory(
     std::unique_ptr<AuthConfigFactory> factory)
 {
@@ -575,6 +620,11 @@ void DownloadEngine::setRefreshInterval(std::chrono::milliseconds interval)
   refreshInterval_ = std::move(interval);
 }
 
+void DownloadEngine::shortenRefreshInterval(std::chrono::milliseconds interval)
+{
+  refreshInterval_ = std::min(refreshInterval_, interval);
+}
+
 void DownloadEngine::addCommand(std::vector<std::unique_ptr<Command>> commands)
 {
   commands_.insert(commands_.end(),
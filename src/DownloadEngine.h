@@ -68,6 +68,9 @@ class Command;
 #ifdef ENABLE_BITTORRENT
 class BtRegistry;
 #endif // ENABLE_BITTORRENT
+#ifdef ENABLE_HTTP2
+class Http2Session;
+#endif // ENABLE_HTTP2
 #ifdef ENABLE_WEBSOCKET
 namespace rpc {
 class WebSocketSessionMan;
@@ -145,6 +148,13 @@ private:
 
   std::unique_ptr<AuthConfigFactory> authConfigFactory_;
 
+#ifdef ENABLE_HTTP2
+  // key = hostname:port, value = HTTP/2 session.  Sessions without
+  // stream are kept for the next request like pooled sockets, and
+  // evicted in evictSocketPool().
+  std::map<std::string, std::shared_ptr<Http2Session>> http2Sessions_;
+#endif // ENABLE_HTTP2
+
 #ifdef ENABLE_WEBSOCKET
   std::unique_ptr<rpc::WebSocketSessionMan> webSocketSessionMan_;
 #endif // ENABLE_WEBSOCKET
@@ -318,12 +328,18 @@ public:
 
   void removeCachedIPAddress(const std::string& hostname, uint16_t port);
 
+  const std::unique_ptr<DNSCache>& getDNSCache() const { return dnsCache_; }
+
   void setAuthConfigFactory(std::unique_ptr<AuthConfigFactory> factory);
 
   const std::unique_ptr<AuthConfigFactory>& getAuthConfigFactory() const;
 
   void setRefreshInterval(std::chrono::milliseconds interval);
 
+  // Sets refresh interval to |interval| if it is shorter than the
+  // current one.
+  void shortenRefreshInterval(std::chrono::milliseconds interval);
+
   const std::string getSessionId() const { return sessionId_; }
 
 #ifdef HAVE_ARES_ADDR_NODE
@@ -332,6 +348,16 @@ public:
   ares_addr_node* getAsyncDNSServers() const { return asyncDNSServers_; }
 #endif // HAVE_ARES_ADDR_NODE
 
+#ifdef ENABLE_HTTP2
+  // Returns HTTP/2 session to |hostname|:|port| which can accept new
+  // request, or nullptr if there is no such session.
+  std::shared_ptr<Http2Session> findHttp2Session(const std::string& hostname,
+                                                 uint16_t port);
+
+  void addHttp2Session(const std::string& hostname, uint16_t port,
+                       const std::shared_ptr<Http2Session>& session);
+#endif // ENABLE_HTTP2
+
 #ifdef ENABLE_WEBSOCKET
   void setWebSocketSessionMan(std::unique_ptr<rpc::WebSocketSessionMan> wsman);
   const std::unique_ptr<rpc::WebSocketSessionMan>&
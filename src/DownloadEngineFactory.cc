@@ -194,29 +194,41 @@ std::unique_ptr<DownloadEngine> DownloadEngineFactory::newDownloadEngine(
         make_unique<WatchProcessCommand>(e->newCUID(), e.get(), pid));
   }
   if (op->getAsBool(PREF_ENABLE_RPC)) {
-    if (op->get(PREF_RPC_SECRET).empty() && op->get(PREF_RPC_USER).empty()) {
-      A2_LOG_WARN("Neither --rpc-secret nor a combination of --rpc-user and "
-                  "--rpc-passwd is set. This is insecure. It is extremely "
-                  "recommended to specify --rpc-secret with the adequate "
-                  "secrecy or now deprecated --rpc-user and --rpc-passwd.");
-    }
-    bool ok = false;
     bool secure = op->getAsBool(PREF_RPC_SECURE);
     if (secure) {
       A2_LOG_NOTICE("RPC transport will be encrypted.");
     }
-    static int families[] = {AF_INET, AF_INET6};
-    size_t familiesLength = op->getAsBool(PREF_DISABLE_IPV6) ? 1 : 2;
-    for (size_t i = 0; i < familiesLength; ++i) {
+    if (!op->blank(PREF_RPC_LISTEN_UNIX)) {
+      // The access to the Unix domain socket is controlled by its
+      // file permission, so TCP ports are not opened.
       auto httpListenCommand = make_unique<HttpListenCommand>(
-          e->newCUID(), e.get(), families[i], secure);
-      if (httpListenCommand->bindPort(op->getAsInt(PREF_RPC_LISTEN_PORT))) {
-        e->addCommand(std::move(httpListenCommand));
-        ok = true;
+          e->newCUID(), e.get(), AF_UNIX, secure);
+      if (!httpListenCommand->bindPath(op->get(PREF_RPC_LISTEN_UNIX))) {
+        throw DL_ABORT_EX("Failed to setup RPC server.");
       }
+      e->addCommand(std::move(httpListenCommand));
     }
-    if (!ok) {
-      throw DL_ABORT_EX("Failed to setup RPC server.");
+    else {
+      if (op->get(PREF_RPC_SECRET).empty() && op->get(PREF_RPC_USER).empty()) {
+        A2_LOG_WARN("Neither --rpc-secret nor a combination of --rpc-user and "
+                    "--rpc-passwd is set. This is insecure. It is extremely "
+                    "recommended to specify --rpc-secret with the adequate "
+                    "secrecy or now deprecated --rpc-user and --rpc-passwd.");
+      }
+      bool ok = false;
+      static int families[] = {AF_INET, AF_INET6};
+      size_t familiesLength = op->getAsBool(PREF_DISABLE_IPV6) ? 1 : 2;
+      for (size_t i = 0; i < familiesLength; ++i) {
+        auto httpListenCommand = make_unique<HttpListenCommand>(
+            e->newCUID(), e.get(), families[i], secure);
+        if (httpListenCommand->bindPort(op->getAsInt(PREF_RPC_LISTEN_PORT))) {
+          e->addCommand(std::move(httpListenCommand));
+          ok = true;
+        }
+      }
+      if (!ok) {
+        throw DL_ABORT_EX("Failed to setup RPC server.");
+      }
     }
   }
   return e;
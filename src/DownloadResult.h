@@ -51,6 +51,7 @@ namespace aria2 {
 class Option;
 class FileEntry;
 class MetadataInfo;
+struct SessionEntry;
 
 struct DownloadResult {
   // This field contains GID. See comment in
@@ -95,6 +96,10 @@ struct DownloadResult {
 
   bool inMemoryDownload;
 
+  // Serialized form of this download in a session file.  It is
+  // created when the session is saved first time.
+  std::shared_ptr<SessionEntry> sessionEntry;
+
   DownloadResult();
   ~DownloadResult();
 
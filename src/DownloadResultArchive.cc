@@ -0,0 +1,512 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2015 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "DownloadResultArchive.h"
+
+#include <cstring>
+#include <cassert>
+#include <algorithm>
+
+#include "DownloadResult.h"
+#include "FileEntry.h"
+#include "Option.h"
+#include "DefaultDiskWriter.h"
+#include "RecoverableException.h"
+#include "LogFactory.h"
+#include "Logger.h"
+#include "fmt.h"
+#include "util.h"
+#include "a2functional.h"
+
+namespace aria2 {
+
+namespace {
+void appendUint32(std::string& out, uint32_t x)
+{
+  x = htonl(x);
+  out.append(reinterpret_cast<const char*>(&x), sizeof(x));
+}
+} // namespace
+
+namespace {
+void appendUint64(std::string& out, uint64_t x)
+{
+  x = hton64(x);
+  out.append(reinterpret_cast<const char*>(&x), sizeof(x));
+}
+} // namespace
+
+namespace {
+void appendString(std::string& out, const std::string& s)
+{
+  appendUint32(out, s.size());
+  out += s;
+}
+} // namespace
+
+namespace {
+template <typename InputIterator>
+void appendStrings(std::string& out, InputIterator first, InputIterator last)
+{
+  appendUint32(out, std::distance(first, last));
+  for (; first != last; ++first) {
+    appendString(out, *first);
+  }
+}
+} // namespace
+
+namespace {
+// Serializes the part of dr reported for stopped downloads.
+void serialize(std::string& out, const DownloadResult& dr)
+{
+  appendUint64(out, dr.gid->getNumericId());
+  appendUint64(out, dr.belongsTo);
+  appendUint32(out, dr.result);
+  appendUint64(out, dr.sessionDownloadLength);
+  appendUint64(out, dr.sessionTime.count());
+  appendUint64(out, dr.totalLength);
+  appendUint64(out, dr.completedLength);
+  appendUint64(out, dr.uploadLength);
+  appendUint64(out, dr.numPieces);
+  appendUint32(out, dr.pieceLength);
+  out += static_cast<char>(dr.inMemoryDownload);
+  appendString(out, dr.resultMessage);
+  appendString(out, dr.dir);
+  appendString(out, dr.bitfield);
+  appendString(out, dr.infoHash);
+  appendUint32(out, dr.followedBy.size());
+  for (auto gid : dr.followedBy) {
+    appendUint64(out, gid);
+  }
+  appendUint32(out, dr.fileEntries.size());
+  for (auto& fe : dr.fileEntries) {
+    appendString(out, fe->getPath());
+    appendUint64(out, fe->getLength());
+    appendUint64(out, fe->getOffset());
+    out += static_cast<char>(fe->isRequested());
+    appendStrings(out, std::begin(fe->getSpentUris()),
+                  std::end(fe->getSpentUris()));
+    appendStrings(out, std::begin(fe->getRemainingUris()),
+                  std::end(fe->getRemainingUris()));
+  }
+}
+} // namespace
+
+namespace {
+class RecordReader {
+public:
+  RecordReader(const char* first, const char* last)
+      : first_(first), last_(last)
+  {
+  }
+
+  bool readUint32(uint32_t& x)
+  {
+    if (last_ - first_ < static_cast<ssize_t>(sizeof(x))) {
+      return false;
+    }
+    memcpy(&x, first_, sizeof(x));
+    x = ntohl(x);
+    first_ += sizeof(x);
+    return true;
+  }
+
+  bool readUint64(uint64_t& x)
+  {
+    if (last_ - first_ < static_cast<ssize_t>(sizeof(x))) {
+      return false;
+    }
+    memcpy(&x, first_, sizeof(x));
+    x = ntoh64(x);
+    first_ += sizeof(x);
+    return true;
+  }
+
+  template <typename T> bool readInt64(T& x)
+  {
+    uint64_t v;
+    if (!readUint64(v)) {
+      return false;
+    }
+    x = static_cast<T>(v);
+    return true;
+  }
+
+  bool readBool(bool& x)
+  {
+    if (first_ == last_) {
+      return false;
+    }
+    x = *first_++ != 0;
+    return true;
+  }
+
+  bool readString(std::string& s)
+  {
+    uint32_t len;
+    if (!readUint32(len) || static_cast<size_t>(last_ - first_) < len) {
+      return false;
+    }
+    s.assign(first_, len);
+    first_ += len;
+    return true;
+  }
+
+  bool readStrings(std::deque<std::string>& ss)
+  {
+    uint32_t n;
+    if (!readUint32(n)) {
+      return false;
+    }
+    for (; n > 0; --n) {
+      std::string s;
+      if (!readString(s)) {
+        return false;
+      }
+      ss.push_back(std::move(s));
+    }
+    return true;
+  }
+
+private:
+  const char* first_;
+  const char* last_;
+};
+} // namespace
+
+namespace {
+// Restores DownloadResult from the record [first, last).  The
+// restored result has the GID imported from the record and empty
+// Option.  Returns null if the record is malformed or the GID is in
+// use.
+std::shared_ptr<DownloadResult> deserialize(const char* first,
+                                            const char* last)
+{
+  RecordReader r(first, last);
+  auto dr = std::make_shared<DownloadResult>();
+  uint64_t gid;
+  uint32_t result, pieceLength, numFollowedBy, numFiles;
+  uint64_t sessionTime;
+  if (!r.readUint64(gid) || !r.readUint64(dr->belongsTo) ||
+      !r.readUint32(result) || !r.readUint64(dr->sessionDownloadLength) ||
+      !r.readUint64(sessionTime) || !r.readInt64(dr->totalLength) ||
+      !r.readInt64(dr->completedLength) || !r.readInt64(dr->uploadLength) ||
+      !r.readInt64(dr->numPieces) || !r.readUint32(pieceLength) ||
+      !r.readBool(dr->inMemoryDownload) || !r.readString(dr->resultMessage) ||
+      !r.readString(dr->dir) || !r.readString(dr->bitfield) ||
+      !r.readString(dr->infoHash) || !r.readUint32(numFollowedBy)) {
+    return nullptr;
+  }
+  dr->result = static_cast<error_code::Value>(result);
+  dr->sessionTime = std::chrono::milliseconds(sessionTime);
+  dr->pieceLength = pieceLength;
+  for (; numFollowedBy > 0; --numFollowedBy) {
+    uint64_t followedBy;
+    if (!r.readUint64(followedBy)) {
+      return nullptr;
+    }
+    dr->followedBy.push_back(followedBy);
+  }
+  if (!r.readUint32(numFiles)) {
+    return nullptr;
+  }
+  for (; numFiles > 0; --numFiles) {
+    std::string path;
+    int64_t length, offset;
+    bool requested;
+    if (!r.readString(path) || !r.readInt64(length) || !r.readInt64(offset) ||
+        !r.readBool(requested)) {
+      return nullptr;
+    }
+    auto fe = std::make_shared<FileEntry>(std::move(path), length, offset);
+    fe->setRequested(requested);
+    if (!r.readStrings(fe->getSpentUris()) ||
+        !r.readStrings(fe->getRemainingUris())) {
+      return nullptr;
+    }
+    dr->fileEntries.push_back(std::move(fe));
+  }
+  dr->gid = GroupId::import(gid);
+  if (!dr->gid) {
+    return nullptr;
+  }
+  dr->option = std::make_shared<Option>();
+  return dr;
+}
+} // namespace
+
+DownloadResultArchive::DownloadResultArchive(std::string filename,
+                                             size_t maxMemoryResult)
+    : filename_(std::move(filename)),
+      maxMemoryResult_(std::max(maxMemoryResult, static_cast<size_t>(2))),
+      fileLength_(0),
+      numSpilled_(0),
+      numRemoved_(0)
+{
+}
+
+DownloadResultArchive::~DownloadResultArchive()
+{
+  if (diskWriter_) {
+    diskWriter_->closeFile();
+  }
+}
+
+void DownloadResultArchive::add(const DownloadResult& dr)
+{
+  auto gid = dr.gid->getNumericId();
+  remove(gid);
+  gidIndex_.emplace(gid, removed_.size());
+  removed_.push_back(false);
+  // The new node covers the sequence numbers [i - (i & -i), i).
+  size_t i = removed_.size();
+  removedTree_.push_back(countRemoved(i - 1) - countRemoved(i - (i & -i)));
+  gids_.push_back(gid);
+  recordOffsets_.push_back(records_.size());
+  serialize(records_, dr);
+  if (gids_.size() > maxMemoryResult_) {
+    spill();
+  }
+}
+
+void DownloadResultArchive::spill()
+{
+  size_t n = gids_.size() / 2;
+  size_t end = recordOffsets_[n];
+  std::string buf;
+  std::vector<int64_t> offsets;
+  offsets.reserve(n);
+  for (size_t i = 0; i < n; ++i) {
+    if (removed_[numSpilled_ + i]) {
+      offsets.push_back(-1);
+      continue;
+    }
+    offsets.push_back(fileLength_ + buf.size());
+    size_t next = i + 1 < n ? recordOffsets_[i + 1] : end;
+    appendUint32(buf, next - recordOffsets_[i]);
+    buf.append(records_, recordOffsets_[i], next - recordOffsets_[i]);
+  }
+  bool ok = true;
+  try {
+    if (!diskWriter_) {
+      diskWriter_ = make_unique<DefaultDiskWriter>(filename_);
+      diskWriter_->initAndOpenFile();
+    }
+    diskWriter_->writeData(reinterpret_cast<const unsigned char*>(buf.data()),
+                           buf.size(), fileLength_);
+    fileLength_ += buf.size();
+  }
+  catch (RecoverableException& ex) {
+    A2_LOG_ERROR_EX(fmt("Could not write download results to %s."
+                        " %lu download results were discarded.",
+                        filename_.c_str(), static_cast<unsigned long>(n)),
+                    ex);
+    ok = false;
+  }
+  if (ok) {
+    fileOffsets_.insert(std::end(fileOffsets_), std::begin(offsets),
+                        std::end(offsets));
+  }
+  else {
+    fileOffsets_.resize(fileOffsets_.size() + n, -1);
+    for (size_t i = 0; i < n; ++i) {
+      if (!removed_[numSpilled_ + i]) {
+        markRemoved(numSpilled_ + i);
+        gidIndex_.erase(gids_[i]);
+      }
+    }
+  }
+  numSpilled_ += n;
+  records_.erase(0, end);
+  gids_.erase(std::begin(gids_), std::begin(gids_) + n);
+  recordOffsets_.erase(std::begin(recordOffsets_),
+                       std::begin(recordOffsets_) + n);
+  for (auto& off : recordOffsets_) {
+    off -= end;
+  }
+}
+
+std::shared_ptr<DownloadResult> DownloadResultArchive::restore(size_t seq) const
+{
+  if (seq >= numSpilled_) {
+    size_t i = seq - numSpilled_;
+    size_t next = i + 1 < recordOffsets_.size() ? recordOffsets_[i + 1]
+                                                : records_.size();
+    return deserialize(records_.data() + recordOffsets_[i],
+                       records_.data() + next);
+  }
+  auto offset = fileOffsets_[seq];
+  if (offset == -1 || !diskWriter_) {
+    return nullptr;
+  }
+  try {
+    uint32_t len;
+    if (diskWriter_->readData(reinterpret_cast<unsigned char*>(&len),
+                              sizeof(len), offset) != sizeof(len)) {
+      return nullptr;
+    }
+    len = ntohl(len);
+    auto buf = make_unique<char[]>(len);
+    if (diskWriter_->readData(reinterpret_cast<unsigned char*>(buf.get()),
+                              len, offset + sizeof(len)) !=
+        static_cast<ssize_t>(len)) {
+      return nullptr;
+    }
+    return deserialize(buf.get(), buf.get() + len);
+  }
+  catch (RecoverableException& ex) {
+    A2_LOG_ERROR_EX(
+        fmt("Could not read download result from %s", filename_.c_str()), ex);
+    return nullptr;
+  }
+}
+
+std::shared_ptr<DownloadResult> DownloadResultArchive::get(a2_gid_t gid) const
+{
+  auto i = gidIndex_.find(gid);
+  if (i == std::end(gidIndex_)) {
+    return nullptr;
+  }
+  return restore((*i).second);
+}
+
+void DownloadResultArchive::markRemoved(size_t seq)
+{
+  removed_[seq] = true;
+  ++numRemoved_;
+  for (size_t i = seq + 1; i <= removedTree_.size(); i += i & -i) {
+    ++removedTree_[i - 1];
+  }
+}
+
+size_t DownloadResultArchive::countRemoved(size_t seq) const
+{
+  size_t n = 0;
+  for (size_t i = seq; i > 0; i -= i & -i) {
+    n += removedTree_[i - 1];
+  }
+  return n;
+}
+
+size_t DownloadResultArchive::toSeq(size_t pos) const
+{
+  if (numRemoved_ == 0) {
+    return pos;
+  }
+  // Find the largest seq such that the number of the results kept in
+  // [0, seq) is at most pos.  The result at seq is then the (pos +
+  // 1)-th kept one.
+  size_t seq = 0;
+  size_t step = 1;
+  while (step * 2 <= removedTree_.size()) {
+    step *= 2;
+  }
+  for (; step > 0; step /= 2) {
+    if (seq + step <= removedTree_.size()) {
+      size_t kept = step - removedTree_[seq + step - 1];
+      if (kept <= pos) {
+        seq += step;
+        pos -= kept;
+      }
+    }
+  }
+  return seq;
+}
+
+std::vector<std::shared_ptr<DownloadResult>>
+DownloadResultArchive::get(size_t first, size_t last) const
+{
+  std::vector<std::shared_ptr<DownloadResult>> res;
+  last = std::min(last, size());
+  if (first >= last) {
+    return res;
+  }
+  res.reserve(last - first);
+  size_t seq = toSeq(first);
+  for (size_t n = last - first; n > 0; ++seq) {
+    if (removed_[seq]) {
+      continue;
+    }
+    --n;
+    auto dr = restore(seq);
+    if (dr) {
+      res.push_back(std::move(dr));
+    }
+  }
+  return res;
+}
+
+ssize_t DownloadResultArchive::find(a2_gid_t gid) const
+{
+  auto i = gidIndex_.find(gid);
+  if (i == std::end(gidIndex_)) {
+    return -1;
+  }
+  size_t seq = (*i).second;
+  if (numRemoved_ == 0) {
+    return seq;
+  }
+  return seq - countRemoved(seq);
+}
+
+bool DownloadResultArchive::remove(a2_gid_t gid)
+{
+  auto i = gidIndex_.find(gid);
+  if (i == std::end(gidIndex_)) {
+    return false;
+  }
+  markRemoved((*i).second);
+  gidIndex_.erase(i);
+  return true;
+}
+
+void DownloadResultArchive::clear()
+{
+  if (diskWriter_) {
+    diskWriter_->closeFile();
+    diskWriter_.reset();
+  }
+  fileLength_ = 0;
+  numSpilled_ = 0;
+  numRemoved_ = 0;
+  fileOffsets_.clear();
+  gids_.clear();
+  recordOffsets_.clear();
+  records_.clear();
+  removed_.clear();
+  removedTree_.clear();
+  gidIndex_.clear();
+}
+
+} // namespace aria2
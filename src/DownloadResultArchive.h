@@ -0,0 +1,154 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2015 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_DOWNLOAD_RESULT_ARCHIVE_H
+#define D_DOWNLOAD_RESULT_ARCHIVE_H
+
+#include "common.h"
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+
+#include "GroupId.h"
+
+namespace aria2 {
+
+struct DownloadResult;
+class DiskWriter;
+
+// Stores the results of stopped downloads which were evicted from
+// RequestGroupMan::downloadResults_ by --max-download-result.  Each
+// result is serialized into a compact record without its Option and
+// runtime objects.  The records of the most recent results are packed
+// in a single in-memory buffer, and their GIDs and offsets are kept
+// in parallel arrays.  When the number of in-memory records exceeds
+// maxMemoryResult, the older half is appended to the archive file.
+//
+// The position of a result is counted from the oldest one, which
+// makes the archive the prefix of the stopped download list seen by
+// RPC.
+class DownloadResultArchive {
+public:
+  DownloadResultArchive(std::string filename, size_t maxMemoryResult);
+
+  ~DownloadResultArchive();
+
+  // Archives dr.  If a result with the same GID is already archived,
+  // it is replaced.
+  void add(const DownloadResult& dr);
+
+  // Restores the result of gid.  Returns null if gid is not archived,
+  // the record could not be read, or gid is now used by another
+  // download.
+  std::shared_ptr<DownloadResult> get(a2_gid_t gid) const;
+
+  // Restores the results in the positions [first, last).  The results
+  // which cannot be restored are skipped.
+  std::vector<std::shared_ptr<DownloadResult>> get(size_t first,
+                                                   size_t last) const;
+
+  // Returns the position of gid, or -1 if gid is not archived.
+  ssize_t find(a2_gid_t gid) const;
+
+  // Removes the result of gid.  Returns true if it was archived.
+  bool remove(a2_gid_t gid);
+
+  // Removes all results.  The archive file is truncated when results
+  // are spilled next time.
+  void clear();
+
+  // Returns the number of archived results.
+  size_t size() const { return gidIndex_.size(); }
+
+  // Returns the number of results kept in memory.
+  size_t countInMemory() const { return gids_.size(); }
+
+  const std::string& getFilename() const { return filename_; }
+
+private:
+  // Writes the older half of the in-memory records to the file.
+  void spill();
+
+  // Returns the sequence number of the result at position pos.
+  size_t toSeq(size_t pos) const;
+
+  // Marks the result of seq as removed.
+  void markRemoved(size_t seq);
+
+  // Returns the number of removed results whose sequence number is
+  // less than seq.
+  size_t countRemoved(size_t seq) const;
+
+  std::shared_ptr<DownloadResult> restore(size_t seq) const;
+
+  std::string filename_;
+
+  size_t maxMemoryResult_;
+
+  std::unique_ptr<DiskWriter> diskWriter_;
+
+  int64_t fileLength_;
+
+  // Each archived result gets the sequence number in the order of
+  // add().  The records whose sequence number is less than
+  // numSpilled_ are in the file, and the rest of them are in memory.
+  size_t numSpilled_;
+
+  // File offsets of spilled records, indexed by sequence number.
+  std::vector<int64_t> fileOffsets_;
+
+  // GIDs and offsets in records_ of in-memory records.
+  std::vector<a2_gid_t> gids_;
+  std::vector<size_t> recordOffsets_;
+  std::string records_;
+
+  // True if the result of the sequence number was removed.
+  std::vector<bool> removed_;
+
+  // Fenwick tree over removed_, so that positions and sequence
+  // numbers are converted in O(log n).  removedTree_[i - 1] holds the
+  // number of removed results in the sequence numbers [i - (i & -i),
+  // i).
+  std::vector<size_t> removedTree_;
+
+  size_t numRemoved_;
+
+  std::unordered_map<a2_gid_t, size_t> gidIndex_;
+};
+
+} // namespace aria2
+
+#endif // D_DOWNLOAD_RESULT_ARCHIVE_H
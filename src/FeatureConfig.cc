@@ -70,6 +70,9 @@
 #ifdef HAVE_LIBSSH2
 #include <libssh2.h>
 #endif // HAVE_LIBSSH2
+#ifdef HAVE_LIBNGHTTP2
+#include <nghttp2/nghttp2ver.h>
+#endif // HAVE_LIBNGHTTP2
 #include "util.h"
 
 namespace aria2 {
@@ -183,6 +186,14 @@ const char* strSupportedFeature(int feature)
 #endif // !HAVE_LIBSSH2
     break;
 
+  case (FEATURE_HTTP2):
+#ifdef ENABLE_HTTP2
+    return "HTTP/2";
+#else  // !ENABLE_HTTP2
+    return nullptr;
+#endif // !ENABLE_HTTP2
+    break;
+
   default:
     return nullptr;
   }
@@ -240,6 +251,9 @@ std::string usedLibs()
 #ifdef HAVE_LIBSSH2
   res += "libssh2/" LIBSSH2_VERSION " ";
 #endif // HAVE_LIBSSH2
+#ifdef HAVE_LIBNGHTTP2
+  res += "nghttp2/" NGHTTP2_VERSION " ";
+#endif // HAVE_LIBNGHTTP2
 
   if (!res.empty()) {
     res.erase(res.length() - 1);
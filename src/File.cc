@@ -324,6 +324,18 @@ Time File::getModifiedTime()
   return Time(fstat.st_mtime);
 }
 
+bool File::getStamp(int64_t& size, int64_t& mtime, uint64_t& inode)
+{
+  a2_struct_stat fstat;
+  if (fillStat(fstat) < 0) {
+    return false;
+  }
+  size = fstat.st_size;
+  mtime = fstat.st_mtime;
+  inode = fstat.st_ino;
+  return true;
+}
+
 std::string File::getCurrentDir()
 {
 #ifdef __MINGW32__
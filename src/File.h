@@ -113,6 +113,12 @@ public:
 
   Time getModifiedTime();
 
+  // Stores the size, modification time and inode number of this file
+  // in |size|, |mtime| and |inode| respectively.  Returns false if
+  // the file cannot be stat'ed.  |inode| is 0 on platforms lacking
+  // it.
+  bool getStamp(int64_t& size, int64_t& mtime, uint64_t& inode);
+
   // Returns the current working directory.  If the current working
   // directory cannot be retrieved or its length is larger than 2048,
   // returns ".".
@@ -48,6 +48,7 @@
 #include "fmt.h"
 #include "ServerStatMan.h"
 #include "ServerStat.h"
+#include "HostConnectionRegistry.h"
 
 namespace aria2 {
 
@@ -74,6 +75,7 @@ FileEntry::FileEntry(std::string path, int64_t length, int64_t offset,
       path_(std::move(path)),
       lastFasterReplace_(Timer::zero()),
       maxConnectionPerServer_(1),
+      hostConnectionRegistry_(nullptr),
       requested_(true),
       uniqueProtocol_(false)
 {
@@ -83,6 +85,7 @@ FileEntry::FileEntry()
     : length_(0),
       offset_(0),
       maxConnectionPerServer_(1),
+      hostConnectionRegistry_(nullptr),
       requested_(false),
       uniqueProtocol_(false)
 {
@@ -121,21 +124,6 @@ std::vector<std::string> FileEntry::getUris() const
   return uris;
 }
 
-namespace {
-template <typename InputIterator, typename OutputIterator>
-OutputIterator enumerateInFlightHosts(InputIterator first, InputIterator last,
-                                      OutputIterator out)
-{
-  for (; first != last; ++first) {
-    uri_split_result us;
-    if (uri_split(&us, (*first)->getUri().c_str()) == 0) {
-      *out++ = uri::getFieldString(us, USR_HOST, (*first)->getUri().c_str());
-    }
-  }
-  return out;
-}
-} // namespace
-
 std::shared_ptr<Request> FileEntry::getRequest(
     URISelector* selector, bool uriReuse,
     const std::vector<std::pair<size_t, std::string>>& usedHosts,
@@ -143,9 +131,6 @@ std::shared_ptr<Request> FileEntry::getRequest(
 {
   std::shared_ptr<Request> req;
   if (requestPool_.empty()) {
-    std::vector<std::string> inFlightHosts;
-    enumerateInFlightHosts(inFlightRequests_.begin(), inFlightRequests_.end(),
-                           std::back_inserter(inFlightHosts));
     for (int g = 0; g < 2; ++g) {
       std::vector<std::string> pending;
       std::vector<std::string> ignoreHost;
@@ -156,8 +141,8 @@ std::shared_ptr<Request> FileEntry::getRequest(
         }
         req = std::make_shared<Request>();
         if (req->setUri(uri)) {
-          if (std::count(inFlightHosts.begin(), inFlightHosts.end(),
-                         req->getHost()) >= maxConnectionPerServer_) {
+          if (countInFlightRequest(req->getHost()) >=
+              static_cast<size_t>(getMaxConnectionPerHost(req->getHost()))) {
             pending.push_back(uri);
             ignoreHost.push_back(req->getHost());
             req.reset();
@@ -172,7 +157,7 @@ std::shared_ptr<Request> FileEntry::getRequest(
           }
           req->setMethod(method);
           spentUris_.push_back(uri);
-          inFlightRequests_.insert(req);
+          addInFlightRequest(req);
           break;
         }
         else {
@@ -206,7 +191,7 @@ std::shared_ptr<Request> FileEntry::getRequest(
     }
     req = *i;
     requestPool_.erase(i);
-    inFlightRequests_.insert(req);
+    addInFlightRequest(req);
     A2_LOG_DEBUG(fmt("Picked up from pool: %s", req->getUri().c_str()));
   }
   return req;
@@ -237,7 +222,7 @@ FileEntry::findFasterRequest(const std::shared_ptr<Request>& base)
     // TODO we should consider that "fastest" is very slow.
     std::shared_ptr<Request> fastestRequest = *requestPool_.begin();
     requestPool_.erase(requestPool_.begin());
-    inFlightRequests_.insert(fastestRequest);
+    addInFlightRequest(fastestRequest);
     lastFasterReplace_ = global::wallclock();
     return fastestRequest;
   }
@@ -253,9 +238,6 @@ std::shared_ptr<Request> FileEntry::findFasterRequest(
   if (lastFasterReplace_.difference(global::wallclock()) < startupIdleTime) {
     return nullptr;
   }
-  std::vector<std::string> inFlightHosts;
-  enumerateInFlightHosts(inFlightRequests_.begin(), inFlightRequests_.end(),
-                         std::back_inserter(inFlightHosts));
   const std::shared_ptr<PeerStat>& basestat = base->getPeerStat();
   A2_LOG_DEBUG("Search faster server using ServerStat.");
   // Use first 10 good URIs to introduce some randomness.
@@ -271,10 +253,10 @@ std::shared_ptr<Request> FileEntry::findFasterRequest(
     }
     std::string host = uri::getFieldString(us, USR_HOST, (*i).c_str());
     std::string protocol = uri::getFieldString(us, USR_SCHEME, (*i).c_str());
-    if (std::count(inFlightHosts.begin(), inFlightHosts.end(), host) >=
-        maxConnectionPerServer_) {
+    int maxConnection = getMaxConnectionPerHost(host);
+    if (countInFlightRequest(host) >= static_cast<size_t>(maxConnection)) {
       A2_LOG_DEBUG(fmt("%s has already used %d times, not considered.",
-                       (*i).c_str(), maxConnectionPerServer_));
+                       (*i).c_str(), maxConnection));
       continue;
     }
     if (findSecond(usedHosts.begin(), usedHosts.end(), host) !=
@@ -301,7 +283,7 @@ std::shared_ptr<Request> FileEntry::findFasterRequest(
     fastestRequest->setReferer(base->getReferer());
     uris_.erase(std::find(uris_.begin(), uris_.end(), uri));
     spentUris_.push_back(uri);
-    inFlightRequests_.insert(fastestRequest);
+    addInFlightRequest(fastestRequest);
     lastFasterReplace_ = global::wallclock();
     return fastestRequest;
   }
@@ -328,9 +310,87 @@ void FileEntry::poolRequest(const std::shared_ptr<Request>& request)
   }
 }
 
+std::shared_ptr<Request> FileEntry::getPooledRequest(cuid_t cuid)
+{
+  for (auto i = requestPool_.begin(), eoi = requestPool_.end(); i != eoi;
+       ++i) {
+    const std::shared_ptr<PeerStat>& peerStat = (*i)->getPeerStat();
+    if (peerStat && peerStat->getCuid() == cuid &&
+        (*i)->getWakeTime() <= global::wallclock()) {
+      auto req = *i;
+      requestPool_.erase(i);
+      addInFlightRequest(req);
+      A2_LOG_DEBUG(fmt("Picked up from pool: %s", req->getUri().c_str()));
+      return req;
+    }
+  }
+  return nullptr;
+}
+
 bool FileEntry::removeRequest(const std::shared_ptr<Request>& request)
 {
-  return inFlightRequests_.erase(request) == 1;
+  if (inFlightRequests_.erase(request) == 0) {
+    return false;
+  }
+  accountInFlightHost(request, -1);
+  return true;
+}
+
+void FileEntry::addInFlightRequest(const std::shared_ptr<Request>& request)
+{
+  if (inFlightRequests_.insert(request).second) {
+    accountInFlightHost(request, 1);
+  }
+}
+
+void FileEntry::accountInFlightHost(const std::shared_ptr<Request>& request,
+                                    int delta)
+{
+  // Use the URI given to the request, not the redirected one, so that
+  // the same host is accounted on insertion and removal.
+  const auto& uri = request->getUri();
+  uri_split_result us;
+  if (uri_split(&us, uri.c_str()) == -1) {
+    return;
+  }
+  auto host = uri::getFieldString(us, USR_HOST, uri.c_str());
+  if (delta > 0) {
+    if (hostConnectionRegistry_) {
+      hostConnectionRegistry_->add(
+          host, uri::getFieldString(us, USR_SCHEME, uri.c_str()));
+    }
+    ++inFlightHostCount_[host];
+    return;
+  }
+  if (hostConnectionRegistry_) {
+    hostConnectionRegistry_->remove(host);
+  }
+  auto i = inFlightHostCount_.find(host);
+  if (i != std::end(inFlightHostCount_) && --(*i).second == 0) {
+    inFlightHostCount_.erase(i);
+  }
+}
+
+void FileEntry::setHostConnectionRegistry(HostConnectionRegistry* registry)
+{
+  if (hostConnectionRegistry_ == registry) {
+    return;
+  }
+  for (const auto& req : inFlightRequests_) {
+    uri_split_result us;
+    if (uri_split(&us, req->getUri().c_str()) == -1) {
+      continue;
+    }
+    auto host = uri::getFieldString(us, USR_HOST, req->getUri().c_str());
+    if (hostConnectionRegistry_) {
+      hostConnectionRegistry_->remove(host);
+    }
+    if (registry) {
+      registry->add(host,
+                    uri::getFieldString(us, USR_SCHEME, req->getUri().c_str()));
+    }
+  }
+  hostConnectionRegistry_ = registry;
 }
 
 void FileEntry::removeURIWhoseHostnameIs(const std::string& hostname)
@@ -445,8 +505,10 @@ void FileEntry::reuseUri(const std::vector<std::string>& ignore)
 
 void FileEntry::releaseRuntimeResource()
 {
+  setHostConnectionRegistry(nullptr);
   requestPool_.clear();
   inFlightRequests_.clear();
+  inFlightHostCount_.clear();
 }
 
 namespace {
@@ -558,6 +620,41 @@ size_t FileEntry::countInFlightRequest() const
 
 size_t FileEntry::countPooledRequest() const { return requestPool_.size(); }
 
+size_t FileEntry::countInFlightRequest(const std::string& host) const
+{
+  auto i = inFlightHostCount_.find(host);
+  if (i == std::end(inFlightHostCount_)) {
+    return 0;
+  }
+  return (*i).second;
+}
+
+void FileEntry::setMaxConnectionPerHost(const std::string& host, int n)
+{
+  maxConnectionPerHost_[host] = std::min(n, maxConnectionPerServer_);
+}
+
+int FileEntry::getMaxConnectionPerHost(const std::string& host) const
+{
+  auto i = maxConnectionPerHost_.find(host);
+  if (i == std::end(maxConnectionPerHost_)) {
+    return maxConnectionPerServer_;
+  }
+  return (*i).second;
+}
+
+bool FileEntry::isConnectionLimitExceeded(
+    const std::shared_ptr<Request>& req) const
+{
+  uri_split_result us;
+  if (uri_split(&us, req->getUri().c_str()) == -1) {
+    return false;
+  }
+  auto host = uri::getFieldString(us, USR_HOST, req->getUri().c_str());
+  return countInFlightRequest(host) >
+         static_cast<size_t>(getMaxConnectionPerHost(host));
+}
+
 void FileEntry::setOriginalName(std::string originalName)
 {
   originalName_ = std::move(originalName);
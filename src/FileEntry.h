@@ -42,6 +42,7 @@
 #include <vector>
 #include <ostream>
 #include <set>
+#include <map>
 #include <memory>
 
 #include "File.h"
@@ -57,6 +58,7 @@ namespace aria2 {
 
 class URISelector;
 class ServerStatMan;
+class HostConnectionRegistry;
 
 class FileEntry {
 public:
@@ -91,12 +93,31 @@ private:
 
   Timer lastFasterReplace_;
   int maxConnectionPerServer_;
+  // Per host limit of connections which overrides
+  // maxConnectionPerServer_.  This is set by adaptive connection
+  // control.
+  std::map<std::string, int> maxConnectionPerHost_;
+  // The number of in-flight requests per host.  This is updated
+  // whenever a Request is added to or removed from
+  // inFlightRequests_.
+  std::map<std::string, size_t> inFlightHostCount_;
+  // Not owned.  Shared by all active downloads to account
+  // connections per host.  May be null.
+  HostConnectionRegistry* hostConnectionRegistry_;
 
   bool requested_;
   bool uniqueProtocol_;
 
   void storePool(const std::shared_ptr<Request>& request);
 
+  // Inserts request to inFlightRequests_ and accounts its host.
+  void addInFlightRequest(const std::shared_ptr<Request>& request);
+
+  // Updates the number of connections to the host of request by
+  // delta.
+  void accountInFlightHost(const std::shared_ptr<Request>& request,
+                           int delta);
+
 public:
   FileEntry();
 
@@ -194,12 +215,26 @@ public:
 
   void poolRequest(const std::shared_ptr<Request>& request);
 
+  // Returns pooled Request object which was last used by the
+  // connection identified by cuid, and removes it from the pool.
+  // Request object which is still sleeping is not returned.  If no
+  // such Request exists, returns null.
+  std::shared_ptr<Request> getPooledRequest(cuid_t cuid);
+
   bool removeRequest(const std::shared_ptr<Request>& request);
 
   size_t countInFlightRequest() const;
 
   size_t countPooledRequest() const;
 
+  // Returns the number of in-flight requests to host.
+  size_t countInFlightRequest(const std::string& host) const;
+
+  // Sets registry which accounts in-flight requests of this entry.
+  // The requests already in-flight are moved from the previous
+  // registry to the new one.
+  void setHostConnectionRegistry(HostConnectionRegistry* registry);
+
   const InFlightRequestSet& getInFlightRequests() const
   {
     return inFlightRequests_;
@@ -228,6 +263,18 @@ public:
 
   int getMaxConnectionPerServer() const { return maxConnectionPerServer_; }
 
+  // Sets the maximum number of connections to host.  The value is
+  // capped by maxConnectionPerServer_.
+  void setMaxConnectionPerHost(const std::string& host, int n);
+
+  // Returns the maximum number of connections to host.  If it is not
+  // set by setMaxConnectionPerHost(), returns maxConnectionPerServer_.
+  int getMaxConnectionPerHost(const std::string& host) const;
+
+  // Returns true if the number of in-flight requests to the host of
+  // req, including req itself, exceeds getMaxConnectionPerHost().
+  bool isConnectionLimitExceeded(const std::shared_ptr<Request>& req) const;
+
   // Reuse URIs which have not emitted error so far and whose host
   // component is not included in ignore. The reusable URIs are
   // appended to uris_ maxConnectionPerServer_ times.
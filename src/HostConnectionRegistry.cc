@@ -0,0 +1,115 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2015 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "HostConnectionRegistry.h"
+
+#include <algorithm>
+#include <tuple>
+
+#include "ServerStatMan.h"
+#include "ServerStat.h"
+
+namespace aria2 {
+
+HostConnectionRegistry::HostConnectionRegistry() {}
+
+HostConnectionRegistry::~HostConnectionRegistry() {}
+
+void HostConnectionRegistry::add(const std::string& host,
+                                 const std::string& protocol)
+{
+  auto i = entries_.find(host);
+  if (i == std::end(entries_)) {
+    entries_.emplace(host, Entry{protocol, 1});
+  }
+  else {
+    ++(*i).second.numConnection;
+  }
+}
+
+void HostConnectionRegistry::remove(const std::string& host)
+{
+  auto i = entries_.find(host);
+  if (i == std::end(entries_)) {
+    return;
+  }
+  if (--(*i).second.numConnection == 0) {
+    entries_.erase(i);
+  }
+}
+
+size_t HostConnectionRegistry::countConnection(const std::string& host) const
+{
+  auto i = entries_.find(host);
+  if (i == std::end(entries_)) {
+    return 0;
+  }
+  return (*i).second.numConnection;
+}
+
+void HostConnectionRegistry::getUsedHosts(
+    std::vector<std::pair<size_t, std::string>>& usedHosts,
+    const ServerStatMan* serverStatMan) const
+{
+  // vector of tuple which consists of use count, -download speed,
+  // hostname. We want to sort by least used and faster download
+  // speed. We use -download speed so that we can sort them using
+  // operator<().
+  std::vector<std::tuple<size_t, int, const std::string*>> tempHosts;
+  tempHosts.reserve(entries_.size());
+  for (const auto& ent : entries_) {
+    int invDlSpeed = 0;
+    if (serverStatMan) {
+      auto ss = serverStatMan->find(ent.first, ent.second.protocol);
+      if (ss && ss->isOK()) {
+        invDlSpeed = -static_cast<int>(ss->getDownloadSpeed());
+      }
+    }
+    tempHosts.emplace_back(ent.second.numConnection, invDlSpeed, &ent.first);
+  }
+  std::sort(std::begin(tempHosts), std::end(tempHosts),
+            [](const std::tuple<size_t, int, const std::string*>& lhs,
+               const std::tuple<size_t, int, const std::string*>& rhs) {
+              return std::tie(std::get<0>(lhs), std::get<1>(lhs),
+                              *std::get<2>(lhs)) <
+                     std::tie(std::get<0>(rhs), std::get<1>(rhs),
+                              *std::get<2>(rhs));
+            });
+  usedHosts.reserve(usedHosts.size() + tempHosts.size());
+  for (const auto& x : tempHosts) {
+    usedHosts.emplace_back(std::get<0>(x), *std::get<2>(x));
+  }
+}
+
+} // namespace aria2
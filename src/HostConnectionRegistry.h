@@ -0,0 +1,94 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2015 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_HOST_CONNECTION_REGISTRY_H
+#define D_HOST_CONNECTION_REGISTRY_H
+
+#include "common.h"
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+namespace aria2 {
+
+class ServerStatMan;
+
+// Keeps the number of in-flight requests per host across all active
+// downloads.  FileEntry updates this registry when a Request becomes
+// in-flight and when it is released, so that the current usage of a
+// host can be looked up without scanning every download.
+class HostConnectionRegistry {
+public:
+  struct Entry {
+    // Scheme of the URI which first used the host.  This is used to
+    // look up ServerStat.
+    std::string protocol;
+    size_t numConnection;
+  };
+
+  typedef std::unordered_map<std::string, Entry> EntryMap;
+
+  HostConnectionRegistry();
+
+  ~HostConnectionRegistry();
+
+  // Records a new connection to host.
+  void add(const std::string& host, const std::string& protocol);
+
+  // Records that a connection to host was released.  If the number of
+  // connections drops to 0, host is removed from the registry.
+  void remove(const std::string& host);
+
+  // Returns the number of connections to host.
+  size_t countConnection(const std::string& host) const;
+
+  // Returns the number of hosts which have at least one connection.
+  size_t countHost() const { return entries_.size(); }
+
+  const EntryMap& getEntries() const { return entries_; }
+
+  // Stores the pairs of the number of connections and hostname in
+  // usedHosts, sorted by least used first and then by faster download
+  // speed recorded in serverStatMan.
+  void getUsedHosts(std::vector<std::pair<size_t, std::string>>& usedHosts,
+                    const ServerStatMan* serverStatMan) const;
+
+private:
+  EntryMap entries_;
+};
+
+} // namespace aria2
+
+#endif // D_HOST_CONNECTION_REGISTRY_H
@@ -0,0 +1,150 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2015 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "Http2DownloadCommand.h"
+
+#include "Http2Session.h"
+#include "HttpResponse.h"
+#include "HttpRequest.h"
+#include "HttpHeader.h"
+#include "Range.h"
+#include "RequestGroup.h"
+#include "DownloadEngine.h"
+#include "SocketCore.h"
+#include "DlRetryEx.h"
+#include "fmt.h"
+
+namespace aria2 {
+
+Http2DownloadCommand::Http2DownloadCommand(
+    cuid_t cuid, const std::shared_ptr<Request>& req,
+    const std::shared_ptr<FileEntry>& fileEntry, RequestGroup* requestGroup,
+    std::unique_ptr<HttpResponse> httpResponse, DownloadEngine* e,
+    const std::shared_ptr<Http2Session>& session,
+    const std::shared_ptr<Http2Stream>& stream)
+    : DownloadCommand(cuid, req, fileEntry, requestGroup, e,
+                      session->getSocket(), nullptr),
+      httpResponse_(std::move(httpResponse)),
+      session_(session),
+      stream_(stream)
+{
+  stream_->setCommand(this);
+  if (!stream_->bufferEmpty() || stream_->closed()) {
+    setStatus(Command::STATUS_ONESHOT_REALTIME);
+    e->setNoWait(true);
+  }
+}
+
+Http2DownloadCommand::~Http2DownloadCommand()
+{
+  session_->closeStream(stream_);
+}
+
+bool Http2DownloadCommand::executeInternal()
+{
+  session_->performIO();
+  if (DownloadCommand::executeInternal()) {
+    return true;
+  }
+  // Send WINDOW_UPDATE for the consumed data.
+  session_->performIO();
+  if (!stream_->bufferEmpty()) {
+    setStatus(Command::STATUS_ONESHOT_REALTIME);
+    getDownloadEngine()->setNoWait(true);
+  }
+  return false;
+}
+
+bool Http2DownloadCommand::prepareForNextSegment()
+{
+  if (DownloadCommand::prepareForNextSegment()) {
+    return true;
+  }
+  // This command continues to download the next segment from the
+  // data already buffered.
+  if (!stream_->bufferEmpty()) {
+    setStatus(Command::STATUS_ONESHOT_REALTIME);
+    getDownloadEngine()->setNoWait(true);
+  }
+  return false;
+}
+
+int64_t Http2DownloadCommand::getRequestEndOffset() const
+{
+  auto endByte = httpResponse_->getHttpHeader()->getRange().endByte;
+  if (endByte > 0) {
+    return endByte + 1;
+  }
+  return endByte;
+}
+
+bool Http2DownloadCommand::shouldEnableWriteCheck()
+{
+  return session_->wantWrite();
+}
+
+bool Http2DownloadCommand::noCheck() const
+{
+  return !stream_->bufferEmpty() || stream_->closed();
+}
+
+bool Http2DownloadCommand::receiveData()
+{
+  if (!stream_->bufferEmpty() || !stream_->closed()) {
+    return false;
+  }
+  if (stream_->getErrorCode() != NGHTTP2_NO_ERROR) {
+    throw DL_RETRY_EX(fmt("HTTP/2 stream was closed: error_code=%u",
+                          stream_->getErrorCode()));
+  }
+  return true;
+}
+
+const unsigned char* Http2DownloadCommand::getReceivedData() const
+{
+  return stream_->getBuffer();
+}
+
+size_t Http2DownloadCommand::getReceivedDataLength() const
+{
+  return stream_->getBufferLength();
+}
+
+void Http2DownloadCommand::drainReceivedData(size_t len)
+{
+  stream_->drain(len);
+  session_->consume(stream_, len);
+}
+
+} // namespace aria2
@@ -0,0 +1,234 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2015 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "Http2RequestCommand.h"
+#include "Http2Session.h"
+#include "Http2DownloadCommand.h"
+#include "HttpRequestCommand.h"
+#include "HttpRequest.h"
+#include "HttpResponse.h"
+#include "HttpHeader.h"
+#include "Request.h"
+#include "RequestGroup.h"
+#include "DownloadEngine.h"
+#include "DownloadContext.h"
+#include "PieceStorage.h"
+#include "FileEntry.h"
+#include "Segment.h"
+#include "SocketCore.h"
+#include "AuthConfigFactory.h"
+#include "URISelector.h"
+#include "DlRetryEx.h"
+#include "DlAbortEx.h"
+#include "Option.h"
+#include "prefs.h"
+#include "message.h"
+#include "error_code.h"
+#include "LogFactory.h"
+#include "Logger.h"
+#include "fmt.h"
+#include "util.h"
+
+namespace aria2 {
+
+Http2RequestCommand::Http2RequestCommand(
+    cuid_t cuid, const std::shared_ptr<Request>& req,
+    const std::shared_ptr<FileEntry>& fileEntry, RequestGroup* requestGroup,
+    DownloadEngine* e, const std::shared_ptr<Http2Session>& session)
+    : AbstractCommand(cuid, req, fileEntry, requestGroup, e,
+                      session->getSocket()),
+      session_(session)
+{
+  disableReadCheckSocket();
+  disableWriteCheckSocket();
+  // Submit request as soon as possible.
+  setStatus(Command::STATUS_ONESHOT_REALTIME);
+  e->setNoWait(true);
+}
+
+Http2RequestCommand::~Http2RequestCommand()
+{
+  if (stream_) {
+    session_->closeStream(stream_);
+  }
+}
+
+bool Http2RequestCommand::executeInternal()
+{
+  if (!stream_) {
+    auto& segment = getSegments().front();
+    size_t nextIndex = getPieceStorage()->getNextUsedIndex(segment->getIndex());
+    int64_t endOffset = std::min(
+        getFileEntry()->getLength(),
+        getFileEntry()->gtoloff(
+            static_cast<int64_t>(segment->getSegmentLength()) * nextIndex));
+    httpRequest_ = createHttpRequest(getRequest(), getFileEntry(), segment,
+                                     getOption(), getRequestGroup(),
+                                     getDownloadEngine(), nullptr, endOffset);
+    // Http2DownloadCommand writes response body to the segments as
+    // is and cannot decode Content-Encoding.
+    httpRequest_->disableAcceptGZip();
+    stream_ = session_->submitRequest(httpRequest_->createRequest(), this);
+    A2_LOG_INFO(fmt("CUID#%" PRId64 " - Requesting %s using HTTP/2 stream %d",
+                    getCuid(), getRequest()->getCurrentUri().c_str(),
+                    stream_->getStreamId()));
+  }
+  session_->performIO();
+  if (stream_->headerReceived()) {
+    auto httpResponse = make_unique<HttpResponse>();
+    httpResponse->setCuid(getCuid());
+    httpResponse->setHttpHeader(stream_->popHttpHeader());
+    httpResponse->setHttpRequest(std::move(httpRequest_));
+    A2_LOG_INFO(fmt("CUID#%" PRId64 " - HTTP/2 response received: status=%d",
+                    getCuid(), httpResponse->getStatusCode()));
+    return processResponse(std::move(httpResponse));
+  }
+  if (stream_->closed()) {
+    throw DL_RETRY_EX(
+        fmt("HTTP/2 stream was closed before response: error_code=%u",
+            stream_->getErrorCode()));
+  }
+  setReadCheckSocket(getSocket());
+  setWriteCheckSocketIf(getSocket(), session_->wantWrite());
+  addCommandSelf();
+  return false;
+}
+
+bool Http2RequestCommand::processResponse(
+    std::unique_ptr<HttpResponse> httpResponse)
+{
+  httpResponse->validateResponse();
+  httpResponse->retrieveCookie();
+
+  auto statusCode = httpResponse->getStatusCode();
+  if (statusCode >= 300) {
+    // Response body is not needed.
+    session_->closeStream(stream_);
+    stream_.reset();
+    if (statusCode == 404) {
+      getRequestGroup()->increaseAndValidateFileNotFoundCount();
+    }
+  }
+  if (httpResponse->isRedirect()) {
+    int rnum =
+        httpResponse->getHttpRequest()->getRequest()->getRedirectCount();
+    if (rnum >= Request::MAX_REDIRECT) {
+      throw DL_ABORT_EX2(fmt("Too many redirects: count=%u", rnum),
+                         error_code::HTTP_TOO_MANY_REDIRECTS);
+    }
+    httpResponse->processRedirect();
+    return prepareForRetry(0);
+  }
+  if (statusCode >= 400) {
+    switch (statusCode) {
+    case 401:
+      if (getOption()->getAsBool(PREF_HTTP_AUTH_CHALLENGE) &&
+          !httpResponse->getHttpRequest()->authenticationUsed() &&
+          getDownloadEngine()->getAuthConfigFactory()->activateBasicCred(
+              getRequest()->getHost(), getRequest()->getPort(),
+              getRequest()->getDir(), getOption().get())) {
+        return prepareForRetry(0);
+      }
+      throw DL_ABORT_EX2(EX_AUTH_FAILED, error_code::HTTP_AUTH_FAILED);
+    case 404:
+      if (getOption()->getAsInt(PREF_MAX_FILE_NOT_FOUND) == 0) {
+        throw DL_ABORT_EX2(MSG_RESOURCE_NOT_FOUND,
+                           error_code::RESOURCE_NOT_FOUND);
+      }
+      throw DL_RETRY_EX2(MSG_RESOURCE_NOT_FOUND,
+                         error_code::RESOURCE_NOT_FOUND);
+    case 503:
+      // Only retry if pretry-wait > 0. Hammering 'busy' server is not
+      // a good idea.
+      if (getOption()->getAsInt(PREF_RETRY_WAIT) > 0) {
+        throw DL_RETRY_EX2(fmt(EX_BAD_STATUS, statusCode),
+                           error_code::HTTP_SERVICE_UNAVAILABLE);
+      }
+      throw DL_ABORT_EX2(fmt(EX_BAD_STATUS, statusCode),
+                         error_code::HTTP_SERVICE_UNAVAILABLE);
+    case 504:
+      // This is Gateway Timeout, so try again
+      throw DL_RETRY_EX2(fmt(EX_BAD_STATUS, statusCode),
+                         error_code::HTTP_SERVICE_UNAVAILABLE);
+    };
+
+    throw DL_ABORT_EX2(fmt(EX_BAD_STATUS, statusCode),
+                       error_code::HTTP_PROTOCOL_ERROR);
+  }
+  if (statusCode >= 300) {
+    return prepareForRetry(0);
+  }
+  if (httpResponse->isContentEncodingSpecified() &&
+      !util::strieq(httpResponse->getContentEncoding(), "identity")) {
+    // We did not ask for it, and the encoded body cannot be written
+    // to the segments.
+    session_->closeStream(stream_);
+    stream_.reset();
+    throw DL_RETRY_EX(fmt("HTTP/2 response has unexpected Content-Encoding: %s",
+                          httpResponse->getContentEncoding().c_str()));
+  }
+
+  getRequestGroup()->validateTotalLength(getFileEntry()->getLength(),
+                                         httpResponse->getEntityLength());
+
+  auto command = make_unique<Http2DownloadCommand>(
+      getCuid(), getRequest(), getFileEntry(), getRequestGroup(),
+      std::move(httpResponse), getDownloadEngine(), session_, stream_);
+  stream_.reset();
+  command->setStartupIdleTime(
+      std::chrono::seconds(getOption()->getAsInt(PREF_STARTUP_IDLE_TIME)));
+  command->setLowestDownloadSpeedLimit(
+      getOption()->getAsInt(PREF_LOWEST_SPEED_LIMIT));
+  getRequestGroup()->getURISelector()->tuneDownloadCommand(
+      getFileEntry()->getRemainingUris(), command.get());
+  getDownloadEngine()->addCommand(std::move(command));
+  return true;
+}
+
+bool Http2RequestCommand::noCheck() const
+{
+  return !stream_ || stream_->headerReceived() || stream_->closed();
+}
+
+bool isHttp2Applicable(const std::shared_ptr<Request>& req,
+                       const RequestGroup* requestGroup, const Option* option)
+{
+  return option->getAsBool(PREF_ENABLE_HTTP2) &&
+         req->getProtocol() == "https" &&
+         req->getMethod() == Request::METHOD_GET &&
+         !req->isPipeliningEnabled() && requestGroup->getPieceStorage() &&
+         requestGroup->getTotalLength() > 0;
+}
+
+} // namespace aria2
@@ -0,0 +1,520 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2015 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "Http2Session.h"
+
+#include <cassert>
+#include <cstring>
+#include <array>
+
+#include "SocketCore.h"
+#include "DownloadEngine.h"
+#include "Command.h"
+#include "HttpHeader.h"
+#include "RecoverableException.h"
+#include "DlRetryEx.h"
+#include "LogFactory.h"
+#include "Logger.h"
+#include "message.h"
+#include "fmt.h"
+#include "util.h"
+#include "a2functional.h"
+#include "wallclock.h"
+
+namespace aria2 {
+
+namespace {
+// The amount of response body the server can send before aria2
+// consumes it, per stream and per connection.
+constexpr int32_t STREAM_WINDOW_SIZE = 1_m;
+constexpr int32_t CONNECTION_WINDOW_SIZE = 16_m;
+} // namespace
+
+Http2Stream::Http2Stream(Command* command)
+    : command_(command),
+      streamId_(-1),
+      httpHeader_(make_unique<HttpHeader>()),
+      bufPos_(0),
+      errorCode_(NGHTTP2_NO_ERROR),
+      headerReceived_(false),
+      closed_(false)
+{
+  httpHeader_->setVersion("HTTP/2");
+}
+
+Http2Stream::~Http2Stream() {}
+
+std::unique_ptr<HttpHeader> Http2Stream::popHttpHeader()
+{
+  return std::move(httpHeader_);
+}
+
+void Http2Stream::resetHttpHeader()
+{
+  httpHeader_ = make_unique<HttpHeader>();
+  httpHeader_->setVersion("HTTP/2");
+}
+
+void Http2Stream::append(const unsigned char* data, size_t len)
+{
+  buf_.insert(std::end(buf_), data, data + len);
+}
+
+void Http2Stream::drain(size_t len)
+{
+  assert(bufPos_ + len <= buf_.size());
+  bufPos_ += len;
+  if (bufPos_ == buf_.size()) {
+    buf_.clear();
+    bufPos_ = 0;
+  }
+  else if (bufPos_ >= buf_.size() / 2) {
+    buf_.erase(std::begin(buf_), std::begin(buf_) + bufPos_);
+    bufPos_ = 0;
+  }
+}
+
+void Http2Stream::close(uint32_t errorCode)
+{
+  closed_ = true;
+  errorCode_ = errorCode;
+}
+
+namespace {
+int onHeaderCallback(nghttp2_session* session, const nghttp2_frame* frame,
+                     const uint8_t* name, size_t namelen, const uint8_t* value,
+                     size_t valuelen, uint8_t flags, void* userData)
+{
+  auto h2session = static_cast<Http2Session*>(userData);
+  if (frame->hd.type != NGHTTP2_HEADERS) {
+    return 0;
+  }
+  auto stream = h2session->findStream(frame->hd.stream_id);
+  // Trailer fields are ignored.
+  if (!stream || stream->headerReceived()) {
+    return 0;
+  }
+  // nghttp2 guarantees that name and value are NULL-terminated and
+  // name is lowercased.
+  auto hdName = reinterpret_cast<const char*>(name);
+  auto hdValue = reinterpret_cast<const char*>(value);
+  if (strcmp(hdName, ":status") == 0) {
+    uint32_t statusCode;
+    if (!util::parseUIntNoThrow(statusCode, std::string(hdValue, valuelen)) ||
+        statusCode < 100 || statusCode > 999) {
+      return NGHTTP2_ERR_TEMPORAL_CALLBACK_FAILURE;
+    }
+    stream->getHttpHeader()->setStatusCode(statusCode);
+    return 0;
+  }
+  auto hdKey = idInterestingHeader(hdName);
+  if (hdKey != HttpHeader::MAX_INTERESTING_HEADER) {
+    stream->getHttpHeader()->put(hdKey, std::string(hdValue, valuelen));
+  }
+  return 0;
+}
+} // namespace
+
+namespace {
+int onFrameRecvCallback(nghttp2_session* session, const nghttp2_frame* frame,
+                        void* userData)
+{
+  auto h2session = static_cast<Http2Session*>(userData);
+  switch (frame->hd.type) {
+  case NGHTTP2_HEADERS: {
+    auto stream = h2session->findStream(frame->hd.stream_id);
+    if (!stream || stream->headerReceived()) {
+      break;
+    }
+    if (stream->getHttpHeader()->getStatusCode() / 100 == 1) {
+      // Wait for the final response.
+      stream->resetHttpHeader();
+      break;
+    }
+    stream->setHeaderReceived();
+    h2session->onStreamUpdate(stream);
+    break;
+  }
+  case NGHTTP2_GOAWAY:
+    h2session->onGoaway();
+    break;
+  }
+  return 0;
+}
+} // namespace
+
+namespace {
+int onDataChunkRecvCallback(nghttp2_session* session, uint8_t flags,
+                            int32_t streamId, const uint8_t* data, size_t len,
+                            void* userData)
+{
+  auto h2session = static_cast<Http2Session*>(userData);
+  auto stream = h2session->findStream(streamId);
+  if (!stream) {
+    // The stream was already closed by us.  Give back the window.
+    nghttp2_session_consume(session, streamId, len);
+    return 0;
+  }
+  stream->append(data, len);
+  h2session->onStreamUpdate(stream);
+  return 0;
+}
+} // namespace
+
+namespace {
+int onStreamCloseCallback(nghttp2_session* session, int32_t streamId,
+                          uint32_t errorCode, void* userData)
+{
+  auto h2session = static_cast<Http2Session*>(userData);
+  auto stream = h2session->findStream(streamId);
+  if (!stream) {
+    return 0;
+  }
+  stream->close(errorCode);
+  h2session->onStreamUpdate(stream);
+  return 0;
+}
+} // namespace
+
+Http2Session::Http2Session(std::shared_ptr<SocketCore> socket,
+                           DownloadEngine* e)
+    : socket_(std::move(socket)),
+      e_(e),
+      session_(nullptr),
+      wbufPos_(0),
+      idleStart_(global::wallclock()),
+      goaway_(false),
+      bad_(false)
+{
+}
+
+Http2Session::~Http2Session()
+{
+  if (session_) {
+    if (!bad_) {
+      nghttp2_session_terminate_session(session_, NGHTTP2_NO_ERROR);
+      sendPendingData();
+    }
+    nghttp2_session_del(session_);
+  }
+}
+
+void Http2Session::init()
+{
+  nghttp2_session_callbacks* callbacks;
+  if (nghttp2_session_callbacks_new(&callbacks) != 0) {
+    throw DL_RETRY_EX("Could not initialize HTTP/2 session");
+  }
+  nghttp2_session_callbacks_set_on_header_callback(callbacks,
+                                                   onHeaderCallback);
+  nghttp2_session_callbacks_set_on_frame_recv_callback(callbacks,
+                                                       onFrameRecvCallback);
+  nghttp2_session_callbacks_set_on_data_chunk_recv_callback(
+      callbacks, onDataChunkRecvCallback);
+  nghttp2_session_callbacks_set_on_stream_close_callback(
+      callbacks, onStreamCloseCallback);
+
+  nghttp2_option* option;
+  if (nghttp2_option_new(&option) != 0) {
+    nghttp2_session_callbacks_del(callbacks);
+    throw DL_RETRY_EX("Could not initialize HTTP/2 session");
+  }
+  nghttp2_option_set_no_auto_window_update(option, 1);
+
+  auto rv = nghttp2_session_client_new2(&session_, callbacks, this, option);
+  nghttp2_option_del(option);
+  nghttp2_session_callbacks_del(callbacks);
+  if (rv != 0) {
+    session_ = nullptr;
+    throw DL_RETRY_EX(fmt("Could not initialize HTTP/2 session: %s",
+                          nghttp2_strerror(rv)));
+  }
+
+  std::array<nghttp2_settings_entry, 2> iv{
+      {{NGHTTP2_SETTINGS_ENABLE_PUSH, 0},
+       {NGHTTP2_SETTINGS_INITIAL_WINDOW_SIZE, STREAM_WINDOW_SIZE}}};
+  rv = nghttp2_submit_settings(session_, NGHTTP2_FLAG_NONE, iv.data(),
+                               iv.size());
+  if (rv == 0) {
+    rv = nghttp2_submit_window_update(
+        session_, NGHTTP2_FLAG_NONE, 0,
+        CONNECTION_WINDOW_SIZE - NGHTTP2_INITIAL_CONNECTION_WINDOW_SIZE);
+  }
+  if (rv != 0) {
+    throw DL_RETRY_EX(fmt("Could not initialize HTTP/2 session: %s",
+                          nghttp2_strerror(rv)));
+  }
+}
+
+std::shared_ptr<Http2Stream>
+Http2Session::submitRequest(const std::string& request, Command* command)
+{
+  if (bad_) {
+    throw DL_RETRY_EX("HTTP/2 session is not available");
+  }
+  auto hds = createHttp2RequestHeaders(request, "https");
+  std::vector<nghttp2_nv> nva;
+  nva.reserve(hds.size());
+  for (auto& hd : hds) {
+    nva.push_back({reinterpret_cast<uint8_t*>(&hd.first[0]),
+                   reinterpret_cast<uint8_t*>(&hd.second[0]), hd.first.size(),
+                   hd.second.size(), NGHTTP2_NV_FLAG_NONE});
+  }
+  auto stream = std::make_shared<Http2Stream>(command);
+  auto streamId = nghttp2_submit_request(session_, nullptr, nva.data(),
+                                         nva.size(), nullptr, nullptr);
+  if (streamId < 0) {
+    throw DL_RETRY_EX(fmt("Could not submit HTTP/2 request: %s",
+                          nghttp2_strerror(streamId)));
+  }
+  stream->setStreamId(streamId);
+  streams_.emplace(streamId, stream);
+  return stream;
+}
+
+void Http2Session::closeStream(const std::shared_ptr<Http2Stream>& stream)
+{
+  auto i = streams_.find(stream->getStreamId());
+  if (i == std::end(streams_) || (*i).second != stream) {
+    return;
+  }
+  stream->setCommand(nullptr);
+  streams_.erase(i);
+  if (streams_.empty()) {
+    idleStart_ = global::wallclock();
+  }
+  if (bad_) {
+    return;
+  }
+  if (!stream->closed()) {
+    nghttp2_submit_rst_stream(session_, NGHTTP2_FLAG_NONE,
+                              stream->getStreamId(), NGHTTP2_CANCEL);
+  }
+  // Data not processed by Command still occupies the window.
+  if (!stream->bufferEmpty()) {
+    nghttp2_session_consume(session_, stream->getStreamId(),
+                            stream->getBufferLength());
+  }
+  sendPendingData();
+}
+
+void Http2Session::consume(const std::shared_ptr<Http2Stream>& stream,
+                           size_t len)
+{
+  if (bad_ || len == 0) {
+    return;
+  }
+  nghttp2_session_consume(session_, stream->getStreamId(), len);
+}
+
+int Http2Session::performIO()
+{
+  if (bad_) {
+    return -1;
+  }
+  try {
+    std::array<unsigned char, 16_k> buf;
+    for (;;) {
+      size_t len = buf.size();
+      socket_->readData(buf.data(), len);
+      if (len == 0) {
+        if (!socket_->wantRead() && !socket_->wantWrite()) {
+          fail(EX_GOT_EOF);
+          return -1;
+        }
+        break;
+      }
+      auto rv = nghttp2_session_mem_recv(session_, buf.data(), len);
+      if (rv < 0) {
+        fail(fmt("HTTP/2 protocol error: %s",
+                 nghttp2_strerror(static_cast<int>(rv))));
+        return -1;
+      }
+    }
+  }
+  catch (RecoverableException& e) {
+    fail(e.what());
+    return -1;
+  }
+  return sendPendingData();
+}
+
+int Http2Session::sendPendingData()
+{
+  try {
+    for (;;) {
+      if (wbufPos_ == wbuf_.size()) {
+        wbuf_.clear();
+        wbufPos_ = 0;
+        while (wbuf_.size() < 16_k) {
+          const uint8_t* data;
+          auto n = nghttp2_session_mem_send(session_, &data);
+          if (n < 0) {
+            fail(fmt("HTTP/2 protocol error: %s",
+                     nghttp2_strerror(static_cast<int>(n))));
+            return -1;
+          }
+          if (n == 0) {
+            break;
+          }
+          wbuf_.insert(std::end(wbuf_), data, data + n);
+        }
+        if (wbuf_.empty()) {
+          return 0;
+        }
+      }
+      auto n = socket_->writeData(wbuf_.data() + wbufPos_,
+                                  wbuf_.size() - wbufPos_);
+      if (n == 0) {
+        return 0;
+      }
+      wbufPos_ += n;
+    }
+  }
+  catch (RecoverableException& e) {
+    fail(e.what());
+    return -1;
+  }
+}
+
+void Http2Session::fail(const std::string& error)
+{
+  if (bad_) {
+    return;
+  }
+  A2_LOG_INFO(fmt("HTTP/2 session error: %s", error.c_str()));
+  bad_ = true;
+  for (auto& kv : streams_) {
+    auto& stream = kv.second;
+    if (!stream->closed()) {
+      stream->close(NGHTTP2_INTERNAL_ERROR);
+      onStreamUpdate(stream.get());
+    }
+  }
+}
+
+bool Http2Session::wantRead() const
+{
+  return !bad_ && nghttp2_session_want_read(session_);
+}
+
+bool Http2Session::wantWrite() const
+{
+  return !bad_ && (wbufPos_ < wbuf_.size() ||
+                   nghttp2_session_want_write(session_) ||
+                   socket_->wantWrite());
+}
+
+bool Http2Session::canSubmitRequest() const
+{
+  return !bad_ && !goaway_ &&
+         streams_.size() <
+             nghttp2_session_get_remote_settings(
+                 session_, NGHTTP2_SETTINGS_MAX_CONCURRENT_STREAMS);
+}
+
+bool Http2Session::isIdleTimeout(std::chrono::seconds timeout) const
+{
+  return streams_.empty() &&
+         (bad_ || goaway_ ||
+          idleStart_.difference(global::wallclock()) >= timeout);
+}
+
+Http2Stream* Http2Session::findStream(int32_t streamId) const
+{
+  auto i = streams_.find(streamId);
+  if (i == std::end(streams_)) {
+    return nullptr;
+  }
+  return (*i).second.get();
+}
+
+void Http2Session::onStreamUpdate(Http2Stream* stream)
+{
+  auto command = stream->getCommand();
+  if (command) {
+    command->setStatus(Command::STATUS_ONESHOT_REALTIME);
+    e_->setNoWait(true);
+  }
+}
+
+std::vector<std::pair<std::string, std::string>>
+createHttp2RequestHeaders(const std::string& request, const std::string& scheme)
+{
+  std::vector<std::pair<std::string, std::string>> nva;
+  auto eol = request.find("\r\n");
+  if (eol == std::string::npos) {
+    eol = request.size();
+  }
+  // Request line is "METHOD PATH HTTP/1.1"
+  auto sp1 = request.find(' ');
+  auto sp2 = request.rfind(' ', eol);
+  if (sp1 == std::string::npos || sp1 >= sp2) {
+    return nva;
+  }
+  nva.emplace_back(":method", request.substr(0, sp1));
+  nva.emplace_back(":scheme", scheme);
+  nva.emplace_back(":authority", "");
+  nva.emplace_back(":path", request.substr(sp1 + 1, sp2 - sp1 - 1));
+  for (auto pos = eol + 2; pos < request.size();) {
+    eol = request.find("\r\n", pos);
+    if (eol == std::string::npos) {
+      eol = request.size();
+    }
+    if (eol == pos) {
+      // End of header
+      break;
+    }
+    auto p = util::divide(std::begin(request) + pos, std::begin(request) + eol,
+                          ':');
+    pos = eol + 2;
+    std::string name(p.first.first, p.first.second);
+    util::lowercase(name);
+    std::string value(p.second.first, p.second.second);
+    if (name == "host") {
+      nva[2].second = std::move(value);
+    }
+    else if (name == "connection" || name == "keep-alive" ||
+             name == "proxy-connection" || name == "transfer-encoding" ||
+             name == "upgrade" || (name == "te" && value != "trailers")) {
+      continue;
+    }
+    else if (!name.empty()) {
+      nva.emplace_back(std::move(name), std::move(value));
+    }
+  }
+  return nva;
+}
+
+} // namespace aria2
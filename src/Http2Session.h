@@ -0,0 +1,212 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2015 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_HTTP2_SESSION_H
+#define D_HTTP2_SESSION_H
+
+#include "common.h"
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+
+#include <nghttp2/nghttp2.h>
+
+#include "TimerA2.h"
+
+namespace aria2 {
+
+class SocketCore;
+class DownloadEngine;
+class Command;
+class HttpHeader;
+
+// A client side HTTP/2 stream.  Response header and body received
+// from the server are buffered in this object until the Command
+// owning the stream processes them.
+class Http2Stream {
+private:
+  Command* command_;
+  int32_t streamId_;
+  std::unique_ptr<HttpHeader> httpHeader_;
+  std::vector<unsigned char> buf_;
+  size_t bufPos_;
+  uint32_t errorCode_;
+  bool headerReceived_;
+  bool closed_;
+
+public:
+  Http2Stream(Command* command);
+  ~Http2Stream();
+
+  // Command which is woken up when something is received on this
+  // stream.
+  Command* getCommand() const { return command_; }
+
+  void setCommand(Command* command) { command_ = command; }
+
+  int32_t getStreamId() const { return streamId_; }
+
+  void setStreamId(int32_t streamId) { streamId_ = streamId; }
+
+  // Response header being received.  It is complete when
+  // headerReceived() returns true.
+  const std::unique_ptr<HttpHeader>& getHttpHeader() const
+  {
+    return httpHeader_;
+  }
+
+  std::unique_ptr<HttpHeader> popHttpHeader();
+
+  // Discards the interim (1xx) response header received so far.
+  void resetHttpHeader();
+
+  bool headerReceived() const { return headerReceived_; }
+
+  void setHeaderReceived() { headerReceived_ = true; }
+
+  // Appends response body data.
+  void append(const unsigned char* data, size_t len);
+
+  const unsigned char* getBuffer() const { return buf_.data() + bufPos_; }
+
+  size_t getBufferLength() const { return buf_.size() - bufPos_; }
+
+  bool bufferEmpty() const { return bufPos_ == buf_.size(); }
+
+  // Discards first |len| bytes of buffered data.
+  void drain(size_t len);
+
+  // Returns true if the stream was closed.  Buffered data may still
+  // remain after the stream is closed.
+  bool closed() const { return closed_; }
+
+  // HTTP/2 error code the stream was closed with.  NGHTTP2_NO_ERROR
+  // means that the server finished response successfully.
+  uint32_t getErrorCode() const { return errorCode_; }
+
+  void close(uint32_t errorCode);
+};
+
+// Client side HTTP/2 session over the established TLS connection
+// which negotiated "h2" using ALPN.  Many Commands share one session,
+// each of them owns a stream.  Whichever Command is executed drives
+// I/O of the session by calling performIO(), and the Commands owning
+// streams received something are woken up.
+//
+// Received response body is not acknowledged to the server until the
+// Command consumes it by calling consume(), so that a stream whose
+// Command does not write data to disk quickly (e.g., due to download
+// speed limit) does not make the other streams starve.
+class Http2Session {
+private:
+  std::shared_ptr<SocketCore> socket_;
+  DownloadEngine* e_;
+  nghttp2_session* session_;
+  std::map<int32_t, std::shared_ptr<Http2Stream>> streams_;
+  // Serialized frames not written to socket yet
+  std::vector<unsigned char> wbuf_;
+  size_t wbufPos_;
+  // The time when the last stream was closed
+  Timer idleStart_;
+  bool goaway_;
+  bool bad_;
+
+  // Closes all streams with error and disables this session.
+  void fail(const std::string& error);
+
+  int sendPendingData();
+
+public:
+  Http2Session(std::shared_ptr<SocketCore> socket, DownloadEngine* e);
+  ~Http2Session();
+
+  // Initializes nghttp2 session and queues client connection
+  // preface.  Throws DlRetryEx on error.
+  void init();
+
+  // Submits GET request whose header fields are taken from HTTP/1.1
+  // request header |request| generated by HttpRequest.  |command| is
+  // woken up when response is received.  Throws DlRetryEx on error.
+  std::shared_ptr<Http2Stream> submitRequest(const std::string& request,
+                                             Command* command);
+
+  // Resets |stream| if it is still open and removes it from this
+  // session.
+  void closeStream(const std::shared_ptr<Http2Stream>& stream);
+
+  // Tells that |len| bytes of response body of |stream| were
+  // processed, so that the server can send more data.
+  void consume(const std::shared_ptr<Http2Stream>& stream, size_t len);
+
+  // Reads available data from socket and sends pending frames.  This
+  // function does not throw.  On error, all streams are closed with
+  // error and their Commands are woken up.  Returns 0 if it
+  // succeeds, or -1.
+  int performIO();
+
+  bool wantRead() const;
+
+  bool wantWrite() const;
+
+  // Returns true if new request can be submitted to this session.
+  bool canSubmitRequest() const;
+
+  size_t countStreams() const { return streams_.size(); }
+
+  // Returns true if this session has no stream for |timeout| or
+  // longer, or it is no longer usable and has no stream.
+  bool isIdleTimeout(std::chrono::seconds timeout) const;
+
+  const std::shared_ptr<SocketCore>& getSocket() const { return socket_; }
+
+  // Following functions are called from nghttp2 callbacks.
+  Http2Stream* findStream(int32_t streamId) const;
+  void onStreamUpdate(Http2Stream* stream);
+  void onGoaway() { goaway_ = true; }
+};
+
+// Converts HTTP/1.1 request header |request| into HTTP/2 header
+// fields.  Pseudo header fields are put first.  |scheme| is used as
+// the value of :scheme.  Header field names are lowercased, Host is
+// turned into :authority and connection-specific header fields are
+// removed.
+std::vector<std::pair<std::string, std::string>>
+createHttp2RequestHeaders(const std::string& request,
+                          const std::string& scheme);
+
+} // namespace aria2
+
+#endif // D_HTTP2_SESSION_H
@@ -41,6 +41,7 @@
 #include "HttpConnection.h"
 #include "HttpRequest.h"
 #include "Segment.h"
+#include "SegmentMan.h"
 #include "SocketCore.h"
 #include "prefs.h"
 #include "Option.h"
@@ -87,6 +88,17 @@ bool HttpDownloadCommand::prepareForNextSegment()
     return true;
   }
 
+  if (httpResponse_->getHttpRequest()->isMultiRange() && !downloadFinished) {
+    if (!getStreamFilter()->finished()) {
+      // The data of the next segment follow in the same response.
+      checkSocketRecvBuffer();
+      addCommandSelf();
+      return false;
+    }
+    // Release the segments the server did not send.
+    getSegmentMan()->cancelSegment(getCuid());
+  }
+
   const std::string& streamFilterName = getStreamFilter()->getName();
   if (getRequest()->isPipeliningEnabled() ||
       (getRequest()->isKeepAliveEnabled() &&
@@ -129,6 +141,12 @@ bool HttpDownloadCommand::prepareForNextSegment()
 
 int64_t HttpDownloadCommand::getRequestEndOffset() const
 {
+  const auto& httpRequest = httpResponse_->getHttpRequest();
+  if (httpRequest->isMultiRange() &&
+      !httpResponse_->getHttpHeader()->defined(HttpHeader::CONTENT_RANGE)) {
+    // multipart/byteranges response
+    return httpRequest->getEndByte() + 1;
+  }
   auto endByte = httpResponse_->getHttpHeader()->getRange().endByte;
   if (endByte > 0) {
     return endByte + 1;
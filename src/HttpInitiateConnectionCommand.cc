@@ -55,6 +55,10 @@
 #include "ConnectCommand.h"
 #include "HttpRequestConnectChain.h"
 #include "HttpProxyRequestConnectChain.h"
+#ifdef ENABLE_HTTP2
+#include "Http2Session.h"
+#include "Http2RequestCommand.h"
+#endif // ENABLE_HTTP2
 
 namespace aria2 {
 
@@ -116,6 +120,22 @@ std::unique_ptr<Command> HttpInitiateConnectionCommand::createNextCommand(
     }
   }
   else {
+#ifdef ENABLE_HTTP2
+    if (isHttp2Applicable(getRequest(), getRequestGroup(),
+                          getOption().get())) {
+      auto session = getDownloadEngine()->findHttp2Session(
+          getRequest()->getHost(), getRequest()->getPort());
+      if (session) {
+        A2_LOG_INFO(fmt("CUID#%" PRId64 " - Reusing HTTP/2 session to %s:%u",
+                        getCuid(), getRequest()->getHost().c_str(),
+                        getRequest()->getPort()));
+        setConnectedAddrInfo(getRequest(), hostname, session->getSocket());
+        return make_unique<Http2RequestCommand>(
+            getCuid(), getRequest(), getFileEntry(), getRequestGroup(),
+            getDownloadEngine(), session);
+      }
+    }
+#endif // ENABLE_HTTP2
     std::shared_ptr<SocketCore> pooledSocket =
         getDownloadEngine()->popPooledSocket(resolvedAddresses,
                                              getRequest()->getPort());
@@ -33,6 +33,9 @@
  */
 /* copyright --> */
 #include "HttpListenCommand.h"
+
+#include <cstring>
+
 #include "DownloadEngine.h"
 #include "RecoverableException.h"
 #include "message.h"
@@ -47,12 +50,19 @@
 #include "util.h"
 #include "A2STR.h"
 #include "fmt.h"
+#include "a2io.h"
+#include "DlAbortEx.h"
 
 namespace aria2 {
 
 HttpListenCommand::HttpListenCommand(cuid_t cuid, DownloadEngine* e, int family,
                                      bool secure)
-    : Command(cuid), e_(e), family_(family), secure_(secure)
+    : Command(cuid),
+      e_(e),
+      family_(family),
+      pathDev_(0),
+      pathIno_(0),
+      secure_(secure)
 {
 }
 
@@ -61,6 +71,16 @@ HttpListenCommand::~HttpListenCommand()
   if (serverSocket_) {
     e_->deleteSocketForReadCheck(serverSocket_, this);
   }
+#ifdef HAVE_SYS_UN_H
+  if (!path_.empty()) {
+    // Another instance may have replaced the socket since then.
+    a2_struct_stat fstat;
+    if (a2stat(path_.c_str(), &fstat) == 0 && fstat.st_dev == pathDev_ &&
+        fstat.st_ino == pathIno_) {
+      unlink(path_.c_str());
+    }
+  }
+#endif // HAVE_SYS_UN_H
 }
 
 bool HttpListenCommand::execute()
@@ -69,17 +89,27 @@ bool HttpListenCommand::execute()
     return true;
   }
   try {
-    if (serverSocket_->isReadable(0)) {
+    // Local clients may connect in bursts, so accept all pending
+    // connections on the Unix domain socket at once.
+    while (serverSocket_->isReadable(0)) {
       std::shared_ptr<SocketCore> socket(serverSocket_->acceptConnection());
-      socket->setTcpNodelay(true);
-      auto endpoint = socket->getPeerInfo();
+      if (family_ == AF_UNIX) {
+        A2_LOG_INFO(fmt("RPC: Accepted the connection on %s.", path_.c_str()));
+      }
+      else {
+        socket->setTcpNodelay(true);
+        auto endpoint = socket->getPeerInfo();
 
-      A2_LOG_INFO(fmt("RPC: Accepted the connection from %s:%u.",
-                      endpoint.addr.c_str(), endpoint.port));
+        A2_LOG_INFO(fmt("RPC: Accepted the connection from %s:%u.",
+                        endpoint.addr.c_str(), endpoint.port));
+      }
 
       e_->setNoWait(true);
       e_->addCommand(
           make_unique<HttpServerCommand>(e_->newCUID(), e_, socket, secure_));
+      if (family_ != AF_UNIX) {
+        break;
+      }
     }
   }
   catch (RecoverableException& e) {
@@ -115,4 +145,82 @@ bool HttpListenCommand::bindPort(uint16_t port)
   return false;
 }
 
+#ifdef HAVE_SYS_UN_H
+namespace {
+// Returns true if the Unix domain socket at |path| is left by a
+// process which is gone, that is, connecting to it is refused.
+bool isStaleSocket(const std::string& path)
+{
+  sockaddr_un addr;
+  if (path.size() >= sizeof(addr.sun_path)) {
+    return false;
+  }
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  memcpy(addr.sun_path, path.c_str(), path.size());
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd == -1) {
+    return false;
+  }
+  int rv;
+  while ((rv = connect(fd, reinterpret_cast<const sockaddr*>(&addr),
+                       sizeof(addr))) == -1 &&
+         errno == EINTR)
+    ;
+  int errNum = errno;
+  close(fd);
+  return rv == -1 && errNum == ECONNREFUSED;
+}
+} // namespace
+#endif // HAVE_SYS_UN_H
+
+bool HttpListenCommand::bindPath(const std::string& path)
+{
+#ifdef HAVE_SYS_UN_H
+  if (serverSocket_) {
+    e_->deleteSocketForReadCheck(serverSocket_, this);
+  }
+  serverSocket_ = std::make_shared<SocketCore>();
+  try {
+    // Remove the socket left by the previous run.  A socket someone
+    // is listening on and other kinds of file are not touched and
+    // make bind fail.
+    a2_struct_stat fstat;
+    if (a2stat(path.c_str(), &fstat) == 0 && S_ISSOCK(fstat.st_mode) &&
+        isStaleSocket(path)) {
+      unlink(path.c_str());
+    }
+    serverSocket_->bindUnix(path);
+    if (a2stat(path.c_str(), &fstat) == -1) {
+      int errNum = errno;
+      throw DL_ABORT_EX(fmt("Failed to stat %s: %s", path.c_str(),
+                            util::safeStrerror(errNum).c_str()));
+    }
+    path_ = path;
+    pathDev_ = fstat.st_dev;
+    pathIno_ = fstat.st_ino;
+    // No one can connect to the socket until beginListen() is called,
+    // so restricting the permission here leaves no window.
+    if (chmod(path.c_str(), S_IRUSR | S_IWUSR) == -1) {
+      int errNum = errno;
+      throw DL_ABORT_EX(fmt("Failed to change the permission of %s: %s",
+                            path.c_str(), util::safeStrerror(errNum).c_str()));
+    }
+    serverSocket_->beginListen(SOMAXCONN);
+    e_->addSocketForReadCheck(serverSocket_, this);
+    A2_LOG_NOTICE(fmt(_("RPC: listening on Unix domain socket %s"),
+                      path.c_str()));
+    return true;
+  }
+  catch (RecoverableException& e) {
+    A2_LOG_ERROR_EX(
+        fmt("RPC: failed to bind Unix domain socket %s", path.c_str()), e);
+    serverSocket_->closeConnection();
+  }
+#else  // !HAVE_SYS_UN_H
+  A2_LOG_ERROR("RPC: Unix domain socket is not supported on this platform.");
+#endif // !HAVE_SYS_UN_H
+  return false;
+}
+
 } // namespace aria2
@@ -37,7 +37,10 @@
 
 #include "Command.h"
 
+#include <sys/types.h>
+
 #include <memory>
+#include <string>
 
 namespace aria2 {
 
@@ -49,6 +52,12 @@ private:
   DownloadEngine* e_;
   int family_;
   std::shared_ptr<SocketCore> serverSocket_;
+  // The path of the Unix domain socket bound by bindPath()
+  std::string path_;
+  // The device and inode of path_ when it was bound.  The file is
+  // removed on exit only if it is still the one we created.
+  dev_t pathDev_;
+  ino_t pathIno_;
   bool secure_;
 
 public:
@@ -59,6 +68,12 @@ public:
   virtual bool execute() CXX11_OVERRIDE;
 
   bool bindPort(uint16_t port);
+
+  // Binds the Unix domain socket at |path|, which is only accessible
+  // by the owner.  The family given in the constructor must be
+  // AF_UNIX.  A socket already at |path| is replaced only if no one
+  // is listening on it.
+  bool bindPath(const std::string& path);
 };
 
 } // namespace aria2
@@ -36,6 +36,7 @@
 
 #include <cassert>
 #include <numeric>
+#include <algorithm>
 #include <vector>
 
 #include "Segment.h"
@@ -79,6 +80,42 @@ void HttpRequest::setSegment(std::shared_ptr<Segment> segment)
   segment_ = std::move(segment);
 }
 
+void HttpRequest::setRangeSegments(
+    std::vector<std::shared_ptr<Segment>> segments)
+{
+  assert(!segments.empty());
+  std::sort(std::begin(segments), std::end(segments),
+            [](const std::shared_ptr<Segment>& lhs,
+               const std::shared_ptr<Segment>& rhs) {
+              return lhs->getPosition() < rhs->getPosition();
+            });
+  segment_ = segments.front();
+  rangeSegments_ = std::move(segments);
+}
+
+std::vector<Range> HttpRequest::getRanges() const
+{
+  std::vector<Range> ranges;
+  for (auto& segment : rangeSegments_) {
+    auto startByte = fileEntry_->gtoloff(segment->getPositionToWrite());
+    auto endByte =
+        std::min(fileEntry_->gtoloff(segment->getPosition() +
+                                     segment->getLength()) -
+                     1,
+                 fileEntry_->getLength() - 1);
+    if (startByte > endByte) {
+      continue;
+    }
+    if (!ranges.empty() && ranges.back().endByte + 1 == startByte) {
+      ranges.back().endByte = endByte;
+    }
+    else {
+      ranges.emplace_back(startByte, endByte, fileEntry_->getLength());
+    }
+  }
+  return ranges;
+}
+
 void HttpRequest::setRequest(std::shared_ptr<Request> request)
 {
   request_ = std::move(request);
@@ -98,6 +135,13 @@ int64_t HttpRequest::getEndByte() const
   if (!segment_ || !request_) {
     return 0;
   }
+  if (isMultiRange()) {
+    // The last byte of the last range
+    const auto& segment = rangeSegments_.back();
+    auto endByte = fileEntry_->gtoloff(segment->getPosition() +
+                                       segment->getLength() - 1);
+    return std::min(endByte, fileEntry_->getLength() - 1);
+  }
   if (request_->isPipeliningEnabled()) {
     auto endByte = fileEntry_->gtoloff(segment_->getPosition() +
                                        segment_->getLength() - 1);
@@ -123,6 +167,14 @@ bool HttpRequest::isRangeSatisfied(const Range& range) const
   if (!segment_) {
     return true;
   }
+  if (isMultiRange()) {
+    // The server may return only the first range, or coalesce
+    // several ranges into one.
+    return getStartByte() == range.startByte &&
+           range.endByte <= getEndByte() &&
+           (fileEntry_->getLength() == 0 ||
+            fileEntry_->getLength() == range.entityLength);
+  }
   return getStartByte() == range.startByte &&
          (getEndByte() == 0 || getEndByte() == range.endByte) &&
          (fileEntry_->getLength() == 0 ||
@@ -198,9 +250,20 @@ std::string HttpRequest::createRequest()
   if (!request_->isKeepAliveEnabled() && !request_->isPipeliningEnabled()) {
     builtinHds.emplace_back("Connection:", "close");
   }
-  if (segment_ && segment_->getLength() > 0 &&
-      (request_->isPipeliningEnabled() || getStartByte() > 0 ||
-       getEndByte() > 0)) {
+  if (isMultiRange()) {
+    std::string rangeHeader = "bytes=";
+    for (auto& range : getRanges()) {
+      rangeHeader += util::itos(range.startByte);
+      rangeHeader += '-';
+      rangeHeader += util::itos(range.endByte);
+      rangeHeader += ',';
+    }
+    rangeHeader.pop_back();
+    builtinHds.emplace_back("Range:", rangeHeader);
+  }
+  else if (segment_ && segment_->getLength() > 0 &&
+           (request_->isPipeliningEnabled() || getStartByte() > 0 ||
+            getEndByte() > 0)) {
     std::string rangeHeader = "bytes=";
     rangeHeader += util::uitos(getStartByte());
     rangeHeader += '-';
@@ -64,6 +64,10 @@ private:
 
   std::shared_ptr<Segment> segment_;
 
+  // Segments requested in one request using multiple byte ranges,
+  // sorted by position.  segment_ is the first one of them.
+  std::vector<std::shared_ptr<Segment>> rangeSegments_;
+
   std::shared_ptr<Request> proxyRequest_;
 
   std::unique_ptr<AuthConfig> authConfig_;
@@ -111,6 +115,23 @@ public:
 
   void setSegment(std::shared_ptr<Segment> segment);
 
+  // Requests all segments in |segments| in this request using
+  // multiple byte ranges.  |segments| must not be empty.
+  void setRangeSegments(std::vector<std::shared_ptr<Segment>> segments);
+
+  const std::vector<std::shared_ptr<Segment>>& getRangeSegments() const
+  {
+    return rangeSegments_;
+  }
+
+  // Returns true if this request has more than one segment set by
+  // setRangeSegments().
+  bool isMultiRange() const { return rangeSegments_.size() > 1; }
+
+  // Returns the byte ranges of the segments set by
+  // setRangeSegments().  Adjacent ranges are merged into one.
+  std::vector<Range> getRanges() const;
+
   void setRequest(std::shared_ptr<Request> request);
 
   int64_t getEntityLength() const;
@@ -59,6 +59,10 @@
 #include "LogFactory.h"
 #include "fmt.h"
 #include "SocketRecvBuffer.h"
+#ifdef ENABLE_HTTP2
+#include "Http2Session.h"
+#include "Http2RequestCommand.h"
+#endif // ENABLE_HTTP2
 
 namespace aria2 {
 
@@ -78,7 +82,6 @@ HttpRequestCommand::HttpRequestCommand(
 
 HttpRequestCommand::~HttpRequestCommand() {}
 
-namespace {
 std::unique_ptr<HttpRequest>
 createHttpRequest(const std::shared_ptr<Request>& req,
                   const std::shared_ptr<FileEntry>& fileEntry,
@@ -86,7 +89,7 @@ createHttpRequest(const std::shared_ptr<Request>& req,
                   const std::shared_ptr<Option>& option, const RequestGroup* rg,
                   const DownloadEngine* e,
                   const std::shared_ptr<Request>& proxyRequest,
-                  int64_t endOffset = 0)
+                  int64_t endOffset)
 {
   auto httpRequest = make_unique<HttpRequest>();
   httpRequest->setUserAgent(option->get(PREF_USER_AGENT));
@@ -116,7 +119,6 @@ createHttpRequest(const std::shared_ptr<Request>& req,
   }
   return httpRequest;
 }
-} // namespace
 
 bool HttpRequestCommand::executeInternal()
 {
@@ -124,12 +126,39 @@ bool HttpRequestCommand::executeInternal()
   if (httpConnection_->sendBufferIsEmpty()) {
 #ifdef ENABLE_SSL
     if (getRequest()->getProtocol() == "https") {
+#ifdef ENABLE_HTTP2
+      if (!isProxyDefined() &&
+          isHttp2Applicable(getRequest(), getRequestGroup(),
+                            getOption().get())) {
+        getSocket()->setALPNProtocols({"h2", "http/1.1"});
+      }
+#endif // ENABLE_HTTP2
       if (!getSocket()->tlsConnect(getRequest()->getHost())) {
         setReadCheckSocketIf(getSocket(), getSocket()->wantRead());
         setWriteCheckSocketIf(getSocket(), getSocket()->wantWrite());
         addCommandSelf();
         return false;
       }
+#ifdef ENABLE_HTTP2
+      if (getSocket()->getALPNProtocol() == "h2") {
+        // If another connection to the same server negotiated HTTP/2
+        // meanwhile, send request using it and close this connection.
+        auto session = getDownloadEngine()->findHttp2Session(
+            getRequest()->getHost(), getRequest()->getPort());
+        if (!session) {
+          session = std::make_shared<Http2Session>(getSocket(),
+                                                   getDownloadEngine());
+          session->init();
+          getDownloadEngine()->addHttp2Session(getRequest()->getHost(),
+                                               getRequest()->getPort(),
+                                               session);
+        }
+        getDownloadEngine()->addCommand(make_unique<Http2RequestCommand>(
+            getCuid(), getRequest(), getFileEntry(), getRequestGroup(),
+            getDownloadEngine(), session));
+        return true;
+      }
+#endif // ENABLE_HTTP2
     }
 #endif // ENABLE_SSL
     if (getSegments().empty()) {
@@ -170,24 +199,42 @@ bool HttpRequestCommand::executeInternal()
       httpConnection_->sendRequest(std::move(httpRequest));
     }
     else {
-      for (auto& segment : getSegments()) {
-        if (!httpConnection_->isIssued(segment)) {
-          int64_t endOffset = 0;
-          // FTP via HTTP proxy does not support end byte marker
-          if (getRequest()->getProtocol() != "ftp" &&
-              getRequestGroup()->getTotalLength() > 0 && getPieceStorage()) {
-            size_t nextIndex =
-                getPieceStorage()->getNextUsedIndex(segment->getIndex());
-            endOffset =
-                std::min(getFileEntry()->getLength(),
-                         getFileEntry()->gtoloff(
-                             static_cast<int64_t>(segment->getSegmentLength()) *
-                             nextIndex));
+      bool multiRange = getRequest()->getMaxRanges() > 1 &&
+                        !getRequest()->isPipeliningHint() &&
+                        getFileEntry()->getLength() > 0;
+      if (multiRange) {
+        // Request the missing pieces at once using multiple byte
+        // ranges.
+        acquireMoreSegments(getRequest()->getMaxRanges());
+        multiRange = getSegments().size() > 1;
+      }
+      if (multiRange) {
+        auto httpRequest = createHttpRequest(
+            getRequest(), getFileEntry(), getSegments().front(), getOption(),
+            getRequestGroup(), getDownloadEngine(), proxyRequest_);
+        httpRequest->setRangeSegments(getSegments());
+        httpConnection_->sendRequest(std::move(httpRequest));
+      }
+      else {
+        for (auto& segment : getSegments()) {
+          if (!httpConnection_->isIssued(segment)) {
+            int64_t endOffset = 0;
+            // FTP via HTTP proxy does not support end byte marker
+            if (getRequest()->getProtocol() != "ftp" &&
+                getRequestGroup()->getTotalLength() > 0 && getPieceStorage()) {
+              size_t nextIndex =
+                  getPieceStorage()->getNextUsedIndex(segment->getIndex());
+              endOffset = std::min(
+                  getFileEntry()->getLength(),
+                  getFileEntry()->gtoloff(
+                      static_cast<int64_t>(segment->getSegmentLength()) *
+                      nextIndex));
+            }
+            httpConnection_->sendRequest(createHttpRequest(
+                getRequest(), getFileEntry(), segment, getOption(),
+                getRequestGroup(), getDownloadEngine(), proxyRequest_,
+                endOffset));
           }
-          httpConnection_->sendRequest(
-              createHttpRequest(getRequest(), getFileEntry(), segment,
-                                getOption(), getRequestGroup(),
-                                getDownloadEngine(), proxyRequest_, endOffset));
         }
       }
     }
@@ -40,7 +40,22 @@
 namespace aria2 {
 
 class HttpConnection;
+class HttpRequest;
 class SocketCore;
+class Segment;
+class Option;
+
+// Creates HttpRequest to download |segment| of |fileEntry| from
+// |req|.  If |endOffset| is positive, it is used as the end of the
+// requested range.
+std::unique_ptr<HttpRequest>
+createHttpRequest(const std::shared_ptr<Request>& req,
+                  const std::shared_ptr<FileEntry>& fileEntry,
+                  const std::shared_ptr<Segment>& segment,
+                  const std::shared_ptr<Option>& option, const RequestGroup* rg,
+                  const DownloadEngine* e,
+                  const std::shared_ptr<Request>& proxyRequest,
+                  int64_t endOffset = 0);
 
 // HttpRequestCommand sends HTTP request header to remote server.
 // Because network I/O is non-blocking, execute() returns false if all
@@ -74,7 +74,11 @@ void HttpResponse::validateResponse() const
   switch (statusCode) {
   case 200: // OK
   case 206: // Partial Content
-    if (!httpHeader_->defined(HttpHeader::TRANSFER_ENCODING)) {
+    if (!httpHeader_->defined(HttpHeader::TRANSFER_ENCODING) &&
+        // Each part of multipart/byteranges response carries its
+        // own Content-Range, which is checked when it is received.
+        !(statusCode == 206 && httpRequest_->isMultiRange() &&
+          !getByteRangesBoundary().empty())) {
       // compare the received range against the requested range
       auto responseRange = httpHeader_->getRange();
       if (!httpRequest_->isRangeSatisfied(responseRange)) {
@@ -250,6 +254,31 @@ std::string HttpResponse::getContentType() const
   return std::string(p.first, p.second);
 }
 
+std::string HttpResponse::getByteRangesBoundary() const
+{
+  if (!httpHeader_ ||
+      !util::strieq(getContentType(), "multipart/byteranges")) {
+    return A2STR::NIL;
+  }
+  const auto& ctype = httpHeader_->find(HttpHeader::CONTENT_TYPE);
+  std::vector<Scip> params;
+  util::splitIter(std::begin(ctype), std::end(ctype),
+                  std::back_inserter(params), ';', true);
+  for (auto& param : params) {
+    auto p = util::divide(param.first, param.second, '=');
+    if (util::strieq(p.first.first, p.first.second, "boundary")) {
+      auto first = p.second.first;
+      auto last = p.second.second;
+      if (last - first >= 2 && *first == '"' && *(last - 1) == '"') {
+        ++first;
+        --last;
+      }
+      return std::string(first, last);
+    }
+  }
+  return A2STR::NIL;
+}
+
 void HttpResponse::setHttpHeader(std::unique_ptr<HttpHeader> httpHeader)
 {
   httpHeader_ = std::move(httpHeader);
@@ -102,6 +102,10 @@ public:
   // Returns type "/" subtype. The parameter is removed.
   std::string getContentType() const;
 
+  // Returns the boundary parameter if Content-Type is
+  // multipart/byteranges.  Otherwise returns empty string.
+  std::string getByteRangesBoundary() const;
+
   void setHttpHeader(std::unique_ptr<HttpHeader> httpHeader);
 
   const std::unique_ptr<HttpHeader>& getHttpHeader() const;
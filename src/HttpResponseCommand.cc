@@ -69,8 +69,13 @@
 #include "URISelector.h"
 #include "CheckIntegrityEntry.h"
 #include "StreamFilter.h"
+#include "ServerStat.h"
+#include "wallclock.h"
 #include "SinkStreamFilter.h"
 #include "ChunkedDecodingStreamFilter.h"
+#include "ByteRangesDecodingStreamFilter.h"
+#include "Range.h"
+#include "DlRetryEx.h"
 #include "uri.h"
 #include "SocketRecvBuffer.h"
 #include "MetalinkHttpEntry.h"
@@ -125,6 +130,39 @@ getContentEncodingStreamFilter(HttpResponse* httpResponse,
   return delegate;
 }
 
+std::unique_ptr<StreamFilter>
+getByteRangesStreamFilter(HttpResponse* httpResponse, FileEntry* fileEntry)
+{
+  const auto& httpRequest = httpResponse->getHttpRequest();
+  const auto& req = httpRequest->getRequest();
+  if (httpResponse->isTransferEncodingSpecified()) {
+    req->setMaxRanges(1);
+    throw DL_RETRY_EX("Transfer-Encoding is not supported in the response to"
+                      " multiple range request.");
+  }
+  if (httpResponse->isContentEncodingSpecified() &&
+      !util::strieq(httpResponse->getContentEncoding(), "identity")) {
+    // The parts would be written to the file still encoded.
+    req->setMaxRanges(1);
+    throw DL_RETRY_EX("Content-Encoding is not supported in the response to"
+                      " multiple range request.");
+  }
+  auto boundary = httpResponse->getByteRangesBoundary();
+  auto filter = make_unique<ByteRangesDecodingStreamFilter>(
+      boundary, fileEntry->getOffset(), fileEntry->getLength());
+  filter->setRequest(req);
+  if (boundary.empty()) {
+    if (httpRequest->getRanges().size() > 1) {
+      A2_LOG_INFO(fmt("The server %s does not support multiple byte ranges.",
+                      req->getHost().c_str()));
+      req->setMaxRanges(1);
+    }
+    filter->setSinglePart(httpResponse->getHttpHeader()->getRange());
+  }
+  filter->init();
+  return std::move(filter);
+}
+
 } // namespace
 
 HttpResponseCommand::HttpResponseCommand(
@@ -152,6 +190,14 @@ bool HttpResponseCommand::executeInternal()
     addCommandSelf();
     return false;
   }
+  {
+    auto ss = getModelServerStat();
+    if (ss) {
+      ss->updateTimeToFirstByte(
+          std::chrono::duration_cast<std::chrono::milliseconds>(
+              requestTime_.difference(global::wallclock())).count());
+    }
+  }
 
   // check HTTP status code
   httpResponse->validateResponse();
@@ -173,6 +219,10 @@ bool HttpResponseCommand::executeInternal()
   }
 
   auto statusCode = httpResponse->getStatusCode();
+  if (req->getMaxRanges() == 0 && statusCode >= 200 && statusCode < 300 &&
+      (req->getProtocol() == "http" || req->getProtocol() == "https")) {
+    req->setMaxRanges(getOption()->getAsInt(PREF_MAX_HTTP_RANGES));
+  }
   auto& ctx = getDownloadContext();
   auto grp = getRequestGroup();
   auto& fe = getFileEntry();
@@ -289,8 +339,12 @@ bool HttpResponseCommand::executeInternal()
     }
   }
 
-  // validate totalsize
-  grp->validateTotalLength(fe->getLength(), httpResponse->getEntityLength());
+  // validate totalsize.  The parts of multipart/byteranges response
+  // are validated by ByteRangesDecodingStreamFilter.
+  if (!httpResponse->getHttpRequest()->isMultiRange() ||
+      httpResponse->getByteRangesBoundary().empty()) {
+    grp->validateTotalLength(fe->getLength(), httpResponse->getEntityLength());
+  }
   // update last modified time
   updateLastModifiedTime(httpResponse->getLastModifiedTime());
 
@@ -305,6 +359,11 @@ bool HttpResponseCommand::executeInternal()
     getDownloadEngine()->addCommand(createHttpDownloadCommand(
         std::move(httpResponse), std::move(teFilter)));
   }
+  else if (httpResponse->getHttpRequest()->isMultiRange()) {
+    auto filter = getByteRangesStreamFilter(httpResponse.get(), fe.get());
+    getDownloadEngine()->addCommand(createHttpDownloadCommand(
+        std::move(httpResponse), std::move(filter)));
+  }
   else {
     auto teFilter = getTransferEncodingStreamFilter(httpResponse.get());
     getDownloadEngine()->addCommand(createHttpDownloadCommand(
@@ -60,6 +60,8 @@ class Checksum;
 class HttpResponseCommand : public AbstractCommand {
 private:
   std::shared_ptr<HttpConnection> httpConnection_;
+  // Used to measure time to first byte for the performance model.
+  Timer requestTime_;
 
   bool handleDefaultEncoding(std::unique_ptr<HttpResponse> httpResponse);
   bool handleOtherEncoding(std::unique_ptr<HttpResponse> httpResponse);
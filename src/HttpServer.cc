@@ -35,6 +35,7 @@
 #include "HttpServer.h"
 
 #include <sstream>
+#include <limits>
 
 #include "HttpHeader.h"
 #include "SocketCore.h"
@@ -52,6 +53,7 @@
 #include "TimeA2.h"
 #include "array_fun.h"
 #include "JsonDiskWriter.h"
+#include "ByteArrayDiskWriter.h"
 #ifdef ENABLE_XML_RPC
 #include "XmlRpcDiskWriter.h"
 #endif // ENABLE_XML_RPC
@@ -241,7 +243,8 @@ bool HttpServer::receiveBody()
       std::min(socketRecvBuffer_->getBufferLength(),
                static_cast<size_t>(lastContentLength_ - bodyConsumed_));
   if (lastBody_) {
-    lastBody_->writeData(socketRecvBuffer_->getBuffer(), length, 0);
+    lastBody_->writeData(socketRecvBuffer_->getBuffer(), length,
+                         bodyConsumed_);
   }
   socketRecvBuffer_->drain(length);
   bodyConsumed_ += length;
@@ -366,6 +369,15 @@ void HttpServer::setUsernamePassword(const std::string& username,
   }
 }
 
+namespace {
+bool isMsgpackContentType(const std::string& contentType)
+{
+  auto mediaType = util::strip(contentType.substr(0, contentType.find(';')));
+  return util::strieq(mediaType, "application/msgpack") ||
+         util::strieq(mediaType, "application/x-msgpack");
+}
+} // namespace
+
 int HttpServer::setupResponseRecv()
 {
   std::string path = createPath();
@@ -378,6 +390,14 @@ int HttpServer::setupResponseRecv()
   }
   else if (getMethod() == "POST") {
     if (path == "/jsonrpc") {
+      if (isMsgpackContentType(
+              lastRequestHeader_->find(HttpHeader::CONTENT_TYPE))) {
+        // The body size is already capped by --rpc-max-request-size.
+        reqType_ = RPC_TYPE_MSGPACK;
+        lastBody_ = make_unique<ByteArrayDiskWriter>(
+            std::numeric_limits<size_t>::max());
+        return 0;
+      }
       if (reqType_ != RPC_TYPE_JSON) {
         reqType_ = RPC_TYPE_JSON;
         lastBody_ = make_unique<json::JsonDiskWriter>();
@@ -59,6 +59,8 @@
 #include "RpcResponse.h"
 #include "rpc_helper.h"
 #include "JsonDiskWriter.h"
+#include "ByteArrayDiskWriter.h"
+#include "msgpack.h"
 #include "ValueBaseJsonParser.h"
 #ifdef ENABLE_XML_RPC
 #include "XmlRpcRequestParserStateMachine.h"
@@ -100,6 +102,27 @@ std::string getJsonRpcContentType(bool script)
 }
 } // namespace
 
+namespace {
+int getRpcErrorHttpCode(int code)
+{
+  switch (code) {
+  case 1:
+    // error caught while executing RpcMethod
+    return 400;
+  case -32600:
+    return 400;
+  case -32601:
+    return 404;
+  default:
+    return 500;
+  };
+}
+} // namespace
+
+namespace {
+const std::string MSGPACK_CONTENT_TYPE = "application/msgpack";
+} // namespace
+
 void HttpServerBodyCommand::sendJsonRpcResponse(const rpc::RpcResponse& res,
                                                 const std::string& callback)
 {
@@ -112,22 +135,8 @@ void HttpServerBodyCommand::sendJsonRpcResponse(const rpc::RpcResponse& res,
   }
   else {
     httpServer_->disableKeepAlive();
-    int httpCode;
-    switch (res.code) {
-    case 1:
-      // error caught while executing RpcMethod
-      httpCode = 400;
-      break;
-    case -32600:
-      httpCode = 400;
-      break;
-    case -32601:
-      httpCode = 404;
-      break;
-    default:
-      httpCode = 500;
-    };
-    httpServer_->feedResponse(httpCode, A2STR::NIL, std::move(responseData),
+    httpServer_->feedResponse(getRpcErrorHttpCode(res.code), A2STR::NIL,
+                              std::move(responseData),
                               getJsonRpcContentType(!callback.empty()));
   }
   addHttpServerResponseCommand(notauthorized);
@@ -144,6 +153,30 @@ void HttpServerBodyCommand::sendJsonRpcBatchResponse(
   addHttpServerResponseCommand(notauthorized);
 }
 
+void HttpServerBodyCommand::sendMsgpackRpcResponse(const rpc::RpcResponse& res)
+{
+  bool notauthorized = rpc::not_authorized(res);
+  std::string responseData = rpc::toMsgpack(res);
+  if (res.code == 0) {
+    httpServer_->feedResponse(std::move(responseData), MSGPACK_CONTENT_TYPE);
+  }
+  else {
+    httpServer_->disableKeepAlive();
+    httpServer_->feedResponse(getRpcErrorHttpCode(res.code), A2STR::NIL,
+                              std::move(responseData), MSGPACK_CONTENT_TYPE);
+  }
+  addHttpServerResponseCommand(notauthorized);
+}
+
+void HttpServerBodyCommand::sendMsgpackRpcBatchResponse(
+    const std::vector<rpc::RpcResponse>& results)
+{
+  bool notauthorized = rpc::any_not_authorized(results.begin(), results.end());
+  httpServer_->feedResponse(rpc::toMsgpackBatch(results),
+                            MSGPACK_CONTENT_TYPE);
+  addHttpServerResponseCommand(notauthorized);
+}
+
 void HttpServerBodyCommand::addHttpServerResponseCommand(bool delayed)
 {
   auto resp = make_unique<HttpServerResponseCommand>(getCuid(), httpServer_, e_,
@@ -310,6 +343,46 @@ bool HttpServerBodyCommand::execute()
           }
           return true;
         }
+        case RPC_TYPE_MSGPACK: {
+          auto dw = static_cast<ByteArrayDiskWriter*>(httpServer_->getBody());
+          auto body = dw->getString();
+          std::unique_ptr<ValueBase> request;
+          try {
+            request = msgpack::decode(
+                reinterpret_cast<const unsigned char*>(body.data()),
+                body.size());
+          }
+          catch (RecoverableException& e) {
+            A2_LOG_INFO_EX(fmt("CUID#%" PRId64
+                               " - Failed to parse MessagePack-RPC request",
+                               getCuid()),
+                           e);
+            sendMsgpackRpcResponse(rpc::createJsonRpcErrorResponse(
+                -32700, "Parse error.", Null::g()));
+            return true;
+          }
+          Dict* dict = downcast<Dict>(request);
+          List* list = downcast<List>(request);
+          if (dict) {
+            sendMsgpackRpcResponse(rpc::processMsgpackRpcRequest(dict, e_));
+          }
+          else if (list) {
+            // This is batch call
+            std::vector<rpc::RpcResponse> results;
+            for (auto& elem : *list) {
+              Dict* dict = downcast<Dict>(elem);
+              if (dict) {
+                results.push_back(rpc::processMsgpackRpcRequest(dict, e_));
+              }
+            }
+            sendMsgpackRpcBatchResponse(results);
+          }
+          else {
+            sendMsgpackRpcResponse(rpc::createJsonRpcErrorResponse(
+                -32600, "Invalid Request.", Null::g()));
+          }
+          return true;
+        }
         default:
           httpServer_->feedResponse(404);
           addHttpServerResponseCommand(false);
@@ -61,6 +61,9 @@ private:
                            const std::string& callback);
   void sendJsonRpcBatchResponse(const std::vector<rpc::RpcResponse>& results,
                                 const std::string& callback);
+  void sendMsgpackRpcResponse(const rpc::RpcResponse& res);
+  void sendMsgpackRpcBatchResponse(
+      const std::vector<rpc::RpcResponse>& results);
   void addHttpServerResponseCommand(bool delayed);
   void updateWriteCheck();
 
@@ -54,6 +54,7 @@
 #include "AuthConfigFactory.h"
 #include "AuthConfig.h"
 #include "DownloadContext.h"
+#include "RequestGroup.h"
 #include "StreamFilter.h"
 #include "BinaryStream.h"
 #include "NullSinkStreamFilter.h"
@@ -202,6 +203,9 @@ bool HttpSkipResponseCommand::processResponse()
   }
 
   auto statusCode = httpResponse_->getStatusCode();
+  if (statusCode == 429 || statusCode == 503) {
+    getRequestGroup()->onServerOverload(getRequest());
+  }
   if (statusCode >= 400) {
     switch (statusCode) {
     case 401:
@@ -568,6 +568,21 @@ public:
     }
   }
 
+  // Returns the iterator to the element whose key is |key|. If it is
+  // not found, returns end().  Complexity: O(1) if |key| is not
+  // found, otherwise O(N)
+  const_iterator find(KeyType key) const
+  {
+    if (index_.count(key) == 0) {
+      return end();
+    }
+    return const_iterator(
+        std::find_if(std::begin(seq_), std::end(seq_),
+                     [key](const typename SeqType::value_type& elem) {
+                       return elem.first == key;
+                     }));
+  }
+
   size_t size() const { return index_.size(); }
 
   size_t empty() const { return index_.empty(); }
@@ -0,0 +1,132 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2015 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "InlineChecksumValidator.h"
+
+#include <array>
+#include <algorithm>
+
+#include "util.h"
+#include "PieceStorage.h"
+#include "MessageDigest.h"
+#include "DiskAdaptor.h"
+#include "DownloadContext.h"
+#include "LogFactory.h"
+#include "fmt.h"
+#include "a2functional.h"
+
+namespace aria2 {
+
+InlineChecksumValidator::InlineChecksumValidator(
+    const std::shared_ptr<DownloadContext>& dctx,
+    const std::shared_ptr<PieceStorage>& pieceStorage)
+    : dctx_(dctx),
+      pieceStorage_(pieceStorage),
+      offset_(0),
+      ctx_(MessageDigest::create(dctx->getHashType()))
+{
+}
+
+InlineChecksumValidator::~InlineChecksumValidator() {}
+
+void InlineChecksumValidator::update(const unsigned char* data, size_t len,
+                                     int64_t offset)
+{
+  if (!ctx_ || offset > offset_ ||
+      offset + static_cast<int64_t>(len) <= offset_) {
+    return;
+  }
+  size_t skip = offset_ - offset;
+  ctx_->update(data + skip, len - skip);
+  offset_ += len - skip;
+  if (offset_ >= dctx_->getTotalLength()) {
+    finish();
+  }
+}
+
+void InlineChecksumValidator::catchUp(int64_t maxLength)
+{
+  if (!ctx_) {
+    return;
+  }
+  std::array<unsigned char, 16_k> buf;
+  int64_t totalLength = dctx_->getTotalLength();
+  int32_t pieceLength = dctx_->getPieceLength();
+  while (maxLength > 0 && offset_ < totalLength) {
+    size_t index = offset_ / pieceLength;
+    if (!pieceStorage_->hasPiece(index)) {
+      break;
+    }
+    int64_t pieceEnd =
+        std::min(static_cast<int64_t>(index + 1) * pieceLength, totalLength);
+    size_t len = std::min(
+        {static_cast<int64_t>(buf.size()), maxLength, pieceEnd - offset_});
+    ssize_t n = pieceStorage_->getDiskAdaptor()->readData(buf.data(), len,
+                                                          offset_);
+    if (n <= 0) {
+      break;
+    }
+    ctx_->update(buf.data(), n);
+    offset_ += n;
+    maxLength -= n;
+  }
+  if (offset_ >= totalLength) {
+    finish();
+  }
+}
+
+void InlineChecksumValidator::finish()
+{
+  std::string actualDigest = ctx_->digest();
+  ctx_.reset();
+  if (dctx_->getDigest() == actualDigest) {
+    A2_LOG_INFO(fmt("Checksum verified while downloading. %s=%s",
+                    dctx_->getHashType().c_str(),
+                    util::toHex(actualDigest).c_str()));
+    dctx_->setChecksumVerified(true);
+  }
+  else {
+    A2_LOG_INFO(fmt("Inline checksum validation failed. expected=%s,"
+                    " actual=%s",
+                    util::toHex(dctx_->getDigest()).c_str(),
+                    util::toHex(actualDigest).c_str()));
+  }
+}
+
+std::unique_ptr<MessageDigest> InlineChecksumValidator::popMessageDigest()
+{
+  return std::move(ctx_);
+}
+
+} // namespace aria2
@@ -0,0 +1,96 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2015 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_INLINE_CHECKSUM_VALIDATOR_H
+#define D_INLINE_CHECKSUM_VALIDATOR_H
+
+#include "common.h"
+
+#include <memory>
+
+namespace aria2 {
+
+class DownloadContext;
+class PieceStorage;
+class MessageDigest;
+
+// Computes the whole file checksum while the file is being
+// downloaded.  The data written contiguously from offset 0 is fed
+// directly; the completed pieces which were downloaded out of order
+// are read back from disk by catchUp().  When the last byte is
+// hashed, the digest is compared with the expected one and
+// DownloadContext::setChecksumVerified(true) is called on match, so
+// that the full re-read after download can be skipped.
+class InlineChecksumValidator {
+private:
+  std::shared_ptr<DownloadContext> dctx_;
+
+  std::shared_ptr<PieceStorage> pieceStorage_;
+
+  // The number of bytes from the beginning of file hashed so far.
+  int64_t offset_;
+
+  // nullptr after all bytes are hashed.
+  std::unique_ptr<MessageDigest> ctx_;
+
+  void finish();
+
+public:
+  InlineChecksumValidator(const std::shared_ptr<DownloadContext>& dctx,
+                          const std::shared_ptr<PieceStorage>& pieceStorage);
+
+  ~InlineChecksumValidator();
+
+  // Tells that |len| bytes pointed by |data| are written at |offset|
+  // of the file.  The data is hashed only if it extends the
+  // contiguous range already hashed.
+  void update(const unsigned char* data, size_t len, int64_t offset);
+
+  // Reads the completed pieces after the hashed range from disk and
+  // hashes them.  At most |maxLength| bytes are read in one call.
+  void catchUp(int64_t maxLength);
+
+  bool finished() const { return !ctx_; }
+
+  int64_t getOffset() const { return offset_; }
+
+  // Hands over the digest context of unfinished computation.  After
+  // this call, this object does nothing.  Returns nullptr if the
+  // computation has finished.
+  std::unique_ptr<MessageDigest> popMessageDigest();
+};
+
+} // namespace aria2
+
+#endif // D_INLINE_CHECKSUM_VALIDATOR_H
@@ -106,4 +106,11 @@ void IteratableChecksumValidator::init()
   ctx_ = MessageDigest::create(dctx_->getHashType());
 }
 
+void IteratableChecksumValidator::resume(std::unique_ptr<MessageDigest> ctx,
+                                         int64_t offset)
+{
+  currentOffset_ = offset;
+  ctx_ = std::move(ctx);
+}
+
 } // namespace aria2
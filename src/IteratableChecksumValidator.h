@@ -64,6 +64,10 @@ public:
 
   virtual void init() CXX11_OVERRIDE;
 
+  // Continues the computation from |offset| with |ctx| which has
+  // already hashed the first |offset| bytes of the file.
+  void resume(std::unique_ptr<MessageDigest> ctx, int64_t offset);
+
   virtual void validateChunk() CXX11_OVERRIDE;
 
   virtual bool finished() const CXX11_OVERRIDE;
@@ -67,8 +67,27 @@ IteratableChunkChecksumValidator::IteratableChunkChecksumValidator(
 
 IteratableChunkChecksumValidator::~IteratableChunkChecksumValidator() {}
 
+void IteratableChunkChecksumValidator::setUnchangedPieces(
+    const BitfieldMan& unchangedPieces)
+{
+  unchangedPieces_ = make_unique<BitfieldMan>(unchangedPieces);
+}
+
 void IteratableChunkChecksumValidator::validateChunk()
 {
+  if (unchangedPieces_ && !finished()) {
+    for (; !finished() && unchangedPieces_->isBitSet(currentIndex_);
+         ++currentIndex_) {
+      if (pieceStorage_->hasPiece(currentIndex_)) {
+        bitfield_->setBit(currentIndex_);
+      }
+    }
+    if (finished()) {
+      pieceStorage_->setBitfield(bitfield_->getBitfield(),
+                                 bitfield_->getBitfieldLength());
+      return;
+    }
+  }
   if (!finished()) {
     std::string actualChecksum;
     try {
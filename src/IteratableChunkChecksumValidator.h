@@ -54,6 +54,9 @@ private:
   std::unique_ptr<BitfieldMan> bitfield_;
   size_t currentIndex_;
   std::unique_ptr<MessageDigest> ctx_;
+  // Pieces which are not hashed.  Their current state in
+  // pieceStorage_ is kept.
+  std::unique_ptr<BitfieldMan> unchangedPieces_;
 
   std::string calculateActualChecksum();
 
@@ -68,6 +71,9 @@ public:
 
   virtual void init() CXX11_OVERRIDE;
 
+  // Skips hash check for the pieces set in |unchangedPieces|.
+  void setUnchangedPieces(const BitfieldMan& unchangedPieces);
+
   virtual void validateChunk() CXX11_OVERRIDE;
 
   virtual bool finished() const CXX11_OVERRIDE;
@@ -35,6 +35,9 @@
 #include "LibgnutlsTLSSession.h"
 
 #include <gnutls/x509.h>
+#if GNUTLS_VERSION_NUMBER >= 0x030703
+#include <gnutls/socket.h>
+#endif // GNUTLS_VERSION_NUMBER >= 0x030703
 
 #include "TLSContext.h"
 #include "util.h"
@@ -351,4 +354,82 @@ int GnuTLSSession::tlsAccept(TLSVersion& version)
 
 std::string GnuTLSSession::getLastErrorString() { return gnutls_strerror(rv_); }
 
+int GnuTLSSession::setSessionData(const std::string& data)
+{
+  rv_ = gnutls_session_set_data(sslSession_, data.data(), data.size());
+  return rv_ == GNUTLS_E_SUCCESS ? TLS_ERR_OK : TLS_ERR_ERROR;
+}
+
+std::string GnuTLSSession::getSessionData()
+{
+#if GNUTLS_VERSION_NUMBER >= 0x030603
+  // With TLSv1.3, session ticket arrives after handshake.  Without
+  // it, the session cannot be resumed.
+  if (gnutls_protocol_get_version(sslSession_) == GNUTLS_TLS1_3 &&
+      !(gnutls_session_get_flags(sslSession_) & GNUTLS_SFLAGS_SESSION_TICKET)) {
+    return "";
+  }
+#endif // GNUTLS_VERSION_NUMBER >= 0x030603
+  gnutls_datum_t data;
+  rv_ = gnutls_session_get_data2(sslSession_, &data);
+  if (rv_ != GNUTLS_E_SUCCESS) {
+    return "";
+  }
+  std::string res(data.data, data.data + data.size);
+  gnutls_free(data.data);
+  return res;
+}
+
+bool GnuTLSSession::isSessionResumed()
+{
+  return gnutls_session_is_resumed(sslSession_);
+}
+
+int GnuTLSSession::getKTLSStatus()
+{
+  int status = 0;
+#if GNUTLS_VERSION_NUMBER >= 0x030703
+  auto flags = gnutls_transport_is_ktls_enabled(sslSession_);
+  if (flags & GNUTLS_KTLS_RECV) {
+    status |= TLS_KTLS_RECV;
+  }
+  if (flags & GNUTLS_KTLS_SEND) {
+    status |= TLS_KTLS_SEND;
+  }
+#endif // GNUTLS_VERSION_NUMBER >= 0x030703
+  return status;
+}
+
+int GnuTLSSession::setALPNProtocols(const std::vector<std::string>& protocols)
+{
+#if GNUTLS_VERSION_NUMBER >= 0x030200
+  std::vector<gnutls_datum_t> data;
+  for (auto& proto : protocols) {
+    gnutls_datum_t d;
+    d.data = reinterpret_cast<unsigned char*>(const_cast<char*>(proto.data()));
+    d.size = proto.size();
+    data.push_back(d);
+  }
+  rv_ = gnutls_alpn_set_protocols(sslSession_, data.data(), data.size(), 0);
+  if (rv_ != GNUTLS_E_SUCCESS) {
+    return TLS_ERR_ERROR;
+  }
+  return TLS_ERR_OK;
+#else  // GNUTLS_VERSION_NUMBER < 0x030200
+  return TLS_ERR_ERROR;
+#endif // GNUTLS_VERSION_NUMBER < 0x030200
+}
+
+std::string GnuTLSSession::getALPNProtocol()
+{
+#if GNUTLS_VERSION_NUMBER >= 0x030200
+  gnutls_datum_t proto;
+  if (gnutls_alpn_get_selected_protocol(sslSession_, &proto) ==
+      GNUTLS_E_SUCCESS) {
+    return std::string(proto.data, proto.data + proto.size);
+  }
+#endif // GNUTLS_VERSION_NUMBER >= 0x030200
+  return "";
+}
+
 } // namespace aria2
@@ -60,6 +60,13 @@ public:
   virtual int tlsAccept(TLSVersion& version) CXX11_OVERRIDE;
   virtual std::string getLastErrorString() CXX11_OVERRIDE;
   virtual size_t getRecvBufferedLength() CXX11_OVERRIDE { return 0; }
+  virtual int setSessionData(const std::string& data) CXX11_OVERRIDE;
+  virtual std::string getSessionData() CXX11_OVERRIDE;
+  virtual bool isSessionResumed() CXX11_OVERRIDE;
+  virtual int getKTLSStatus() CXX11_OVERRIDE;
+  virtual int setALPNProtocols(const std::vector<std::string>& protocols)
+      CXX11_OVERRIDE;
+  virtual std::string getALPNProtocol() CXX11_OVERRIDE;
 
 private:
   gnutls_session_t sslSession_;
@@ -164,6 +164,18 @@ OpenSSLTLSContext::~OpenSSLTLSContext() { SSL_CTX_free(sslCtx_); }
 
 bool OpenSSLTLSContext::good() const { return good_; }
 
+void OpenSSLTLSContext::setKTLS(bool enable)
+{
+#ifdef SSL_OP_ENABLE_KTLS
+  if (enable) {
+    SSL_CTX_set_options(sslCtx_, SSL_OP_ENABLE_KTLS);
+  }
+  else {
+    SSL_CTX_clear_options(sslCtx_, SSL_OP_ENABLE_KTLS);
+  }
+#endif // SSL_OP_ENABLE_KTLS
+}
+
 bool OpenSSLTLSContext::addCredentialFile(const std::string& certfile,
                                           const std::string& keyfile)
 {
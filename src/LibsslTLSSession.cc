@@ -347,4 +347,92 @@ std::string OpenSSLTLSSession::getLastErrorString()
   }
 }
 
+int OpenSSLTLSSession::setSessionData(const std::string& data)
+{
+  auto p = reinterpret_cast<const unsigned char*>(data.data());
+  auto session = d2i_SSL_SESSION(nullptr, &p, data.size());
+  if (!session) {
+    return TLS_ERR_ERROR;
+  }
+  rv_ = SSL_set_session(ssl_, session);
+  SSL_SESSION_free(session);
+  return rv_ == 1 ? TLS_ERR_OK : TLS_ERR_ERROR;
+}
+
+std::string OpenSSLTLSSession::getSessionData()
+{
+  auto session = SSL_get1_session(ssl_);
+  if (!session) {
+    return "";
+  }
+  std::unique_ptr<SSL_SESSION, decltype(&SSL_SESSION_free)> sessionDeleter(
+      session, SSL_SESSION_free);
+#if OPENSSL_VERSION_NUMBER >= 0x10101000L && !defined(LIBRESSL_VERSION_NUMBER)
+  // With TLSv1.3, session ticket arrives after handshake.
+  if (!SSL_SESSION_is_resumable(session)) {
+    return "";
+  }
+#endif // OPENSSL_VERSION_NUMBER >= 0x10101000L && !LIBRESSL_VERSION_NUMBER
+  auto len = i2d_SSL_SESSION(session, nullptr);
+  if (len <= 0) {
+    return "";
+  }
+  std::string res(len, '\0');
+  auto p = reinterpret_cast<unsigned char*>(&res[0]);
+  i2d_SSL_SESSION(session, &p);
+  return res;
+}
+
+bool OpenSSLTLSSession::isSessionResumed() { return SSL_session_reused(ssl_); }
+
+int OpenSSLTLSSession::getKTLSStatus()
+{
+  int status = 0;
+#ifdef BIO_get_ktls_recv
+  if (BIO_get_ktls_recv(SSL_get_rbio(ssl_))) {
+    status |= TLS_KTLS_RECV;
+  }
+#endif // BIO_get_ktls_recv
+#ifdef BIO_get_ktls_send
+  if (BIO_get_ktls_send(SSL_get_wbio(ssl_))) {
+    status |= TLS_KTLS_SEND;
+  }
+#endif // BIO_get_ktls_send
+  return status;
+}
+
+int OpenSSLTLSSession::setALPNProtocols(
+    const std::vector<std::string>& protocols)
+{
+#if OPENSSL_VERSION_NUMBER >= 0x10002000L
+  // ALPN protocol list is a sequence of length prefixed strings.
+  std::string wire;
+  for (auto& proto : protocols) {
+    wire += static_cast<char>(proto.size());
+    wire += proto;
+  }
+  if (SSL_set_alpn_protos(ssl_, reinterpret_cast<const unsigned char*>(
+                                    wire.data()),
+                          wire.size()) != 0) {
+    return TLS_ERR_ERROR;
+  }
+  return TLS_ERR_OK;
+#else  // OPENSSL_VERSION_NUMBER < 0x10002000L
+  return TLS_ERR_ERROR;
+#endif // OPENSSL_VERSION_NUMBER < 0x10002000L
+}
+
+std::string OpenSSLTLSSession::getALPNProtocol()
+{
+#if OPENSSL_VERSION_NUMBER >= 0x10002000L
+  const unsigned char* data;
+  unsigned int len;
+  SSL_get0_alpn_selected(ssl_, &data, &len);
+  if (data) {
+    return std::string(data, data + len);
+  }
+#endif // OPENSSL_VERSION_NUMBER >= 0x10002000L
+  return "";
+}
+
 } // namespace aria2
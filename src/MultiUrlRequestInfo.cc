@@ -67,11 +67,13 @@
 #include "console.h"
 #ifdef ENABLE_WEBSOCKET
 #include "WebSocketSessionMan.h"
+#include "WebSocketSubscriptionCommand.h"
 #else // !ENABLE_WEBSOCKET
 #include "NullWebSocketSessionMan.h"
 #endif // !ENABLE_WEBSOCKET
 #ifdef ENABLE_SSL
 #include "TLSContext.h"
+#include "TLSSessionCache.h"
 #endif // ENABLE_SSL
 #ifdef ENABLE_ASYNC_DNS
 #include "AsyncNameResolver.h"
@@ -198,6 +200,7 @@ int MultiUrlRequestInfo::prepare()
         throw DL_ABORT_EX("Loading private key and/or certificate for secure "
                           "RPC failed.");
       }
+      svTlsContext->setKTLS(option_->getAsBool(PREF_ENABLE_KTLS));
       SocketCore::setServerTLSContext(svTlsContext);
     }
 #endif // ENABLE_SSL
@@ -211,6 +214,8 @@ int MultiUrlRequestInfo::prepare()
       e_->setWebSocketSessionMan(make_unique<rpc::WebSocketSessionMan>());
       SingletonHolder<Notifier>::instance()->addDownloadEventListener(
           e_->getWebSocketSessionMan().get());
+      e_->addRoutineCommand(make_unique<rpc::WebSocketSubscriptionCommand>(
+          e_->newCUID(), e_.get()));
     }
 #endif // ENABLE_WEBSOCKET
 
@@ -270,7 +275,9 @@ int MultiUrlRequestInfo::prepare()
       }
     }
     clTlsContext->setVerifyPeer(option_->getAsBool(PREF_CHECK_CERTIFICATE));
+    clTlsContext->setKTLS(option_->getAsBool(PREF_ENABLE_KTLS));
     SocketCore::setClientTLSContext(clTlsContext);
+    SocketCore::setTLSSessionCache(std::make_shared<TLSSessionCache>());
 #endif
 #ifdef HAVE_ARES_ADDR_NODE
     ares_addr_node* asyncDNSServers =
@@ -278,6 +285,16 @@ int MultiUrlRequestInfo::prepare()
     e_->setAsyncDNSServers(asyncDNSServers);
 #endif // HAVE_ARES_ADDR_NODE
 
+    auto& dnsCache = e_->getDNSCache();
+    dnsCache->setDefaultTTL(
+        std::chrono::seconds(option_->getAsInt(PREF_DNS_CACHE_TTL)));
+    dnsCache->setNegativeTTL(
+        std::chrono::seconds(option_->getAsInt(PREF_DNS_NEGATIVE_CACHE_TTL)));
+    const std::string& dnsCacheFile = option_->get(PREF_DNS_CACHE_FILE);
+    if (!dnsCacheFile.empty() && File(dnsCacheFile).isFile()) {
+      dnsCache->load(dnsCacheFile);
+    }
+
     std::string serverStatIf = option_->get(PREF_SERVER_STAT_IF);
     if (!serverStatIf.empty()) {
       e_->getRequestGroupMan()->loadServerStat(serverStatIf);
@@ -315,6 +332,22 @@ error_code::Value MultiUrlRequestInfo::getResult()
   if (!serverStatOf.empty()) {
     e_->getRequestGroupMan()->saveServerStat(serverStatOf);
   }
+  const std::string& dnsCacheFile = option_->get(PREF_DNS_CACHE_FILE);
+  if (!dnsCacheFile.empty()) {
+    e_->getDNSCache()->save(dnsCacheFile);
+  }
+#ifdef ENABLE_SSL
+  auto& tlsSessionCache = SocketCore::getTLSSessionCache();
+  if (tlsSessionCache && tlsSessionCache->getNumHandshake() > 0) {
+    A2_LOG_NOTICE(fmt(MSG_TLS_SESSION_RESUMPTION_STAT,
+                      static_cast<unsigned long long>(
+                          tlsSessionCache->getNumResumed()),
+                      static_cast<unsigned long long>(
+                          tlsSessionCache->getNumHandshake()),
+                      static_cast<int>(tlsSessionCache->getNumResumed() * 100 /
+                                       tlsSessionCache->getNumHandshake())));
+  }
+#endif // ENABLE_SSL
   if (!option_->getAsBool(PREF_QUIET)) {
     e_->getRequestGroupMan()->showDownloadResults(
         *global::cout(), option_->get(PREF_DOWNLOAD_RESULT) == A2_V_FULL);
@@ -61,6 +61,16 @@ int NetStat::calculateAvgDownloadSpeed()
   return avgDownloadSpeed_ = downloadSpeed_.calculateAvgSpeed();
 }
 
+int NetStat::calculateInstantDownloadSpeed()
+{
+  return downloadSpeed_.calculateInstantSpeed();
+}
+
+int NetStat::calculateSmoothedDownloadSpeed()
+{
+  return downloadSpeed_.calculateSmoothedSpeed();
+}
+
 int NetStat::calculateUploadSpeed() { return uploadSpeed_.calculateSpeed(); }
 
 int NetStat::calculateAvgUploadSpeed()
@@ -68,6 +78,16 @@ int NetStat::calculateAvgUploadSpeed()
   return avgUploadSpeed_ = uploadSpeed_.calculateAvgSpeed();
 }
 
+int NetStat::calculateInstantUploadSpeed()
+{
+  return uploadSpeed_.calculateInstantSpeed();
+}
+
+int NetStat::calculateSmoothedUploadSpeed()
+{
+  return uploadSpeed_.calculateSmoothedSpeed();
+}
+
 void NetStat::updateDownload(size_t bytes)
 {
   downloadSpeed_.update(bytes);
@@ -120,6 +140,10 @@ TransferStat NetStat::toTransferStat()
   TransferStat stat;
   stat.downloadSpeed = calculateDownloadSpeed();
   stat.uploadSpeed = calculateUploadSpeed();
+  stat.instantDownloadSpeed = calculateInstantDownloadSpeed();
+  stat.instantUploadSpeed = calculateInstantUploadSpeed();
+  stat.smoothedDownloadSpeed = calculateSmoothedDownloadSpeed();
+  stat.smoothedUploadSpeed = calculateSmoothedUploadSpeed();
   stat.sessionDownloadLength = getSessionDownloadLength();
   stat.sessionUploadLength = getSessionUploadLength();
   return stat;
@@ -63,10 +63,21 @@ public:
 
   int calculateAvgDownloadSpeed();
 
+  // Returns the download speed during the last complete second.
+  int calculateInstantDownloadSpeed();
+
+  // Returns the exponentially weighted moving average of the download
+  // speed.
+  int calculateSmoothedDownloadSpeed();
+
   int calculateUploadSpeed();
 
   int calculateAvgUploadSpeed();
 
+  int calculateInstantUploadSpeed();
+
+  int calculateSmoothedUploadSpeed();
+
   void updateDownload(size_t bytes);
 
   void updateUpload(size_t bytes);
@@ -36,68 +36,123 @@
 
 #include <cstdlib>
 #include <cstring>
+#include <algorithm>
+#include <unordered_set>
 
 #include "bitfield.h"
 
 namespace aria2 {
 
-Option::Option()
-    : table_(option::countOption()), use_((option::countOption() + 7) / 8)
-{
+namespace {
+struct ValueHash {
+  size_t operator()(const std::shared_ptr<const std::string>& v) const
+  {
+    return std::hash<std::string>()(*v);
+  }
+};
+
+struct ValueEqual {
+  bool operator()(const std::shared_ptr<const std::string>& a,
+                  const std::shared_ptr<const std::string>& b) const
+  {
+    return *a == *b;
+  }
+};
+
+// Returns the shared copy of |value|.  Entries only referenced by the
+// pool are purged whenever it has doubled in size since the last
+// purge.
+std::shared_ptr<const std::string> intern(const std::string& value)
+{
+  typedef std::unordered_set<std::shared_ptr<const std::string>, ValueHash,
+                             ValueEqual>
+      Pool;
+  static Pool pool;
+  static size_t purgeSize = 1024;
+  // Look up without copying value, using a non-owning pointer.
+  auto i = pool.find(
+      std::shared_ptr<const std::string>(std::shared_ptr<void>(), &value));
+  if (i != std::end(pool)) {
+    return *i;
+  }
+  if (pool.size() >= purgeSize) {
+    for (auto j = std::begin(pool); j != std::end(pool);) {
+      if (j->use_count() == 1) {
+        j = pool.erase(j);
+      }
+      else {
+        ++j;
+      }
+    }
+    purgeSize = std::max(static_cast<size_t>(1024), pool.size() * 2);
+  }
+  auto v = std::make_shared<const std::string>(value);
+  pool.insert(v);
+  return v;
 }
+} // namespace
+
+Option::Option() : use_((option::countOption() + 31) / 32, UseWord{0, 0}) {}
 
 Option::~Option() {}
 
 Option::Option(const Option& option)
-    : table_(option.table_), use_(option.use_), parent_(option.parent_)
+    : use_(option.use_), values_(option.values_), parent_(option.parent_)
 {
 }
 
 Option& Option::operator=(const Option& option)
 {
   if (this != &option) {
-    table_ = option.table_;
     use_ = option.use_;
+    values_ = option.values_;
     parent_ = option.parent_;
   }
   return *this;
 }
 
-namespace {
-
-template <typename V> void setBit(V& b, PrefPtr pref)
+size_t Option::rank(PrefPtr pref) const
 {
-  b[pref->i / 8] |= 128 >> (pref->i % 8);
+  auto& w = use_[pref->i / 32];
+  return w.rank + bitfield::countBit32(w.bits & ((1u << (pref->i % 32)) - 1));
 }
 
-template <typename V> void unsetBit(V& b, PrefPtr pref)
+void Option::put(PrefPtr pref, const std::string& value)
 {
-  b[pref->i / 8] &= ~(128 >> (pref->i % 8));
+  if (definedLocal(pref) && *values_[rank(pref)] == value) {
+    return;
+  }
+  put(pref, intern(value));
 }
 
-} // namespace
-
-void Option::put(PrefPtr pref, const std::string& value)
+void Option::put(PrefPtr pref, std::shared_ptr<const std::string> value)
 {
-  setBit(use_, pref);
-  table_[pref->i] = value;
+  auto pos = rank(pref);
+  if (definedLocal(pref)) {
+    values_[pos] = std::move(value);
+    return;
+  }
+  values_.insert(std::begin(values_) + pos, std::move(value));
+  use_[pref->i / 32].bits |= 1u << (pref->i % 32);
+  for (size_t w = pref->i / 32 + 1; w < use_.size(); ++w) {
+    ++use_[w].rank;
+  }
 }
 
 bool Option::defined(PrefPtr pref) const
 {
-  return bitfield::test(use_, use_.size() * 8, pref->i) ||
-         (parent_ && parent_->defined(pref));
+  return definedLocal(pref) || (parent_ && parent_->defined(pref));
 }
 
 bool Option::definedLocal(PrefPtr pref) const
 {
-  return bitfield::test(use_, use_.size() * 8, pref->i);
+  return use_[pref->i / 32].bits & (1u << (pref->i % 32));
 }
 
 bool Option::blank(PrefPtr pref) const
 {
-  if (bitfield::test(use_, use_.size() * 8, pref->i)) {
-    return table_[pref->i].empty();
+  if (definedLocal(pref)) {
+    return values_[rank(pref)]->empty();
   }
   else {
     return !parent_ || parent_->blank(pref);
@@ -106,8 +161,8 @@ bool Option::blank(PrefPtr pref) const
 
 const std::string& Option::get(PrefPtr pref) const
 {
-  if (bitfield::test(use_, use_.size() * 8, pref->i)) {
-    return table_[pref->i];
+  if (definedLocal(pref)) {
+    return *values_[rank(pref)];
   }
   else if (parent_) {
     return parent_->get(pref);
@@ -154,8 +209,14 @@ double Option::getAsDouble(PrefPtr pref) const
 
 void Option::removeLocal(PrefPtr pref)
 {
-  unsetBit(use_, pref);
-  table_[pref->i].clear();
+  if (!definedLocal(pref)) {
+    return;
+  }
+  values_.erase(std::begin(values_) + rank(pref));
+  use_[pref->i / 32].bits &= ~(1u << (pref->i % 32));
+  for (size_t w = pref->i / 32 + 1; w < use_.size(); ++w) {
+    --use_[w].rank;
+  }
 }
 
 void Option::remove(PrefPtr pref)
@@ -168,17 +229,16 @@ void Option::remove(PrefPtr pref)
 
 void Option::clear()
 {
-  std::fill(use_.begin(), use_.end(), 0);
-  std::fill(table_.begin(), table_.end(), "");
+  std::fill(use_.begin(), use_.end(), UseWord{0, 0});
+  values_.clear();
 }
 
 void Option::merge(const Option& option)
 {
-  size_t bits = option.use_.size() * 8;
-  for (size_t i = 1, len = table_.size(); i < len; ++i) {
-    if (bitfield::test(option.use_, bits, i)) {
-      use_[i / 8] |= 128 >> (i % 8);
-      table_[i] = option.table_[i];
+  for (size_t i = 1, len = option::countOption(); i < len; ++i) {
+    auto pref = option::i2p(i);
+    if (option.definedLocal(pref)) {
+      put(pref, option.values_[option.rank(pref)]);
     }
   }
 }
@@ -45,12 +45,32 @@
 
 namespace aria2 {
 
+// Holds option values overriding those of parent_.  Only the values
+// defined in this object are stored, so that an Option of a download,
+// which usually defines a handful of prefs, stays small.
 class Option {
 private:
-  std::vector<std::string> table_;
-  std::vector<unsigned char> use_;
+  struct UseWord {
+    // Bit i is set if the pref whose ID is 32*w+i is defined, where w
+    // is the index of this word.
+    uint32_t bits;
+    // The number of bits set in the preceding words.
+    uint32_t rank;
+  };
+  std::vector<UseWord> use_;
+  // Values of the defined prefs in the order of their IDs.  The
+  // position of a value is found from use_ without a search.  The
+  // strings are interned, because values such as dir and header are
+  // repeated in many downloads.
+  std::vector<std::shared_ptr<const std::string>> values_;
   std::shared_ptr<Option> parent_;
 
+  // Returns the position of the value of |pref| in values_, which
+  // must be defined in this object, or the position it is inserted
+  // at if it is not.
+  size_t rank(PrefPtr pref) const;
+  void put(PrefPtr pref, std::shared_ptr<const std::string> value);
+
 public:
   Option();
   ~Option();
@@ -83,9 +103,6 @@ public:
   // Removes all option values from this object. This function does
   // not modify parent_.
   void clear();
-  // Returns the option value table of this object. It does not
-  // contain option values in parent_ and so forth.
-  const std::vector<std::string>& getTable() const { return table_; }
   // Copy option values defined in option to this option. parent_ is
   // left unmodified for this object.
   void merge(const Option& option);
@@ -125,6 +125,19 @@ std::vector<OptionHandler*> OptionHandlerFactory::createOptionHandlers()
     op->addTag(TAG_ADVANCED);
     handlers.push_back(op);
   }
+  {
+    OptionHandler* op(new NumberOptionHandler(
+        PREF_BANDWIDTH_WEIGHT, TEXT_BANDWIDTH_WEIGHT, "1", 1, 1000));
+    op->addTag(TAG_ADVANCED);
+    op->addTag(TAG_BITTORRENT);
+    op->addTag(TAG_FTP);
+    op->addTag(TAG_HTTP);
+    op->setInitialOption(true);
+    op->setChangeOption(true);
+    op->setChangeGlobalOption(true);
+    op->setChangeOptionForReserved(true);
+    handlers.push_back(op);
+  }
   {
     OptionHandler* op(new BooleanOptionHandler(PREF_CHECK_INTEGRITY,
                                                TEXT_CHECK_INTEGRITY, A2_V_FALSE,
@@ -228,6 +241,26 @@ std::vector<OptionHandler*> OptionHandlerFactory::createOptionHandlers()
     op->addTag(TAG_ADVANCED);
     handlers.push_back(op);
   }
+  {
+    OptionHandler* op(new DefaultOptionHandler(PREF_DNS_CACHE_FILE,
+                                               TEXT_DNS_CACHE_FILE,
+                                               NO_DEFAULT_VALUE, PATH_TO_FILE));
+    op->addTag(TAG_ADVANCED);
+    handlers.push_back(op);
+  }
+  {
+    OptionHandler* op(new NumberOptionHandler(
+        PREF_DNS_CACHE_TTL, TEXT_DNS_CACHE_TTL, "300", 1, INT32_MAX));
+    op->addTag(TAG_ADVANCED);
+    handlers.push_back(op);
+  }
+  {
+    OptionHandler* op(new NumberOptionHandler(PREF_DNS_NEGATIVE_CACHE_TTL,
+                                              TEXT_DNS_NEGATIVE_CACHE_TTL, "5",
+                                              0, INT32_MAX));
+    op->addTag(TAG_ADVANCED);
+    handlers.push_back(op);
+  }
   {
     OptionHandler* op(
         new NumberOptionHandler(PREF_DNS_TIMEOUT, NO_DESCRIPTION, "30", 1, 60));
@@ -242,6 +275,14 @@ std::vector<OptionHandler*> OptionHandlerFactory::createOptionHandlers()
     op->setChangeGlobalOption(true);
     handlers.push_back(op);
   }
+  {
+    OptionHandler* op(new DefaultOptionHandler(
+        PREF_DOWNLOAD_RESULT_ARCHIVE, TEXT_DOWNLOAD_RESULT_ARCHIVE,
+        NO_DEFAULT_VALUE, PATH_TO_FILE));
+    op->addTag(TAG_ADVANCED);
+    op->addTag(TAG_RPC);
+    handlers.push_back(op);
+  }
 #ifdef ENABLE_ASYNC_DNS
   {
     // TODO Deprecated
@@ -392,6 +433,17 @@ std::vector<OptionHandler*> OptionHandlerFactory::createOptionHandlers()
     op->addTag(TAG_ADVANCED);
     handlers.push_back(op);
   }
+  {
+    OptionHandler* op(new BooleanOptionHandler(PREF_JOURNAL_CONTROL_FILE,
+                                               TEXT_JOURNAL_CONTROL_FILE,
+                                               A2_V_FALSE,
+                                               OptionHandler::OPT_ARG));
+    op->addTag(TAG_ADVANCED);
+    op->setInitialOption(true);
+    op->setChangeGlobalOption(true);
+    op->setChangeOptionForReserved(true);
+    handlers.push_back(op);
+  }
   {
     OptionHandler* op(new DefaultOptionHandler(
         PREF_LOG, TEXT_LOG, NO_DEFAULT_VALUE, PATH_TO_FILE_STDOUT,
@@ -428,6 +480,19 @@ std::vector<OptionHandler*> OptionHandlerFactory::createOptionHandlers()
     op->setChangeOptionForReserved(true);
     handlers.push_back(op);
   }
+  {
+    OptionHandler* op(new BooleanOptionHandler(PREF_ADAPTIVE_CONNECTION,
+                                               TEXT_ADAPTIVE_CONNECTION,
+                                               A2_V_FALSE,
+                                               OptionHandler::OPT_ARG));
+    op->addTag(TAG_FTP);
+    op->addTag(TAG_HTTP);
+    op->addTag(TAG_EXPERIMENTAL);
+    op->setInitialOption(true);
+    op->setChangeGlobalOption(true);
+    op->setChangeOptionForReserved(true);
+    handlers.push_back(op);
+  }
   {
     OptionHandler* op(new UnitNumberOptionHandler(
         PREF_MAX_DOWNLOAD_LIMIT, TEXT_MAX_DOWNLOAD_LIMIT, "0", 0));
@@ -490,6 +555,14 @@ std::vector<OptionHandler*> OptionHandlerFactory::createOptionHandlers()
     handlers.push_back(op);
   }
 #ifdef ENABLE_SSL
+  {
+    OptionHandler* op(new BooleanOptionHandler(PREF_ENABLE_KTLS,
+                                               TEXT_ENABLE_KTLS, A2_V_FALSE,
+                                               OptionHandler::OPT_ARG));
+    op->addTag(TAG_ADVANCED);
+    op->addTag(TAG_EXPERIMENTAL);
+    handlers.push_back(op);
+  }
   {
     OptionHandler* op(new ParameterOptionHandler(
         PREF_MIN_TLS_VERSION, TEXT_MIN_TLS_VERSION, A2_V_TLS10,
@@ -671,6 +744,19 @@ std::vector<OptionHandler*> OptionHandlerFactory::createOptionHandlers()
     op->addTag(TAG_ADVANCED);
     handlers.push_back(op);
   }
+  {
+    OptionHandler* op(new UnitNumberOptionHandler(
+        PREF_SPEED_LIMIT_BURST, TEXT_SPEED_LIMIT_BURST, "0", 0, 1_g));
+    op->addTag(TAG_ADVANCED);
+    op->addTag(TAG_BITTORRENT);
+    op->addTag(TAG_FTP);
+    op->addTag(TAG_HTTP);
+    op->setInitialOption(true);
+    op->setChangeOption(true);
+    op->setChangeGlobalOption(true);
+    op->setChangeOptionForReserved(true);
+    handlers.push_back(op);
+  }
   {
     OptionHandler* op(
         new NumberOptionHandler(PREF_STOP, TEXT_STOP, "0", 0, INT32_MAX));
@@ -729,6 +815,15 @@ std::vector<OptionHandler*> OptionHandlerFactory::createOptionHandlers()
     op->addTag(TAG_RPC);
     handlers.push_back(op);
   }
+#ifdef HAVE_SYS_UN_H
+  {
+    OptionHandler* op(new DefaultOptionHandler(
+        PREF_RPC_LISTEN_UNIX, TEXT_RPC_LISTEN_UNIX, NO_DEFAULT_VALUE,
+        PATH_TO_FILE));
+    op->addTag(TAG_RPC);
+    handlers.push_back(op);
+  }
+#endif // HAVE_SYS_UN_H
   {
     OptionHandler* op(new UnitNumberOptionHandler(
         PREF_RPC_MAX_REQUEST_SIZE, TEXT_RPC_MAX_REQUEST_SIZE, "2M", 0));
@@ -967,7 +1062,7 @@ std::vector<OptionHandler*> OptionHandlerFactory::createOptionHandlers()
   {
     OptionHandler* op(new ParameterOptionHandler(
         PREF_URI_SELECTOR, TEXT_URI_SELECTOR, V_FEEDBACK,
-        {V_INORDER, V_FEEDBACK, V_ADAPTIVE}));
+        {V_INORDER, V_FEEDBACK, V_ADAPTIVE, V_BANDIT}));
     op->addTag(TAG_FTP);
     op->addTag(TAG_HTTP);
     op->setInitialOption(true);
@@ -1031,6 +1126,20 @@ std::vector<OptionHandler*> OptionHandlerFactory::createOptionHandlers()
     op->setChangeOptionForReserved(true);
     handlers.push_back(op);
   }
+#ifdef ENABLE_HTTP2
+  {
+    OptionHandler* op(new BooleanOptionHandler(PREF_ENABLE_HTTP2,
+                                               TEXT_ENABLE_HTTP2, A2_V_FALSE,
+                                               OptionHandler::OPT_ARG));
+    op->addTag(TAG_HTTP);
+    op->addTag(TAG_HTTPS);
+    op->addTag(TAG_EXPERIMENTAL);
+    op->setInitialOption(true);
+    op->setChangeGlobalOption(true);
+    op->setChangeOptionForReserved(true);
+    handlers.push_back(op);
+  }
+#endif // ENABLE_HTTP2
   {
     OptionHandler* op(new CumulativeOptionHandler(PREF_HEADER, TEXT_HEADER,
                                                   NO_DEFAULT_VALUE, "\n"));
@@ -1106,6 +1215,15 @@ std::vector<OptionHandler*> OptionHandlerFactory::createOptionHandlers()
     op->hide();
     handlers.push_back(op);
   }
+  {
+    OptionHandler* op(new NumberOptionHandler(
+        PREF_MAX_HTTP_RANGES, TEXT_MAX_HTTP_RANGES, "1", 1, 64));
+    op->addTag(TAG_HTTP);
+    op->setInitialOption(true);
+    op->setChangeGlobalOption(true);
+    op->setChangeOptionForReserved(true);
+    handlers.push_back(op);
+  }
   {
     OptionHandler* op(new DefaultOptionHandler(PREF_METALINK_LOCATION,
                                                TEXT_METALINK_LOCATION));
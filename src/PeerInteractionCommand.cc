@@ -356,10 +356,7 @@ bool PeerInteractionCommand::executeInternal()
           setWriteCheckSocket(getSocket());
         }
 
-        if (getDownloadEngine()
-                ->getRequestGroupMan()
-                ->doesOverallDownloadSpeedExceed() ||
-            requestGroup_->doesDownloadSpeedExceed()) {
+        if (btInteractive_->isDownloadLimitReached()) {
           disableReadCheckSocket();
           setNoCheck(true);
         }
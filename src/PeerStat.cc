@@ -60,6 +60,16 @@ int PeerStat::calculateAvgDownloadSpeed()
   return netStat_.calculateAvgDownloadSpeed();
 }
 
+int PeerStat::calculateInstantDownloadSpeed()
+{
+  return netStat_.calculateInstantDownloadSpeed();
+}
+
+int PeerStat::calculateSmoothedDownloadSpeed()
+{
+  return netStat_.calculateSmoothedDownloadSpeed();
+}
+
 int PeerStat::calculateUploadSpeed() { return netStat_.calculateUploadSpeed(); }
 
 int PeerStat::calculateAvgUploadSpeed()
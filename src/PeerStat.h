@@ -64,6 +64,10 @@ public:
 
   int calculateAvgDownloadSpeed();
 
+  int calculateInstantDownloadSpeed();
+
+  int calculateSmoothedDownloadSpeed();
+
   int calculateUploadSpeed();
 
   int calculateAvgUploadSpeed();
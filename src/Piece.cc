@@ -369,6 +369,26 @@ size_t Piece::appendWrCache(WrDiskCache* diskCache, int64_t goff,
   return delta;
 }
 
+std::pair<unsigned char*, size_t>
+Piece::getWrCacheAppendBuffer(int64_t goff) const
+{
+  if (!wrCache_) {
+    return {nullptr, 0};
+  }
+  return wrCache_->getAppendBuffer(goff);
+}
+
+void Piece::commitWrCacheAppend(WrDiskCache* diskCache, size_t len)
+{
+  if (!diskCache || len == 0) {
+    return;
+  }
+  assert(wrCache_);
+  wrCache_->commitAppend(len);
+  bool rv = diskCache->update(wrCache_.get(), len);
+  assert(rv);
+}
+
 void Piece::releaseWrCache(WrDiskCache* diskCache)
 {
   if (diskCache && wrCache_) {
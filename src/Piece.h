@@ -187,6 +187,11 @@ public:
   }
   size_t appendWrCache(WrDiskCache* diskCache, int64_t goff,
                        const unsigned char* data, size_t len);
+  // Returns the memory in the write cache where the data at |goff|
+  // can be written without copy, and its length.  The data written
+  // there must be committed by commitWrCacheAppend().
+  std::pair<unsigned char*, size_t> getWrCacheAppendBuffer(int64_t goff) const;
+  void commitWrCacheAppend(WrDiskCache* diskCache, size_t len);
   void releaseWrCache(WrDiskCache* diskCache);
   WrDiskCacheEntry* getWrDiskCacheEntry() const { return wrCache_.get(); }
 };
@@ -37,6 +37,7 @@
 #include "IteratableChunkChecksumValidator.h"
 #include "DownloadContext.h"
 #include "PieceStorage.h"
+#include "BtProgressInfoFile.h"
 #include "a2functional.h"
 
 namespace aria2 {
@@ -62,6 +63,10 @@ void PieceHashCheckIntegrityEntry::initValidator()
       getRequestGroup()->getDownloadContext(),
       getRequestGroup()->getPieceStorage());
   validator->init();
+  const auto& progressInfoFile = getRequestGroup()->getProgressInfoFile();
+  if (progressInfoFile && progressInfoFile->getUnchangedPieces()) {
+    validator->setUnchangedPieces(*progressInfoFile->getUnchangedPieces());
+  }
   setValidator(std::move(validator));
 }
 
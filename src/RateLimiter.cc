@@ -0,0 +1,269 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2015 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "RateLimiter.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "wallclock.h"
+#include "a2time.h"
+
+namespace aria2 {
+
+namespace {
+// A child which has not asked for tokens in this period does not get
+// its share.
+constexpr auto ACTIVE_PERIOD = 1_s;
+
+// The minimum burst, so that a typical socket read is not split.
+constexpr int64_t MIN_BURST = 16_k;
+
+// Waiting shorter than this only makes event loop spin.
+constexpr auto MIN_WAIT_TIME = A2_DELTA_MILLIS;
+
+constexpr int64_t REFILL_PERIOD_MICROS = 10000;
+} // namespace
+
+RateLimiter::RateLimiter(RateLimiter* parent, int rate)
+    : parent_(nullptr),
+      rate_(rate),
+      burst_(0),
+      weight_(1),
+      pool_(0),
+      credit_(0),
+      refillRemainder_(0),
+      lastRefill_(global::wallclock()),
+      lastActive_(Timer::zero())
+{
+  if (rate_ > 0) {
+    pool_ = getEffectiveBurst();
+  }
+  setParent(parent);
+}
+
+RateLimiter::~RateLimiter()
+{
+  setParent(nullptr);
+  for (auto child : children_) {
+    child->parent_ = nullptr;
+  }
+}
+
+void RateLimiter::setParent(RateLimiter* parent)
+{
+  if (parent_ == parent) {
+    return;
+  }
+  if (parent_) {
+    auto& siblings = parent_->children_;
+    siblings.erase(std::remove(std::begin(siblings), std::end(siblings), this),
+                   std::end(siblings));
+  }
+  parent_ = parent;
+  credit_ = 0;
+  if (parent_) {
+    parent_->children_.push_back(this);
+  }
+}
+
+void RateLimiter::setRate(int rate)
+{
+  bool start = rate_ == 0 && rate > 0;
+  rate_ = rate;
+  if (start) {
+    // Start with full bucket.
+    pool_ = getEffectiveBurst();
+    refillRemainder_ = 0;
+    lastRefill_ = global::wallclock();
+  }
+}
+
+void RateLimiter::setBurst(int64_t burst) { burst_ = burst; }
+
+void RateLimiter::setWeight(int weight) { weight_ = std::max(1, weight); }
+
+int64_t RateLimiter::getEffectiveBurst() const
+{
+  return std::max(burst_ > 0 ? burst_ : static_cast<int64_t>(rate_),
+                  MIN_BURST);
+}
+
+bool RateLimiter::isActive() const
+{
+  return lastActive_.difference(global::wallclock()) < ACTIVE_PERIOD;
+}
+
+bool RateLimiter::limited() const
+{
+  for (auto node = this; node; node = node->parent_) {
+    if (node->rate_ > 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void RateLimiter::refill()
+{
+  if (rate_ == 0) {
+    return;
+  }
+  const auto& now = global::wallclock();
+  auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+                     lastRefill_.difference(now))
+                     .count();
+  // Refilling too often makes the shares of children small and the
+  // rounding errors large.
+  if (elapsed < REFILL_PERIOD_MICROS) {
+    return;
+  }
+  lastRefill_ = now;
+  int64_t burst = getEffectiveBurst();
+  // Don't let a long idle period overflow the computation below.
+  elapsed = std::min(elapsed, static_cast<int64_t>(burst * 1000000 / rate_ +
+                                                   1000000));
+  int64_t acc = rate_ * elapsed + refillRemainder_;
+  int64_t amount = acc / 1000000;
+  refillRemainder_ = acc % 1000000;
+
+  int64_t totalWeight = 0;
+  for (auto child : children_) {
+    if (child->isActive()) {
+      totalWeight += child->weight_;
+    }
+  }
+  int64_t rest = amount;
+  int64_t totalCredit = 0;
+  for (auto child : children_) {
+    if (totalWeight > 0 && child->isActive()) {
+      int64_t share = amount * child->weight_ / totalWeight;
+      int64_t room = burst * child->weight_ / totalWeight - child->credit_;
+      int64_t given = std::max(static_cast<int64_t>(0), std::min(share, room));
+      child->credit_ += given;
+      rest -= given;
+    }
+    totalCredit += std::max(child->credit_, static_cast<int64_t>(0));
+  }
+  // The tokens held by this node, including credits, never exceed
+  // burst.
+  pool_ = std::min(pool_ + rest,
+                   std::max(burst - totalCredit, static_cast<int64_t>(0)));
+}
+
+int64_t RateLimiter::getTokens(const RateLimiter* child) const
+{
+  int64_t tokens = pool_;
+  if (child) {
+    tokens = std::max(tokens, static_cast<int64_t>(0)) + child->credit_;
+  }
+  return tokens;
+}
+
+int64_t RateLimiter::available(const RateLimiter* child)
+{
+  int64_t avail = std::numeric_limits<int64_t>::max();
+  if (rate_ > 0) {
+    refill();
+    avail = std::max(getTokens(child), static_cast<int64_t>(0));
+  }
+  if (parent_) {
+    avail = std::min(avail, parent_->available(this));
+  }
+  return avail;
+}
+
+int64_t RateLimiter::getWaitMicros(const RateLimiter* child)
+{
+  int64_t wait = 0;
+  if (rate_ > 0) {
+    refill();
+    int64_t tokens = getTokens(child);
+    if (tokens <= 0) {
+      wait = (1 - tokens) * 1000000 / rate_;
+    }
+  }
+  if (parent_) {
+    wait = std::max(wait, parent_->getWaitMicros(this));
+  }
+  return wait;
+}
+
+void RateLimiter::charge(RateLimiter* child, int64_t len)
+{
+  if (rate_ > 0) {
+    if (child) {
+      // Use the credit first, then borrow from the pool.  The excess
+      // becomes the debt of the child so that it does not consume the
+      // share of the others.
+      int64_t rest = len;
+      int64_t m = std::max(static_cast<int64_t>(0),
+                           std::min(child->credit_, rest));
+      child->credit_ -= m;
+      rest -= m;
+      m = std::max(static_cast<int64_t>(0), std::min(pool_, rest));
+      pool_ -= m;
+      rest -= m;
+      child->credit_ -= rest;
+    }
+    else {
+      pool_ -= len;
+    }
+  }
+  if (parent_) {
+    parent_->charge(this, len);
+  }
+}
+
+size_t RateLimiter::getAllowance(size_t len)
+{
+  for (auto node = this; node; node = node->parent_) {
+    node->lastActive_ = global::wallclock();
+  }
+  return std::min(static_cast<int64_t>(len), available(nullptr));
+}
+
+bool RateLimiter::exhausted() { return available(nullptr) <= 0; }
+
+std::chrono::milliseconds RateLimiter::getWaitTime()
+{
+  auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::microseconds(getWaitMicros(nullptr)));
+  return std::min(std::max(wait, MIN_WAIT_TIME),
+                  std::chrono::milliseconds(1_s));
+}
+
+void RateLimiter::consume(size_t len) { charge(nullptr, len); }
+
+} // namespace aria2
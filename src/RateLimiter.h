@@ -0,0 +1,142 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2015 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_RATE_LIMITER_H
+#define D_RATE_LIMITER_H
+
+#include "common.h"
+
+#include <vector>
+
+#include "TimerA2.h"
+
+namespace aria2 {
+
+// Token bucket which forms a hierarchy of bandwidth limits: global,
+// per RequestGroup and per connection.  A transfer is allowed only if
+// this node and all its ancestors have tokens.
+//
+// A node with non-zero rate distributes its refill among the children
+// which were active recently, in proportion to their weights.  The
+// share of a child is kept as its credit and only that child can use
+// it.  The share which is not needed by any child goes to the shared
+// pool, and any child can borrow from it.  This way, a child gets at
+// least its weighted share under contention and can use the bandwidth
+// unused by the others.
+//
+// The tokens may become negative because the amount of data read from
+// socket is not known in advance.  The debt is paid back by refill.
+class RateLimiter {
+private:
+  RateLimiter* parent_;
+  std::vector<RateLimiter*> children_;
+  // Bytes per second.  0 means unlimited.
+  int rate_;
+  // The maximum number of tokens this node can accumulate.  0 means
+  // the amount of 1 second.
+  int64_t burst_;
+  int weight_;
+  // Tokens which are not assigned to any child.
+  int64_t pool_;
+  // Tokens assigned to this node by parent_.
+  int64_t credit_;
+  // Fractional part of refill, in bytes * microseconds.
+  int64_t refillRemainder_;
+  Timer lastRefill_;
+  Timer lastActive_;
+
+  int64_t getEffectiveBurst() const;
+
+  bool isActive() const;
+
+  void refill();
+
+  // Returns the number of tokens of this node available to |child|,
+  // which may be negative.  |child| may be nullptr, which means the
+  // request comes from this node.
+  int64_t getTokens(const RateLimiter* child) const;
+
+  // Returns the number of bytes |child| can transfer now.
+  int64_t available(const RateLimiter* child);
+
+  // Returns the time in microseconds until |child| can transfer.
+  int64_t getWaitMicros(const RateLimiter* child);
+
+  void charge(RateLimiter* child, int64_t len);
+
+public:
+  RateLimiter(RateLimiter* parent = nullptr, int rate = 0);
+
+  ~RateLimiter();
+
+  // Don't allow copying
+  RateLimiter(const RateLimiter&) = delete;
+  RateLimiter& operator=(const RateLimiter&) = delete;
+
+  void setParent(RateLimiter* parent);
+
+  RateLimiter* getParent() const { return parent_; }
+
+  void setRate(int rate);
+
+  int getRate() const { return rate_; }
+
+  void setBurst(int64_t burst);
+
+  void setWeight(int weight);
+
+  int getWeight() const { return weight_; }
+
+  // Returns true if this node or any of its ancestors has a limit.
+  bool limited() const;
+
+  // Returns the number of bytes, at most |len|, which can be
+  // transferred now.  This also marks this node and its ancestors
+  // active so that they get their share of bandwidth.
+  size_t getAllowance(size_t len);
+
+  // Returns true if no byte can be transferred now.
+  bool exhausted();
+
+  // Returns the time until getAllowance() is expected to return
+  // non-zero value.
+  std::chrono::milliseconds getWaitTime();
+
+  // Tells that |len| bytes have been transferred.
+  void consume(size_t len);
+};
+
+} // namespace aria2
+
+#endif // D_RATE_LIMITER_H
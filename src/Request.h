@@ -41,6 +41,7 @@
 
 #include "TimerA2.h"
 #include "uri.h"
+#include "Command.h"
 
 namespace aria2 {
 
@@ -69,6 +70,9 @@ private:
   bool pipeliningHint_;
   // maximum number of pipelined requests
   int maxPipelinedRequest_;
+  // maximum number of byte ranges requested in one request. 0 means
+  // that it has not been decided yet.
+  int maxRanges_;
   std::shared_ptr<PeerStat> peerStat_;
   bool removalRequested_;
   uint16_t connectedPort_;
@@ -137,6 +141,10 @@ public:
 
   int getMaxPipelinedRequest() const { return maxPipelinedRequest_; }
 
+  void setMaxRanges(int num) { maxRanges_ = num; }
+
+  int getMaxRanges() const { return maxRanges_; }
+
   void setMethod(const std::string& method);
 
   const std::string& getUsername() const { return us_.username; }
@@ -150,7 +158,8 @@ public:
 
   const std::shared_ptr<PeerStat>& getPeerStat() const { return peerStat_; }
 
-  const std::shared_ptr<PeerStat>& initPeerStat();
+  // Creates new PeerStat for the connection identified by cuid.
+  const std::shared_ptr<PeerStat>& initPeerStat(cuid_t cuid);
 
   void requestRemoval() { removalRequested_ = true; }
 
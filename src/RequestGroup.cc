@@ -36,6 +36,7 @@
 
 #include <cassert>
 #include <algorithm>
+#include <map>
 
 #include "PostDownloadHandler.h"
 #include "DownloadEngine.h"
@@ -72,6 +73,11 @@
 #include "A2STR.h"
 #include "URISelector.h"
 #include "InorderURISelector.h"
+#include "AdaptiveConnectionControl.h"
+#include "RateLimiter.h"
+#include "PeerStat.h"
+#include "wallclock.h"
+#include "uri.h"
 #include "PieceSelector.h"
 #include "a2functional.h"
 #include "SocketCore.h"
@@ -81,6 +87,8 @@
 #include "RequestGroupCriteria.h"
 #include "CheckIntegrityCommand.h"
 #include "ChecksumCheckIntegrityEntry.h"
+#include "InlineChecksumValidator.h"
+#include "MessageDigest.h"
 #ifdef ENABLE_BITTORRENT
 #include "bittorrent_helper.h"
 #include "BtRegistry.h"
@@ -119,6 +127,11 @@
 
 namespace aria2 {
 
+struct RequestGroup::PendingSpec {
+  std::vector<std::string> uris;
+  bool useOutOption;
+};
+
 RequestGroup::RequestGroup(const std::shared_ptr<GroupId>& gid,
                            const std::shared_ptr<Option>& option)
     : belongsToGID_(0),
@@ -141,6 +154,9 @@ RequestGroup::RequestGroup(const std::shared_ptr<GroupId>& gid,
       fileNotFoundCount_(0),
       maxDownloadSpeedLimit_(option->getAsInt(PREF_MAX_DOWNLOAD_LIMIT)),
       maxUploadSpeedLimit_(option->getAsInt(PREF_MAX_UPLOAD_LIMIT)),
+      downloadLimiter_(
+          make_unique<RateLimiter>(nullptr, maxDownloadSpeedLimit_)),
+      uploadLimiter_(make_unique<RateLimiter>(nullptr, maxUploadSpeedLimit_)),
       resumeFailureCount_(0),
       haltReason_(RequestGroup::NONE),
       lastErrorCode_(error_code::UNDEFINED),
@@ -153,6 +169,8 @@ RequestGroup::RequestGroup(const std::shared_ptr<GroupId>& gid,
       seedOnly_(false)
 {
   fileAllocationEnabled_ = option_->get(PREF_FILE_ALLOCATION) != V_NONE;
+  setBandwidthWeight(option_->getAsInt(PREF_BANDWIDTH_WEIGHT));
+  setSpeedLimitBurst(option_->getAsLLInt(PREF_SPEED_LIMIT_BURST));
   if (!option_->getAsBool(PREF_DRY_RUN)) {
     initializePreDownloadHandler();
     initializePostDownloadHandler();
@@ -604,12 +622,14 @@ void RequestGroup::initPieceStorage()
   segmentMan_ =
       std::make_shared<SegmentMan>(downloadContext_, tempPieceStorage);
   pieceStorage_ = tempPieceStorage;
+  inlineChecksumValidator_.reset();
 }
 
 void RequestGroup::dropPieceStorage()
 {
   segmentMan_.reset();
   pieceStorage_.reset();
+  inlineChecksumValidator_.reset();
 }
 
 bool RequestGroup::downloadFinishedByFileLength()
@@ -633,6 +653,10 @@ bool RequestGroup::downloadFinishedByFileLength()
 void RequestGroup::adjustFilename(
     const std::shared_ptr<BtProgressInfoFile>& infoFile)
 {
+  if (requestGroupMan_) {
+    // The caller may have changed the file path.
+    requestGroupMan_->updateFilePathIndex(this);
+  }
   if (!isPreLocalFileCheckEnabled()) {
     // OK, no need to care about filename.
     return;
@@ -752,8 +776,14 @@ void RequestGroup::tryAutoFileRenaming()
     auto newfilename = fmt("%s.%d", filepath.c_str(), i);
     File newfile(newfilename);
     File ctrlfile(newfile.getPath() + DefaultBtProgressInfoFile::getSuffix());
-    if (!newfile.exists() || (newfile.exists() && ctrlfile.exists())) {
+    if ((!newfile.exists() || (newfile.exists() && ctrlfile.exists())) &&
+        !(requestGroupMan_ &&
+          requestGroupMan_->isFilePathBeingDownloaded(newfile.getPath(),
+                                                      getGID()))) {
       downloadContext_->getFirstFileEntry()->setPath(newfile.getPath());
+      if (requestGroupMan_) {
+        requestGroupMan_->updateFilePathIndex(this);
+      }
       return;
     }
   }
@@ -822,7 +852,8 @@ void RequestGroup::createNextCommand(
 
 std::string RequestGroup::getFirstFilePath() const
 {
-  assert(downloadContext_);
+  assert(downloadContext_ || pendingSpec_);
+  materialize();
   if (inMemoryDownload()) {
     return "[MEMORY]" +
            File(downloadContext_->getFirstFileEntry()->getPath()).getBasename();
@@ -925,6 +956,9 @@ void RequestGroup::decreaseNumCommand()
 
 TransferStat RequestGroup::calculateStat() const
 {
+  if (pendingSpec_) {
+    return TransferStat();
+  }
   TransferStat stat = downloadContext_->getNetStat().toTransferStat();
 #ifdef ENABLE_BITTORRENT
   if (btRuntime_) {
@@ -955,7 +989,11 @@ void RequestGroup::setForceHaltRequested(bool f, HaltReason haltReason)
   forceHaltRequested_ = f;
 }
 
-void RequestGroup::setPauseRequested(bool f) { pauseRequested_ = f; }
+void RequestGroup::setPauseRequested(bool f)
+{
+  pauseRequested_ = f;
+  sessionEntry_.reset();
+}
 
 void RequestGroup::releaseRuntimeResource(DownloadEngine* e)
 {
@@ -1088,6 +1126,24 @@ void RequestGroup::setPieceStorage(
     const std::shared_ptr<PieceStorage>& pieceStorage)
 {
   pieceStorage_ = pieceStorage;
+  inlineChecksumValidator_.reset();
+}
+
+void RequestGroup::initInlineChecksumValidator()
+{
+  if (inlineChecksumValidator_ || !pieceStorage_ ||
+      !downloadContext_->isChecksumVerificationNeeded() ||
+      !downloadContext_->knowsTotalLength() ||
+      !MessageDigest::supports(downloadContext_->getHashType())) {
+    return;
+  }
+  inlineChecksumValidator_ = std::make_shared<InlineChecksumValidator>(
+      downloadContext_, pieceStorage_);
+}
+
+void RequestGroup::resetInlineChecksumValidator()
+{
+  inlineChecksumValidator_.reset();
 }
 
 void RequestGroup::setProgressInfoFile(
@@ -1108,13 +1164,15 @@ std::shared_ptr<DownloadResult> RequestGroup::createDownloadResult() const
 {
   A2_LOG_DEBUG(fmt("GID#%s - Creating DownloadResult.", gid_->toHex().c_str()));
   TransferStat st = calculateStat();
+  // Don't materialize a pending download just to save a session.
+  auto dctx = peekDownloadContext();
   auto res = std::make_shared<DownloadResult>();
   res->gid = gid_;
-  res->fileEntries = downloadContext_->getFileEntries();
+  res->fileEntries = dctx->getFileEntries();
   res->inMemoryDownload = inMemoryDownload_;
   res->sessionDownloadLength = st.sessionDownloadLength;
   res->sessionTime = std::chrono::duration_cast<std::chrono::milliseconds>(
-      downloadContext_->calculateSessionTime());
+      dctx->calculateSessionTime());
 
   auto result = downloadResult();
   res->result = result.first;
@@ -1132,13 +1190,13 @@ std::shared_ptr<DownloadResult> RequestGroup::createDownloadResult() const
                              pieceStorage_->getBitfieldLength());
   }
 #ifdef ENABLE_BITTORRENT
-  if (downloadContext_->hasAttribute(CTX_ATTR_BT)) {
-    const unsigned char* p = bittorrent::getInfoHash(downloadContext_);
+  if (dctx->hasAttribute(CTX_ATTR_BT)) {
+    const unsigned char* p = bittorrent::getInfoHash(dctx);
     res->infoHash.assign(p, p + INFO_HASH_LENGTH);
   }
 #endif // ENABLE_BITTORRENT
-  res->pieceLength = downloadContext_->getPieceLength();
-  res->numPieces = downloadContext_->getNumPieces();
+  res->pieceLength = dctx->getPieceLength();
+  res->numPieces = dctx->getNumPieces();
   res->dir = option_->get(PREF_DIR);
   return res;
 }
@@ -1170,6 +1228,84 @@ void RequestGroup::setURISelector(std::unique_ptr<URISelector> uriSelector)
   uriSelector_ = std::move(uriSelector);
 }
 
+void RequestGroup::setConnectionControl(
+    std::unique_ptr<AdaptiveConnectionControl> connectionControl)
+{
+  connectionControl_ = std::move(connectionControl);
+  if (!connectionControl_ || !downloadContext_) {
+    return;
+  }
+  // Apply the remembered levels before the first connections are
+  // made.
+  for (const auto& fileEntry : downloadContext_->getFileEntries()) {
+    for (const auto& uri : fileEntry->getRemainingUris()) {
+      uri_split_result us;
+      if (uri_split(&us, uri.c_str()) == -1) {
+        continue;
+      }
+      auto host = uri::getFieldString(us, USR_HOST, uri.c_str());
+      auto protocol = uri::getFieldString(us, USR_SCHEME, uri.c_str());
+      applyConnectionLevel(host, connectionControl_->getLevel(host, protocol));
+    }
+  }
+}
+
+void RequestGroup::applyConnectionLevel(const std::string& host, int level)
+{
+  for (const auto& fileEntry : downloadContext_->getFileEntries()) {
+    fileEntry->setMaxConnectionPerHost(host, level);
+  }
+}
+
+void RequestGroup::updateConnectionControl(DownloadEngine* e)
+{
+  if (!connectionControl_ || !segmentMan_ ||
+      connectionControlTimer_.difference(global::wallclock()) < 1_s) {
+    return;
+  }
+  connectionControlTimer_ = global::wallclock();
+  // (host, protocol) => (aggregate speed, number of connections)
+  std::map<std::pair<std::string, std::string>, std::pair<int, int>> stats;
+  for (const auto& ps : segmentMan_->getPeerStats()) {
+    if (ps->getStatus() != NetStat::ACTIVE) {
+      continue;
+    }
+    auto& v = stats[std::make_pair(ps->getHostname(), ps->getProtocol())];
+    v.first += ps->calculateDownloadSpeed();
+    ++v.second;
+  }
+  bool raised = false;
+  for (const auto& i : stats) {
+    const auto& host = i.first.first;
+    const auto& protocol = i.first.second;
+    if (connectionControl_->update(host, protocol, i.second.first,
+                                   i.second.second, global::wallclock())) {
+      raised = true;
+    }
+    applyConnectionLevel(host, connectionControl_->getLevel(host, protocol));
+  }
+  if (raised && numStreamCommand_ < numConcurrentCommand_) {
+    std::vector<std::unique_ptr<Command>> commands;
+    createNextCommand(commands, e, 1);
+    e->addCommand(std::move(commands));
+  }
+}
+
+void RequestGroup::onServerOverload(const std::shared_ptr<Request>& req)
+{
+  if (!connectionControl_) {
+    return;
+  }
+  uri_split_result us;
+  if (uri_split(&us, req->getUri().c_str()) == -1) {
+    return;
+  }
+  auto host = uri::getFieldString(us, USR_HOST, req->getUri().c_str());
+  auto protocol = uri::getFieldString(us, USR_SCHEME, req->getUri().c_str());
+  connectionControl_->onOverload(host, protocol, global::wallclock());
+  applyConnectionLevel(host, connectionControl_->getLevel(host, protocol));
+}
+
 void RequestGroup::applyLastModifiedTimeToLocalFiles()
 {
   if (!pieceStorage_ || !lastModifiedTime_.good()) {
@@ -1208,16 +1344,41 @@ void RequestGroup::setTimeout(std::chrono::seconds timeout)
   timeout_ = std::move(timeout);
 }
 
-bool RequestGroup::doesDownloadSpeedExceed()
+void RequestGroup::setMaxDownloadSpeedLimit(int speed)
+{
+  maxDownloadSpeedLimit_ = speed;
+  downloadLimiter_->setRate(speed);
+}
+
+void RequestGroup::setMaxUploadSpeedLimit(int speed)
+{
+  maxUploadSpeedLimit_ = speed;
+  uploadLimiter_->setRate(speed);
+}
+
+void RequestGroup::setBandwidthWeight(int weight)
 {
-  int spd = downloadContext_->getNetStat().calculateDownloadSpeed();
-  return maxDownloadSpeedLimit_ > 0 && maxDownloadSpeedLimit_ < spd;
+  downloadLimiter_->setWeight(weight);
+  uploadLimiter_->setWeight(weight);
 }
 
-bool RequestGroup::doesUploadSpeedExceed()
+void RequestGroup::setSpeedLimitBurst(int64_t burst)
 {
-  int spd = downloadContext_->getNetStat().calculateUploadSpeed();
-  return maxUploadSpeedLimit_ > 0 && maxUploadSpeedLimit_ < spd;
+  downloadLimiter_->setBurst(burst);
+  uploadLimiter_->setBurst(burst);
+}
+
+void RequestGroup::setRequestGroupMan(RequestGroupMan* requestGroupMan)
+{
+  requestGroupMan_ = requestGroupMan;
+  if (requestGroupMan_) {
+    downloadLimiter_->setParent(requestGroupMan_->getDownloadLimiter());
+    uploadLimiter_->setParent(requestGroupMan_->getUploadLimiter());
+  }
+  else {
+    downloadLimiter_->setParent(nullptr);
+    uploadLimiter_->setParent(nullptr);
+  }
 }
 
 void RequestGroup::saveControlFile() const
@@ -1232,9 +1393,68 @@ void RequestGroup::removeControlFile() const
   progressInfoFile_->removeFile();
 }
 
+void RequestGroup::setPendingUris(std::vector<std::string> uris,
+                                  bool useOutOption)
+{
+  downloadContext_.reset();
+  pendingSpec_ = make_unique<PendingSpec>();
+  pendingSpec_->uris = std::move(uris);
+  pendingSpec_->useOutOption = useOutOption;
+}
+
+namespace {
+std::shared_ptr<DownloadContext>
+createDownloadContext(const Option& option,
+                      const std::vector<std::string>& uris, bool useOutOption)
+{
+  auto dctx = std::make_shared<DownloadContext>(
+      option.getAsInt(PREF_PIECE_LENGTH), 0,
+      useOutOption && !option.blank(PREF_OUT)
+          ? util::applyDir(option.get(PREF_DIR), option.get(PREF_OUT))
+          : A2STR::NIL);
+  dctx->getFirstFileEntry()->setUris(uris);
+  dctx->getFirstFileEntry()->setMaxConnectionPerServer(
+      option.getAsInt(PREF_MAX_CONNECTION_PER_SERVER));
+  const std::string& checksum = option.get(PREF_CHECKSUM);
+  if (!checksum.empty()) {
+    auto p = util::divide(std::begin(checksum), std::end(checksum), '=');
+    std::string hashType(p.first.first, p.first.second);
+    std::string hexDigest(p.second.first, p.second.second);
+    util::lowercase(hashType);
+    dctx->setDigest(hashType,
+                    util::fromHex(std::begin(hexDigest), std::end(hexDigest)));
+  }
+  return dctx;
+}
+} // namespace
+
+void RequestGroup::materialize() const
+{
+  if (!pendingSpec_) {
+    return;
+  }
+  A2_LOG_DEBUG(fmt("GID#%s - Creating DownloadContext.", gid_->toHex().c_str()));
+  downloadContext_ = createDownloadContext(*option_, pendingSpec_->uris,
+                                           pendingSpec_->useOutOption);
+  // Only the lazily created members change here, so it is fine to
+  // become the owner through const_cast.
+  downloadContext_->setOwnerRequestGroup(const_cast<RequestGroup*>(this));
+  pendingSpec_.reset();
+}
+
+std::shared_ptr<DownloadContext> RequestGroup::peekDownloadContext() const
+{
+  if (pendingSpec_) {
+    return createDownloadContext(*option_, pendingSpec_->uris,
+                                 pendingSpec_->useOutOption);
+  }
+  return downloadContext_;
+}
+
 void RequestGroup::setDownloadContext(
     const std::shared_ptr<DownloadContext>& downloadContext)
 {
+  pendingSpec_.reset();
   downloadContext_ = downloadContext;
   if (downloadContext_) {
     downloadContext_->setOwnerRequestGroup(this);
@@ -45,6 +45,7 @@
 
 #include "TransferStat.h"
 #include "TimeA2.h"
+#include "TimerA2.h"
 #include "Request.h"
 #include "error_code.h"
 #include "MetadataInfo.h"
@@ -58,6 +59,7 @@ class Command;
 class DownloadCommand;
 class DownloadContext;
 class PieceStorage;
+class InlineChecksumValidator;
 class BtProgressInfoFile;
 class Dependency;
 class PreDownloadHandler;
@@ -67,7 +69,10 @@ class Option;
 class RequestGroup;
 class CheckIntegrityEntry;
 struct DownloadResult;
+struct SessionEntry;
 class URISelector;
+class AdaptiveConnectionControl;
+class RateLimiter;
 class URIResult;
 class RequestGroupMan;
 #ifdef ENABLE_BITTORRENT
@@ -98,10 +103,22 @@ private:
 
   std::shared_ptr<SegmentMan> segmentMan_;
 
-  std::shared_ptr<DownloadContext> downloadContext_;
+  // Created lazily from pendingSpec_ for a download which is added
+  // by URIs.  See setPendingUris().
+  mutable std::shared_ptr<DownloadContext> downloadContext_;
+
+  struct PendingSpec;
+
+  // Non-null while DownloadContext of this download has not been
+  // created yet.
+  mutable std::unique_ptr<PendingSpec> pendingSpec_;
 
   std::shared_ptr<PieceStorage> pieceStorage_;
 
+  // Computes whole file checksum while downloading.  nullptr if
+  // checksum is not computed that way.
+  std::shared_ptr<InlineChecksumValidator> inlineChecksumValidator_;
+
   std::shared_ptr<BtProgressInfoFile> progressInfoFile_;
 
   std::shared_ptr<DiskWriterFactory> diskWriterFactory_;
@@ -110,6 +127,11 @@ private:
 
   std::unique_ptr<URISelector> uriSelector_;
 
+  std::unique_ptr<AdaptiveConnectionControl> connectionControl_;
+
+  // Last time when connectionControl_ was updated.
+  Timer connectionControlTimer_;
+
   std::shared_ptr<MetadataInfo> metadataInfo_;
 
   RequestGroupMan* requestGroupMan_;
@@ -154,6 +176,12 @@ private:
 
   int maxUploadSpeedLimit_;
 
+  // Speed limiters of this download.  Their parents are the ones of
+  // RequestGroupMan, and connections attach their limiters to them.
+  std::unique_ptr<RateLimiter> downloadLimiter_;
+
+  std::unique_ptr<RateLimiter> uploadLimiter_;
+
   int resumeFailureCount_;
 
   HaltReason haltReason_;
@@ -162,6 +190,10 @@ private:
 
   std::string lastErrorMessage_;
 
+  // Serialized form of this download in a session file, kept while
+  // this download is waiting and does not change.
+  std::shared_ptr<SessionEntry> sessionEntry_;
+
   bool saveControlFile_;
 
   bool fileAllocationEnabled_;
@@ -268,11 +300,35 @@ public:
 
   TransferStat calculateStat() const;
 
+  // Returns DownloadContext of this download.  If this download is
+  // pending, DownloadContext is created here.
   const std::shared_ptr<DownloadContext>& getDownloadContext() const
   {
+    if (pendingSpec_) {
+      materialize();
+    }
     return downloadContext_;
   }
 
+  // Makes this download pending: DownloadContext with a single file
+  // entry is not created until it is needed.  |uris| are the URIs of
+  // that file entry.  If |useOutOption| is true, PREF_OUT is used as
+  // its path.  This keeps a download waiting in the queue small.
+  void setPendingUris(std::vector<std::string> uris, bool useOutOption);
+
+  // Returns true if DownloadContext of this download has not been
+  // created yet.
+  bool isPending() const { return pendingSpec_.get(); }
+
+  // Creates DownloadContext of a pending download.  Does nothing if
+  // this download is not pending.
+  void materialize() const;
+
+  // Returns DownloadContext of this download.  If this download is
+  // pending, returns a new DownloadContext which is not owned by
+  // this object, leaving this download pending.
+  std::shared_ptr<DownloadContext> peekDownloadContext() const;
+
   // This function also calls
   // downloadContext->setOwnerRequestGroup(this).
   void
@@ -285,9 +341,26 @@ public:
 
   void setPieceStorage(const std::shared_ptr<PieceStorage>& pieceStorage);
 
+  // Creates InlineChecksumValidator if it has not been created yet
+  // and whole file checksum verification is needed.
+  void initInlineChecksumValidator();
+
+  const std::shared_ptr<InlineChecksumValidator>&
+  getInlineChecksumValidator() const
+  {
+    return inlineChecksumValidator_;
+  }
+
+  void resetInlineChecksumValidator();
+
   void setProgressInfoFile(
       const std::shared_ptr<BtProgressInfoFile>& progressInfoFile);
 
+  const std::shared_ptr<BtProgressInfoFile>& getProgressInfoFile() const
+  {
+    return progressInfoFile_;
+  }
+
   void increaseStreamCommand();
 
   void decreaseStreamCommand();
@@ -381,6 +454,9 @@ public:
 
   void adjustFilename(const std::shared_ptr<BtProgressInfoFile>& infoFile);
 
+  // Sets the maximum number of connections to host in all FileEntries.
+  void applyConnectionLevel(const std::string& host, int level);
+
   std::shared_ptr<DownloadResult> createDownloadResult() const;
 
   const std::shared_ptr<Option>& getOption() const { return option_; }
@@ -394,6 +470,23 @@ public:
     return uriSelector_;
   }
 
+  void setConnectionControl(
+      std::unique_ptr<AdaptiveConnectionControl> connectionControl);
+
+  const std::unique_ptr<AdaptiveConnectionControl>&
+  getConnectionControl() const
+  {
+    return connectionControl_;
+  }
+
+  // Feeds the download speed from each server to connectionControl_,
+  // and creates a new connection if it allows one more connection.
+  // This function does nothing if connectionControl_ is not set.
+  void updateConnectionControl(DownloadEngine* e);
+
+  // Tells connectionControl_ that the server of req is overloaded.
+  void onServerOverload(const std::shared_ptr<Request>& req);
+
   void applyLastModifiedTimeToLocalFiles();
 
   void updateLastModifiedTime(const Time& time);
@@ -410,23 +503,23 @@ public:
 
   const std::chrono::seconds& getTimeout() const { return timeout_; }
 
-  // Returns true if current download speed exceeds
-  // maxDownloadSpeedLimit_.  Always returns false if
-  // maxDownloadSpeedLimit_ == 0.  Otherwise returns false.
-  bool doesDownloadSpeedExceed();
-
-  // Returns true if current upload speed exceeds
-  // maxUploadSpeedLimit_. Always returns false if
-  // maxUploadSpeedLimit_ == 0. Otherwise returns false.
-  bool doesUploadSpeedExceed();
-
   int getMaxDownloadSpeedLimit() const { return maxDownloadSpeedLimit_; }
 
-  void setMaxDownloadSpeedLimit(int speed) { maxDownloadSpeedLimit_ = speed; }
+  void setMaxDownloadSpeedLimit(int speed);
 
   int getMaxUploadSpeedLimit() const { return maxUploadSpeedLimit_; }
 
-  void setMaxUploadSpeedLimit(int speed) { maxUploadSpeedLimit_ = speed; }
+  void setMaxUploadSpeedLimit(int speed);
+
+  RateLimiter* getDownloadLimiter() const { return downloadLimiter_.get(); }
+
+  RateLimiter* getUploadLimiter() const { return uploadLimiter_.get(); }
+
+  // Sets the weight used when this download shares bandwidth with
+  // other downloads.
+  void setBandwidthWeight(int weight);
+
+  void setSpeedLimitBurst(int64_t burst);
 
   void setLastErrorCode(error_code::Value code, const char* message = "")
   {
@@ -459,10 +552,9 @@ public:
 
   a2_gid_t belongsTo() const { return belongsToGID_; }
 
-  void setRequestGroupMan(RequestGroupMan* requestGroupMan)
-  {
-    requestGroupMan_ = requestGroupMan;
-  }
+  // This function also attaches the speed limiters of this object
+  // to the ones of |requestGroupMan|.
+  void setRequestGroupMan(RequestGroupMan* requestGroupMan);
 
   RequestGroupMan* getRequestGroupMan() { return requestGroupMan_; }
 
@@ -484,7 +576,26 @@ public:
 
   int getState() const { return state_; }
 
-  void setState(int state) { state_ = state; }
+  void setState(int state)
+  {
+    state_ = state;
+    sessionEntry_.reset();
+  }
+
+  const std::shared_ptr<SessionEntry>& getSessionEntry() const
+  {
+    return sessionEntry_;
+  }
+
+  void setSessionEntry(std::shared_ptr<SessionEntry> entry)
+  {
+    sessionEntry_ = std::move(entry);
+  }
+
+  // Discards the cached session entry.  Call this when this download
+  // is changed in a way saved in a session file (e.g., its options or
+  // URIs).
+  void markSessionDirty() { sessionEntry_.reset(); }
 
   bool isSeedOnlyEnabled() { return seedOnly_; }
 
@@ -51,13 +51,17 @@
 #include "message.h"
 #include "a2functional.h"
 #include "DownloadResult.h"
+#include "DownloadResultArchive.h"
 #include "DownloadContext.h"
 #include "ServerStatMan.h"
 #include "ServerStat.h"
+#include "HostConnectionRegistry.h"
 #include "SegmentMan.h"
 #include "FeedbackURISelector.h"
 #include "InorderURISelector.h"
 #include "AdaptiveURISelector.h"
+#include "BanditURISelector.h"
+#include "AdaptiveConnectionControl.h"
 #include "Option.h"
 #include "prefs.h"
 #include "File.h"
@@ -83,6 +87,7 @@
 #include "SimpleRandomizer.h"
 #include "array_fun.h"
 #include "OpenedFileCounter.h"
+#include "RateLimiter.h"
 #ifdef ENABLE_BITTORRENT
 #include "bittorrent_helper.h"
 #endif // ENABLE_BITTORRENT
@@ -100,6 +105,12 @@ void appendReservedGroup(RequestGroupList& list, InputIterator first,
 }
 } // namespace
 
+namespace {
+// The number of archived download results kept in memory before the
+// older ones are written to the archive file.
+constexpr size_t MAX_ARCHIVED_RESULT_IN_MEMORY = 10000;
+} // namespace
+
 RequestGroupMan::RequestGroupMan(
     std::vector<std::shared_ptr<RequestGroup>> requestGroups,
     int maxSimultaneousDownloads, const Option* option)
@@ -107,10 +118,15 @@ RequestGroupMan::RequestGroupMan(
       numActive_(0),
       option_(option),
       serverStatMan_(std::make_shared<ServerStatMan>()),
+      hostConnectionRegistry_(make_unique<HostConnectionRegistry>()),
       maxOverallDownloadSpeedLimit_(
           option->getAsInt(PREF_MAX_OVERALL_DOWNLOAD_LIMIT)),
       maxOverallUploadSpeedLimit_(
           option->getAsInt(PREF_MAX_OVERALL_UPLOAD_LIMIT)),
+      downloadLimiter_(
+          make_unique<RateLimiter>(nullptr, maxOverallDownloadSpeedLimit_)),
+      uploadLimiter_(
+          make_unique<RateLimiter>(nullptr, maxOverallUploadSpeedLimit_)),
       keepRunning_(option->getAsBool(PREF_ENABLE_RPC)),
       queueCheck_(true),
       removedErrorResult_(0),
@@ -120,6 +136,11 @@ RequestGroupMan::RequestGroupMan(
           this, option->getAsInt(PREF_BT_MAX_OPEN_FILES))),
       numStoppedTotal_(0)
 {
+  setSpeedLimitBurst(option->getAsLLInt(PREF_SPEED_LIMIT_BURST));
+  if (!option->blank(PREF_DOWNLOAD_RESULT_ARCHIVE)) {
+    downloadResultArchive_ = make_unique<DownloadResultArchive>(
+        option->get(PREF_DOWNLOAD_RESULT_ARCHIVE), MAX_ARCHIVED_RESULT_IN_MEMORY);
+  }
   appendReservedGroup(reservedGroups_, requestGroups.begin(),
                       requestGroups.end());
 }
@@ -134,11 +155,23 @@ bool RequestGroupMan::downloadFinished()
   return requestGroups_.empty() && reservedGroups_.empty();
 }
 
+namespace {
+void setHostConnectionRegistry(RequestGroup* group,
+                               HostConnectionRegistry* registry)
+{
+  for (const auto& fileEntry : group->getDownloadContext()->getFileEntries()) {
+    fileEntry->setHostConnectionRegistry(registry);
+  }
+}
+} // namespace
+
 void RequestGroupMan::addRequestGroup(
     const std::shared_ptr<RequestGroup>& group)
 {
+  setHostConnectionRegistry(group.get(), hostConnectionRegistry_.get());
   ++numActive_;
   requestGroups_.push_back(group->getGID(), group);
+  updateFilePathIndex(group.get());
 }
 
 void RequestGroupMan::addReservedGroup(
@@ -326,6 +359,7 @@ public:
   bool operator()(const RequestGroupList::value_type& group)
   {
     if (group->getNumCommand() == 0) {
+      e_->getRequestGroupMan()->removeFilePathIndex(group->getGID());
       collectStat(group);
       const std::shared_ptr<DownloadContext>& dctx =
           group->getDownloadContext();
@@ -458,6 +492,18 @@ void RequestGroupMan::configureRequestGroup(
     requestGroup->setURISelector(
         make_unique<AdaptiveURISelector>(serverStatMan_, requestGroup.get()));
   }
+  else if (uriSelectorValue == V_BANDIT) {
+    requestGroup->setURISelector(
+        make_unique<BanditURISelector>(serverStatMan_));
+  }
+  if (requestGroup->getOption()->getAsBool(PREF_ADAPTIVE_CONNECTION)) {
+    requestGroup->setConnectionControl(make_unique<AdaptiveConnectionControl>(
+        std::min(
+            requestGroup->getOption()->getAsInt(PREF_MAX_CONNECTION_PER_SERVER),
+            requestGroup->getOption()->getAsInt(PREF_SPLIT)),
+        serverStatMan_));
+  }
+  setHostConnectionRegistry(requestGroup.get(), hostConnectionRegistry_.get());
 }
 
 namespace {
@@ -504,6 +550,9 @@ void RequestGroupMan::fillRequestGroupFromReserver(DownloadEngine* e)
       pending.push_back(groupToAdd);
       continue;
     }
+    // Waiting downloads added by URIs do not have DownloadContext
+    // yet.  Create it now that the download starts.
+    groupToAdd->materialize();
     // Drop pieceStorage here because paused download holds its
     // reference.
     groupToAdd->dropPieceStorage();
@@ -512,6 +561,7 @@ void RequestGroupMan::fillRequestGroupFromReserver(DownloadEngine* e)
     groupToAdd->setState(RequestGroup::STATE_ACTIVE);
     ++numActive_;
     requestGroups_.push_back(groupToAdd->getGID(), groupToAdd);
+    updateFilePathIndex(groupToAdd.get());
     try {
       auto res = createInitialCommand(groupToAdd, e);
       ++count;
@@ -797,20 +847,30 @@ std::string RequestGroupMan::formatDownloadResult(
   return o.str();
 }
 
-namespace {
-template <typename StringInputIterator, typename FileEntryInputIterator>
-bool sameFilePathExists(StringInputIterator sfirst, StringInputIterator slast,
-                        FileEntryInputIterator ffirst,
-                        FileEntryInputIterator flast)
+bool RequestGroupMan::isFilePathBeingDownloaded(const std::string& path,
+                                                a2_gid_t gid) const
 {
-  for (; ffirst != flast; ++ffirst) {
-    if (std::binary_search(sfirst, slast, (*ffirst)->getPath())) {
+  auto range = filePathIndex_.equal_range(path);
+  for (auto i = range.first; i != range.second; ++i) {
+    if (i->second == gid) {
+      continue;
+    }
+    auto rg = requestGroups_.get(i->second);
+    if (!rg) {
+      continue;
+    }
+    // The index may be stale if the path was changed without
+    // updateFilePathIndex().
+    const auto& entries = rg->getDownloadContext()->getFileEntries();
+    if (std::find_if(entries.begin(), entries.end(),
+                     [&path](const std::shared_ptr<FileEntry>& fileEntry) {
+                       return fileEntry->getPath() == path;
+                     }) != entries.end()) {
       return true;
     }
   }
   return false;
 }
-} // namespace
 
 bool RequestGroupMan::isSameFileBeingDownloaded(
     RequestGroup* requestGroup) const
@@ -820,20 +880,44 @@ bool RequestGroupMan::isSameFileBeingDownloaded(
   if (!requestGroup->isPreLocalFileCheckEnabled()) {
     return false;
   }
-  std::vector<std::string> files;
-  for (auto& rg : requestGroups_) {
-    if (rg.get() != requestGroup) {
-      const std::vector<std::shared_ptr<FileEntry>>& entries =
-          rg->getDownloadContext()->getFileEntries();
-      std::transform(entries.begin(), entries.end(), std::back_inserter(files),
-                     std::mem_fn(&FileEntry::getPath));
+  for (auto& fileEntry : requestGroup->getDownloadContext()->getFileEntries()) {
+    if (isFilePathBeingDownloaded(fileEntry->getPath(),
+                                  requestGroup->getGID())) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void RequestGroupMan::updateFilePathIndex(RequestGroup* requestGroup)
+{
+  removeFilePathIndex(requestGroup->getGID());
+  if (!requestGroups_.get(requestGroup->getGID())) {
+    return;
+  }
+  auto& paths = indexedFilePaths_[requestGroup->getGID()];
+  for (auto& fileEntry : requestGroup->getDownloadContext()->getFileEntries()) {
+    paths.push_back(fileEntry->getPath());
+    filePathIndex_.emplace(fileEntry->getPath(), requestGroup->getGID());
+  }
+}
+
+void RequestGroupMan::removeFilePathIndex(a2_gid_t gid)
+{
+  auto i = indexedFilePaths_.find(gid);
+  if (i == indexedFilePaths_.end()) {
+    return;
+  }
+  for (auto& path : i->second) {
+    auto range = filePathIndex_.equal_range(path);
+    for (auto j = range.first; j != range.second; ++j) {
+      if (j->second == gid) {
+        filePathIndex_.erase(j);
+        break;
+      }
     }
   }
-  std::sort(files.begin(), files.end());
-  const std::vector<std::shared_ptr<FileEntry>>& entries =
-      requestGroup->getDownloadContext()->getFileEntries();
-  return sameFilePathExists(files.begin(), files.end(), entries.begin(),
-                            entries.end());
+  indexedFilePaths_.erase(i);
 }
 
 void RequestGroupMan::halt()
@@ -856,21 +940,36 @@ TransferStat RequestGroupMan::calculateStat()
   return netStat_.toTransferStat();
 }
 
+size_t RequestGroupMan::countDownloadResult() const
+{
+  return downloadResults_.size() +
+         (downloadResultArchive_ ? downloadResultArchive_->size() : 0);
+}
+
 std::shared_ptr<DownloadResult>
 RequestGroupMan::findDownloadResult(a2_gid_t gid) const
 {
-  return downloadResults_.get(gid);
+  auto dr = downloadResults_.get(gid);
+  if (!dr && downloadResultArchive_) {
+    dr = downloadResultArchive_->get(gid);
+  }
+  return dr;
 }
 
 bool RequestGroupMan::removeDownloadResult(a2_gid_t gid)
 {
-  return downloadResults_.remove(gid);
+  return downloadResults_.remove(gid) ||
+         (downloadResultArchive_ && downloadResultArchive_->remove(gid));
 }
 
 void RequestGroupMan::addDownloadResult(
     const std::shared_ptr<DownloadResult>& dr)
 {
   ++numStoppedTotal_;
+  if (downloadResultArchive_) {
+    // The GID of an archived result may have been reused.
+    downloadResultArchive_->remove(dr->gid->getNumericId());
+  }
   bool rv = downloadResults_.push_back(dr->gid->getNumericId(), dr);
   assert(rv);
   while (downloadResults_.size() > maxDownloadResult_) {
@@ -882,11 +981,20 @@ void RequestGroupMan::addDownloadResult(
       removedLastErrorResult_ = dr->result;
       ++removedErrorResult_;
     }
+    if (downloadResultArchive_) {
+      downloadResultArchive_->add(*dr);
+    }
     downloadResults_.pop_front();
   }
 }
 
-void RequestGroupMan::purgeDownloadResult() { downloadResults_.clear(); }
+void RequestGroupMan::purgeDownloadResult()
+{
+  downloadResults_.clear();
+  if (downloadResultArchive_) {
+    downloadResultArchive_->clear();
+  }
+}
 
 std::shared_ptr<ServerStat>
 RequestGroupMan::findServerStat(const std::string& hostname,
@@ -928,60 +1036,28 @@ void RequestGroupMan::removeStaleServerStat(const std::chrono::seconds& timeout)
   serverStatMan_->removeStaleServerStat(timeout);
 }
 
-bool RequestGroupMan::doesOverallDownloadSpeedExceed()
+void RequestGroupMan::setMaxOverallDownloadSpeedLimit(int speed)
+{
+  maxOverallDownloadSpeedLimit_ = speed;
+  downloadLimiter_->setRate(speed);
+}
+
+void RequestGroupMan::setMaxOverallUploadSpeedLimit(int speed)
 {
-  return maxOverallDownloadSpeedLimit_ > 0 &&
-         maxOverallDownloadSpeedLimit_ < netStat_.calculateDownloadSpeed();
+  maxOverallUploadSpeedLimit_ = speed;
+  uploadLimiter_->setRate(speed);
 }
 
-bool RequestGroupMan::doesOverallUploadSpeedExceed()
+void RequestGroupMan::setSpeedLimitBurst(int64_t burst)
 {
-  return maxOverallUploadSpeedLimit_ > 0 &&
-         maxOverallUploadSpeedLimit_ < netStat_.calculateUploadSpeed();
+  downloadLimiter_->setBurst(burst);
+  uploadLimiter_->setBurst(burst);
 }
 
 void RequestGroupMan::getUsedHosts(
     std::vector<std::pair<size_t, std::string>>& usedHosts)
 {
-  // vector of tuple which consists of use count, -download speed,
-  // hostname. We want to sort by least used and faster download
-  // speed. We use -download speed so that we can sort them using
-  // operator<().
-  std::vector<std::tuple<size_t, int, std::string>> tempHosts;
-  for (const auto& rg : requestGroups_) {
-    const auto& inFlightReqs =
-        rg->getDownloadContext()->getFirstFileEntry()->getInFlightRequests();
-    for (const auto& req : inFlightReqs) {
-      uri_split_result us;
-      if (uri_split(&us, req->getUri().c_str()) == 0) {
-        std::string host =
-            uri::getFieldString(us, USR_HOST, req->getUri().c_str());
-        auto k = tempHosts.begin();
-        auto eok = tempHosts.end();
-        for (; k != eok; ++k) {
-          if (std::get<2>(*k) == host) {
-            ++std::get<0>(*k);
-            break;
-          }
-        }
-        if (k == eok) {
-          std::string protocol =
-              uri::getFieldString(us, USR_SCHEME, req->getUri().c_str());
-          auto ss = findServerStat(host, protocol);
-          int invDlSpeed = (ss && ss->isOK())
-                               ? -(static_cast<int>(ss->getDownloadSpeed()))
-                               : 0;
-          tempHosts.emplace_back(1, invDlSpeed, host);
-        }
-      }
-    }
-  }
-  std::sort(tempHosts.begin(), tempHosts.end());
-  std::transform(tempHosts.begin(), tempHosts.end(),
-                 std::back_inserter(usedHosts),
-                 [](const std::tuple<size_t, int, std::string>& x) {
-                   return std::make_pair(std::get<0>(x), std::get<2>(x));
-                 });
+  hostConnectionRegistry_->getUsedHosts(usedHosts, serverStatMan_.get());
 }
 
 void RequestGroupMan::setUriListParser(
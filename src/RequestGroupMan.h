@@ -41,6 +41,7 @@
 #include <deque>
 #include <vector>
 #include <map>
+#include <unordered_map>
 #include <memory>
 
 #include "DownloadResult.h"
@@ -61,6 +62,10 @@ class OutputFile;
 class UriListParser;
 class WrDiskCache;
 class OpenedFileCounter;
+class RateLimiter;
+class HostConnectionRegistry;
+class DownloadResultArchive;
+struct SessionEntry;
 
 typedef IndexedList<a2_gid_t, std::shared_ptr<RequestGroup>> RequestGroupList;
 typedef IndexedList<a2_gid_t, std::shared_ptr<DownloadResult>>
@@ -71,6 +76,9 @@ private:
   RequestGroupList requestGroups_;
   RequestGroupList reservedGroups_;
   DownloadResultList downloadResults_;
+  // Download results evicted from downloadResults_.  Null unless
+  // --download-result-archive is given.
+  std::unique_ptr<DownloadResultArchive> downloadResultArchive_;
 
   int maxSimultaneousDownloads_;
 
@@ -85,10 +93,19 @@ private:
 
   std::shared_ptr<ServerStatMan> serverStatMan_;
 
+  // The number of connections per host across active downloads.
+  std::unique_ptr<HostConnectionRegistry> hostConnectionRegistry_;
+
   int maxOverallDownloadSpeedLimit_;
 
   int maxOverallUploadSpeedLimit_;
 
+  // The roots of the download and upload speed limit hierarchy.
+  // RequestGroups attach their limiters to them.
+  std::unique_ptr<RateLimiter> downloadLimiter_;
+
+  std::unique_ptr<RateLimiter> uploadLimiter_;
+
   NetStat netStat_;
 
   // true if download engine should keep running even if there is no
@@ -117,8 +134,13 @@ private:
   // evicted DownloadResults.
   size_t numStoppedTotal_;
 
-  // SHA1 hash value of the content of last session serialization.
-  std::string lastSessionHash_;
+  // Entries of the last session serialization.
+  std::vector<std::shared_ptr<SessionEntry>> lastSessionEntries_;
+
+  // File paths of active downloads and the GID owning them.  The
+  // paths indexed for each GID are kept to remove them later.
+  std::unordered_multimap<std::string, a2_gid_t> filePathIndex_;
+  std::unordered_map<a2_gid_t, std::vector<std::string>> indexedFilePaths_;
 
   void formatDownloadResultFull(
       OutputFile& out, const char* status,
@@ -199,6 +221,17 @@ public:
 
   bool isSameFileBeingDownloaded(RequestGroup* requestGroup) const;
 
+  // Returns true if |path| is written by an active download other
+  // than the one identified by |gid|.
+  bool isFilePathBeingDownloaded(const std::string& path, a2_gid_t gid) const;
+
+  // Indexes current file paths of |requestGroup|, replacing the ones
+  // indexed before.  This must be called when the download starts or
+  // its file paths are changed.
+  void updateFilePathIndex(RequestGroup* requestGroup);
+
+  void removeFilePathIndex(a2_gid_t gid);
+
   TransferStat calculateStat();
 
   class DownloadStat {
@@ -235,6 +268,18 @@ public:
     return downloadResults_;
   }
 
+  // Returns the archived download results, or null if archiving is
+  // disabled.  They are older than the ones in getDownloadResults().
+  const DownloadResultArchive* getDownloadResultArchive() const
+  {
+    return downloadResultArchive_.get();
+  }
+
+  // Returns the number of download results including archived ones.
+  size_t countDownloadResult() const;
+
+  // Looks up download result of gid in getDownloadResults() and then
+  // in the archive.
   std::shared_ptr<DownloadResult> findDownloadResult(a2_gid_t gid) const;
 
   // Removes all download results.
@@ -261,36 +306,26 @@ public:
 
   void removeStaleServerStat(const std::chrono::seconds& timeout);
 
-  // Returns true if current download speed exceeds
-  // maxOverallDownloadSpeedLimit_.  Always returns false if
-  // maxOverallDownloadSpeedLimit_ == 0.  Otherwise returns false.
-  bool doesOverallDownloadSpeedExceed();
-
-  void setMaxOverallDownloadSpeedLimit(int speed)
-  {
-    maxOverallDownloadSpeedLimit_ = speed;
-  }
+  void setMaxOverallDownloadSpeedLimit(int speed);
 
   int getMaxOverallDownloadSpeedLimit() const
   {
     return maxOverallDownloadSpeedLimit_;
   }
 
-  // Returns true if current upload speed exceeds
-  // maxOverallUploadSpeedLimit_. Always returns false if
-  // maxOverallUploadSpeedLimit_ == 0. Otherwise returns false.
-  bool doesOverallUploadSpeedExceed();
-
-  void setMaxOverallUploadSpeedLimit(int speed)
-  {
-    maxOverallUploadSpeedLimit_ = speed;
-  }
+  void setMaxOverallUploadSpeedLimit(int speed);
 
   int getMaxOverallUploadSpeedLimit() const
   {
     return maxOverallUploadSpeedLimit_;
   }
 
+  RateLimiter* getDownloadLimiter() const { return downloadLimiter_.get(); }
+
+  RateLimiter* getUploadLimiter() const { return uploadLimiter_.get(); }
+
+  void setSpeedLimitBurst(int64_t burst);
+
   void setMaxSimultaneousDownloads(int max) { maxSimultaneousDownloads_ = max; }
 
   // Call this function if requestGroups_ queue should be maintained.
@@ -305,6 +340,11 @@ public:
   // Returns currently used hosts and its use count.
   void getUsedHosts(std::vector<std::pair<size_t, std::string>>& usedHosts);
 
+  const HostConnectionRegistry* getHostConnectionRegistry() const
+  {
+    return hostConnectionRegistry_.get();
+  }
+
   const std::shared_ptr<ServerStatMan>& getServerStatMan() const
   {
     return serverStatMan_;
@@ -328,12 +368,17 @@ public:
 
   size_t getNumStoppedTotal() const { return numStoppedTotal_; }
 
-  void setLastSessionHash(std::string lastSessionHash)
+  void setLastSessionEntries(
+      std::vector<std::shared_ptr<SessionEntry>> lastSessionEntries)
   {
-    lastSessionHash_ = std::move(lastSessionHash);
+    lastSessionEntries_ = std::move(lastSessionEntries);
   }
 
-  const std::string& getLastSessionHash() const { return lastSessionHash_; }
+  const std::vector<std::shared_ptr<SessionEntry>>&
+  getLastSessionEntries() const
+  {
+    return lastSessionEntries_;
+  }
 
   const std::shared_ptr<OpenedFileCounter>& getOpenedFileCounter() const
   {
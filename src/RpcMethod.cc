@@ -49,6 +49,7 @@
 #include "DlAbortEx.h"
 #include "a2functional.h"
 #include "util.h"
+#include "json.h"
 
 namespace aria2 {
 
@@ -88,12 +89,25 @@ void RpcMethod::authorize(RpcRequest& req, DownloadEngine* e)
   }
 }
 
+bool RpcMethod::processJson(const RpcRequest& req, DownloadEngine* e,
+                            json::JsonWriter& out)
+{
+  return false;
+}
+
 RpcResponse RpcMethod::execute(RpcRequest req, DownloadEngine* e)
 {
   auto authorized = RpcResponse::NOTAUTHORIZED;
   try {
     authorize(req, e);
     authorized = RpcResponse::AUTHORIZED;
+    if (req.jsonStream) {
+      std::string json;
+      json::JsonWriter out(json);
+      if (processJson(req, e, out)) {
+        return RpcResponse(0, authorized, std::move(json), std::move(req.id));
+      }
+    }
     auto r = process(req, e);
     return RpcResponse(0, authorized, std::move(r), std::move(req.id));
   }
@@ -49,6 +49,10 @@ class OptionParser;
 class Option;
 class Exception;
 
+namespace json {
+class JsonWriter;
+} // namespace json
+
 namespace rpc {
 
 struct RpcRequest;
@@ -73,6 +77,14 @@ protected:
   virtual std::unique_ptr<ValueBase> process(const RpcRequest& req,
                                              DownloadEngine* e) = 0;
 
+  // Subclass may implement this function to write the result of req
+  // to out in JSON directly, without building ValueBase objects.  It
+  // is only called if req.jsonStream is true.  Returns false if this
+  // is not supported, and process() is used instead.  The default
+  // implementation returns false.
+  virtual bool processJson(const RpcRequest& req, DownloadEngine* e,
+                           json::JsonWriter& out);
+
   void gatherRequestOption(Option* option, const Dict* optionsDict);
 
   void gatherChangeableOption(Option* option, const Dict* optionDict);
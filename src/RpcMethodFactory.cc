@@ -51,7 +51,7 @@ std::unique_ptr<RpcMethod> noSuchRpcMethod;
 
 namespace {
 std::vector<std::string> rpcMethodNames = {
-    "aria2.addUri",
+    "aria2.addUri", "aria2.addUris",
 #ifdef ENABLE_BITTORRENT
     "aria2.addTorrent", "aria2.getPeers",
 #endif // ENABLE_BITTORRENT
@@ -67,7 +67,11 @@ std::vector<std::string> rpcMethodNames = {
     "aria2.changeGlobalOption", "aria2.purgeDownloadResult",
     "aria2.removeDownloadResult", "aria2.getVersion", "aria2.getSessionInfo",
     "aria2.shutdown", "aria2.forceShutdown", "aria2.getGlobalStat",
-    "aria2.saveSession", "system.multicall", "system.listMethods",
+    "aria2.getHostStat", "aria2.saveSession",
+#ifdef ENABLE_WEBSOCKET
+    "aria2.subscribe", "aria2.unsubscribe",
+#endif // ENABLE_WEBSOCKET
+    "system.multicall", "system.listMethods",
 };
 } // namespace
 
@@ -80,6 +84,10 @@ std::unique_ptr<RpcMethod> createMethod(const std::string& methodName)
     return make_unique<AddUriRpcMethod>();
   }
 
+  if (methodName == AddUrisRpcMethod::getMethodName()) {
+    return make_unique<AddUrisRpcMethod>();
+  }
+
 #ifdef ENABLE_BITTORRENT
   if (methodName == AddTorrentRpcMethod::getMethodName()) {
     return make_unique<AddTorrentRpcMethod>();
@@ -208,10 +216,24 @@ std::unique_ptr<RpcMethod> createMethod(const std::string& methodName)
     return make_unique<GetGlobalStatRpcMethod>();
   }
 
+  if (methodName == GetHostStatRpcMethod::getMethodName()) {
+    return make_unique<GetHostStatRpcMethod>();
+  }
+
   if (methodName == SaveSessionRpcMethod::getMethodName()) {
     return make_unique<SaveSessionRpcMethod>();
   }
 
+#ifdef ENABLE_WEBSOCKET
+  if (methodName == SubscribeRpcMethod::getMethodName()) {
+    return make_unique<SubscribeRpcMethod>();
+  }
+
+  if (methodName == UnsubscribeRpcMethod::getMethodName()) {
+    return make_unique<UnsubscribeRpcMethod>();
+  }
+#endif // ENABLE_WEBSOCKET
+
   if (methodName == SystemMulticallRpcMethod::getMethodName()) {
     return make_unique<SystemMulticallRpcMethod>();
   }
@@ -69,6 +69,19 @@
 #include "MessageDigest.h"
 #include "message_digest_helper.h"
 #include "OpenedFileCounter.h"
+#include "HostConnectionRegistry.h"
+#include "DownloadResultArchive.h"
+#include "ServerStat.h"
+#include "SocketCore.h"
+#include "json.h"
+#ifdef ENABLE_WEBSOCKET
+#include "WebSocketSession.h"
+#include "WebSocketSessionMan.h"
+#include "WebSocketInteractionCommand.h"
+#endif // ENABLE_WEBSOCKET
+#ifdef ENABLE_SSL
+#include "TLSSessionCache.h"
+#endif // ENABLE_SSL
 #ifdef ENABLE_BITTORRENT
 #include "bittorrent_helper.h"
 #include "BtRegistry.h"
@@ -102,6 +115,10 @@ const char KEY_TOTAL_LENGTH[] = "totalLength";
 const char KEY_COMPLETED_LENGTH[] = "completedLength";
 const char KEY_DOWNLOAD_SPEED[] = "downloadSpeed";
 const char KEY_UPLOAD_SPEED[] = "uploadSpeed";
+const char KEY_INSTANT_DOWNLOAD_SPEED[] = "instantDownloadSpeed";
+const char KEY_INSTANT_UPLOAD_SPEED[] = "instantUploadSpeed";
+const char KEY_SMOOTHED_DOWNLOAD_SPEED[] = "smoothedDownloadSpeed";
+const char KEY_SMOOTHED_UPLOAD_SPEED[] = "smoothedUploadSpeed";
 const char KEY_UPLOAD_LENGTH[] = "uploadLength";
 const char KEY_CONNECTIONS[] = "connections";
 const char KEY_BITFIELD[] = "bitfield";
@@ -131,6 +148,7 @@ const char KEY_SESSION_ID[] = "sessionId";
 const char KEY_FILES[] = "files";
 const char KEY_DIR[] = "dir";
 const char KEY_URIS[] = "uris";
+const char KEY_OPTIONS[] = "options";
 const char KEY_BITTORRENT[] = "bittorrent";
 const char KEY_INFO[] = "info";
 const char KEY_NAME[] = "name";
@@ -143,12 +161,23 @@ const char KEY_NUM_WAITING[] = "numWaiting";
 const char KEY_NUM_STOPPED[] = "numStopped";
 const char KEY_NUM_ACTIVE[] = "numActive";
 const char KEY_NUM_STOPPED_TOTAL[] = "numStoppedTotal";
+const char KEY_NUM_TLS_HANDSHAKE[] = "numTLSHandshake";
+const char KEY_NUM_TLS_RESUMED[] = "numTLSResumed";
+const char KEY_HOST[] = "host";
+const char KEY_PROTOCOL[] = "protocol";
+
+// Keys whose values come from RequestGroup::calculateStat()
+const char* TRANSFER_STAT_KEYS[] = {
+    KEY_DOWNLOAD_SPEED,         KEY_UPLOAD_SPEED,
+    KEY_INSTANT_DOWNLOAD_SPEED, KEY_INSTANT_UPLOAD_SPEED,
+    KEY_SMOOTHED_DOWNLOAD_SPEED, KEY_SMOOTHED_UPLOAD_SPEED,
+    KEY_UPLOAD_LENGTH};
 } // namespace
 
 namespace {
 std::unique_ptr<ValueBase> createGIDResponse(a2_gid_t gid)
 {
-  return String::g(GroupId::toHex(gid));
+  return Gid::g(gid);
 }
 } // namespace
 
@@ -198,6 +227,12 @@ a2_gid_t str2Gid(const String* str)
   case GroupId::ERR_NOT_UNIQUE:
     throw DL_ABORT_EX(fmt("GID %s is not unique", str->s().c_str()));
   case GroupId::ERR_NOT_FOUND:
+    // Archived download results do not keep their GIDs in use.  They
+    // can be looked up by the full GID.
+    if (str->s().size() == sizeof(a2_gid_t) * 2 &&
+        GroupId::toNumericId(n, str->s().c_str()) == 0) {
+      break;
+    }
     throw DL_ABORT_EX(fmt("GID %s is not found", str->s().c_str()));
   case GroupId::ERR_INVALID:
     throw DL_ABORT_EX(fmt("Invalid GID %s", str->s().c_str()));
@@ -206,6 +241,21 @@ a2_gid_t str2Gid(const String* str)
 }
 } // namespace
 
+namespace {
+// GIDs are hex strings, but MessagePack-RPC clients may send back the
+// GIDs they received in integers.
+a2_gid_t getRequiredGid(const RpcRequest& req, size_t index)
+{
+  if (req.params->size() > index) {
+    const Integer* gidParam = downcast<Integer>(req.params->get(index));
+    if (gidParam) {
+      return static_cast<a2_gid_t>(gidParam->i());
+    }
+  }
+  return str2Gid(checkRequiredParam<String>(req, index));
+}
+} // namespace
+
 namespace {
 template <typename OutputIterator>
 void extractUris(OutputIterator out, const List* src)
@@ -253,6 +303,83 @@ std::unique_ptr<ValueBase> AddUriRpcMethod::process(const RpcRequest& req,
   }
 }
 
+namespace {
+// Creates RequestGroup from |uris| using |option| and returns it.
+// Only the first RequestGroup is used, as aria2.addUri does.
+std::shared_ptr<RequestGroup>
+createRequestGroupForUris(const std::shared_ptr<Option>& option,
+                          const std::vector<std::string>& uris)
+{
+  if (uris.empty()) {
+    throw DL_ABORT_EX("URI is not provided.");
+  }
+  std::vector<std::shared_ptr<RequestGroup>> result;
+  createRequestGroupForUri(result, option, uris,
+                           /* ignoreForceSeq = */ true,
+                           /* ignoreLocalPath = */ true);
+  if (result.empty()) {
+    throw DL_ABORT_EX("No URI to download.");
+  }
+  return result.front();
+}
+} // namespace
+
+std::unique_ptr<ValueBase> AddUrisRpcMethod::process(const RpcRequest& req,
+                                                     DownloadEngine* e)
+{
+  const List* itemsParam = checkRequiredParam<List>(req, 0);
+  const Dict* optsParam = checkParam<Dict>(req, 1);
+  const Integer* posParam = checkParam<Integer>(req, 2);
+
+  // Options shared by all items are validated only once.  Each item
+  // may overlay its own options on a copy of them.
+  auto requestOption = std::make_shared<Option>(*e->getOption());
+  gatherRequestOption(requestOption.get(), optsParam);
+
+  bool posGiven = checkPosParam(posParam);
+  size_t pos = posGiven ? posParam->i() : 0;
+
+  std::vector<std::shared_ptr<RequestGroup>> result;
+  result.reserve(itemsParam->size());
+  std::vector<std::string> uris;
+  for (auto& elem : *itemsParam) {
+    uris.clear();
+    auto option = requestOption;
+    if (auto urisParam = downcast<List>(elem)) {
+      extractUris(std::back_inserter(uris), urisParam);
+    }
+    else if (auto itemParam = downcast<Dict>(elem)) {
+      extractUris(std::back_inserter(uris),
+                  downcast<List>(itemParam->get(KEY_URIS)));
+      auto itemOptsParam = downcast<Dict>(itemParam->get(KEY_OPTIONS));
+      if (itemOptsParam && !itemOptsParam->empty()) {
+        option = std::make_shared<Option>(*requestOption);
+        gatherRequestOption(option.get(), itemOptsParam);
+      }
+    }
+    else {
+      throw DL_ABORT_EX(
+          fmt("Item #%lu must be an array of URIs or a struct.",
+              static_cast<unsigned long>(result.size())));
+    }
+    result.push_back(createRequestGroupForUris(option, uris));
+  }
+  // Nothing is added unless all items are valid.
+  auto gids = List::g();
+  if (!result.empty()) {
+    if (posGiven) {
+      e->getRequestGroupMan()->insertReservedGroup(pos, result);
+    }
+    else {
+      e->getRequestGroupMan()->addReservedGroup(result);
+    }
+    for (auto& group : result) {
+      gids->append(Gid::g(group->getGID()));
+    }
+  }
+  return std::move(gids);
+}
+
 namespace {
 std::string getHexSha1(const std::string& s)
 {
@@ -374,7 +501,7 @@ std::unique_ptr<ValueBase> AddMetalinkRpcMethod::process(const RpcRequest& req,
       e->getRequestGroupMan()->addReservedGroup(result);
     }
     for (auto& i : result) {
-      gids->append(GroupId::toHex(i->getGID()));
+      gids->append(Gid::g(i->getGID()));
     }
   }
   return std::move(gids);
@@ -385,9 +512,7 @@ namespace {
 std::unique_ptr<ValueBase> removeDownload(const RpcRequest& req,
                                           DownloadEngine* e, bool forceRemove)
 {
-  const String* gidParam = checkRequiredParam<String>(req, 0);
-
-  a2_gid_t gid = str2Gid(gidParam);
+  a2_gid_t gid = getRequiredGid(req, 0);
   auto group = e->getRequestGroupMan()->findGroup(gid);
   if (group) {
     if (group->getState() == RequestGroup::STATE_ACTIVE) {
@@ -433,9 +558,7 @@ namespace {
 std::unique_ptr<ValueBase> pauseDownload(const RpcRequest& req,
                                          DownloadEngine* e, bool forcePause)
 {
-  const String* gidParam = checkRequiredParam<String>(req, 0);
-
-  a2_gid_t gid = str2Gid(gidParam);
+  a2_gid_t gid = getRequiredGid(req, 0);
   auto group = e->getRequestGroupMan()->findGroup(gid);
   if (group) {
     bool reserved = group->getState() == RequestGroup::STATE_WAITING;
@@ -500,9 +623,7 @@ ForcePauseAllRpcMethod::process(const RpcRequest& req, DownloadEngine* e)
 std::unique_ptr<ValueBase> UnpauseRpcMethod::process(const RpcRequest& req,
                                                      DownloadEngine* e)
 {
-  const String* gidParam = checkRequiredParam<String>(req, 0);
-
-  a2_gid_t gid = str2Gid(gidParam);
+  a2_gid_t gid = getRequiredGid(req, 0);
   auto group = e->getRequestGroupMan()->findGroup(gid);
   if (!group || group->getState() != RequestGroup::STATE_WAITING ||
       !group->isPauseRequested()) {
@@ -609,13 +730,14 @@ bool requested_key(const std::vector<std::string>& keys, const std::string& k)
 }
 } // namespace
 
-void gatherProgressCommon(Dict* entryDict,
+template <typename EntryDict>
+void gatherProgressCommon(EntryDict* entryDict,
                           const std::shared_ptr<RequestGroup>& group,
                           const std::vector<std::string>& keys)
 {
   auto& ps = group->getPieceStorage();
   if (requested_key(keys, KEY_GID)) {
-    entryDict->put(KEY_GID, GroupId::toHex(group->getGID()).c_str());
+    entryDict->put(KEY_GID, Gid::g(group->getGID()));
   }
   if (requested_key(keys, KEY_TOTAL_LENGTH)) {
     // This is "filtered" total length if --select-file is used.
@@ -626,13 +748,33 @@ void gatherProgressCommon(Dict* entryDict,
     entryDict->put(KEY_COMPLETED_LENGTH,
                    util::itos(group->getCompletedLength()));
   }
-  TransferStat stat = group->calculateStat();
+  TransferStat stat;
+  if (std::any_of(std::begin(TRANSFER_STAT_KEYS), std::end(TRANSFER_STAT_KEYS),
+                  [&keys](const char* k) { return requested_key(keys, k); })) {
+    stat = group->calculateStat();
+  }
   if (requested_key(keys, KEY_DOWNLOAD_SPEED)) {
     entryDict->put(KEY_DOWNLOAD_SPEED, util::itos(stat.downloadSpeed));
   }
   if (requested_key(keys, KEY_UPLOAD_SPEED)) {
     entryDict->put(KEY_UPLOAD_SPEED, util::itos(stat.uploadSpeed));
   }
+  if (requested_key(keys, KEY_INSTANT_DOWNLOAD_SPEED)) {
+    entryDict->put(KEY_INSTANT_DOWNLOAD_SPEED,
+                   util::itos(stat.instantDownloadSpeed));
+  }
+  if (requested_key(keys, KEY_INSTANT_UPLOAD_SPEED)) {
+    entryDict->put(KEY_INSTANT_UPLOAD_SPEED,
+                   util::itos(stat.instantUploadSpeed));
+  }
+  if (requested_key(keys, KEY_SMOOTHED_DOWNLOAD_SPEED)) {
+    entryDict->put(KEY_SMOOTHED_DOWNLOAD_SPEED,
+                   util::itos(stat.smoothedDownloadSpeed));
+  }
+  if (requested_key(keys, KEY_SMOOTHED_UPLOAD_SPEED)) {
+    entryDict->put(KEY_SMOOTHED_UPLOAD_SPEED,
+                   util::itos(stat.smoothedUploadSpeed));
+  }
   if (requested_key(keys, KEY_UPLOAD_LENGTH)) {
     entryDict->put(KEY_UPLOAD_LENGTH, util::itos(stat.allTimeUploadLength));
   }
@@ -647,7 +789,13 @@ void gatherProgressCommon(Dict* entryDict,
       }
     }
   }
-  auto& dctx = group->getDownloadContext();
+  // A pending download is reported without creating its
+  // DownloadContext.
+  std::shared_ptr<DownloadContext> dctx;
+  if (requested_key(keys, KEY_PIECE_LENGTH) ||
+      requested_key(keys, KEY_NUM_PIECES) || requested_key(keys, KEY_FILES)) {
+    dctx = group->peekDownloadContext();
+  }
   if (requested_key(keys, KEY_PIECE_LENGTH)) {
     entryDict->put(KEY_PIECE_LENGTH, util::itos(dctx->getPieceLength()));
   }
@@ -659,14 +807,14 @@ void gatherProgressCommon(Dict* entryDict,
       auto list = List::g();
       // The element is GID.
       for (auto& gid : group->followedBy()) {
-        list->append(GroupId::toHex(gid));
+        list->append(Gid::g(gid));
       }
       entryDict->put(KEY_FOLLOWED_BY, std::move(list));
     }
   }
   if (requested_key(keys, KEY_BELONGS_TO)) {
     if (group->belongsTo()) {
-      entryDict->put(KEY_BELONGS_TO, GroupId::toHex(group->belongsTo()));
+      entryDict->put(KEY_BELONGS_TO, Gid::g(group->belongsTo()));
     }
   }
   if (requested_key(keys, KEY_FILES)) {
@@ -681,6 +829,14 @@ void gatherProgressCommon(Dict* entryDict,
   }
 }
 
+template void gatherProgressCommon(Dict* entryDict,
+                                   const std::shared_ptr<RequestGroup>& group,
+                                   const std::vector<std::string>& keys);
+
+template void gatherProgressCommon(json::JsonWriter* entryDict,
+                                   const std::shared_ptr<RequestGroup>& group,
+                                   const std::vector<std::string>& keys);
+
 #ifdef ENABLE_BITTORRENT
 void gatherBitTorrentMetadata(Dict* btDict, TorrentAttribute* torrentAttrs)
 {
@@ -710,7 +866,8 @@ void gatherBitTorrentMetadata(Dict* btDict, TorrentAttribute* torrentAttrs)
 }
 
 namespace {
-void gatherProgressBitTorrent(Dict* entryDict,
+template <typename EntryDict>
+void gatherProgressBitTorrent(EntryDict* entryDict,
                               const std::shared_ptr<RequestGroup>& group,
                               TorrentAttribute* torrentAttrs,
                               BtObject* btObject,
@@ -775,27 +932,46 @@ void gatherPeer(List* peers, const std::shared_ptr<PeerStorage>& ps)
 } // namespace
 #endif // ENABLE_BITTORRENT
 
-namespace {
-void gatherProgress(Dict* entryDict, const std::shared_ptr<RequestGroup>& group,
+template <typename EntryDict>
+void gatherProgress(EntryDict* entryDict,
+                    const std::shared_ptr<RequestGroup>& group,
                     DownloadEngine* e, const std::vector<std::string>& keys)
 {
   gatherProgressCommon(entryDict, group, keys);
 #ifdef ENABLE_BITTORRENT
-  if (group->getDownloadContext()->hasAttribute(CTX_ATTR_BT)) {
+  if (!group->isPending() &&
+      group->getDownloadContext()->hasAttribute(CTX_ATTR_BT)) {
     gatherProgressBitTorrent(entryDict, group, bittorrent::getTorrentAttrs(
                                                    group->getDownloadContext()),
                              e->getBtRegistry()->get(group->getGID()), keys);
   }
 #endif // ENABLE_BITTORRENT
 }
-} // namespace
 
-void gatherStoppedDownload(Dict* entryDict,
+template void gatherProgress(Dict* entryDict,
+                             const std::shared_ptr<RequestGroup>& group,
+                             DownloadEngine* e,
+                             const std::vector<std::string>& keys);
+
+template void gatherProgress(json::JsonWriter* entryDict,
+                             const std::shared_ptr<RequestGroup>& group,
+                             DownloadEngine* e,
+                             const std::vector<std::string>& keys);
+
+#ifdef ENABLE_WEBSOCKET
+template void gatherProgress(SubscriptionFieldWriter* entryDict,
+                             const std::shared_ptr<RequestGroup>& group,
+                             DownloadEngine* e,
+                             const std::vector<std::string>& keys);
+#endif // ENABLE_WEBSOCKET
+
+template <typename EntryDict>
+void gatherStoppedDownload(EntryDict* entryDict,
                            const std::shared_ptr<DownloadResult>& ds,
                            const std::vector<std::string>& keys)
 {
   if (requested_key(keys, KEY_GID)) {
-    entryDict->put(KEY_GID, ds->gid->toHex());
+    entryDict->put(KEY_GID, Gid::g(ds->gid->getNumericId()));
   }
   if (requested_key(keys, KEY_ERROR_CODE)) {
     entryDict->put(KEY_ERROR_CODE, util::itos(static_cast<int>(ds->result)));
@@ -819,14 +995,14 @@ void gatherStoppedDownload(Dict* entryDict,
       auto list = List::g();
       // The element is GID.
       for (auto gid : ds->followedBy) {
-        list->append(GroupId::toHex(gid));
+        list->append(Gid::g(gid));
       }
       entryDict->put(KEY_FOLLOWED_BY, std::move(list));
     }
   }
   if (requested_key(keys, KEY_BELONGS_TO)) {
     if (ds->belongsTo) {
-      entryDict->put(KEY_BELONGS_TO, GroupId::toHex(ds->belongsTo));
+      entryDict->put(KEY_BELONGS_TO, Gid::g(ds->belongsTo));
     }
   }
   if (requested_key(keys, KEY_FILES)) {
@@ -856,6 +1032,18 @@ void gatherStoppedDownload(Dict* entryDict,
   if (requested_key(keys, KEY_UPLOAD_SPEED)) {
     entryDict->put(KEY_UPLOAD_SPEED, VLB_ZERO);
   }
+  if (requested_key(keys, KEY_INSTANT_DOWNLOAD_SPEED)) {
+    entryDict->put(KEY_INSTANT_DOWNLOAD_SPEED, VLB_ZERO);
+  }
+  if (requested_key(keys, KEY_INSTANT_UPLOAD_SPEED)) {
+    entryDict->put(KEY_INSTANT_UPLOAD_SPEED, VLB_ZERO);
+  }
+  if (requested_key(keys, KEY_SMOOTHED_DOWNLOAD_SPEED)) {
+    entryDict->put(KEY_SMOOTHED_DOWNLOAD_SPEED, VLB_ZERO);
+  }
+  if (requested_key(keys, KEY_SMOOTHED_UPLOAD_SPEED)) {
+    entryDict->put(KEY_SMOOTHED_UPLOAD_SPEED, VLB_ZERO);
+  }
   if (!ds->infoHash.empty()) {
     if (requested_key(keys, KEY_INFO_HASH)) {
       entryDict->put(KEY_INFO_HASH, util::toHex(ds->infoHash));
@@ -878,12 +1066,18 @@ void gatherStoppedDownload(Dict* entryDict,
   }
 }
 
+template void gatherStoppedDownload(Dict* entryDict,
+                                    const std::shared_ptr<DownloadResult>& ds,
+                                    const std::vector<std::string>& keys);
+
+template void gatherStoppedDownload(json::JsonWriter* entryDict,
+                                    const std::shared_ptr<DownloadResult>& ds,
+                                    const std::vector<std::string>& keys);
+
 std::unique_ptr<ValueBase> GetFilesRpcMethod::process(const RpcRequest& req,
                                                       DownloadEngine* e)
 {
-  const String* gidParam = checkRequiredParam<String>(req, 0);
-
-  a2_gid_t gid = str2Gid(gidParam);
+  a2_gid_t gid = getRequiredGid(req, 0);
   auto files = List::g();
   auto group = e->getRequestGroupMan()->findGroup(gid);
   if (!group) {
@@ -912,9 +1106,7 @@ std::unique_ptr<ValueBase> GetFilesRpcMethod::process(const RpcRequest& req,
 std::unique_ptr<ValueBase> GetUrisRpcMethod::process(const RpcRequest& req,
                                                      DownloadEngine* e)
 {
-  const String* gidParam = checkRequiredParam<String>(req, 0);
-
-  a2_gid_t gid = str2Gid(gidParam);
+  a2_gid_t gid = getRequiredGid(req, 0);
   auto group = e->getRequestGroupMan()->findGroup(gid);
   if (!group) {
     throw DL_ABORT_EX(fmt("No URI data is available for GID#%s",
@@ -933,9 +1125,7 @@ std::unique_ptr<ValueBase> GetUrisRpcMethod::process(const RpcRequest& req,
 std::unique_ptr<ValueBase> GetPeersRpcMethod::process(const RpcRequest& req,
                                                       DownloadEngine* e)
 {
-  const String* gidParam = checkRequiredParam<String>(req, 0);
-
-  a2_gid_t gid = str2Gid(gidParam);
+  a2_gid_t gid = getRequiredGid(req, 0);
   auto group = e->getRequestGroupMan()->findGroup(gid);
   if (!group) {
     throw DL_ABORT_EX(fmt("No peer data is available for GID#%s",
@@ -951,25 +1141,25 @@ std::unique_ptr<ValueBase> GetPeersRpcMethod::process(const RpcRequest& req,
 }
 #endif // ENABLE_BITTORRENT
 
-std::unique_ptr<ValueBase> TellStatusRpcMethod::process(const RpcRequest& req,
-                                                        DownloadEngine* e)
+namespace {
+template <typename EntryDict>
+void gatherStatus(EntryDict* entryDict, const RpcRequest& req,
+                  DownloadEngine* e)
 {
-  const String* gidParam = checkRequiredParam<String>(req, 0);
+  a2_gid_t gid = getRequiredGid(req, 0);
   const List* keysParam = checkParam<List>(req, 1);
 
-  a2_gid_t gid = str2Gid(gidParam);
   std::vector<std::string> keys;
   toStringList(std::back_inserter(keys), keysParam);
 
   auto group = e->getRequestGroupMan()->findGroup(gid);
-  auto entryDict = Dict::g();
   if (!group) {
     auto ds = e->getRequestGroupMan()->findDownloadResult(gid);
     if (!ds) {
       throw DL_ABORT_EX(
           fmt("No such download for GID#%s", GroupId::toHex(gid).c_str()));
     }
-    gatherStoppedDownload(entryDict.get(), ds, keys);
+    gatherStoppedDownload(entryDict, ds, keys);
   }
   else {
     if (requested_key(keys, KEY_STATUS)) {
@@ -985,28 +1175,85 @@ std::unique_ptr<ValueBase> TellStatusRpcMethod::process(const RpcRequest& req,
         }
       }
     }
-    gatherProgress(entryDict.get(), group, e, keys);
+    gatherProgress(entryDict, group, e, keys);
   }
+}
+} // namespace
+
+std::unique_ptr<ValueBase> TellStatusRpcMethod::process(const RpcRequest& req,
+                                                        DownloadEngine* e)
+{
+  auto entryDict = Dict::g();
+  gatherStatus(entryDict.get(), req, e);
   return std::move(entryDict);
 }
 
+bool TellStatusRpcMethod::processJson(const RpcRequest& req, DownloadEngine* e,
+                                      json::JsonWriter& out)
+{
+  out.beginObject();
+  gatherStatus(&out, req, e);
+  out.endObject();
+  return true;
+}
+
+TellActiveRpcMethod::Page TellActiveRpcMethod::getActivePage(
+    const RpcRequest& req, DownloadEngine* e)
+{
+  if (req.params->empty() || downcast<List>(req.params->get(0))) {
+    // tellActive([keys]) returns all active downloads.
+    const List* keysParam = checkParam<List>(req, 0);
+    const auto& items = getItems(e);
+    Page page{std::begin(items), std::end(items), false, {}};
+    toStringList(std::back_inserter(page.keys), keysParam);
+    return page;
+  }
+  return getPage(req, e);
+}
+
 std::unique_ptr<ValueBase> TellActiveRpcMethod::process(const RpcRequest& req,
                                                         DownloadEngine* e)
 {
-  const List* keysParam = checkParam<List>(req, 0);
-  std::vector<std::string> keys;
-  toStringList(std::back_inserter(keys), keysParam);
-  auto list = List::g();
-  bool statusReq = requested_key(keys, KEY_STATUS);
-  for (auto& group : e->getRequestGroupMan()->getRequestGroups()) {
-    auto entryDict = Dict::g();
-    if (statusReq) {
-      entryDict->put(KEY_STATUS, VLB_ACTIVE);
-    }
-    gatherProgress(entryDict.get(), group, e, keys);
-    list->append(std::move(entryDict));
+  return createList(getActivePage(req, e), e);
+}
+
+bool TellActiveRpcMethod::processJson(const RpcRequest& req, DownloadEngine* e,
+                                      json::JsonWriter& out)
+{
+  writeList(getActivePage(req, e), e, out);
+  return true;
+}
+
+const RequestGroupList& TellActiveRpcMethod::getItems(DownloadEngine* e) const
+{
+  return e->getRequestGroupMan()->getRequestGroups();
+}
+
+namespace {
+template <typename EntryDict>
+void createActiveEntry(EntryDict* entryDict,
+                       const std::shared_ptr<RequestGroup>& item,
+                       DownloadEngine* e, const std::vector<std::string>& keys)
+{
+  if (requested_key(keys, KEY_STATUS)) {
+    entryDict->put(KEY_STATUS, VLB_ACTIVE);
   }
-  return std::move(list);
+  gatherProgress(entryDict, item, e, keys);
+}
+} // namespace
+
+void TellActiveRpcMethod::createEntry(
+    Dict* entryDict, const std::shared_ptr<RequestGroup>& item,
+    DownloadEngine* e, const std::vector<std::string>& keys) const
+{
+  createActiveEntry(entryDict, item, e, keys);
+}
+
+void TellActiveRpcMethod::createEntry(
+    json::JsonWriter* entryDict, const std::shared_ptr<RequestGroup>& item,
+    DownloadEngine* e, const std::vector<std::string>& keys) const
+{
+  createActiveEntry(entryDict, item, e, keys);
 }
 
 const RequestGroupList& TellWaitingRpcMethod::getItems(DownloadEngine* e) const
@@ -1014,9 +1261,11 @@ const RequestGroupList& TellWaitingRpcMethod::getItems(DownloadEngine* e) const
   return e->getRequestGroupMan()->getReservedGroups();
 }
 
-void TellWaitingRpcMethod::createEntry(
-    Dict* entryDict, const std::shared_ptr<RequestGroup>& item,
-    DownloadEngine* e, const std::vector<std::string>& keys) const
+namespace {
+template <typename EntryDict>
+void createWaitingEntry(EntryDict* entryDict,
+                        const std::shared_ptr<RequestGroup>& item,
+                        DownloadEngine* e, const std::vector<std::string>& keys)
 {
   if (requested_key(keys, KEY_STATUS)) {
     if (item->isPauseRequested()) {
@@ -1028,6 +1277,103 @@ void TellWaitingRpcMethod::createEntry(
   }
   gatherProgress(entryDict, item, e, keys);
 }
+} // namespace
+
+void TellWaitingRpcMethod::createEntry(
+    Dict* entryDict, const std::shared_ptr<RequestGroup>& item,
+    DownloadEngine* e, const std::vector<std::string>& keys) const
+{
+  createWaitingEntry(entryDict, item, e, keys);
+}
+
+void TellWaitingRpcMethod::createEntry(
+    json::JsonWriter* entryDict, const std::shared_ptr<RequestGroup>& item,
+    DownloadEngine* e, const std::vector<std::string>& keys) const
+{
+  createWaitingEntry(entryDict, item, e, keys);
+}
+
+TellStoppedRpcMethod::StoppedPage
+TellStoppedRpcMethod::getStoppedPage(const RpcRequest& req, DownloadEngine* e)
+{
+  const Integer* numParam = checkRequiredInteger(req, 1, IntegerGE(0));
+  const List* keysParam = checkParam<List>(req, 2);
+
+  int64_t num = numParam->i();
+  StoppedPage page{{}, false, {}};
+  toStringList(std::back_inserter(page.keys), keysParam);
+  const auto& items = getItems(e);
+  auto archive = e->getRequestGroupMan()->getDownloadResultArchive();
+  int64_t numArchived = archive ? archive->size() : 0;
+  int64_t size = numArchived + items.size();
+  std::pair<int64_t, int64_t> range;
+  const String* cursorParam = downcast<String>(req.params->get(0));
+  if (cursorParam) {
+    int64_t first = 0;
+    if (!cursorParam->s().empty()) {
+      a2_gid_t gid;
+      if (GroupId::toNumericId(gid, cursorParam->s().c_str()) != 0) {
+        throw DL_ABORT_EX(fmt("Invalid cursor %s", cursorParam->s().c_str()));
+      }
+      auto i = items.find(gid);
+      if (i != std::end(items)) {
+        first = numArchived + (i - std::begin(items));
+      }
+      else {
+        first = archive ? archive->find(gid) : -1;
+        if (first == -1) {
+          throw DL_ABORT_EX(fmt("No such download for cursor %s",
+                                cursorParam->s().c_str()));
+        }
+      }
+      ++first;
+    }
+    range = std::make_pair(first, std::min(size, first + num));
+  }
+  else {
+    const Integer* offsetParam = checkRequiredParam<Integer>(req, 0);
+    range = getPaginationPositions(offsetParam->i(), num, size);
+    page.reverse = offsetParam->i() < 0;
+  }
+  if (range.first < numArchived) {
+    page.items = archive->get(range.first, std::min(range.second, numArchived));
+  }
+  for (auto i = std::max(range.first, numArchived); i < range.second; ++i) {
+    page.items.push_back(*(std::begin(items) + (i - numArchived)));
+  }
+  if (page.reverse) {
+    std::reverse(std::begin(page.items), std::end(page.items));
+  }
+  return page;
+}
+
+std::unique_ptr<ValueBase> TellStoppedRpcMethod::process(const RpcRequest& req,
+                                                         DownloadEngine* e)
+{
+  auto page = getStoppedPage(req, e);
+  auto list = List::g();
+  for (auto& item : page.items) {
+    auto entryDict = Dict::g();
+    createEntry(entryDict.get(), item, e, page.keys);
+    list->append(std::move(entryDict));
+  }
+  return std::move(list);
+}
+
+bool TellStoppedRpcMethod::processJson(const RpcRequest& req,
+                                       DownloadEngine* e,
+                                       json::JsonWriter& out)
+{
+  auto page = getStoppedPage(req, e);
+  out.beginArray();
+  for (auto& item : page.items) {
+    out.beginObject();
+    createEntry(&out, item, e, page.keys);
+    out.endObject();
+  }
+  out.endArray();
+  return true;
+}
 
 const DownloadResultList&
 TellStoppedRpcMethod::getItems(DownloadEngine* e) const
@@ -1042,6 +1388,13 @@ void TellStoppedRpcMethod::createEntry(
   gatherStoppedDownload(entryDict, item, keys);
 }
 
+void TellStoppedRpcMethod::createEntry(
+    json::JsonWriter* entryDict, const std::shared_ptr<DownloadResult>& item,
+    DownloadEngine* e, const std::vector<std::string>& keys) const
+{
+  gatherStoppedDownload(entryDict, item, keys);
+}
+
 std::unique_ptr<ValueBase>
 PurgeDownloadResultRpcMethod::process(const RpcRequest& req, DownloadEngine* e)
 {
@@ -1052,9 +1405,7 @@ PurgeDownloadResultRpcMethod::process(const RpcRequest& req, DownloadEngine* e)
 std::unique_ptr<ValueBase>
 RemoveDownloadResultRpcMethod::process(const RpcRequest& req, DownloadEngine* e)
 {
-  const String* gidParam = checkRequiredParam<String>(req, 0);
-
-  a2_gid_t gid = str2Gid(gidParam);
+  a2_gid_t gid = getRequiredGid(req, 0);
   if (!e->getRequestGroupMan()->removeDownloadResult(gid)) {
     throw DL_ABORT_EX(fmt("Could not remove download result of GID#%s",
                           GroupId::toHex(gid).c_str()));
@@ -1065,10 +1416,9 @@ RemoveDownloadResultRpcMethod::process(const RpcRequest& req, DownloadEngine* e)
 std::unique_ptr<ValueBase> ChangeOptionRpcMethod::process(const RpcRequest& req,
                                                           DownloadEngine* e)
 {
-  const String* gidParam = checkRequiredParam<String>(req, 0);
+  a2_gid_t gid = getRequiredGid(req, 0);
   const Dict* optsParam = checkRequiredParam<Dict>(req, 1);
 
-  a2_gid_t gid = str2Gid(gidParam);
   auto group = e->getRequestGroupMan()->findGroup(gid);
   Option option;
   if (group) {
@@ -1131,9 +1481,7 @@ void pushRequestOption(Dict* dict, const std::shared_ptr<Option>& option,
 std::unique_ptr<ValueBase> GetOptionRpcMethod::process(const RpcRequest& req,
                                                        DownloadEngine* e)
 {
-  const String* gidParam = checkRequiredParam<String>(req, 0);
-
-  a2_gid_t gid = str2Gid(gidParam);
+  a2_gid_t gid = getRequiredGid(req, 0);
   auto group = e->getRequestGroupMan()->findGroup(gid);
   auto result = Dict::g();
   if (!group) {
@@ -1154,7 +1502,7 @@ std::unique_ptr<ValueBase>
 GetGlobalOptionRpcMethod::process(const RpcRequest& req, DownloadEngine* e)
 {
   auto result = Dict::g();
-  for (size_t i = 0, len = e->getOption()->getTable().size(); i < len; ++i) {
+  for (size_t i = 0, len = option::countOption(); i < len; ++i) {
     PrefPtr pref = option::i2p(i);
     if (pref == PREF_RPC_SECRET || !e->getOption()->defined(pref)) {
       continue;
@@ -1170,11 +1518,10 @@ GetGlobalOptionRpcMethod::process(const RpcRequest& req, DownloadEngine* e)
 std::unique_ptr<ValueBase>
 ChangePositionRpcMethod::process(const RpcRequest& req, DownloadEngine* e)
 {
-  const String* gidParam = checkRequiredParam<String>(req, 0);
+  a2_gid_t gid = getRequiredGid(req, 0);
   const Integer* posParam = checkRequiredParam<Integer>(req, 1);
   const String* howParam = checkRequiredParam<String>(req, 2);
 
-  a2_gid_t gid = str2Gid(gidParam);
   int pos = posParam->i();
   const std::string& howStr = howParam->s();
   OffsetMode how;
@@ -1206,9 +1553,7 @@ GetSessionInfoRpcMethod::process(const RpcRequest& req, DownloadEngine* e)
 std::unique_ptr<ValueBase> GetServersRpcMethod::process(const RpcRequest& req,
                                                         DownloadEngine* e)
 {
-  const String* gidParam = checkRequiredParam<String>(req, 0);
-
-  a2_gid_t gid = str2Gid(gidParam);
+  a2_gid_t gid = getRequiredGid(req, 0);
   auto group = e->getRequestGroupMan()->findGroup(gid);
   if (!group || group->getState() != RequestGroup::STATE_ACTIVE) {
     throw DL_ABORT_EX(
@@ -1228,6 +1573,10 @@ std::unique_ptr<ValueBase> GetServersRpcMethod::process(const RpcRequest& req,
         serverEntry->put(KEY_CURRENT_URI, req->getCurrentUri());
         serverEntry->put(KEY_DOWNLOAD_SPEED,
                          util::itos(ps->calculateDownloadSpeed()));
+        serverEntry->put(KEY_INSTANT_DOWNLOAD_SPEED,
+                         util::itos(ps->calculateInstantDownloadSpeed()));
+        serverEntry->put(KEY_SMOOTHED_DOWNLOAD_SPEED,
+                         util::itos(ps->calculateSmoothedDownloadSpeed()));
         servers->append(std::move(serverEntry));
       }
     }
@@ -1240,13 +1589,12 @@ std::unique_ptr<ValueBase> GetServersRpcMethod::process(const RpcRequest& req,
 std::unique_ptr<ValueBase> ChangeUriRpcMethod::process(const RpcRequest& req,
                                                        DownloadEngine* e)
 {
-  const String* gidParam = checkRequiredParam<String>(req, 0);
+  a2_gid_t gid = getRequiredGid(req, 0);
   const Integer* indexParam = checkRequiredInteger(req, 1, IntegerGE(1));
   const List* delUrisParam = checkRequiredParam<List>(req, 2);
   const List* addUrisParam = checkRequiredParam<List>(req, 3);
   const Integer* posParam = checkParam<Integer>(req, 4);
 
-  a2_gid_t gid = str2Gid(gidParam);
   bool posGiven = checkPosParam(posParam);
   size_t pos = posGiven ? posParam->i() : 0;
   size_t index = indexParam->i() - 1;
@@ -1285,6 +1633,9 @@ std::unique_ptr<ValueBase> ChangeUriRpcMethod::process(const RpcRequest& req,
       }
     }
   }
+  if (delcount || addcount) {
+    group->markSessionDirty();
+  }
   if (addcount && group->getPieceStorage()) {
     std::vector<std::unique_ptr<Command>> commands;
     group->createNextCommand(commands, e);
@@ -1324,19 +1675,118 @@ ForceShutdownRpcMethod::process(const RpcRequest& req, DownloadEngine* e)
 
 std::unique_ptr<ValueBase>
 GetGlobalStatRpcMethod::process(const RpcRequest& req, DownloadEngine* e)
+{
+  auto res = Dict::g();
+  gatherGlobalStat(res.get(), e);
+  return std::move(res);
+}
+
+template <typename EntryDict>
+void gatherGlobalStat(EntryDict* res, DownloadEngine* e)
 {
   auto& rgman = e->getRequestGroupMan();
   auto ts = rgman->calculateStat();
-  auto res = Dict::g();
   res->put(KEY_DOWNLOAD_SPEED, util::itos(ts.downloadSpeed));
   res->put(KEY_UPLOAD_SPEED, util::itos(ts.uploadSpeed));
+  res->put(KEY_INSTANT_DOWNLOAD_SPEED, util::itos(ts.instantDownloadSpeed));
+  res->put(KEY_INSTANT_UPLOAD_SPEED, util::itos(ts.instantUploadSpeed));
+  res->put(KEY_SMOOTHED_DOWNLOAD_SPEED, util::itos(ts.smoothedDownloadSpeed));
+  res->put(KEY_SMOOTHED_UPLOAD_SPEED, util::itos(ts.smoothedUploadSpeed));
   res->put(KEY_NUM_WAITING, util::uitos(rgman->getReservedGroups().size()));
-  res->put(KEY_NUM_STOPPED, util::uitos(rgman->getDownloadResults().size()));
+  res->put(KEY_NUM_STOPPED, util::uitos(rgman->countDownloadResult()));
   res->put(KEY_NUM_STOPPED_TOTAL, util::uitos(rgman->getNumStoppedTotal()));
   res->put(KEY_NUM_ACTIVE, util::uitos(rgman->getRequestGroups().size()));
-  return std::move(res);
+#ifdef ENABLE_SSL
+  auto& tlsSessionCache = SocketCore::getTLSSessionCache();
+  if (tlsSessionCache) {
+    res->put(KEY_NUM_TLS_HANDSHAKE,
+             util::uitos(tlsSessionCache->getNumHandshake()));
+    res->put(KEY_NUM_TLS_RESUMED, util::uitos(tlsSessionCache->getNumResumed()));
+  }
+#endif // ENABLE_SSL
 }
 
+template void gatherGlobalStat(Dict* res, DownloadEngine* e);
+
+#ifdef ENABLE_WEBSOCKET
+template void gatherGlobalStat(SubscriptionFieldWriter* res, DownloadEngine* e);
+#endif // ENABLE_WEBSOCKET
+
+std::unique_ptr<ValueBase>
+GetHostStatRpcMethod::process(const RpcRequest& req, DownloadEngine* e)
+{
+  auto& rgman = e->getRequestGroupMan();
+  const auto& entries = rgman->getHostConnectionRegistry()->getEntries();
+  std::vector<const HostConnectionRegistry::EntryMap::value_type*> hosts;
+  hosts.reserve(entries.size());
+  for (const auto& ent : entries) {
+    hosts.push_back(&ent);
+  }
+  std::sort(std::begin(hosts), std::end(hosts),
+            [](const HostConnectionRegistry::EntryMap::value_type* lhs,
+               const HostConnectionRegistry::EntryMap::value_type* rhs) {
+              return lhs->first < rhs->first;
+            });
+  auto list = List::g();
+  for (auto ent : hosts) {
+    auto entryDict = Dict::g();
+    entryDict->put(KEY_HOST, ent->first);
+    entryDict->put(KEY_PROTOCOL, ent->second.protocol);
+    entryDict->put(KEY_CONNECTIONS, util::uitos(ent->second.numConnection));
+    auto ss = rgman->findServerStat(ent->first, ent->second.protocol);
+    entryDict->put(KEY_DOWNLOAD_SPEED,
+                   util::itos((ss && ss->isOK()) ? ss->getDownloadSpeed() : 0));
+    list->append(std::move(entryDict));
+  }
+  return std::move(list);
+}
+
+#ifdef ENABLE_WEBSOCKET
+namespace {
+WebSocketSessionMan* getSubscriptionSessionMan(const RpcRequest& req,
+                                               DownloadEngine* e)
+{
+  if (!req.wsSession || !e->getWebSocketSessionMan()) {
+    throw DL_ABORT_EX(
+        fmt("%s is only available over WebSocket.", req.methodName.c_str()));
+  }
+  return e->getWebSocketSessionMan().get();
+}
+} // namespace
+
+std::unique_ptr<ValueBase> SubscribeRpcMethod::process(const RpcRequest& req,
+                                                       DownloadEngine* e)
+{
+  const List* keysParam = checkParam<List>(req, 0);
+  const Integer* intervalParam = checkParam<Integer>(req, 1);
+  auto wsman = getSubscriptionSessionMan(req, e);
+  std::vector<std::string> keys;
+  toStringList(std::back_inserter(keys), keysParam);
+  auto interval = 1_s;
+  if (intervalParam) {
+    if (intervalParam->i() < 1) {
+      throw DL_ABORT_EX("The interval must be greater than or equal to 1.");
+    }
+    interval = std::chrono::seconds(intervalParam->i());
+  }
+  return String::g(wsman->subscribe(req.wsSession->getCommand()->getSession(),
+                                    std::move(keys), interval));
+}
+
+std::unique_ptr<ValueBase> UnsubscribeRpcMethod::process(const RpcRequest& req,
+                                                         DownloadEngine* e)
+{
+  const String* idParam = checkRequiredParam<String>(req, 0);
+  auto wsman = getSubscriptionSessionMan(req, e);
+  if (!wsman->unsubscribe(req.wsSession->getCommand()->getSession(),
+                          idParam->s())) {
+    throw DL_ABORT_EX(
+        fmt("No such subscription %s", idParam->s().c_str()));
+  }
+  return createOKResponse();
+}
+#endif // ENABLE_WEBSOCKET
+
 std::unique_ptr<ValueBase> SaveSessionRpcMethod::process(const RpcRequest& req,
                                                          DownloadEngine* e)
 {
@@ -1479,6 +1929,7 @@ void changeOption(const std::shared_ptr<RequestGroup>& group,
   const std::shared_ptr<DownloadContext>& dctx = group->getDownloadContext();
   const std::shared_ptr<Option>& grOption = group->getOption();
   grOption->merge(option);
+  group->markSessionDirty();
   if (option.defined(PREF_CHECKSUM)) {
     const std::string& checksum = grOption->get(PREF_CHECKSUM);
     auto p = util::divide(std::begin(checksum), std::end(checksum), '=');
@@ -1559,6 +2010,12 @@ void changeOption(const std::shared_ptr<RequestGroup>& group,
   if (option.defined(PREF_MAX_UPLOAD_LIMIT)) {
     group->setMaxUploadSpeedLimit(grOption->getAsInt(PREF_MAX_UPLOAD_LIMIT));
   }
+  if (option.defined(PREF_BANDWIDTH_WEIGHT)) {
+    group->setBandwidthWeight(grOption->getAsInt(PREF_BANDWIDTH_WEIGHT));
+  }
+  if (option.defined(PREF_SPEED_LIMIT_BURST)) {
+    group->setSpeedLimitBurst(grOption->getAsLLInt(PREF_SPEED_LIMIT_BURST));
+  }
 #ifdef ENABLE_BITTORRENT
   auto btObject = e->getBtRegistry()->get(group->getGID());
   if (btObject) {
@@ -1580,6 +2037,10 @@ void changeGlobalOption(const Option& option, DownloadEngine* e)
     e->getRequestGroupMan()->setMaxOverallUploadSpeedLimit(
         option.getAsInt(PREF_MAX_OVERALL_UPLOAD_LIMIT));
   }
+  if (option.defined(PREF_SPEED_LIMIT_BURST)) {
+    e->getRequestGroupMan()->setSpeedLimitBurst(
+        option.getAsLLInt(PREF_SPEED_LIMIT_BURST));
+  }
   if (option.defined(PREF_MAX_CONCURRENT_DOWNLOADS)) {
     e->getRequestGroupMan()->setMaxSimultaneousDownloads(
         option.getAsInt(PREF_MAX_CONCURRENT_DOWNLOADS));
@@ -49,6 +49,7 @@
 #include "IndexedList.h"
 #include "GroupId.h"
 #include "RequestGroupMan.h"
+#include "json.h"
 
 namespace aria2 {
 
@@ -135,6 +136,15 @@ public:
   static const char* getMethodName() { return "aria2.addUri"; }
 };
 
+class AddUrisRpcMethod : public RpcMethod {
+protected:
+  virtual std::unique_ptr<ValueBase> process(const RpcRequest& req,
+                                             DownloadEngine* e) CXX11_OVERRIDE;
+
+public:
+  static const char* getMethodName() { return "aria2.addUris"; }
+};
+
 class RemoveRpcMethod : public RpcMethod {
 protected:
   virtual std::unique_ptr<ValueBase> process(const RpcRequest& req,
@@ -290,17 +300,11 @@ protected:
   virtual std::unique_ptr<ValueBase> process(const RpcRequest& req,
                                              DownloadEngine* e) CXX11_OVERRIDE;
 
-public:
-  static const char* getMethodName() { return "aria2.tellStatus"; }
-};
-
-class TellActiveRpcMethod : public RpcMethod {
-protected:
-  virtual std::unique_ptr<ValueBase> process(const RpcRequest& req,
-                                             DownloadEngine* e) CXX11_OVERRIDE;
+  virtual bool processJson(const RpcRequest& req, DownloadEngine* e,
+                           json::JsonWriter& out) CXX11_OVERRIDE;
 
 public:
-  static const char* getMethodName() { return "aria2.tellActive"; }
+  static const char* getMethodName() { return "aria2.tellStatus"; }
 };
 
 template <typename T> class AbstractPaginationRpcMethod : public RpcMethod {
@@ -309,16 +313,28 @@ private:
   std::pair<InputIterator, InputIterator>
   getPaginationRange(int64_t offset, int64_t num, InputIterator first,
                      InputIterator last)
+  {
+    auto pos = getPaginationPositions(offset, num, std::distance(first, last));
+    last = first;
+    std::advance(first, pos.first);
+    std::advance(last, pos.second);
+    return std::make_pair(first, last);
+  }
+
+protected:
+  // Returns the positions [first, last) of the items to respond in
+  // the list which has size items.
+  static std::pair<int64_t, int64_t>
+  getPaginationPositions(int64_t offset, int64_t num, int64_t size)
   {
     if (num <= 0) {
-      return std::make_pair(last, last);
+      return std::make_pair(size, size);
     }
 
-    int64_t size = std::distance(first, last);
     if (offset < 0) {
       int64_t tempoffset = offset + size;
       if (tempoffset < 0) {
-        return std::make_pair(last, last);
+        return std::make_pair(size, size);
       }
       offset = tempoffset - (num - 1);
       if (offset < 0) {
@@ -327,48 +343,105 @@ private:
       }
     }
     else if (size <= offset) {
-      return std::make_pair(last, last);
+      return std::make_pair(size, size);
     }
-    int64_t lastDistance;
-    if (size < offset + num) {
-      lastDistance = size;
-    }
-    else {
-      lastDistance = offset + num;
-    }
-    last = first;
-    std::advance(first, offset);
-    std::advance(last, lastDistance);
-    return std::make_pair(first, last);
+    return std::make_pair(offset, std::min(size, offset + num));
   }
 
 protected:
   typedef IndexedList<a2_gid_t, std::shared_ptr<T>> ItemListType;
+  typedef typename ItemListType::const_iterator ItemIterator;
 
-  virtual std::unique_ptr<ValueBase> process(const RpcRequest& req,
-                                             DownloadEngine* e) CXX11_OVERRIDE
+  struct Page {
+    ItemIterator first;
+    ItemIterator last;
+    // True if the items are returned from last to first.
+    bool reverse;
+    std::vector<std::string> keys;
+  };
+
+  // Reads the offset, num and keys parameters of req and returns the
+  // items to respond.  The offset is either an integer position, or
+  // a GID string used as a cursor: the page then starts right after
+  // that download, or at the first item if the string is empty.
+  Page getPage(const RpcRequest& req, DownloadEngine* e)
   {
-    const Integer* offsetParam = checkRequiredParam<Integer>(req, 0);
     const Integer* numParam = checkRequiredInteger(req, 1, IntegerGE(0));
     const List* keysParam = checkParam<List>(req, 2);
 
-    int64_t offset = offsetParam->i();
     int64_t num = numParam->i();
-    std::vector<std::string> keys;
-    toStringList(std::back_inserter(keys), keysParam);
     const ItemListType& items = getItems(e);
+    Page page{std::end(items), std::end(items), false, {}};
+    toStringList(std::back_inserter(page.keys), keysParam);
+    const String* cursorParam = downcast<String>(req.params->get(0));
+    if (cursorParam) {
+      page.first = std::begin(items);
+      if (!cursorParam->s().empty()) {
+        a2_gid_t gid;
+        if (GroupId::toNumericId(gid, cursorParam->s().c_str()) != 0) {
+          throw DL_ABORT_EX(
+              fmt("Invalid cursor %s", cursorParam->s().c_str()));
+        }
+        page.first = items.find(gid);
+        if (page.first == std::end(items)) {
+          throw DL_ABORT_EX(fmt("No such download for cursor %s",
+                                cursorParam->s().c_str()));
+        }
+        ++page.first;
+      }
+      page.last = page.first + std::min(num, static_cast<int64_t>(
+                                                 std::end(items) - page.first));
+      return page;
+    }
+    const Integer* offsetParam = checkRequiredParam<Integer>(req, 0);
+    int64_t offset = offsetParam->i();
     auto range =
         getPaginationRange(offset, num, std::begin(items), std::end(items));
+    page.first = range.first;
+    page.last = range.second;
+    page.reverse = offset < 0;
+    return page;
+  }
+
+  std::unique_ptr<List> createList(const Page& page, DownloadEngine* e) const
+  {
     auto list = List::g();
-    for (; range.first != range.second; ++range.first) {
+    for (auto i = page.first; i != page.last; ++i) {
       auto entryDict = Dict::g();
-      createEntry(entryDict.get(), *range.first, e, keys);
+      createEntry(entryDict.get(), *i, e, page.keys);
       list->append(std::move(entryDict));
     }
-    if (offset < 0) {
+    if (page.reverse) {
       std::reverse(list->begin(), list->end());
     }
-    return std::move(list);
+    return list;
+  }
+
+  void writeList(const Page& page, DownloadEngine* e,
+                 json::JsonWriter& out) const
+  {
+    out.beginArray();
+    auto n = page.last - page.first;
+    for (decltype(n) i = 0; i < n; ++i) {
+      auto& item = page.reverse ? *(page.last - i - 1) : *(page.first + i);
+      out.beginObject();
+      createEntry(&out, item, e, page.keys);
+      out.endObject();
+    }
+    out.endArray();
+  }
+
+  virtual std::unique_ptr<ValueBase> process(const RpcRequest& req,
+                                             DownloadEngine* e) CXX11_OVERRIDE
+  {
+    return createList(getPage(req, e), e);
+  }
+
+  virtual bool processJson(const RpcRequest& req, DownloadEngine* e,
+                           json::JsonWriter& out) CXX11_OVERRIDE
+  {
+    writeList(getPage(req, e), e, out);
+    return true;
   }
 
   virtual const ItemListType& getItems(DownloadEngine* e) const = 0;
@@ -376,6 +449,40 @@ protected:
   virtual void createEntry(Dict* entryDict, const std::shared_ptr<T>& item,
                            DownloadEngine* e,
                            const std::vector<std::string>& keys) const = 0;
+
+  virtual void createEntry(json::JsonWriter* entryDict,
+                           const std::shared_ptr<T>& item, DownloadEngine* e,
+                           const std::vector<std::string>& keys) const = 0;
+};
+
+class TellActiveRpcMethod : public AbstractPaginationRpcMethod<RequestGroup> {
+private:
+  // Without the offset and num parameters, tellActive takes keys
+  // only and returns all active downloads.
+  Page getActivePage(const RpcRequest& req, DownloadEngine* e);
+
+protected:
+  virtual std::unique_ptr<ValueBase> process(const RpcRequest& req,
+                                             DownloadEngine* e) CXX11_OVERRIDE;
+
+  virtual bool processJson(const RpcRequest& req, DownloadEngine* e,
+                           json::JsonWriter& out) CXX11_OVERRIDE;
+
+  virtual const RequestGroupList&
+  getItems(DownloadEngine* e) const CXX11_OVERRIDE;
+
+  virtual void
+  createEntry(Dict* entryDict, const std::shared_ptr<RequestGroup>& item,
+              DownloadEngine* e,
+              const std::vector<std::string>& keys) const CXX11_OVERRIDE;
+
+  virtual void
+  createEntry(json::JsonWriter* entryDict,
+              const std::shared_ptr<RequestGroup>& item, DownloadEngine* e,
+              const std::vector<std::string>& keys) const CXX11_OVERRIDE;
+
+public:
+  static const char* getMethodName() { return "aria2.tellActive"; }
 };
 
 class TellWaitingRpcMethod : public AbstractPaginationRpcMethod<RequestGroup> {
@@ -388,13 +495,36 @@ protected:
               DownloadEngine* e,
               const std::vector<std::string>& keys) const CXX11_OVERRIDE;
 
+  virtual void
+  createEntry(json::JsonWriter* entryDict,
+              const std::shared_ptr<RequestGroup>& item, DownloadEngine* e,
+              const std::vector<std::string>& keys) const CXX11_OVERRIDE;
+
 public:
   static const char* getMethodName() { return "aria2.tellWaiting"; }
 };
 
 class TellStoppedRpcMethod
     : public AbstractPaginationRpcMethod<DownloadResult> {
+private:
+  struct StoppedPage {
+    std::vector<std::shared_ptr<DownloadResult>> items;
+    // True if the items are returned from last to first.
+    bool reverse;
+    std::vector<std::string> keys;
+  };
+
+  // Same as getPage(), but pages through the archived download
+  // results followed by getItems().
+  StoppedPage getStoppedPage(const RpcRequest& req, DownloadEngine* e);
+
 protected:
+  virtual std::unique_ptr<ValueBase> process(const RpcRequest& req,
+                                             DownloadEngine* e) CXX11_OVERRIDE;
+
+  virtual bool processJson(const RpcRequest& req, DownloadEngine* e,
+                           json::JsonWriter& out) CXX11_OVERRIDE;
+
   virtual const DownloadResultList&
   getItems(DownloadEngine* e) const CXX11_OVERRIDE;
 
@@ -403,6 +533,11 @@ protected:
               DownloadEngine* e,
               const std::vector<std::string>& keys) const CXX11_OVERRIDE;
 
+  virtual void
+  createEntry(json::JsonWriter* entryDict,
+              const std::shared_ptr<DownloadResult>& item, DownloadEngine* e,
+              const std::vector<std::string>& keys) const CXX11_OVERRIDE;
+
 public:
   static const char* getMethodName() { return "aria2.tellStopped"; }
 };
@@ -497,6 +632,35 @@ public:
   static const char* getMethodName() { return "aria2.getGlobalStat"; }
 };
 
+class GetHostStatRpcMethod : public RpcMethod {
+protected:
+  virtual std::unique_ptr<ValueBase> process(const RpcRequest& req,
+                                             DownloadEngine* e) CXX11_OVERRIDE;
+
+public:
+  static const char* getMethodName() { return "aria2.getHostStat"; }
+};
+
+#ifdef ENABLE_WEBSOCKET
+class SubscribeRpcMethod : public RpcMethod {
+protected:
+  virtual std::unique_ptr<ValueBase> process(const RpcRequest& req,
+                                             DownloadEngine* e) CXX11_OVERRIDE;
+
+public:
+  static const char* getMethodName() { return "aria2.subscribe"; }
+};
+
+class UnsubscribeRpcMethod : public RpcMethod {
+protected:
+  virtual std::unique_ptr<ValueBase> process(const RpcRequest& req,
+                                             DownloadEngine* e) CXX11_OVERRIDE;
+
+public:
+  static const char* getMethodName() { return "aria2.unsubscribe"; }
+};
+#endif // ENABLE_WEBSOCKET
+
 class ForceShutdownRpcMethod : public RpcMethod {
 protected:
   virtual std::unique_ptr<ValueBase> process(const RpcRequest& req,
@@ -544,17 +708,35 @@ protected:
 };
 
 // Helper function to store data to entryDict from ds. This function
-// is used by tellStatus method.
-void gatherStoppedDownload(Dict* entryDict,
+// is used by tellStatus method.  EntryDict is either Dict or
+// json::JsonWriter.
+template <typename EntryDict>
+void gatherStoppedDownload(EntryDict* entryDict,
                            const std::shared_ptr<DownloadResult>& ds,
                            const std::vector<std::string>& keys);
 
 // Helper function to store data to entryDict from group. This
-// function is used by tellStatus/tellActive/tellWaiting method
-void gatherProgressCommon(Dict* entryDict,
+// function is used by tellStatus/tellActive/tellWaiting method.
+// EntryDict is either Dict or json::JsonWriter.
+template <typename EntryDict>
+void gatherProgressCommon(EntryDict* entryDict,
                           const std::shared_ptr<RequestGroup>& group,
                           const std::vector<std::string>& keys);
 
+// Helper function to store data to entryDict from group, including
+// BitTorrent specific data.  EntryDict is either Dict,
+// json::JsonWriter or SubscriptionFieldWriter.
+template <typename EntryDict>
+void gatherProgress(EntryDict* entryDict,
+                    const std::shared_ptr<RequestGroup>& group,
+                    DownloadEngine* e, const std::vector<std::string>& keys);
+
+// Helper function to store the global statistics returned by
+// getGlobalStat method to res.  EntryDict is either Dict or
+// SubscriptionFieldWriter.
+template <typename EntryDict>
+void gatherGlobalStat(EntryDict* res, DownloadEngine* e);
+
 #ifdef ENABLE_BITTORRENT
 // Helper function to store BitTorrent metadata from torrentAttrs.
 void gatherBitTorrentMetadata(Dict* btDict, TorrentAttribute* torrentAttrs);
@@ -45,11 +45,19 @@ namespace aria2 {
 
 namespace rpc {
 
+class WebSocketSession;
+
 struct RpcRequest {
   std::string methodName;
   std::unique_ptr<List> params;
   std::unique_ptr<ValueBase> id;
   bool jsonRpc;
+  // True if the response is sent as JSON as is.  The method may then
+  // encode its result directly into RpcResponse::json.
+  bool jsonStream;
+  // The WebSocket session which the request was received from, or
+  // nullptr.
+  WebSocketSession* wsSession;
 
   RpcRequest();
 
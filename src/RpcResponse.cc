@@ -39,6 +39,7 @@
 
 #include "util.h"
 #include "json.h"
+#include "msgpack.h"
 #ifdef HAVE_ZLIB
 #include "GZipEncoder.h"
 #endif // HAVE_ZLIB
@@ -133,6 +134,15 @@ RpcResponse::RpcResponse(int code, RpcResponse::authorization_t authorized,
 {
 }
 
+RpcResponse::RpcResponse(int code, RpcResponse::authorization_t authorized,
+                         std::string json, std::unique_ptr<ValueBase> id)
+    : id{std::move(id)},
+      json{std::move(json)},
+      code{code},
+      authorized{authorized}
+{
+}
+
 std::string toXml(const RpcResponse& res, bool gzip)
 {
   if (gzip) {
@@ -152,23 +162,27 @@ std::string toXml(const RpcResponse& res, bool gzip)
 
 namespace {
 template <typename OutputStream>
-OutputStream& encodeJsonAll(OutputStream& o, int code, const ValueBase* param,
-                            const ValueBase* id,
+OutputStream& encodeJsonAll(OutputStream& o, const RpcResponse& res,
                             const std::string& callback = A2STR::NIL)
 {
   if (!callback.empty()) {
     o << callback << "(";
   }
   o << "{\"id\":";
-  json::encode(o, id);
+  json::encode(o, res.id.get());
   o << ",\"jsonrpc\":\"2.0\",";
-  if (code == 0) {
+  if (res.code == 0) {
     o << "\"result\":";
   }
   else {
     o << "\"error\":";
   }
-  json::encode(o, param);
+  if (res.param) {
+    json::encode(o, res.param.get());
+  }
+  else {
+    o << res.json;
+  }
   o << "}";
   if (!callback.empty()) {
     o << ")";
@@ -184,16 +198,14 @@ std::string toJson(const RpcResponse& res, const std::string& callback,
 #ifdef HAVE_ZLIB
     GZipEncoder o;
     o.init();
-    return encodeJsonAll(o, res.code, res.param.get(), res.id.get(), callback)
-        .str();
+    return encodeJsonAll(o, res, callback).str();
 #else  // !HAVE_ZLIB
     abort();
 #endif // !HAVE_ZLIB
   }
   else {
     std::stringstream o;
-    return encodeJsonAll(o, res.code, res.param.get(), res.id.get(), callback)
-        .str();
+    return encodeJsonAll(o, res, callback).str();
   }
 }
 
@@ -208,13 +220,12 @@ OutputStream& encodeJsonBatchAll(OutputStream& o,
   }
   o << "[";
   if (!results.empty()) {
-    encodeJsonAll(o, results[0].code, results[0].param.get(),
-                  results[0].id.get());
+    encodeJsonAll(o, results[0]);
 
     for (auto i = std::begin(results) + 1, eoi = std::end(results); i != eoi;
          ++i) {
       o << ",";
-      encodeJsonAll(o, (*i).code, (*i).param.get(), (*i).id.get());
+      encodeJsonAll(o, *i);
     }
   }
   o << "]";
@@ -243,6 +254,108 @@ std::string toJsonBatch(const std::vector<RpcResponse>& results,
   }
 }
 
+namespace {
+class MsgpackRpcValueVisitor : public ValueBaseVisitor {
+public:
+  MsgpackRpcValueVisitor(msgpack::Packer& packer)
+      : packer_(packer), bitfield_(false)
+  {
+  }
+
+  virtual void visit(const String& v) CXX11_OVERRIDE
+  {
+    if (bitfield_) {
+      auto bits = util::fromHex(std::begin(v.s()), std::end(v.s()));
+      if (bits.size() * 2 == v.s().size()) {
+        packer_.packBin(bits);
+        return;
+      }
+    }
+    packer_.packStr(v.s());
+  }
+
+  virtual void visit(const Gid& v) CXX11_OVERRIDE
+  {
+    packer_.packUint64(v.gid());
+  }
+
+  virtual void visit(const Integer& v) CXX11_OVERRIDE { packer_.packInt(v.i()); }
+
+  virtual void visit(const Bool& v) CXX11_OVERRIDE { packer_.packBool(v.val()); }
+
+  virtual void visit(const Null& v) CXX11_OVERRIDE { packer_.packNil(); }
+
+  virtual void visit(const List& v) CXX11_OVERRIDE
+  {
+    packer_.packArrayHeader(v.size());
+    for (const auto& e : v) {
+      e->accept(*this);
+    }
+  }
+
+  virtual void visit(const Dict& v) CXX11_OVERRIDE
+  {
+    auto bitfield = bitfield_;
+    packer_.packMapHeader(v.size());
+    for (const auto& e : v) {
+      packer_.packStr(e.first);
+      bitfield_ = e.first == "bitfield";
+      e.second->accept(*this);
+    }
+    bitfield_ = bitfield;
+  }
+
+private:
+  msgpack::Packer& packer_;
+  // True while visiting the value of a member holding a bitfield.
+  // Strings which are not well formed are packed as str.
+  bool bitfield_;
+};
+} // namespace
+
+namespace {
+void encodeMsgpackAll(msgpack::Packer& packer, const RpcResponse& res)
+{
+  packer.packMapHeader(3);
+  packer.packStr("id");
+  if (res.id) {
+    packer.pack(res.id.get());
+  }
+  else {
+    packer.packNil();
+  }
+  packer.packStr("jsonrpc");
+  packer.packStr("2.0");
+  packer.packStr(res.code == 0 ? "result" : "error");
+  if (res.param) {
+    MsgpackRpcValueVisitor visitor(packer);
+    res.param->accept(visitor);
+  }
+  else {
+    packer.packNil();
+  }
+}
+} // namespace
+
+std::string toMsgpack(const RpcResponse& res)
+{
+  std::string out;
+  msgpack::Packer packer(out);
+  encodeMsgpackAll(packer, res);
+  return out;
+}
+
+std::string toMsgpackBatch(const std::vector<RpcResponse>& results)
+{
+  std::string out;
+  msgpack::Packer packer(out);
+  packer.packArrayHeader(results.size());
+  for (auto& res : results) {
+    encodeMsgpackAll(packer, res);
+  }
+  return out;
+}
+
 } // namespace rpc
 
 } // namespace aria2
@@ -52,11 +52,17 @@ struct RpcResponse {
   // 0 for success, non-zero for error
   std::unique_ptr<ValueBase> param;
   std::unique_ptr<ValueBase> id;
+  // Result already encoded in JSON.  This is used instead of param
+  // when param is null.
+  std::string json;
   int code;
   authorization_t authorized;
 
   RpcResponse(int code, authorization_t authorized,
               std::unique_ptr<ValueBase> param, std::unique_ptr<ValueBase> id);
+
+  RpcResponse(int code, authorization_t authorized, std::string json,
+              std::unique_ptr<ValueBase> id);
 };
 
 inline bool not_authorized(const rpc::RpcResponse& res)
@@ -80,6 +86,13 @@ std::string toJson(const RpcResponse& response, const std::string& callback,
 std::string toJsonBatch(const std::vector<RpcResponse>& results,
                         const std::string& callback, bool gzip = false);
 
+// Encodes RPC response in MessagePack with the same structure as
+// JSON-RPC.  GIDs, which are Gid values, are encoded as uint 64 and
+// bitfields as bin instead of hex strings.
+std::string toMsgpack(const RpcResponse& response);
+
+std::string toMsgpackBatch(const std::vector<RpcResponse>& results);
+
 } // namespace rpc
 
 } // namespace aria2
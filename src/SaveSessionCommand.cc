@@ -68,16 +68,16 @@ void SaveSessionCommand::process()
 
     SessionSerializer sessionSerializer(rgman.get());
 
-    auto sessionHash = sessionSerializer.calculateHash();
-    if (rgman->getLastSessionHash() == sessionHash) {
+    auto entries = sessionSerializer.createEntries();
+    if (sameSessionEntries(rgman->getLastSessionEntries(), entries)) {
       A2_LOG_INFO("No change since last serialization or startup. "
                   "No serialization is necessary this time.");
       return;
     }
 
-    rgman->setLastSessionHash(std::move(sessionHash));
+    rgman->setLastSessionEntries(entries);
 
-    if (sessionSerializer.save(filename)) {
+    if (sessionSerializer.save(filename, entries)) {
       A2_LOG_NOTICE(
           fmt(_("Serialized session to '%s' successfully."), filename.c_str()));
     }
@@ -282,6 +282,78 @@ std::shared_ptr<Segment> SegmentMan::getCleanSegmentIfOwnerIsIdle(cuid_t cuid,
   return nullptr;
 }
 
+namespace {
+// The owner of a segment is not robbed until its download runs this
+// long, so that it can get up to speed.
+constexpr auto STEAL_GRACE_PERIOD = 5_s;
+
+// Returns current download speed of the connection which |peerStat|
+// belongs to. Returns -1 if it is not known: the connection has not
+// started downloading yet, or has just started.
+int estimateSpeed(const std::shared_ptr<PeerStat>& peerStat)
+{
+  if (!peerStat || peerStat->getStatus() == NetStat::IDLE ||
+      peerStat->getDownloadStartTime().difference(global::wallclock()) <
+          STEAL_GRACE_PERIOD) {
+    return -1;
+  }
+  return peerStat->calculateDownloadSpeed();
+}
+} // namespace
+
+std::shared_ptr<Segment> SegmentMan::stealSegment(cuid_t cuid)
+{
+  auto ps = getPeerStat(cuid);
+  if (!ps) {
+    return nullptr;
+  }
+  int speed =
+      std::max(ps->calculateDownloadSpeed(), ps->getAvgDownloadSpeed());
+  if (speed == 0) {
+    return nullptr;
+  }
+  std::shared_ptr<SegmentEntry> victim;
+  int victimSpeed = 0;
+  int64_t victimRemaining = 0;
+  for (auto& entry : usedSegmentEntries_) {
+    auto& segment = entry->segment;
+    if (entry->cuid == cuid || segment->getLength() == 0) {
+      continue;
+    }
+    int ownerSpeed = estimateSpeed(getPeerStat(entry->cuid));
+    if (ownerSpeed < 0) {
+      continue;
+    }
+    int64_t remaining = segment->getLength() - segment->getWrittenLength();
+    // Stealing only pays off if cuid is much faster than the owner
+    // and the owner still needs a while to finish the segment.
+    if (speed < ownerSpeed * 2 || remaining <= ownerSpeed * 2 ||
+        remaining < static_cast<int64_t>(
+                        segment->getPiece()->getBlockLength())) {
+      continue;
+    }
+    if (!victim || ownerSpeed < victimSpeed ||
+        (ownerSpeed == victimSpeed && remaining > victimRemaining)) {
+      victim = entry;
+      victimSpeed = ownerSpeed;
+      victimRemaining = remaining;
+    }
+  }
+  if (!victim) {
+    return nullptr;
+  }
+  size_t index = victim->segment->getIndex();
+  A2_LOG_INFO(fmt("CUID#%" PRId64 " - Stealing segment#%lu from CUID#%" PRId64
+                  ", remaining=%" PRId64 ", speed=%d, owner speed=%d",
+                  cuid, static_cast<unsigned long>(index), victim->cuid,
+                  victimRemaining, speed, victimSpeed));
+  // The owner finds its segments canceled and restarts.  The bytes
+  // it has written are kept in the piece and the written length
+  // memo, so that cuid resumes from there.
+  cancelSegment(victim->cuid);
+  return getSegmentWithIndex(cuid, index);
+}
+
 void SegmentMan::cancelSegmentInternal(cuid_t cuid,
                                        const std::shared_ptr<Segment>& segment)
 {
@@ -408,9 +480,10 @@ void SegmentMan::registerPeerStat(const std::shared_ptr<PeerStat>& peerStat)
 
 std::shared_ptr<PeerStat> SegmentMan::getPeerStat(cuid_t cuid) const
 {
-  for (auto& e : peerStats_) {
-    if (e->getCuid() == cuid) {
-      return e;
+  // The latest PeerStat reflects the current connection.
+  for (auto i = peerStats_.rbegin(), eoi = peerStats_.rend(); i != eoi; ++i) {
+    if ((*i)->getCuid() == cuid) {
+      return *i;
     }
   }
   return nullptr;
@@ -154,6 +154,15 @@ public:
   std::shared_ptr<Segment> getCleanSegmentIfOwnerIsIdle(cuid_t cuid,
                                                         size_t index);
 
+  // Work stealing for the end of the download, where no free segment
+  // is left.  Among the segments owned by other commands, selects the
+  // one owned by the slowest connection, preferring larger remaining
+  // length, and moves it to cuid if cuid is at least twice as fast as
+  // the owner.  The owner's segments are canceled and cuid resumes
+  // the segment at its written length.  If no segment is worth
+  // stealing, returns null.
+  std::shared_ptr<Segment> stealSegment(cuid_t cuid);
+
   /**
    * Updates download status.
    */
@@ -205,6 +214,7 @@ public:
     return peerStats_;
   }
 
+  // Returns the most recently registered PeerStat for cuid.
   std::shared_ptr<PeerStat> getPeerStat(cuid_t cuid) const;
 
   // If there is slower PeerStat than given peerStat for the same
@@ -36,6 +36,7 @@
 
 #include <ostream>
 #include <algorithm>
+#include <cmath>
 
 #include "array_fun.h"
 #include "Logger.h"
@@ -57,6 +58,12 @@ ServerStat::ServerStat(const std::string& hostname, const std::string& protocol)
       singleConnectionAvgSpeed_(0),
       multiConnectionAvgSpeed_(0),
       counter_(0),
+      ewmaSpeed_(0),
+      connectTime_(0),
+      timeToFirstByte_(0),
+      failureRate_(0),
+      samples_(0),
+      connectionLevel_(0),
       status_(OK)
 {
 }
@@ -139,6 +146,66 @@ void ServerStat::updateMultiConnectionAvgSpeed(int downloadSpeed)
   multiConnectionAvgSpeed_ = (int)avgDownloadSpeed;
 }
 
+namespace {
+// Weight of new sample in moving averages
+constexpr double SPEED_ALPHA = 0.3;
+constexpr double LATENCY_ALPHA = 0.3;
+constexpr double FAILURE_ALPHA = 0.2;
+
+int ewma(int avg, int sample, double alpha)
+{
+  if (avg == 0) {
+    return sample;
+  }
+  return static_cast<int>(std::lround(alpha * sample + (1 - alpha) * avg));
+}
+} // namespace
+
+void ServerStat::updateEwmaSpeed(int downloadSpeed)
+{
+  ewmaSpeed_ = ewma(ewmaSpeed_, downloadSpeed, SPEED_ALPHA);
+  failureRate_ = (1 - FAILURE_ALPHA) * failureRate_;
+  ++samples_;
+  status_ = OK;
+  lastUpdated_.reset();
+  A2_LOG_DEBUG(fmt("ServerStat:%s: ewmaSpeed_=%.2fKB/s failureRate_=%.3f",
+                   getHostname().c_str(), (float)ewmaSpeed_ / 1024,
+                   failureRate_));
+}
+
+void ServerStat::setEwmaSpeed(int ewmaSpeed) { ewmaSpeed_ = ewmaSpeed; }
+
+void ServerStat::updateConnectTime(int connectTime)
+{
+  // 0 means no sample.
+  connectTime_ = ewma(connectTime_, std::max(connectTime, 1), LATENCY_ALPHA);
+}
+
+void ServerStat::setConnectTime(int connectTime) { connectTime_ = connectTime; }
+
+void ServerStat::updateTimeToFirstByte(int timeToFirstByte)
+{
+  timeToFirstByte_ =
+      ewma(timeToFirstByte_, std::max(timeToFirstByte, 1), LATENCY_ALPHA);
+}
+
+void ServerStat::setTimeToFirstByte(int timeToFirstByte)
+{
+  timeToFirstByte_ = timeToFirstByte;
+}
+
+void ServerStat::setFailureRate(double failureRate)
+{
+  failureRate_ = failureRate;
+}
+
+void ServerStat::setSamples(int samples) { samples_ = samples; }
+
+void ServerStat::setConnectionLevel(int connectionLevel)
+{
+  connectionLevel_ = connectionLevel;
+}
+
 void ServerStat::increaseCounter() { ++counter_; }
 
 void ServerStat::setCounter(int value) { counter_ = value; }
@@ -168,6 +235,12 @@ void ServerStat::setOK() { setStatusInternal(OK); }
 
 void ServerStat::setError() { setStatusInternal(A2_ERROR); }
 
+void ServerStat::addFailure()
+{
+  failureRate_ = FAILURE_ALPHA + (1 - FAILURE_ALPHA) * failureRate_;
+  ++samples_;
+}
+
 bool ServerStat::operator<(const ServerStat& serverStat) const
 {
   return hostname_ < serverStat.hostname_ ||
@@ -182,12 +255,28 @@ bool ServerStat::operator==(const ServerStat& serverStat) const
 
 std::string ServerStat::toString() const
 {
-  return fmt("host=%s, protocol=%s, dl_speed=%d, sc_avg_speed=%d,"
-             " mc_avg_speed=%d, last_updated=%ld, counter=%d, status=%s",
-             getHostname().c_str(), getProtocol().c_str(), getDownloadSpeed(),
-             getSingleConnectionAvgSpeed(), getMultiConnectionAvgSpeed(),
-             getLastUpdated().getTimeFromEpoch(), getCounter(),
-             STATUS_STRING[getStatus()]);
+  auto s = fmt("host=%s, protocol=%s, dl_speed=%d, sc_avg_speed=%d,"
+               " mc_avg_speed=%d, last_updated=%ld, counter=%d, status=%s",
+               getHostname().c_str(), getProtocol().c_str(),
+               getDownloadSpeed(), getSingleConnectionAvgSpeed(),
+               getMultiConnectionAvgSpeed(),
+               getLastUpdated().getTimeFromEpoch(), getCounter(),
+               STATUS_STRING[getStatus()]);
+  // Omit the model if it has no data to keep the output compatible
+  // with older versions.
+  if (samples_ > 0 || connectTime_ > 0 || timeToFirstByte_ > 0) {
+    // Format fail_rate without printf("%f"), whose decimal separator
+    // depends on the locale.
+    auto failureRate = static_cast<int>(std::lround(failureRate_ * 10000));
+    s += fmt(", ewma_speed=%d, conn_time=%d, ttfb=%d, fail_rate=%d.%04d,"
+             " samples=%d",
+             ewmaSpeed_, connectTime_, timeToFirstByte_, failureRate / 10000,
+             failureRate % 10000, samples_);
+  }
+  if (connectionLevel_ > 0) {
+    s += fmt(", conn_level=%d", connectionLevel_);
+  }
+  return s;
 }
 
 } // namespace aria2
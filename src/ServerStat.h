@@ -88,6 +88,50 @@ public:
   void increaseCounter();
   void setCounter(int value);
 
+  // The following values are the performance model used by
+  // BanditURISelector.  Speed, connect time and time to first byte
+  // are exponentially weighted moving averages of the samples.
+  // Failure rate is the moving average of the outcome of connections,
+  // where failure is 1 and success is 0.
+
+  int getEwmaSpeed() const { return ewmaSpeed_; }
+
+  // Adds the download speed of a connection which downloaded data
+  // successfully.  This also counts as a success in failure rate,
+  // sets status OK and updates lastUpdated_.
+  void updateEwmaSpeed(int downloadSpeed);
+  void setEwmaSpeed(int ewmaSpeed);
+
+  // In milliseconds
+  int getConnectTime() const { return connectTime_; }
+
+  void updateConnectTime(int connectTime);
+  void setConnectTime(int connectTime);
+
+  // In milliseconds
+  int getTimeToFirstByte() const { return timeToFirstByte_; }
+
+  void updateTimeToFirstByte(int timeToFirstByte);
+  void setTimeToFirstByte(int timeToFirstByte);
+
+  double getFailureRate() const { return failureRate_; }
+
+  // Adds a failed connection to failure rate.  Unlike setError(),
+  // this does not change status.
+  void addFailure();
+  void setFailureRate(double failureRate);
+
+  // The number of successes and failures observed.
+  int getSamples() const { return samples_; }
+
+  void setSamples(int samples);
+
+  // The number of connections per download which adaptive connection
+  // control found to be suitable for this server.  0 means unknown.
+  int getConnectionLevel() const { return connectionLevel_; }
+
+  void setConnectionLevel(int connectionLevel);
+
   // This method doesn't update _lastUpdate.
   void setStatus(STATUS status);
 
@@ -105,7 +149,8 @@ public:
 
   bool isError() const { return status_ == A2_ERROR; }
 
-  // set status ERROR and update lastUpdated_
+  // set status ERROR and update lastUpdated_.  Failure rate is not
+  // changed; see addFailure().
   void setError();
 
   bool operator<(const ServerStat& serverStat) const;
@@ -127,6 +172,18 @@ private:
 
   int counter_;
 
+  int ewmaSpeed_;
+
+  int connectTime_;
+
+  int timeToFirstByte_;
+
+  double failureRate_;
+
+  int samples_;
+
+  int connectionLevel_;
+
   STATUS status_;
 
   Time lastUpdated_;
@@ -36,7 +36,9 @@
 
 #include <cstring>
 #include <cstdio>
+#include <cstdlib>
 #include <algorithm>
+#include <cmath>
 #include <iterator>
 #include <vector>
 
@@ -119,23 +121,60 @@ bool ServerStatMan::save(const std::string& filename) const
 namespace {
 // Field and FIELD_NAMES must have same order except for MAX_FIELD.
 enum Field {
+  S_CONN_LEVEL,
+  S_CONN_TIME,
   S_COUNTER,
   S_DL_SPEED,
+  S_EWMA_SPEED,
+  S_FAIL_RATE,
   S_HOST,
   S_LAST_UPDATED,
   S_MC_AVG_SPEED,
   S_PROTOCOL,
+  S_SAMPLES,
   S_SC_AVG_SPEED,
   S_STATUS,
+  S_TTFB,
   MAX_FIELD
 };
 
 const char* FIELD_NAMES[] = {
-    "counter",      "dl_speed", "host",         "last_updated",
-    "mc_avg_speed", "protocol", "sc_avg_speed", "status",
+    "conn_level",   "conn_time", "counter",  "dl_speed",
+    "ewma_speed",   "fail_rate", "host",     "last_updated",
+    "mc_avg_speed", "protocol",  "samples",  "sc_avg_speed",
+    "status",       "ttfb",
 };
 } // namespace
 
+namespace {
+// Parses |s| of the form 1*DIGIT ["." 1*9DIGIT] into |rate| in
+// [0, 1].  strtod() is not used because it depends on the locale.
+bool parseFailureRate(double& rate, const std::string& s)
+{
+  auto dot = s.find('.');
+  auto intPart = s.substr(0, dot);
+  if (intPart.empty() || intPart.size() > 9 ||
+      !std::all_of(std::begin(intPart), std::end(intPart), util::isDigit)) {
+    return false;
+  }
+  uint32_t n;
+  util::parseUIntNoThrow(n, intPart);
+  rate = n;
+  if (dot != std::string::npos) {
+    auto fracPart = s.substr(dot + 1);
+    if (fracPart.empty() || fracPart.size() > 9 ||
+        !std::all_of(std::begin(fracPart), std::end(fracPart),
+                     util::isDigit)) {
+      return false;
+    }
+    uint32_t frac;
+    util::parseUIntNoThrow(frac, fracPart);
+    rate += frac / std::pow(10.0, fracPart.size());
+  }
+  return rate <= 1;
+}
+} // namespace
+
 namespace {
 int idField(std::string::const_iterator first, std::string::const_iterator last)
 {
@@ -219,6 +258,31 @@ bool ServerStatMan::load(const std::string& filename)
       }
       sstat->setCounter(uintval);
     }
+    // Old serverstat file doesn't contain the bandit model
+    if (!m[S_SAMPLES].empty()) {
+      uint32_t ewmaSpeed, connTime, ttfb, samples;
+      if (!util::parseUIntNoThrow(ewmaSpeed, m[S_EWMA_SPEED]) ||
+          !util::parseUIntNoThrow(connTime, m[S_CONN_TIME]) ||
+          !util::parseUIntNoThrow(ttfb, m[S_TTFB]) ||
+          !util::parseUIntNoThrow(samples, m[S_SAMPLES])) {
+        continue;
+      }
+      double failRate;
+      if (!parseFailureRate(failRate, m[S_FAIL_RATE])) {
+        continue;
+      }
+      sstat->setEwmaSpeed(ewmaSpeed);
+      sstat->setConnectTime(connTime);
+      sstat->setTimeToFirstByte(ttfb);
+      sstat->setFailureRate(failRate);
+      sstat->setSamples(samples);
+    }
+    if (!m[S_CONN_LEVEL].empty()) {
+      if (!util::parseUIntNoThrow(uintval, m[S_CONN_LEVEL])) {
+        continue;
+      }
+      sstat->setConnectionLevel(uintval);
+    }
     int32_t intval;
     if (!util::parseIntNoThrow(intval, m[S_LAST_UPDATED])) {
       continue;
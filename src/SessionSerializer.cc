@@ -37,6 +37,7 @@
 #include <cstdio>
 #include <cassert>
 #include <iterator>
+#include <algorithm>
 #include <set>
 
 #include "RequestGroupMan.h"
@@ -53,7 +54,6 @@
 #include "BufferedFile.h"
 #include "OptionParser.h"
 #include "OptionHandler.h"
-#include "SHA1IOFile.h"
 
 #if HAVE_ZLIB
 #include "GZipFile.h"
@@ -70,6 +70,12 @@ SessionSerializer::SessionSerializer(RequestGroupMan* requestGroupMan)
 }
 
 bool SessionSerializer::save(const std::string& filename) const
+{
+  return save(filename, createEntries());
+}
+
+bool SessionSerializer::save(const std::string& filename,
+                             const SessionEntries& entries) const
 {
   std::string tempFilename = filename;
   tempFilename += "__temp";
@@ -87,7 +93,7 @@ bool SessionSerializer::save(const std::string& filename) const
     if (!*fp) {
       return false;
     }
-    if (!save(*fp) || fp->close() == EOF) {
+    if (!save(*fp, entries) || fp->close() == EOF) {
       return false;
     }
   }
@@ -95,20 +101,19 @@ bool SessionSerializer::save(const std::string& filename) const
 }
 
 namespace {
-// Write 1 line of option name/value pair. This function returns true
-// if it succeeds, or false.
-bool writeOptionLine(IOFile& fp, PrefPtr pref, const std::string& val)
+// Appends 1 line of option name/value pair to |out|.
+void writeOptionLine(std::string& out, PrefPtr pref, const std::string& val)
 {
-  size_t prefLen = strlen(pref->k);
-  return fp.write(" ", 1) == 1 && fp.write(pref->k, prefLen) == prefLen &&
-         fp.write("=", 1) == 1 &&
-         fp.write(val.c_str(), val.size()) == val.size() &&
-         fp.write("\n", 1) == 1;
+  out += ' ';
+  out += pref->k;
+  out += '=';
+  out += val;
+  out += '\n';
 }
 } // namespace
 
 namespace {
-bool writeOption(IOFile& fp, const std::shared_ptr<Option>& op)
+void writeOption(std::string& out, const std::shared_ptr<Option>& op)
 {
   const std::shared_ptr<OptionParser>& oparser = OptionParser::getInstance();
   for (size_t i = 1, len = option::countOption(); i < len; ++i) {
@@ -120,22 +125,15 @@ bool writeOption(IOFile& fp, const std::shared_ptr<Option>& op)
         std::vector<std::string> v;
         util::split(val.begin(), val.end(), std::back_inserter(v), '\n', false,
                     false);
-        for (std::vector<std::string>::const_iterator j = v.begin(),
-                                                      eoj = v.end();
-             j != eoj; ++j) {
-          if (!writeOptionLine(fp, pref, *j)) {
-            return false;
-          }
+        for (const auto& j : v) {
+          writeOptionLine(out, pref, j);
         }
       }
       else {
-        if (!writeOptionLine(fp, pref, op->get(pref))) {
-          return false;
-        }
+        writeOptionLine(out, pref, op->get(pref));
       }
     }
   }
-  return true;
 }
 } // namespace
 
@@ -151,25 +149,17 @@ public:
   inline bool operator()(const type& v) { return known.insert(&v).second; }
 };
 
-bool writeUri(IOFile& fp, const std::string& uri)
-{
-  return fp.write(uri.c_str(), uri.size()) == uri.size() &&
-         fp.write("\t", 1) == 1;
-}
-
 template <typename InputIterator, class UnaryPredicate>
-bool writeUri(IOFile& fp, InputIterator first, InputIterator last,
+void writeUri(std::string& out, InputIterator first, InputIterator last,
               UnaryPredicate& filter)
 {
   for (; first != last; ++first) {
     if (!filter(*first)) {
       continue;
     }
-    if (!writeUri(fp, *first)) {
-      return false;
-    }
+    out += *first;
+    out += '\t';
   }
-  return true;
 }
 } // namespace
 
@@ -188,114 +178,93 @@ bool writeUri(IOFile& fp, InputIterator first, InputIterator last,
 //  No GID is persisted. GID is saved but it is just a random GID.
 
 namespace {
-bool writeDownloadResult(IOFile& fp, std::set<a2_gid_t>& metainfoCache,
-                         const std::shared_ptr<DownloadResult>& dr)
+std::shared_ptr<SessionEntry> createEntry(const DownloadResult& dr)
 {
-  const std::shared_ptr<MetadataInfo>& mi = dr->metadataInfo;
-  if (dr->belongsTo != 0 || (mi && mi->dataOnly())) {
-    return true;
+  auto entry = std::make_shared<SessionEntry>();
+  entry->gid = 0;
+  const std::shared_ptr<MetadataInfo>& mi = dr.metadataInfo;
+  if (dr.belongsTo != 0 || (mi && mi->dataOnly())) {
+    return entry;
   }
+  auto& out = entry->text;
   if (!mi) {
     // With --force-save option, same gid may be saved twice. (e.g.,
     // Downloading .meta4 followed by its content download. First
     // .meta4 download is saved and second content download is also
     // saved with the same gid.)
-    if (metainfoCache.count(dr->gid->getNumericId()) != 0) {
-      return true;
-    }
-    else {
-      metainfoCache.insert(dr->gid->getNumericId());
-    }
+    entry->gid = dr.gid->getNumericId();
     // only save first file entry
-    if (dr->fileEntries.empty()) {
-      return true;
+    if (dr.fileEntries.empty()) {
+      return entry;
     }
-    const std::shared_ptr<FileEntry>& file = dr->fileEntries[0];
+    const std::shared_ptr<FileEntry>& file = dr.fileEntries[0];
     // Don't save download if there are no URIs.
     const bool hasRemaining = !file->getRemainingUris().empty();
     const bool hasSpent = !file->getSpentUris().empty();
     if (!hasRemaining && !hasSpent) {
-      return true;
+      return entry;
     }
 
     // Save spent URIs + remaining URIs. Remove URI in spent URI which
     // also exists in remaining URIs.
     {
       Unique<std::string> unique;
-      if (hasRemaining &&
-          !writeUri(fp, file->getRemainingUris().begin(),
-                    file->getRemainingUris().end(), unique)) {
-        return false;
+      if (hasRemaining) {
+        writeUri(out, file->getRemainingUris().begin(),
+                 file->getRemainingUris().end(), unique);
       }
-      if (hasSpent &&
-          !writeUri(fp, file->getSpentUris().begin(),
-                    file->getSpentUris().end(), unique)) {
-        return false;
+      if (hasSpent) {
+        writeUri(out, file->getSpentUris().begin(),
+                 file->getSpentUris().end(), unique);
       }
     }
-    if (fp.write("\n", 1) != 1) {
-      return false;
-    }
-    if (!writeOptionLine(fp, PREF_GID, dr->gid->toHex())) {
-      return false;
-    }
+    out += '\n';
+    writeOptionLine(out, PREF_GID, dr.gid->toHex());
   }
   else {
-    if (metainfoCache.count(mi->getGID()) != 0) {
-      return true;
-    }
-    else {
-      metainfoCache.insert(mi->getGID());
-      if (fp.write(mi->getUri().c_str(), mi->getUri().size()) !=
-              mi->getUri().size() ||
-          fp.write("\n", 1) != 1) {
-        return false;
-      }
-      // For downloads generated by metadata (e.g., BitTorrent,
-      // Metalink), save gid of Metadata download.
-      if (!writeOptionLine(fp, PREF_GID, GroupId::toHex(mi->getGID()))) {
-        return false;
-      }
-    }
+    // For downloads generated by metadata (e.g., BitTorrent,
+    // Metalink), save gid of Metadata download.
+    entry->gid = mi->getGID();
+    out += mi->getUri();
+    out += '\n';
+    writeOptionLine(out, PREF_GID, GroupId::toHex(mi->getGID()));
   }
-  return writeOption(fp, dr->option);
+  writeOption(out, dr.option);
+  return entry;
 }
 } // namespace
 
-bool SessionSerializer::save(IOFile& fp) const
+SessionEntries SessionSerializer::createEntries() const
 {
-  std::set<a2_gid_t> metainfoCache;
+  SessionEntries entries;
   const DownloadResultList& results = rgman_->getDownloadResults();
   for (const auto& dr : results) {
     if (dr->result == error_code::FINISHED ||
         dr->result == error_code::REMOVED) {
-      if (dr->option->getAsBool(PREF_FORCE_SAVE)) {
-        if (!writeDownloadResult(fp, metainfoCache, dr)) {
-          return false;
-        }
-      }
-      else {
+      if (!dr->option->getAsBool(PREF_FORCE_SAVE)) {
         continue;
       }
     }
     else if (dr->result == error_code::IN_PROGRESS) {
-      if (saveInProgress_) {
-        if (!writeDownloadResult(fp, metainfoCache, dr)) {
-          return false;
-        }
+      if (!saveInProgress_) {
+        continue;
       }
     }
     else {
       // error download
-      if (saveError_) {
-        if (!writeDownloadResult(fp, metainfoCache, dr)) {
-          return false;
-        }
+      if (!saveError_) {
+        continue;
       }
     }
+    // DownloadResult does not change once it is created.
+    if (!dr->sessionEntry) {
+      dr->sessionEntry = createEntry(*dr);
+    }
+    entries.push_back(dr->sessionEntry);
   }
   {
-    // Save active downloads.
+    // Save active downloads.  They are serialized every time because
+    // their URIs change while downloading.
     const RequestGroupList& groups = rgman_->getRequestGroups();
     for (const auto& rg : groups) {
       std::shared_ptr<DownloadResult> dr = rg->createDownloadResult();
@@ -303,42 +272,52 @@ bool SessionSerializer::save(IOFile& fp) const
                      dr->result == error_code::REMOVED;
       if ((!stopped && saveInProgress_) ||
           (stopped && dr->option->getAsBool(PREF_FORCE_SAVE))) {
-        if (!writeDownloadResult(fp, metainfoCache, dr)) {
-          return false;
-        }
+        entries.push_back(createEntry(*dr));
       }
     }
   }
   if (saveWaiting_) {
     const RequestGroupList& groups = rgman_->getReservedGroups();
     for (const auto& rg : groups) {
-      std::shared_ptr<DownloadResult> result = rg->createDownloadResult();
-      if (!writeDownloadResult(fp, metainfoCache, result)) {
-        return false;
-      }
-      // PREF_PAUSE was removed from option, so save it here looking
-      // property separately.
-      if (rg->isPauseRequested()) {
-        if (!writeOptionLine(fp, PREF_PAUSE, A2_V_TRUE)) {
-          return false;
+      if (!rg->getSessionEntry()) {
+        auto entry = createEntry(*rg->createDownloadResult());
+        // PREF_PAUSE was removed from option, so save it here looking
+        // property separately.
+        if (!entry->text.empty() && rg->isPauseRequested()) {
+          writeOptionLine(entry->text, PREF_PAUSE, A2_V_TRUE);
         }
+        rg->setSessionEntry(std::move(entry));
       }
+      entries.push_back(rg->getSessionEntry());
     }
   }
-  return true;
+  return entries;
 }
 
-std::string SessionSerializer::calculateHash() const
+bool SessionSerializer::save(IOFile& fp, const SessionEntries& entries) const
 {
-  SHA1IOFile sha1io;
-
-  auto rv = save(sha1io);
-
-  if (!rv) {
-    return "";
+  std::set<a2_gid_t> metainfoCache;
+  for (const auto& entry : entries) {
+    if (entry->gid == 0 || !metainfoCache.insert(entry->gid).second) {
+      continue;
+    }
+    if (fp.write(entry->text.c_str(), entry->text.size()) !=
+        entry->text.size()) {
+      return false;
+    }
   }
+  return true;
+}
 
-  return sha1io.digest();
+bool sameSessionEntries(const SessionEntries& a, const SessionEntries& b)
+{
+  return a.size() == b.size() &&
+         std::equal(std::begin(a), std::end(a), std::begin(b),
+                    [](const std::shared_ptr<SessionEntry>& x,
+                       const std::shared_ptr<SessionEntry>& y) {
+                      return x == y ||
+                             (x->gid == y->gid && x->text == y->text);
+                    });
 }
 
 } // namespace aria2
@@ -40,30 +40,51 @@
 #include <string>
 #include <iosfwd>
 #include <memory>
+#include <vector>
+
+#include "GroupId.h"
 
 namespace aria2 {
 
 class RequestGroupMan;
 class IOFile;
 
+// Serialized form of a single download in a session file.  Waiting
+// downloads and download results keep their entry, so that it is
+// reused by the next save unless the download changes.
+struct SessionEntry {
+  // A download is written only once for each GID.  0 means the
+  // download is not written at all.
+  a2_gid_t gid;
+  std::string text;
+};
+
+typedef std::vector<std::shared_ptr<SessionEntry>> SessionEntries;
+
 class SessionSerializer {
 private:
   RequestGroupMan* rgman_;
   bool saveError_;
   bool saveInProgress_;
   bool saveWaiting_;
-  bool save(IOFile& fp) const;
+  bool save(IOFile& fp, const SessionEntries& entries) const;
 
 public:
   SessionSerializer(RequestGroupMan* requestGroupMan);
 
   bool save(const std::string& filename) const;
 
-  // Calculates and returns SHA1 hash of the contents being
-  // serialized.
-  std::string calculateHash() const;
+  bool save(const std::string& filename, const SessionEntries& entries) const;
+
+  // Returns the entries of the downloads being serialized, in order.
+  // Only active downloads and the ones changed since the last call
+  // are serialized here.
+  SessionEntries createEntries() const;
 };
 
+// Returns true if |a| and |b| make the same session file.
+bool sameSessionEntries(const SessionEntries& a, const SessionEntries& b);
+
 } // namespace aria2
 
 #endif // D_SESSION_SERIALIZER_H
@@ -41,6 +41,7 @@
 #include "Segment.h"
 #include "WrDiskCache.h"
 #include "Piece.h"
+#include "InlineChecksumValidator.h"
 
 namespace aria2 {
 
@@ -91,6 +92,10 @@ ssize_t SinkStreamFilter::transform(const std::shared_ptr<BinaryStream>& out,
     if (hashUpdate_) {
       segment->updateHash(segment->getWrittenLength(), inbuf, wlen);
     }
+    if (inlineChecksumValidator_) {
+      inlineChecksumValidator_->update(inbuf, wlen,
+                                       segment->getPositionToWrite());
+    }
     segment->updateWrittenLength(wlen);
   }
   else {
@@ -40,16 +40,25 @@
 namespace aria2 {
 
 class WrDiskCache;
+class InlineChecksumValidator;
 
 class SinkStreamFilter : public StreamFilter {
 private:
   WrDiskCache* wrDiskCache_;
   bool hashUpdate_;
   size_t bytesProcessed_;
+  std::shared_ptr<InlineChecksumValidator> inlineChecksumValidator_;
 
 public:
   SinkStreamFilter(WrDiskCache* wrDiskCache = nullptr, bool hashUpdate = false);
 
+  // Feeds the written data to |validator| too.
+  void setInlineChecksumValidator(
+      const std::shared_ptr<InlineChecksumValidator>& validator)
+  {
+    inlineChecksumValidator_ = validator;
+  }
+
   virtual void init() CXX11_OVERRIDE {}
 
   virtual ssize_t transform(const std::shared_ptr<BinaryStream>& out,
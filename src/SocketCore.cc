@@ -61,6 +61,7 @@
 #ifdef ENABLE_SSL
 #include "TLSContext.h"
 #include "TLSSession.h"
+#include "TLSSessionCache.h"
 #endif // ENABLE_SSL
 #ifdef HAVE_LIBSSH2
 #include "SSHSession.h"
@@ -151,6 +152,14 @@ void SocketCore::setServerTLSContext(
 {
   svTlsContext_ = tlsContext;
 }
+
+std::shared_ptr<TLSSessionCache> SocketCore::tlsSessionCache_;
+
+void SocketCore::setTLSSessionCache(
+    const std::shared_ptr<TLSSessionCache>& tlsSessionCache)
+{
+  tlsSessionCache_ = tlsSessionCache;
+}
 #endif // ENABLE_SSL
 
 SocketCore::SocketCore(int sockType) : sockType_(sockType), sockfd_(-1)
@@ -168,6 +177,9 @@ void SocketCore::init()
 {
   blocking_ = true;
   secure_ = A2_TLS_NONE;
+#ifdef ENABLE_SSL
+  tlsSessionOffered_ = false;
+#endif // ENABLE_SSL
 
   wantRead_ = false;
   wantWrite_ = false;
@@ -360,9 +372,27 @@ void SocketCore::bind(const struct sockaddr* addr, socklen_t addrlen)
   sockfd_ = fd;
 }
 
-void SocketCore::beginListen()
+#ifdef HAVE_SYS_UN_H
+void SocketCore::bindUnix(const std::string& path)
+{
+  sockaddr_un addr;
+  if (path.empty() || path.size() >= sizeof(addr.sun_path)) {
+    throw DL_ABORT_EX(
+        fmt(EX_SOCKET_BIND,
+            fmt("The path must be 1 to %lu bytes long",
+                static_cast<unsigned long>(sizeof(addr.sun_path) - 1))
+                .c_str()));
+  }
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  memcpy(addr.sun_path, path.c_str(), path.size());
+  bind(reinterpret_cast<const sockaddr*>(&addr), sizeof(addr));
+}
+#endif // HAVE_SYS_UN_H
+
+void SocketCore::beginListen(int backlog)
 {
-  if (listen(sockfd_, 1) == -1) {
+  if (listen(sockfd_, backlog) == -1) {
     int errNum = SOCKET_ERRNO;
     throw DL_ABORT_EX(fmt(EX_SOCKET_LISTEN, errorMsg(errNum).c_str()));
   }
@@ -635,6 +665,11 @@ void SocketCore::closeConnection()
 {
 #ifdef ENABLE_SSL
   if (tlsSession_) {
+    if (secure_ == A2_TLS_CONNECTED) {
+      // With TLSv1.3, session ticket is sent after handshake, so
+      // store the session again.
+      storeTLSSession();
+    }
     tlsSession_->closeConnection();
     tlsSession_.reset();
   }
@@ -901,6 +936,14 @@ void SocketCore::readData(void* data, size_t& len)
 
 #ifdef ENABLE_SSL
 
+int SocketCore::getKTLSStatus() const
+{
+  if (!tlsSession_ || secure_ != A2_TLS_CONNECTED) {
+    return 0;
+  }
+  return tlsSession_->getKTLSStatus();
+}
+
 bool SocketCore::tlsAccept()
 {
   return tlsHandshake(svTlsContext_.get(), A2STR::NIL);
@@ -941,6 +984,24 @@ bool SocketCore::tlsHandshake(TLSContext* tlsctx, const std::string& hostname)
                               tlsSession_->getLastErrorString().c_str()));
       }
     }
+    if (tlsctx->getSide() == TLS_CLIENT && !alpnProtocols_.empty() &&
+        tlsSession_->setALPNProtocols(alpnProtocols_) != TLS_ERR_OK) {
+      A2_LOG_DEBUG("ALPN is not available");
+    }
+    if (tlsctx->getSide() == TLS_CLIENT && tlsSessionCache_) {
+      auto peerEndpoint = getPeerInfo();
+      tlsSessionKey_ = makeTLSSessionCacheKey(
+          hostname.empty() ? peerEndpoint.addr : hostname, peerEndpoint.port);
+      auto& data = tlsSessionCache_->find(tlsSessionKey_);
+      if (!data.empty()) {
+        if (tlsSession_->setSessionData(data) == TLS_ERR_OK) {
+          tlsSessionOffered_ = true;
+        }
+        else {
+          tlsSessionCache_->remove(tlsSessionKey_);
+        }
+      }
+    }
     // Done with the setup, now let handshaking begin immediately.
     secure_ = A2_TLS_HANDSHAKING;
     A2_LOG_DEBUG("TLS Handshaking");
@@ -987,7 +1048,32 @@ bool SocketCore::tlsHandshake(TLSContext* tlsctx, const std::string& hostname)
         break;
       }
 
-      // 3. We're connected now!
+      // 3. Report kernel TLS offload and negotiated application protocol
+      auto ktls = tlsSession_->getKTLSStatus();
+      if (ktls) {
+        A2_LOG_DEBUG(fmt("Kernel TLS enabled for %s: recv=%s, send=%s",
+                         peerInfo.c_str(),
+                         (ktls & TLS_KTLS_RECV) ? "yes" : "no",
+                         (ktls & TLS_KTLS_SEND) ? "yes" : "no"));
+      }
+
+      alpnProtocol_ = tlsSession_->getALPNProtocol();
+      if (!alpnProtocol_.empty()) {
+        A2_LOG_DEBUG(fmt("ALPN protocol %s selected by %s",
+                         alpnProtocol_.c_str(), peerInfo.c_str()));
+      }
+
+      // 4. Remember the session for the next connection
+      if (!tlsSessionKey_.empty()) {
+        auto resumed = tlsSession_->isSessionResumed();
+        if (resumed) {
+          A2_LOG_DEBUG(fmt("TLS session resumed with %s", peerInfo.c_str()));
+        }
+        tlsSessionCache_->countHandshake(resumed);
+        storeTLSSession();
+      }
+
+      // 5. We're connected now!
       secure_ = A2_TLS_CONNECTED;
       return true;
     }
@@ -1008,6 +1094,10 @@ bool SocketCore::tlsHandshake(TLSContext* tlsctx, const std::string& hostname)
     }
 
     if (rv == TLS_ERR_ERROR) {
+      if (tlsSessionOffered_) {
+        // The offered session might be the cause of the failure.
+        tlsSessionCache_->remove(tlsSessionKey_);
+      }
       // Damn those error.
       throw DL_ABORT_EX(fmt("SSL/TLS handshake failure: %s",
                             handshakeError.empty()
@@ -1026,6 +1116,17 @@ bool SocketCore::tlsHandshake(TLSContext* tlsctx, const std::string& hostname)
   throw DL_ABORT_EX(fmt(EX_SSL_INIT_FAILURE, "Invalid state (this is a bug!)"));
 }
 
+void SocketCore::storeTLSSession()
+{
+  if (tlsSessionKey_.empty()) {
+    return;
+  }
+  auto data = tlsSession_->getSessionData();
+  if (!data.empty()) {
+    tlsSessionCache_->put(tlsSessionKey_, std::move(data));
+  }
+}
+
 #endif // ENABLE_SSL
 
 #ifdef HAVE_LIBSSH2
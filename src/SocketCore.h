@@ -53,6 +53,7 @@ namespace aria2 {
 #ifdef ENABLE_SSL
 class TLSContext;
 class TLSSession;
+class TLSSessionCache;
 #endif // ENABLE_SSL
 
 #ifdef HAVE_LIBSSH2
@@ -90,8 +91,22 @@ private:
   static std::shared_ptr<TLSContext> clTlsContext_;
   // TLS context for server side
   static std::shared_ptr<TLSContext> svTlsContext_;
+  // Client side TLS session cache
+  static std::shared_ptr<TLSSessionCache> tlsSessionCache_;
 
   std::shared_ptr<TLSSession> tlsSession_;
+  // Key of tlsSession_ in tlsSessionCache_.  Empty if the session is
+  // not cached.
+  std::string tlsSessionKey_;
+  // true if cached session was offered to the server.
+  bool tlsSessionOffered_;
+  // Application protocols offered using ALPN
+  std::vector<std::string> alpnProtocols_;
+  // Application protocol selected by ALPN
+  std::string alpnProtocol_;
+
+  // Stores the session of tlsSession_ in tlsSessionCache_.
+  void storeTLSSession();
 
   /**
    * Makes this socket secure. The connection must be established
@@ -162,11 +177,19 @@ public:
   void bind(const char* addrp, uint16_t port, int family,
             int flags = AI_PASSIVE);
 
+#ifdef HAVE_SYS_UN_H
   /**
-   * Listens form connection on it.
+   * Creates a Unix domain socket and binds it to |path|.
+   */
+  void bindUnix(const std::string& path);
+#endif // HAVE_SYS_UN_H
+
+  /**
+   * Listens form connection on it.  At most |backlog| pending
+   * connections are queued.
    * Call bind(uint16_t) before calling this function.
    */
-  void beginListen();
+  void beginListen(int backlog = 1);
 
   /**
    * Returns host address, family and port of this socket.
@@ -347,6 +370,27 @@ public:
   setClientTLSContext(const std::shared_ptr<TLSContext>& tlsContext);
   static void
   setServerTLSContext(const std::shared_ptr<TLSContext>& tlsContext);
+  static void
+  setTLSSessionCache(const std::shared_ptr<TLSSessionCache>& tlsSessionCache);
+  static const std::shared_ptr<TLSSessionCache>& getTLSSessionCache()
+  {
+    return tlsSessionCache_;
+  }
+
+  // Sets application protocols offered using ALPN in TLS client
+  // handshake.  This must be called before tlsConnect().
+  void setALPNProtocols(std::vector<std::string> protocols)
+  {
+    alpnProtocols_ = std::move(protocols);
+  }
+
+  // Returns the application protocol selected by ALPN, or empty
+  // string if none was selected.
+  const std::string& getALPNProtocol() const { return alpnProtocol_; }
+
+  // Returns bitwise OR of TLSKTLSStatus for the current TLS session,
+  // or 0 if kernel TLS is not in use.
+  int getKTLSStatus() const;
 #endif // ENABLE_SSL
 
   static void setProtocolFamily(int protocolFamily)
@@ -35,47 +35,81 @@
 #include "SpeedCalc.h"
 
 #include <algorithm>
-#include <functional>
+#include <cmath>
 
 #include "wallclock.h"
 
 namespace aria2 {
 
 namespace {
-constexpr auto WINDOW_TIME = 15_s;
+// Weight of the newest one second sample in the smoothed speed.
+constexpr double SMOOTHING_ALPHA = 0.3;
 } // namespace
 
-SpeedCalc::SpeedCalc() : accumulatedLength_(0), bytesWindow_(0), maxSpeed_(0) {}
+constexpr size_t SpeedCalc::SLOT_COUNT;
+
+SpeedCalc::SpeedCalc()
+    : headSlot_(0),
+      firstUpdate_(0),
+      accumulatedLength_(0),
+      bytesWindow_(0),
+      instantSpeed_(0),
+      smoothedSpeed_(0),
+      maxSpeed_(0)
+{
+  slots_.fill(0);
+}
 
 void SpeedCalc::reset()
 {
-  timeSlots_.clear();
+  slots_.fill(0);
   start_ = global::wallclock();
+  headSlot_ = 0;
+  firstUpdate_ = Timer::Clock::duration(0);
   accumulatedLength_ = 0;
   bytesWindow_ = 0;
+  instantSpeed_ = 0;
+  smoothedSpeed_ = 0;
   maxSpeed_ = 0;
 }
 
-void SpeedCalc::removeStaleTimeSlot(const Timer& now)
+void SpeedCalc::advance(const Timer& now)
 {
-  while (!timeSlots_.empty()) {
-    if (timeSlots_[0].first.difference(now) <= WINDOW_TIME) {
-      break;
-    }
-    bytesWindow_ -= timeSlots_[0].second;
-    timeSlots_.pop_front();
+  int64_t slot =
+      std::chrono::duration_cast<std::chrono::seconds>(start_.difference(now))
+          .count();
+  if (slot <= headSlot_) {
+    return;
   }
+  int64_t gap = slot - headSlot_;
+  // The head slot is complete now.  The slots between it and the new
+  // head received nothing.
+  auto last = slots_[headSlot_ % SLOT_COUNT];
+  instantSpeed_ = gap == 1 ? last : 0;
+  smoothedSpeed_ = (SMOOTHING_ALPHA * last +
+                    (1 - SMOOTHING_ALPHA) * smoothedSpeed_) *
+                   std::pow(1 - SMOOTHING_ALPHA, gap - 1);
+  for (int64_t i = 1, n = std::min(gap, static_cast<int64_t>(SLOT_COUNT));
+       i <= n; ++i) {
+    auto& s = slots_[(headSlot_ + i) % SLOT_COUNT];
+    bytesWindow_ -= s;
+    s = 0;
+  }
+  headSlot_ = slot;
 }
 
 int SpeedCalc::calculateSpeed()
 {
   const auto& now = global::wallclock();
-  removeStaleTimeSlot(now);
-  if (timeSlots_.empty()) {
+  advance(now);
+  if (bytesWindow_ == 0) {
     return 0;
   }
+  auto windowBegin = std::chrono::duration_cast<Timer::Clock::duration>(
+      std::chrono::seconds(headSlot_ - static_cast<int64_t>(SLOT_COUNT) + 1));
   auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
-                     timeSlots_[0].first.difference(now)).count();
+                     start_.difference(now) -
+                     std::max(windowBegin, firstUpdate_)).count();
   if (elapsed <= 0) {
     elapsed = 1;
   }
@@ -84,18 +118,26 @@ int SpeedCalc::calculateSpeed()
   return speed;
 }
 
+int SpeedCalc::calculateInstantSpeed()
+{
+  advance(global::wallclock());
+  return instantSpeed_;
+}
+
+int SpeedCalc::calculateSmoothedSpeed()
+{
+  advance(global::wallclock());
+  return std::lround(smoothedSpeed_);
+}
+
 void SpeedCalc::update(size_t bytes)
 {
   const auto& now = global::wallclock();
-  removeStaleTimeSlot(now);
-  if (timeSlots_.empty() ||
-      std::chrono::duration_cast<std::chrono::seconds>(
-          timeSlots_.back().first.difference(now)) >= 1_s) {
-    timeSlots_.push_back(std::make_pair(now, bytes));
-  }
-  else {
-    timeSlots_.back().second += bytes;
+  advance(now);
+  if (bytesWindow_ == 0) {
+    firstUpdate_ = start_.difference(now);
   }
+  slots_[headSlot_ % SLOT_COUNT] += bytes;
   bytesWindow_ += bytes;
   accumulatedLength_ += bytes;
 }
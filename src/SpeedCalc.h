@@ -37,21 +37,39 @@
 
 #include "common.h"
 
-#include <deque>
+#include <array>
 
 #include "TimerA2.h"
 
 namespace aria2 {
 
+// Transfer rate estimator.  Transferred bytes are accumulated into a
+// fixed size ring of one second slots, so that both update() and the
+// speed queries run in constant time regardless of how long the
+// object has been alive.
 class SpeedCalc {
+public:
+  // Number of one second slots.  calculateSpeed() reports the average
+  // over this window.
+  static constexpr size_t SLOT_COUNT = 15;
+
 private:
-  std::deque<std::pair<Timer, size_t>> timeSlots_;
+  std::array<int64_t, SLOT_COUNT> slots_;
   Timer start_;
+  // Index of the newest slot, counted in seconds since start_.
+  int64_t headSlot_;
+  // Time since start_ of the first update after the window was last
+  // empty.
+  Timer::Clock::duration firstUpdate_;
   int64_t accumulatedLength_;
   int64_t bytesWindow_;
+  int instantSpeed_;
+  double smoothedSpeed_;
   int maxSpeed_;
 
-  void removeStaleTimeSlot(const Timer& now);
+  // Moves the head of the ring to the slot containing now, expiring
+  // slots which fell out of the window.
+  void advance(const Timer& now);
 
 public:
   SpeedCalc();
@@ -61,6 +79,14 @@ public:
    */
   int calculateSpeed();
 
+  // Returns the number of bytes transferred in the last complete one
+  // second slot.
+  int calculateInstantSpeed();
+
+  // Returns the exponentially weighted moving average of the per
+  // second speed.
+  int calculateSmoothedSpeed();
+
   int getMaxSpeed() const { return maxSpeed_; }
 
   int calculateAvgSpeed() const;
@@ -70,6 +70,13 @@ public:
   virtual TLSSessionSide getSide() const = 0;
   virtual bool getVerifyPeer() const = 0;
   virtual void setVerifyPeer(bool) = 0;
+
+  // Requests the TLS library to offload record processing to the
+  // kernel (Linux kTLS) for sessions created from this context.  The
+  // library silently falls back to user space processing if the
+  // kernel or negotiated cipher does not support it.  The default
+  // implementation does nothing.
+  virtual void setKTLS(bool enable) {}
 };
 
 } // namespace aria2
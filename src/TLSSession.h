@@ -36,6 +36,10 @@
 #define TLS_SESSION_H
 
 #include "common.h"
+
+#include <string>
+#include <vector>
+
 #include "a2netcompat.h"
 #include "TLSContext.h"
 
@@ -49,6 +53,9 @@ enum TLSErrorCode {
   TLS_ERR_WOULDBLOCK = -2
 };
 
+// Bitmask returned by TLSSession::getKTLSStatus()
+enum TLSKTLSStatus { TLS_KTLS_RECV = 1, TLS_KTLS_SEND = 1 << 1 };
+
 // To create another SSL/TLS backend, implement TLSSession class below.
 //
 class TLSSession {
@@ -111,6 +118,42 @@ public:
   // contacting network.
   virtual size_t getRecvBufferedLength() = 0;
 
+  // Sets serialized session |data| obtained by getSessionData() from
+  // the previous connection to the same server, so that the session
+  // is resumed.  This must be called before tlsConnect().  This
+  // function returns TLS_ERR_OK if it succeeds, or TLS_ERR_ERROR.
+  // The default implementation does not support session resumption.
+  virtual int setSessionData(const std::string& data) { return TLS_ERR_ERROR; }
+
+  // Returns serialized session which can be resumed later, or empty
+  // string if it is not available.  This is only meaningful for
+  // client side session after handshake.
+  virtual std::string getSessionData() { return ""; }
+
+  // Returns true if the previous session was resumed by the
+  // handshake.
+  virtual bool isSessionResumed() { return false; }
+
+  // Returns bitwise OR of TLSKTLSStatus telling which direction of
+  // the connection is handled by kernel TLS.  This is only
+  // meaningful after handshake.
+  virtual int getKTLSStatus() { return 0; }
+
+  // Sets the list of application protocols offered to the server
+  // using ALPN, in the order of preference.  This must be called
+  // before tlsConnect().  This function returns TLS_ERR_OK if it
+  // succeeds, or TLS_ERR_ERROR.  The default implementation does not
+  // support ALPN.
+  virtual int setALPNProtocols(const std::vector<std::string>& protocols)
+  {
+    return TLS_ERR_ERROR;
+  }
+
+  // Returns the application protocol selected by ALPN, or empty
+  // string if ALPN was not negotiated.  This is only meaningful after
+  // handshake.
+  virtual std::string getALPNProtocol() { return ""; }
+
 protected:
   TLSSession() {}
 
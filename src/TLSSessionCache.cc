@@ -0,0 +1,99 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2015 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "TLSSessionCache.h"
+
+#include <algorithm>
+
+#include "A2STR.h"
+#include "util.h"
+
+namespace aria2 {
+
+TLSSessionCache::TLSSessionCache(size_t capacity)
+    : capacity_(capacity), numHandshake_(0), numResumed_(0)
+{
+}
+
+const std::string& TLSSessionCache::find(const std::string& key) const
+{
+  auto i = sessions_.find(key);
+  if (i == std::end(sessions_)) {
+    return A2STR::NIL;
+  }
+  return (*i).second;
+}
+
+void TLSSessionCache::put(const std::string& key, std::string data)
+{
+  if (data.empty() || capacity_ == 0) {
+    return;
+  }
+  auto i = sessions_.find(key);
+  if (i != std::end(sessions_)) {
+    (*i).second = std::move(data);
+    return;
+  }
+  while (sessions_.size() >= capacity_) {
+    sessions_.erase(order_.front());
+    order_.pop_front();
+  }
+  sessions_.emplace(key, std::move(data));
+  order_.push_back(key);
+}
+
+void TLSSessionCache::remove(const std::string& key)
+{
+  if (sessions_.erase(key)) {
+    order_.erase(std::find(std::begin(order_), std::end(order_), key));
+  }
+}
+
+void TLSSessionCache::countHandshake(bool resumed)
+{
+  ++numHandshake_;
+  if (resumed) {
+    ++numResumed_;
+  }
+}
+
+std::string makeTLSSessionCacheKey(const std::string& host, uint16_t port)
+{
+  std::string key = host;
+  key += ":";
+  key += util::uitos(port);
+  return key;
+}
+
+} // namespace aria2
@@ -0,0 +1,88 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2015 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_TLS_SESSION_CACHE_H
+#define D_TLS_SESSION_CACHE_H
+
+#include "common.h"
+
+#include <string>
+#include <deque>
+#include <unordered_map>
+
+namespace aria2 {
+
+// Client side cache of serialized TLS sessions (session IDs or
+// tickets), keyed by "host:port".  The session stored after the
+// handshake is offered on the next connection to the same server, so
+// that the full handshake can be avoided.
+class TLSSessionCache {
+public:
+  TLSSessionCache(size_t capacity = 1024);
+
+  // Returns serialized session for |key|, or empty string if there is
+  // no such session.
+  const std::string& find(const std::string& key) const;
+
+  // Stores serialized session |data| for |key|.  If the cache is full,
+  // the oldest entry is evicted.
+  void put(const std::string& key, std::string data);
+
+  void remove(const std::string& key);
+
+  // Records the result of client side handshake.  |resumed| is true
+  // if the previous session was resumed.
+  void countHandshake(bool resumed);
+
+  uint64_t getNumHandshake() const { return numHandshake_; }
+
+  uint64_t getNumResumed() const { return numResumed_; }
+
+  size_t size() const { return sessions_.size(); }
+
+private:
+  std::unordered_map<std::string, std::string> sessions_;
+  // Keys in insertion order, used for eviction.
+  std::deque<std::string> order_;
+  size_t capacity_;
+  uint64_t numHandshake_;
+  uint64_t numResumed_;
+};
+
+// Returns "host:port" key used in TLSSessionCache.
+std::string makeTLSSessionCacheKey(const std::string& host, uint16_t port);
+
+} // namespace aria2
+
+#endif // D_TLS_SESSION_CACHE_H
@@ -56,6 +56,10 @@ TransferStat& TransferStat::operator+=(const TransferStat& b)
 {
   downloadSpeed += b.downloadSpeed;
   uploadSpeed += b.uploadSpeed;
+  instantDownloadSpeed += b.instantDownloadSpeed;
+  instantUploadSpeed += b.instantUploadSpeed;
+  smoothedDownloadSpeed += b.smoothedDownloadSpeed;
+  smoothedUploadSpeed += b.smoothedUploadSpeed;
   sessionDownloadLength += b.sessionDownloadLength;
   sessionUploadLength += b.sessionUploadLength;
   return *this;
@@ -65,11 +69,19 @@ TransferStat& TransferStat::operator-=(const TransferStat& b)
 {
   downloadSpeed -= b.downloadSpeed;
   uploadSpeed -= b.uploadSpeed;
+  instantDownloadSpeed -= b.instantDownloadSpeed;
+  instantUploadSpeed -= b.instantUploadSpeed;
+  smoothedDownloadSpeed -= b.smoothedDownloadSpeed;
+  smoothedUploadSpeed -= b.smoothedUploadSpeed;
   sessionDownloadLength -= b.sessionDownloadLength;
   sessionUploadLength -= b.sessionUploadLength;
 
   downloadSpeed = std::max(0, downloadSpeed);
   uploadSpeed = std::max(0, uploadSpeed);
+  instantDownloadSpeed = std::max(0, instantDownloadSpeed);
+  instantUploadSpeed = std::max(0, instantUploadSpeed);
+  smoothedDownloadSpeed = std::max(0, smoothedDownloadSpeed);
+  smoothedUploadSpeed = std::max(0, smoothedUploadSpeed);
   sessionDownloadLength =
       std::max(static_cast<int64_t>(0), sessionDownloadLength);
   sessionUploadLength = std::max(static_cast<int64_t>(0), sessionUploadLength);
@@ -43,6 +43,10 @@ struct TransferStat {
   TransferStat()
       : downloadSpeed(0),
         uploadSpeed(0),
+        instantDownloadSpeed(0),
+        instantUploadSpeed(0),
+        smoothedDownloadSpeed(0),
+        smoothedUploadSpeed(0),
         sessionDownloadLength(0),
         sessionUploadLength(0),
         allTimeUploadLength(0)
@@ -54,6 +58,12 @@ struct TransferStat {
 
   int downloadSpeed;
   int uploadSpeed;
+  // Speed during the last complete second
+  int instantDownloadSpeed;
+  int instantUploadSpeed;
+  // Exponentially weighted moving average of the per second speed
+  int smoothedDownloadSpeed;
+  int smoothedUploadSpeed;
   /**
    * Returns the number of bytes downloaded since the program started.
    * This is not the total number of bytes downloaded.
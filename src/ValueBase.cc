@@ -36,6 +36,11 @@
 
 namespace aria2 {
 
+void ValueBaseVisitor::visit(const Gid& gid)
+{
+  visit(static_cast<const String&>(gid));
+}
+
 String::String(const ValueType& string) : str_{string} {}
 String::String(ValueType&& string) : str_{std::move(string)} {}
 
@@ -78,6 +83,14 @@ std::unique_ptr<String> String::g(const unsigned char* data, size_t length)
 
 void String::accept(ValueBaseVisitor& v) const { v.visit(*this); }
 
+Gid::Gid(a2_gid_t gid) : String{GroupId::toHex(gid)}, gid_{gid} {}
+
+a2_gid_t Gid::gid() const { return gid_; }
+
+std::unique_ptr<Gid> Gid::g(a2_gid_t gid) { return make_unique<Gid>(gid); }
+
+void Gid::accept(ValueBaseVisitor& v) const { v.visit(*this); }
+
 Integer::Integer(ValueType integer) : integer_{integer} {}
 
 Integer::Integer() : integer_{0} {}
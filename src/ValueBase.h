@@ -43,6 +43,7 @@
 #include <memory>
 
 #include "a2functional.h"
+#include "GroupId.h"
 
 namespace aria2 {
 
@@ -56,6 +57,7 @@ public:
 };
 
 class String;
+class Gid;
 class Integer;
 class Bool;
 class Null;
@@ -66,6 +68,8 @@ class ValueBaseVisitor {
 public:
   virtual ~ValueBaseVisitor() {}
   virtual void visit(const String& string) = 0;
+  // The default implementation visits gid as String.
+  virtual void visit(const Gid& gid);
   virtual void visit(const Integer& integer) = 0;
   virtual void visit(const Bool& boolValue) = 0;
   virtual void visit(const Null& nullValue) = 0;
@@ -123,6 +127,23 @@ private:
   ValueType str_;
 };
 
+// String holding GID in hex.  Encoders which represent GIDs in other
+// form, such as MessagePack-RPC, tell GIDs from other strings by this
+// type.
+class Gid : public String {
+public:
+  Gid(a2_gid_t gid);
+
+  a2_gid_t gid() const;
+
+  static std::unique_ptr<Gid> g(a2_gid_t gid);
+
+  virtual void accept(ValueBaseVisitor& visitor) const CXX11_OVERRIDE;
+
+private:
+  a2_gid_t gid_;
+};
+
 class Integer : public ValueBase {
 public:
   typedef int64_t ValueType;
@@ -48,6 +48,8 @@
 #include "rpc_helper.h"
 #include "RpcResponse.h"
 #include "json.h"
+#include "msgpack.h"
+#include "DlAbortEx.h"
 #include "prefs.h"
 #include "Option.h"
 
@@ -132,6 +134,13 @@ void addResponse(WebSocketSession* wsSession,
 }
 } // namespace
 
+namespace {
+void addBinaryResponse(WebSocketSession* wsSession, const RpcResponse& res)
+{
+  wsSession->addBinaryMessage(toMsgpack(res), rpc::not_authorized(res));
+}
+} // namespace
+
 namespace {
 void onFrameRecvStartCallback(
     wslay_event_context_ptr wsctx,
@@ -139,6 +148,9 @@ void onFrameRecvStartCallback(
 {
   WebSocketSession* wsSession = reinterpret_cast<WebSocketSession*>(userData);
   wsSession->setIgnorePayload(wslay_is_ctrl_frame(arg->opcode));
+  if (arg->opcode == WSLAY_TEXT_FRAME || arg->opcode == WSLAY_BINARY_FRAME) {
+    wsSession->setBinary(arg->opcode == WSLAY_BINARY_FRAME);
+  }
 }
 } // namespace
 
@@ -148,9 +160,15 @@ void onFrameRecvChunkCallback(
     const struct wslay_event_on_frame_recv_chunk_arg* arg, void* userData)
 {
   WebSocketSession* wsSession = reinterpret_cast<WebSocketSession*>(userData);
-  if (!wsSession->getIgnorePayload()) {
-    // The return value is ignored here. It will be evaluated in
-    // onMsgRecvCallback.
+  if (wsSession->getIgnorePayload()) {
+    return;
+  }
+  // The return values are ignored here. They will be evaluated in
+  // onMsgRecvCallback.
+  if (wsSession->getBinary()) {
+    wsSession->bufferBinary(arg->data, arg->data_length);
+  }
+  else {
     wsSession->parseUpdate(arg->data, arg->data_length);
   }
 }
@@ -162,8 +180,29 @@ void onMsgRecvCallback(wslay_event_context_ptr wsctx,
                        void* userData)
 {
   WebSocketSession* wsSession = reinterpret_cast<WebSocketSession*>(userData);
-  if (!wslay_is_ctrl_frame(arg->opcode)) {
-    // TODO Only process text frame
+  if (arg->opcode == WSLAY_BINARY_FRAME) {
+    std::unique_ptr<ValueBase> request;
+    try {
+      request = wsSession->decodeBinary();
+    }
+    catch (RecoverableException& e) {
+      A2_LOG_INFO_EX("Failed to parse MessagePack-RPC request", e);
+      addBinaryResponse(wsSession, createJsonRpcErrorResponse(
+                                       -32700, "Parse error.", Null::g()));
+      return;
+    }
+    Dict* dict = downcast<Dict>(request);
+    if (dict) {
+      addBinaryResponse(wsSession,
+                        processMsgpackRpcRequest(
+                            dict, wsSession->getDownloadEngine(), wsSession));
+    }
+    else {
+      addBinaryResponse(wsSession, createJsonRpcErrorResponse(
+                                       -32600, "Invalid Request.", Null::g()));
+    }
+  }
+  else if (!wslay_is_ctrl_frame(arg->opcode)) {
     ssize_t error = 0;
     auto json = wsSession->parseFinal(nullptr, 0, error);
     if (error < 0) {
@@ -176,7 +215,7 @@ void onMsgRecvCallback(wslay_event_context_ptr wsctx,
     Dict* jsondict = downcast<Dict>(json);
     auto e = wsSession->getDownloadEngine();
     if (jsondict) {
-      RpcResponse res = processJsonRpcRequest(jsondict, e);
+      RpcResponse res = processJsonRpcRequest(jsondict, e, wsSession);
       addResponse(wsSession, res);
     }
     else {
@@ -189,7 +228,7 @@ void onMsgRecvCallback(wslay_event_context_ptr wsctx,
              i != eoi; ++i) {
           Dict* jsondict = downcast<Dict>(*i);
           if (jsondict) {
-            auto resp = processJsonRpcRequest(jsondict, e);
+            auto resp = processJsonRpcRequest(jsondict, e, wsSession);
             results.push_back(std::move(resp));
           }
         }
@@ -215,6 +254,8 @@ WebSocketSession::WebSocketSession(const std::shared_ptr<SocketCore>& socket,
     : socket_(socket),
       e_(e),
       ignorePayload_(false),
+      binary_(false),
+      binaryOverflow_(false),
       receivedLength_(0),
       command_(nullptr)
 {
@@ -260,40 +301,57 @@ int WebSocketSession::onWriteEvent()
 }
 
 namespace {
-class TextMessageCommand : public Command {
+class MessageCommand : public Command {
 private:
   std::shared_ptr<WebSocketSession> session_;
   const std::string msg_;
+  bool binary_;
 
 public:
-  TextMessageCommand(cuid_t cuid, std::shared_ptr<WebSocketSession> session,
-                     const std::string& msg)
-      : Command(cuid), session_{std::move(session)}, msg_{msg}
+  MessageCommand(cuid_t cuid, std::shared_ptr<WebSocketSession> session,
+                 const std::string& msg, bool binary)
+      : Command(cuid), session_{std::move(session)}, msg_{msg}, binary_{binary}
   {
   }
   virtual bool execute() CXX11_OVERRIDE
   {
-    session_->addTextMessage(msg_, false);
+    if (binary_) {
+      session_->addBinaryMessage(msg_, false);
+    }
+    else {
+      session_->addTextMessage(msg_, false);
+    }
     return true;
   }
 };
 } // namespace
 
 void WebSocketSession::addTextMessage(const std::string& msg, bool delayed)
+{
+  addMessage(WSLAY_TEXT_FRAME, msg, delayed);
+}
+
+void WebSocketSession::addBinaryMessage(const std::string& msg, bool delayed)
+{
+  addMessage(WSLAY_BINARY_FRAME, msg, delayed);
+}
+
+void WebSocketSession::addMessage(uint8_t opcode, const std::string& msg,
+                                  bool delayed)
 {
   if (delayed) {
     auto e = getDownloadEngine();
     auto cuid = command_->getCuid();
-    auto c = make_unique<TextMessageCommand>(cuid, command_->getSession(), msg);
+    auto c = make_unique<MessageCommand>(cuid, command_->getSession(), msg,
+                                         opcode == WSLAY_BINARY_FRAME);
     e->addCommand(
         make_unique<DelayedCommand>(cuid, e, 1_s, std::move(c), false));
     return;
   }
 
-  // TODO Don't add text message if the size of outbound queue in
-  // wsctx_ exceeds certain limit.
-  wslay_event_msg arg = {WSLAY_TEXT_FRAME,
-                         reinterpret_cast<const uint8_t*>(msg.c_str()),
+  // TODO Don't add message if the size of outbound queue in wsctx_
+  // exceeds certain limit.
+  wslay_event_msg arg = {opcode, reinterpret_cast<const uint8_t*>(msg.c_str()),
                          msg.size()};
   wslay_event_queue_msg(wsctx_, &arg);
 }
@@ -330,6 +388,30 @@ WebSocketSession::parseFinal(const uint8_t* data, size_t len, ssize_t& error)
   return res;
 }
 
+bool WebSocketSession::bufferBinary(const uint8_t* data, size_t len)
+{
+  size_t maxlen = e_->getOption()->getAsInt(PREF_RPC_MAX_REQUEST_SIZE);
+  if (binaryOverflow_ || binaryBuffer_.size() + len > maxlen) {
+    binaryOverflow_ = true;
+    return false;
+  }
+  binaryBuffer_.append(reinterpret_cast<const char*>(data), len);
+  return true;
+}
+
+std::unique_ptr<ValueBase> WebSocketSession::decodeBinary()
+{
+  std::string buf;
+  buf.swap(binaryBuffer_);
+  bool overflow = binaryOverflow_;
+  binaryOverflow_ = false;
+  if (overflow) {
+    throw DL_ABORT_EX("Request too long.");
+  }
+  return msgpack::decode(reinterpret_cast<const unsigned char*>(buf.data()),
+                         buf.size());
+}
+
 } // namespace rpc
 
 } // namespace aria2
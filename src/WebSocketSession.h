@@ -75,6 +75,8 @@ public:
   // Adds text message |msg|. The message is queued and will be sent
   // in onWriteEvent().
   void addTextMessage(const std::string& msg, bool delayed);
+  // Adds binary message |msg| in the same way as addTextMessage().
+  void addBinaryMessage(const std::string& msg, bool delayed);
   // Returns true if the close frame is received.
   bool closeReceived();
   // Returns true if the close frame is sent.
@@ -88,6 +90,13 @@ public:
   // this function resets parser state and receivedLength_.
   std::unique_ptr<ValueBase> parseFinal(const uint8_t* data, size_t len,
                                         ssize_t& error);
+  // Buffers partial MessagePack request body.  Returns false if the
+  // request exceeds --rpc-max-request-size.
+  bool bufferBinary(const uint8_t* data, size_t len);
+  // Decodes the buffered MessagePack request and returns the result.
+  // Throws DlAbortEx if the request is malformed or too large.
+  // Whether success or failure, this function clears the buffer.
+  std::unique_ptr<ValueBase> decodeBinary();
 
   const std::shared_ptr<SocketCore>& getSocket() const { return socket_; }
 
@@ -101,13 +110,23 @@ public:
 
   void setIgnorePayload(bool flag) { ignorePayload_ = flag; }
 
+  bool getBinary() const { return binary_; }
+
+  void setBinary(bool flag) { binary_ = flag; }
+
 private:
+  void addMessage(uint8_t opcode, const std::string& msg, bool delayed);
+
   std::shared_ptr<SocketCore> socket_;
   DownloadEngine* e_;
   wslay_event_context_ptr wsctx_;
   bool ignorePayload_;
+  // True if the current message consists of binary frames.
+  bool binary_;
+  bool binaryOverflow_;
   int32_t receivedLength_;
   json::ValueBaseJsonParser parser_;
+  std::string binaryBuffer_;
   WebSocketInteractionCommand* command_;
 };
 
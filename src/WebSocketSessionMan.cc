@@ -35,6 +35,7 @@
 #include "WebSocketSessionMan.h"
 
 #include <cassert>
+#include <algorithm>
 
 #include "WebSocketSession.h"
 #include "RequestGroup.h"
@@ -42,12 +43,17 @@
 #include "util.h"
 #include "WebSocketInteractionCommand.h"
 #include "LogFactory.h"
+#include "DownloadEngine.h"
+#include "RequestGroupMan.h"
+#include "RpcMethodImpl.h"
+#include "wallclock.h"
+#include "fmt.h"
 
 namespace aria2 {
 
 namespace rpc {
 
-WebSocketSessionMan::WebSocketSessionMan() {}
+WebSocketSessionMan::WebSocketSessionMan() : nextSubscriptionId_(1) {}
 
 WebSocketSessionMan::~WebSocketSessionMan() {}
 
@@ -63,6 +69,16 @@ void WebSocketSessionMan::removeSession(
 {
   A2_LOG_DEBUG("WebSocket session removed.");
   sessions_.erase(wsSession);
+  for (auto& sub : subscriptions_) {
+    sub->sessions.erase(wsSession);
+    sub->joinedSessions.erase(wsSession);
+  }
+  subscriptions_.erase(
+      std::remove_if(std::begin(subscriptions_), std::end(subscriptions_),
+                     [](const std::unique_ptr<Subscription>& sub) {
+                       return sub->sessions.empty();
+                     }),
+      std::end(subscriptions_));
 }
 
 void WebSocketSessionMan::addNotification(const std::string& method,
@@ -124,6 +140,248 @@ void WebSocketSessionMan::onEvent(DownloadEvent event,
   addNotification(getMethodName(event), group);
 }
 
+namespace {
+const std::string ON_STATS_CHANGED = "aria2.onStatsChanged";
+} // namespace
+
+namespace {
+void beginStatsMessage(json::JsonWriter& out, const std::string& id)
+{
+  out.beginObject();
+  out.put("jsonrpc", "2.0");
+  out.put("method", ON_STATS_CHANGED);
+  out.key("params");
+  out.beginArray();
+  out.beginObject();
+  out.put("subscription", id);
+}
+} // namespace
+
+namespace {
+void endStatsMessage(json::JsonWriter& out)
+{
+  out.endObject();
+  out.endArray();
+  out.endObject();
+}
+} // namespace
+
+namespace {
+void writeFields(json::JsonWriter& out,
+                 const std::map<std::string, std::string>& fields)
+{
+  for (auto& kv : fields) {
+    out.key(kv.first);
+    out.rawValue(kv.second);
+  }
+}
+} // namespace
+
+SubscriptionFieldWriter::SubscriptionFieldWriter(json::JsonWriter& out,
+                                                 FieldValues& values,
+                                                 const FieldValues* last,
+                                                 std::string gid)
+    : out_(out),
+      values_(values),
+      last_(last),
+      gid_(std::move(gid)),
+      written_(false)
+{
+}
+
+void SubscriptionFieldWriter::put(const std::string& key,
+                                  const std::string& value)
+{
+  buf_.clear();
+  json::JsonWriter(buf_).value(value);
+  putEncoded(key);
+}
+
+void SubscriptionFieldWriter::put(const std::string& key,
+                                  std::unique_ptr<ValueBase> vlb)
+{
+  buf_.clear();
+  json::JsonWriter(buf_).value(vlb.get());
+  putEncoded(key);
+}
+
+void SubscriptionFieldWriter::putEncoded(const std::string& key)
+{
+  // The GID identifies the entry and is written with the first change.
+  if (!gid_.empty() && key == "gid") {
+    return;
+  }
+  if (last_) {
+    auto i = last_->find(key);
+    if (i != std::end(*last_) && (*i).second == buf_) {
+      values_[key] = buf_;
+      return;
+    }
+  }
+  if (!written_ && !gid_.empty()) {
+    out_.beginObject();
+    out_.put("gid", gid_);
+  }
+  written_ = true;
+  out_.key(key);
+  out_.rawValue(buf_);
+  values_[key] = buf_;
+}
+
+bool SubscriptionFieldWriter::finish()
+{
+  if (written_ && !gid_.empty()) {
+    out_.endObject();
+  }
+  return written_;
+}
+
+void WebSocketSessionMan::sendMessage(const WebSocketSessions& sessions,
+                                      const std::string& msg)
+{
+  for (auto& session : sessions) {
+    session->addTextMessage(msg, false);
+    session->getCommand()->updateWriteCheck();
+  }
+}
+
+std::string
+WebSocketSessionMan::subscribe(const std::shared_ptr<WebSocketSession>& wsSession,
+                               std::vector<std::string> keys,
+                               std::chrono::seconds interval)
+{
+  std::sort(std::begin(keys), std::end(keys));
+  keys.erase(std::unique(std::begin(keys), std::end(keys)), std::end(keys));
+  for (auto& sub : subscriptions_) {
+    if (sub->interval != interval || sub->keys != keys) {
+      continue;
+    }
+    if (sub->sessions.insert(wsSession).second && !sub->lastPush.isZero()) {
+      // The other sessions only receive changes, so the new one needs
+      // the complete state they have seen so far.  It is sent on the
+      // next tick so that the response to aria2.subscribe comes first.
+      sub->joinedSessions.insert(wsSession);
+    }
+    return sub->id;
+  }
+  auto sub = make_unique<Subscription>();
+  sub->id = util::itos(nextSubscriptionId_++);
+  sub->keys = std::move(keys);
+  sub->interval = interval;
+  sub->lastPush = Timer::zero();
+  sub->sessions.insert(wsSession);
+  subscriptions_.push_back(std::move(sub));
+  A2_LOG_DEBUG(fmt("WebSocket subscription %s added.",
+                   subscriptions_.back()->id.c_str()));
+  return subscriptions_.back()->id;
+}
+
+bool WebSocketSessionMan::unsubscribe(
+    const std::shared_ptr<WebSocketSession>& wsSession, const std::string& id)
+{
+  auto i = std::find_if(std::begin(subscriptions_), std::end(subscriptions_),
+                        [&id](const std::unique_ptr<Subscription>& sub) {
+                          return sub->id == id;
+                        });
+  if (i == std::end(subscriptions_) || (*i)->sessions.erase(wsSession) == 0) {
+    return false;
+  }
+  (*i)->joinedSessions.erase(wsSession);
+  if ((*i)->sessions.empty()) {
+    A2_LOG_DEBUG(fmt("WebSocket subscription %s removed.", id.c_str()));
+    subscriptions_.erase(i);
+  }
+  return true;
+}
+
+void WebSocketSessionMan::pushSubscriptions(DownloadEngine* e)
+{
+  for (auto& sub : subscriptions_) {
+    if (!sub->joinedSessions.empty()) {
+      sendSnapshot(*sub);
+    }
+    if (sub->lastPush.difference(global::wallclock()) < sub->interval) {
+      continue;
+    }
+    sub->lastPush = global::wallclock();
+    pushSubscription(*sub, e);
+  }
+}
+
+void WebSocketSessionMan::sendSnapshot(Subscription& sub)
+{
+  std::string msg;
+  json::JsonWriter out(msg);
+  beginStatsMessage(out, sub.id);
+  out.key("global");
+  out.beginObject();
+  writeFields(out, sub.globalValues);
+  out.endObject();
+  out.key("changed");
+  out.beginArray();
+  for (auto& entry : sub.values) {
+    out.beginObject();
+    out.put("gid", GroupId::toHex(entry.first));
+    writeFields(out, entry.second);
+    out.endObject();
+  }
+  out.endArray();
+  endStatsMessage(out);
+  sendMessage(sub.joinedSessions, msg);
+  sub.joinedSessions.clear();
+}
+
+void WebSocketSessionMan::pushSubscription(Subscription& sub,
+                                           DownloadEngine* e)
+{
+  std::string msg;
+  json::JsonWriter out(msg);
+  bool changed = false;
+  beginStatsMessage(out, sub.id);
+
+  FieldValues globalValues;
+  out.key("global");
+  out.beginObject();
+  {
+    SubscriptionFieldWriter fields(out, globalValues, &sub.globalValues, "");
+    gatherGlobalStat(&fields, e);
+    changed |= fields.finish();
+  }
+  out.endObject();
+  sub.globalValues.swap(globalValues);
+
+  std::map<a2_gid_t, FieldValues> values;
+  out.key("changed");
+  out.beginArray();
+  for (auto& group : e->getRequestGroupMan()->getRequestGroups()) {
+    auto gid = group->getGID();
+    auto last = sub.values.find(gid);
+    const FieldValues* lastValues =
+        last == std::end(sub.values) ? nullptr : &(*last).second;
+    SubscriptionFieldWriter fields(out, values[gid], lastValues,
+                                   GroupId::toHex(gid));
+    gatherProgress(&fields, group, e, sub.keys);
+    changed |= fields.finish();
+  }
+  out.endArray();
+
+  out.key("removed");
+  out.beginArray();
+  for (auto& entry : sub.values) {
+    if (values.count(entry.first) == 0) {
+      out.value(GroupId::toHex(entry.first));
+      changed = true;
+    }
+  }
+  out.endArray();
+  endStatsMessage(out);
+
+  sub.values.swap(values);
+  if (changed) {
+    sendMessage(sub.sessions, msg);
+  }
+}
+
 } // namespace rpc
 
 } // namespace aria2
@@ -38,33 +38,113 @@
 #include "Notifier.h"
 
 #include <set>
+#include <map>
 #include <string>
+#include <vector>
 #include <memory>
+#include <chrono>
 
 #include "a2functional.h"
+#include "TimerA2.h"
+#include "GroupId.h"
 
 namespace aria2 {
 
 class RequestGroup;
+class DownloadEngine;
+class ValueBase;
+
+namespace json {
+class JsonWriter;
+} // namespace json
 
 namespace rpc {
 
 class WebSocketSession;
 
+// Receives the fields of a download from gatherProgress(), or the
+// global statistics from gatherGlobalStat(), and writes only those
+// whose encoded value differs from last to out.  All encoded values
+// are stored in values for the next comparison.  If gid is not empty,
+// the changed fields are written in an object starting with "gid",
+// which is only opened when the first change is found.
+class SubscriptionFieldWriter {
+public:
+  // Encoded field values keyed by field name.
+  typedef std::map<std::string, std::string> FieldValues;
+
+  SubscriptionFieldWriter(json::JsonWriter& out, FieldValues& values,
+                          const FieldValues* last, std::string gid);
+
+  void put(const std::string& key, const std::string& value);
+  void put(const std::string& key, std::unique_ptr<ValueBase> vlb);
+
+  // Closes the object opened for gid and returns true if any field
+  // was written.
+  bool finish();
+
+private:
+  void putEncoded(const std::string& key);
+
+  json::JsonWriter& out_;
+  FieldValues& values_;
+  const FieldValues* last_;
+  std::string gid_;
+  std::string buf_;
+  bool written_;
+};
+
 class WebSocketSessionMan : public DownloadEventListener {
 public:
   typedef std::set<std::shared_ptr<WebSocketSession>, RefLess<WebSocketSession>>
       WebSocketSessions;
   WebSocketSessionMan();
-  ~WebSocketSessionMan();
+  virtual ~WebSocketSessionMan();
   void addSession(const std::shared_ptr<WebSocketSession>& wsSession);
   void removeSession(const std::shared_ptr<WebSocketSession>& wsSession);
   void addNotification(const std::string& method, const RequestGroup* group);
   virtual void onEvent(DownloadEvent event,
                        const RequestGroup* group) CXX11_OVERRIDE;
+  // Subscribes wsSession to the progress of active downloads and to
+  // the global statistics.  keys selects the fields of each download
+  // as in aria2.tellStatus.  Sessions subscribing with the same keys
+  // and interval share one subscription, whose ID is returned.
+  std::string subscribe(const std::shared_ptr<WebSocketSession>& wsSession,
+                        std::vector<std::string> keys,
+                        std::chrono::seconds interval);
+  // Returns false if wsSession is not subscribed to id.
+  bool unsubscribe(const std::shared_ptr<WebSocketSession>& wsSession,
+                   const std::string& id);
+  // Sends the fields changed since the last push to each subscription
+  // whose interval has elapsed.  The message is encoded once per
+  // subscription and shared by all of its sessions.
+  void pushSubscriptions(DownloadEngine* e);
 
 private:
+  typedef SubscriptionFieldWriter::FieldValues FieldValues;
+
+  struct Subscription {
+    std::string id;
+    std::vector<std::string> keys;
+    std::chrono::seconds interval;
+    Timer lastPush;
+    WebSocketSessions sessions;
+    // Sessions which have not received the values below yet.
+    WebSocketSessions joinedSessions;
+    // Values sent by the last push, used to compute the changes.
+    std::map<a2_gid_t, FieldValues> values;
+    FieldValues globalValues;
+  };
+
+  void sendSnapshot(Subscription& sub);
+  void pushSubscription(Subscription& sub, DownloadEngine* e);
+  // Queues msg to sessions.  Overridden in tests.
+  virtual void sendMessage(const WebSocketSessions& sessions,
+                           const std::string& msg);
+
   WebSocketSessions sessions_;
+  std::vector<std::unique_ptr<Subscription>> subscriptions_;
+  int64_t nextSubscriptionId_;
 };
 
 } // namespace rpc
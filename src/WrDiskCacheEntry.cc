@@ -35,6 +35,7 @@
 #include "WrDiskCacheEntry.h"
 
 #include <cstring>
+#include <cassert>
 
 #include "DiskAdaptor.h"
 #include "RecoverableException.h"
@@ -105,21 +106,36 @@ bool WrDiskCacheEntry::cacheData(DataCell* dataCell)
 size_t WrDiskCacheEntry::append(int64_t goff, const unsigned char* data,
                                 size_t len)
 {
-  if (set_.empty()) {
+  auto buf = getAppendBuffer(goff);
+  size_t wlen = std::min(buf.second, len);
+  if (wlen == 0) {
     return 0;
   }
-  auto i = set_.end();
-  --i;
-  if (static_cast<int64_t>((*i)->goff + (*i)->len) == goff) {
-    size_t wlen = std::min((*i)->capacity - (*i)->len, len);
-    memcpy((*i)->data + (*i)->offset + (*i)->len, data, wlen);
-    (*i)->len += wlen;
-    size_ += wlen;
-    return wlen;
+  memcpy(buf.first, data, wlen);
+  commitAppend(wlen);
+  return wlen;
+}
+
+std::pair<unsigned char*, size_t>
+WrDiskCacheEntry::getAppendBuffer(int64_t goff) const
+{
+  if (set_.empty()) {
+    return {nullptr, 0};
   }
-  else {
-    return 0;
+  auto cell = *set_.rbegin();
+  if (static_cast<int64_t>(cell->goff + cell->len) != goff) {
+    return {nullptr, 0};
   }
+  return {cell->data + cell->offset + cell->len, cell->capacity - cell->len};
+}
+
+void WrDiskCacheEntry::commitAppend(size_t len)
+{
+  assert(!set_.empty());
+  auto cell = *set_.rbegin();
+  assert(cell->len + len <= cell->capacity);
+  cell->len += len;
+  size_ += len;
 }
 
 } // namespace aria2
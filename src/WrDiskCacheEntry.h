@@ -80,6 +80,16 @@ public:
   // contagious. Returns the number of copied bytes.
   size_t append(int64_t goff, const unsigned char* data, size_t len);
 
+  // Returns the unused memory of last dataCell in set_ and its length
+  // if the data at |goff| is contagious to it.  Otherwise returns
+  // (nullptr, 0).  The data written there must be committed by
+  // commitAppend().
+  std::pair<unsigned char*, size_t> getAppendBuffer(int64_t goff) const;
+
+  // Adds |len| bytes written to the memory returned by
+  // getAppendBuffer() to last dataCell.
+  void commitAppend(size_t len);
+
   size_t getSize() const { return size_; }
   void setSizeKey(size_t sizeKey) { sizeKey_ = sizeKey; }
   size_t getSizeKey() const { return sizeKey_; }
@@ -81,6 +81,10 @@
 #include <sys/uio.h>
 #endif // HAVE_SYS_UIO_H
 
+#ifdef HAVE_SYS_UN_H
+#include <sys/un.h>
+#endif // HAVE_SYS_UN_H
+
 #ifndef HAVE_GETADDRINFO
 #include "getaddrinfo.h"
 #define HAVE_GAI_STRERROR
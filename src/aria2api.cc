@@ -288,6 +288,54 @@ int addUri(Session* session, A2Gid* gid, const std::vector<std::string>& uris,
   return 0;
 }
 
+int addUris(Session* session, std::vector<A2Gid>* gids,
+            const std::vector<UriItem>& items, const KeyVals& options,
+            int position)
+{
+  auto& e = session->context->reqinfo->getDownloadEngine();
+  auto requestOption = std::make_shared<Option>(*e->getOption());
+  std::vector<std::shared_ptr<RequestGroup>> result;
+  result.reserve(items.size());
+  try {
+    apiGatherRequestOption(requestOption.get(), options,
+                           OptionParser::getInstance());
+    for (auto& item : items) {
+      auto option = requestOption;
+      if (!item.options.empty()) {
+        option = std::make_shared<Option>(*requestOption);
+        apiGatherRequestOption(option.get(), item.options,
+                               OptionParser::getInstance());
+      }
+      std::vector<std::shared_ptr<RequestGroup>> groups;
+      createRequestGroupForUri(groups, option, item.uris,
+                               /* ignoreForceSeq = */ true,
+                               /* ignoreLocalPath = */ true);
+      if (groups.empty()) {
+        return -1;
+      }
+      result.push_back(groups.front());
+    }
+  }
+  catch (RecoverableException& e) {
+    A2_LOG_INFO_EX(EX_EXCEPTION_CAUGHT, e);
+    return -1;
+  }
+  if (!result.empty()) {
+    if (position >= 0) {
+      e->getRequestGroupMan()->insertReservedGroup(position, result);
+    }
+    else {
+      e->getRequestGroupMan()->addReservedGroup(result);
+    }
+    if (gids) {
+      for (auto& group : result) {
+        gids->push_back(group->getGID());
+      }
+    }
+  }
+  return 0;
+}
+
 int addMetalink(Session* session, std::vector<A2Gid>* gids,
                 const std::string& metalinkFile, const KeyVals& options,
                 int position)
@@ -518,7 +566,7 @@ GlobalStat getGlobalStat(Session* session)
   res.uploadSpeed = ts.uploadSpeed;
   res.numActive = rgman->getRequestGroups().size();
   res.numWaiting = rgman->getReservedGroups().size();
-  res.numStopped = rgman->getDownloadResults().size();
+  res.numStopped = rgman->countDownloadResult();
   return res;
 }
 
@@ -134,24 +134,9 @@ createRequestGroup(const std::shared_ptr<Option>& optionTemplate,
 {
   auto option = util::copy(optionTemplate);
   auto rg = std::make_shared<RequestGroup>(getGID(option), option);
-  auto dctx = std::make_shared<DownloadContext>(
-      option->getAsInt(PREF_PIECE_LENGTH), 0,
-      useOutOption && !option->blank(PREF_OUT)
-          ? util::applyDir(option->get(PREF_DIR), option->get(PREF_OUT))
-          : A2STR::NIL);
-  dctx->getFirstFileEntry()->setUris(uris);
-  dctx->getFirstFileEntry()->setMaxConnectionPerServer(
-      option->getAsInt(PREF_MAX_CONNECTION_PER_SERVER));
-  const std::string& checksum = option->get(PREF_CHECKSUM);
-  if (!checksum.empty()) {
-    auto p = util::divide(std::begin(checksum), std::end(checksum), '=');
-    std::string hashType(p.first.first, p.first.second);
-    std::string hexDigest(p.second.first, p.second.second);
-    util::lowercase(hashType);
-    dctx->setDigest(hashType,
-                    util::fromHex(std::begin(hexDigest), std::end(hexDigest)));
-  }
-  rg->setDownloadContext(dctx);
+  // DownloadContext is created when the download starts.  Until then,
+  // this download only holds its URIs.
+  rg->setPendingUris(uris, useOutOption);
 
   if (option->getAsBool(PREF_ENABLE_RPC)) {
     rg->setPauseRequested(option->getAsBool(PREF_PAUSE));
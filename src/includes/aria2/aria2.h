@@ -294,6 +294,46 @@ bool isNull(A2Gid gid);
 int addUri(Session* session, A2Gid* gid, const std::vector<std::string>& uris,
            const KeyVals& options, int position = -1);
 
+/**
+ * @struct
+ *
+ * This object contains URIs of one download and the options only
+ * applied to it.
+ */
+struct UriItem {
+  /**
+   * URIs pointing to the same file. See :func:`addUri()`.
+   */
+  std::vector<std::string> uris;
+  /**
+   * Options applied to this download on top of the options shared by
+   * all items.
+   */
+  KeyVals options;
+};
+
+/**
+ * @function
+ *
+ * Adds new downloads in bulk. Each element of the |items| is added as
+ * one download in the same way as :func:`addUri()`, but the |options|
+ * shared by all items are validated only once and all downloads are
+ * inserted to the waiting queue at once, keeping the order in the
+ * |items|. The :member:`UriItem::options` of each item are applied on
+ * top of the |options|. If unknown options are included, they are
+ * simply ignored. If the |position| is not negative integer, the new
+ * downloads are inserted at position in the waiting queue. If the
+ * |position| is negative or the |position| is larger than the size of
+ * the queue, they are appended at the end of the queue. On successful
+ * return, if the |gids| is not ``NULL``, the GIDs of added downloads
+ * are appended to the |*gids| in the order of the |items|. If any
+ * item is invalid, no download is added. This function returns 0 if
+ * it succeeds, or negative error code.
+ */
+int addUris(Session* session, std::vector<A2Gid>* gids,
+            const std::vector<UriItem>& items, const KeyVals& options,
+            int position = -1);
+
 /**
  * @function
  *
@@ -99,6 +99,103 @@ std::string encode(const ValueBase* json)
   return encode(out, json).str();
 }
 
+JsonWriter::JsonWriter(std::string& out) : out_(out), needComma_(false) {}
+
+void JsonWriter::separate()
+{
+  if (needComma_) {
+    out_ += ',';
+  }
+}
+
+void JsonWriter::beginObject()
+{
+  separate();
+  out_ += '{';
+  needComma_ = false;
+}
+
+void JsonWriter::endObject()
+{
+  out_ += '}';
+  needComma_ = true;
+}
+
+void JsonWriter::beginArray()
+{
+  separate();
+  out_ += '[';
+  needComma_ = false;
+}
+
+void JsonWriter::endArray()
+{
+  out_ += ']';
+  needComma_ = true;
+}
+
+void JsonWriter::key(const std::string& k)
+{
+  separate();
+  out_ += '"';
+  out_ += jsonEscape(k);
+  out_ += "\":";
+  needComma_ = false;
+}
+
+void JsonWriter::value(const std::string& s)
+{
+  separate();
+  out_ += '"';
+  out_ += jsonEscape(s);
+  out_ += '"';
+  needComma_ = true;
+}
+
+void JsonWriter::value(const ValueBase* vlb)
+{
+  separate();
+  encode(*this, vlb);
+  needComma_ = true;
+}
+
+void JsonWriter::rawValue(const std::string& json)
+{
+  separate();
+  out_ += json;
+  needComma_ = true;
+}
+
+void JsonWriter::put(const std::string& k, const std::string& v)
+{
+  key(k);
+  value(v);
+}
+
+void JsonWriter::put(const std::string& k, std::unique_ptr<ValueBase> vlb)
+{
+  key(k);
+  value(vlb.get());
+}
+
+JsonWriter& JsonWriter::operator<<(const char* s)
+{
+  out_ += s;
+  return *this;
+}
+
+JsonWriter& JsonWriter::operator<<(const std::string& s)
+{
+  out_ += s;
+  return *this;
+}
+
+JsonWriter& JsonWriter::operator<<(int64_t n)
+{
+  out_ += util::itos(n);
+  return *this;
+}
+
 JsonGetParam::JsonGetParam(const std::string& request,
                            const std::string& callback)
     : request(request), callback(callback)
@@ -117,6 +117,43 @@ OutputStream& encode(OutputStream& out, const ValueBase* vlb)
 // Serializes JSON object or array.
 std::string encode(const ValueBase* json);
 
+// Writes JSON text incrementally into a string without building
+// ValueBase objects first.  The caller is responsible for the
+// structure being well formed: key() must precede each value in an
+// object.  put() offers the same interface as Dict::put(), so that
+// code filling a Dict can be instantiated for JsonWriter as well.
+class JsonWriter {
+public:
+  JsonWriter(std::string& out);
+
+  void beginObject();
+  void endObject();
+  void beginArray();
+  void endArray();
+
+  // Writes the member name k in the current object.
+  void key(const std::string& k);
+
+  void value(const std::string& s);
+  void value(const ValueBase* vlb);
+  // Writes json, which must be a JSON text, as a value.
+  void rawValue(const std::string& json);
+
+  void put(const std::string& key, const std::string& value);
+  void put(const std::string& key, std::unique_ptr<ValueBase> vlb);
+
+  // Used by encode() to write raw JSON text.
+  JsonWriter& operator<<(const char* s);
+  JsonWriter& operator<<(const std::string& s);
+  JsonWriter& operator<<(int64_t n);
+
+private:
+  void separate();
+
+  std::string& out_;
+  bool needComma_;
+};
+
 struct JsonGetParam {
   std::string request;
   std::string callback;
@@ -0,0 +1,418 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2015 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "msgpack.h"
+
+#include <cstring>
+#include <limits>
+
+#include "DlAbortEx.h"
+#include "fmt.h"
+
+namespace aria2 {
+
+namespace msgpack {
+
+namespace {
+// Same limit as JsonParser
+constexpr size_t MAX_DEPTH = 50;
+} // namespace
+
+namespace {
+void appendBigEndian(std::string& out, uint64_t n, size_t width)
+{
+  for (size_t i = width; i > 0; --i) {
+    out += static_cast<char>((n >> ((i - 1) * 8)) & 0xffu);
+  }
+}
+} // namespace
+
+Packer::Packer(std::string& out) : out_(out) {}
+
+void Packer::packNil() { out_ += '\xc0'; }
+
+void Packer::packBool(bool b) { out_ += b ? '\xc3' : '\xc2'; }
+
+void Packer::packInt(int64_t n)
+{
+  if (n >= 0) {
+    if (n <= 0x7f) {
+      out_ += static_cast<char>(n);
+    }
+    else if (n <= 0xff) {
+      out_ += '\xcc';
+      appendBigEndian(out_, n, 1);
+    }
+    else if (n <= 0xffff) {
+      out_ += '\xcd';
+      appendBigEndian(out_, n, 2);
+    }
+    else if (n <= 0xffffffffll) {
+      out_ += '\xce';
+      appendBigEndian(out_, n, 4);
+    }
+    else {
+      // uint 64 is only used for GIDs in the response.
+      out_ += '\xd3';
+      appendBigEndian(out_, n, 8);
+    }
+  }
+  else if (n >= -32) {
+    out_ += static_cast<char>(n);
+  }
+  else if (n >= std::numeric_limits<int8_t>::min()) {
+    out_ += '\xd0';
+    appendBigEndian(out_, static_cast<uint64_t>(n), 1);
+  }
+  else if (n >= std::numeric_limits<int16_t>::min()) {
+    out_ += '\xd1';
+    appendBigEndian(out_, static_cast<uint64_t>(n), 2);
+  }
+  else if (n >= std::numeric_limits<int32_t>::min()) {
+    out_ += '\xd2';
+    appendBigEndian(out_, static_cast<uint64_t>(n), 4);
+  }
+  else {
+    out_ += '\xd3';
+    appendBigEndian(out_, static_cast<uint64_t>(n), 8);
+  }
+}
+
+void Packer::packUint64(uint64_t n)
+{
+  out_ += '\xcf';
+  appendBigEndian(out_, n, 8);
+}
+
+void Packer::packStr(const std::string& s)
+{
+  auto n = s.size();
+  if (n <= 31) {
+    out_ += static_cast<char>(0xa0u | n);
+  }
+  else if (n <= 0xff) {
+    out_ += '\xd9';
+    appendBigEndian(out_, n, 1);
+  }
+  else if (n <= 0xffff) {
+    out_ += '\xda';
+    appendBigEndian(out_, n, 2);
+  }
+  else {
+    out_ += '\xdb';
+    appendBigEndian(out_, n, 4);
+  }
+  out_ += s;
+}
+
+void Packer::packBin(const std::string& s)
+{
+  auto n = s.size();
+  if (n <= 0xff) {
+    out_ += '\xc4';
+    appendBigEndian(out_, n, 1);
+  }
+  else if (n <= 0xffff) {
+    out_ += '\xc5';
+    appendBigEndian(out_, n, 2);
+  }
+  else {
+    out_ += '\xc6';
+    appendBigEndian(out_, n, 4);
+  }
+  out_ += s;
+}
+
+void Packer::packArrayHeader(size_t n)
+{
+  if (n <= 15) {
+    out_ += static_cast<char>(0x90u | n);
+  }
+  else if (n <= 0xffff) {
+    out_ += '\xdc';
+    appendBigEndian(out_, n, 2);
+  }
+  else {
+    out_ += '\xdd';
+    appendBigEndian(out_, n, 4);
+  }
+}
+
+void Packer::packMapHeader(size_t n)
+{
+  if (n <= 15) {
+    out_ += static_cast<char>(0x80u | n);
+  }
+  else if (n <= 0xffff) {
+    out_ += '\xde';
+    appendBigEndian(out_, n, 2);
+  }
+  else {
+    out_ += '\xdf';
+    appendBigEndian(out_, n, 4);
+  }
+}
+
+void Packer::pack(const ValueBase* vlb)
+{
+  class PackValueBaseVisitor : public ValueBaseVisitor {
+  public:
+    PackValueBaseVisitor(Packer& packer) : packer_(packer) {}
+
+    virtual void visit(const String& string) CXX11_OVERRIDE
+    {
+      packer_.packStr(string.s());
+    }
+
+    virtual void visit(const Integer& integer) CXX11_OVERRIDE
+    {
+      packer_.packInt(integer.i());
+    }
+
+    virtual void visit(const Bool& boolValue) CXX11_OVERRIDE
+    {
+      packer_.packBool(boolValue.val());
+    }
+
+    virtual void visit(const Null& nullValue) CXX11_OVERRIDE
+    {
+      packer_.packNil();
+    }
+
+    virtual void visit(const List& list) CXX11_OVERRIDE
+    {
+      packer_.packArrayHeader(list.size());
+      for (auto& e : list) {
+        e->accept(*this);
+      }
+    }
+
+    virtual void visit(const Dict& dict) CXX11_OVERRIDE
+    {
+      packer_.packMapHeader(dict.size());
+      for (auto& e : dict) {
+        packer_.packStr(e.first);
+        e.second->accept(*this);
+      }
+    }
+
+  private:
+    Packer& packer_;
+  };
+  PackValueBaseVisitor visitor(*this);
+  vlb->accept(visitor);
+}
+
+std::string encode(const ValueBase* vlb)
+{
+  std::string out;
+  Packer(out).pack(vlb);
+  return out;
+}
+
+namespace {
+class Unpacker {
+public:
+  Unpacker(const unsigned char* data, size_t len)
+      : p_(data), last_(data + len)
+  {
+  }
+
+  std::unique_ptr<ValueBase> unpack(size_t depth)
+  {
+    if (depth > MAX_DEPTH) {
+      throw DL_ABORT_EX("MessagePack: structure too deep");
+    }
+    auto c = readUint(1);
+    if (c <= 0x7f) {
+      return Integer::g(c);
+    }
+    if (c >= 0xe0) {
+      return Integer::g(static_cast<int8_t>(c));
+    }
+    if ((c & 0xf0) == 0x80) {
+      return unpackMap(c & 0x0f, depth);
+    }
+    if ((c & 0xf0) == 0x90) {
+      return unpackArray(c & 0x0f, depth);
+    }
+    if ((c & 0xe0) == 0xa0) {
+      return String::g(readBytes(c & 0x1f));
+    }
+    switch (c) {
+    case 0xc0:
+      return Null::g();
+    case 0xc2:
+      return Bool::gFalse();
+    case 0xc3:
+      return Bool::gTrue();
+    case 0xc4:
+    case 0xd9:
+      return String::g(readBytes(readUint(1)));
+    case 0xc5:
+    case 0xda:
+      return String::g(readBytes(readUint(2)));
+    case 0xc6:
+    case 0xdb:
+      return String::g(readBytes(readUint(4)));
+    case 0xca: {
+      uint32_t bits = readUint(4);
+      float f;
+      memcpy(&f, &bits, sizeof(f));
+      return Integer::g(toInteger(f));
+    }
+    case 0xcb: {
+      uint64_t bits = readUint(8);
+      double d;
+      memcpy(&d, &bits, sizeof(d));
+      return Integer::g(toInteger(d));
+    }
+    case 0xcc:
+      return Integer::g(readUint(1));
+    case 0xcd:
+      return Integer::g(readUint(2));
+    case 0xce:
+      return Integer::g(readUint(4));
+    case 0xcf: {
+      auto n = readUint(8);
+      if (n > static_cast<uint64_t>(std::numeric_limits<int64_t>::max())) {
+        // Only GIDs take this range in RPC.
+        return Gid::g(n);
+      }
+      return Integer::g(static_cast<int64_t>(n));
+    }
+    case 0xd0:
+      return Integer::g(static_cast<int8_t>(readUint(1)));
+    case 0xd1:
+      return Integer::g(static_cast<int16_t>(readUint(2)));
+    case 0xd2:
+      return Integer::g(static_cast<int32_t>(readUint(4)));
+    case 0xd3:
+      return Integer::g(static_cast<int64_t>(readUint(8)));
+    case 0xdc:
+      return unpackArray(readUint(2), depth);
+    case 0xdd:
+      return unpackArray(readUint(4), depth);
+    case 0xde:
+      return unpackMap(readUint(2), depth);
+    case 0xdf:
+      return unpackMap(readUint(4), depth);
+    default:
+      throw DL_ABORT_EX(fmt("MessagePack: unsupported format 0x%02x",
+                            static_cast<unsigned int>(c)));
+    }
+  }
+
+  bool eof() const { return p_ == last_; }
+
+private:
+  uint64_t readUint(size_t width)
+  {
+    if (static_cast<size_t>(last_ - p_) < width) {
+      throw DL_ABORT_EX("MessagePack: unexpected end of data");
+    }
+    uint64_t n = 0;
+    for (size_t i = 0; i < width; ++i) {
+      n = (n << 8) | *p_++;
+    }
+    return n;
+  }
+
+  std::string readBytes(uint64_t len)
+  {
+    if (static_cast<uint64_t>(last_ - p_) < len) {
+      throw DL_ABORT_EX("MessagePack: unexpected end of data");
+    }
+    std::string s(reinterpret_cast<const char*>(p_), len);
+    p_ += len;
+    return s;
+  }
+
+  template <typename T> int64_t toInteger(T f)
+  {
+    if (!(f > std::numeric_limits<int64_t>::min() &&
+          f < std::numeric_limits<int64_t>::max())) {
+      throw DL_ABORT_EX("MessagePack: float out of range");
+    }
+    return static_cast<int64_t>(f);
+  }
+
+  std::unique_ptr<ValueBase> unpackArray(uint64_t n, size_t depth)
+  {
+    auto list = List::g();
+    // Each element takes at least 1 byte; do not trust n further.
+    if (n > static_cast<uint64_t>(last_ - p_)) {
+      throw DL_ABORT_EX("MessagePack: unexpected end of data");
+    }
+    for (; n > 0; --n) {
+      list->append(unpack(depth + 1));
+    }
+    return std::move(list);
+  }
+
+  std::unique_ptr<ValueBase> unpackMap(uint64_t n, size_t depth)
+  {
+    auto dict = Dict::g();
+    if (n > static_cast<uint64_t>(last_ - p_) / 2) {
+      throw DL_ABORT_EX("MessagePack: unexpected end of data");
+    }
+    for (; n > 0; --n) {
+      auto key = unpack(depth + 1);
+      auto s = downcast<String>(key);
+      if (!s) {
+        throw DL_ABORT_EX("MessagePack: map key must be a string");
+      }
+      dict->put(s->s(), unpack(depth + 1));
+    }
+    return std::move(dict);
+  }
+
+  const unsigned char* p_;
+  const unsigned char* last_;
+};
+} // namespace
+
+std::unique_ptr<ValueBase> decode(const unsigned char* data, size_t len)
+{
+  Unpacker unpacker(data, len);
+  auto vlb = unpacker.unpack(0);
+  if (!unpacker.eof()) {
+    throw DL_ABORT_EX("MessagePack: trailing data");
+  }
+  return vlb;
+}
+
+} // namespace msgpack
+
+} // namespace aria2
@@ -0,0 +1,88 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2015 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_MSGPACK_H
+#define D_MSGPACK_H
+
+#include "common.h"
+
+#include <string>
+#include <memory>
+
+#include "ValueBase.h"
+
+namespace aria2 {
+
+namespace msgpack {
+
+// Appends MessagePack encoded values to a string.  Each function
+// uses the shortest format which holds its argument.
+class Packer {
+public:
+  Packer(std::string& out);
+
+  void packNil();
+  void packBool(bool b);
+  void packInt(int64_t n);
+  // Always uses the uint 64 format.
+  void packUint64(uint64_t n);
+  void packStr(const std::string& s);
+  void packBin(const std::string& s);
+  void packArrayHeader(size_t n);
+  void packMapHeader(size_t n);
+  // String is packed as str, List as array and Dict as map.
+  void pack(const ValueBase* vlb);
+
+private:
+  void packHeader(uint8_t fix, uint8_t fixMax, uint8_t base, size_t n);
+
+  std::string& out_;
+};
+
+// Serializes vlb in MessagePack.
+std::string encode(const ValueBase* vlb);
+
+// Deserializes the MessagePack value in [data, data+len).  Both str
+// and bin are decoded as String, and float as Integer truncated
+// toward zero.  Values in the uint 64 format are decoded as Integer,
+// or as Gid if they do not fit in int64_t.  Throws DlAbortEx if data
+// is malformed, has trailing bytes or nests deeper than JSON parser
+// allows.
+std::unique_ptr<ValueBase> decode(const unsigned char* data, size_t len);
+
+} // namespace msgpack
+
+} // namespace aria2
+
+#endif // D_MSGPACK_H
@@ -133,6 +133,7 @@ const std::string V_ERROR("error");
 const std::string V_INORDER("inorder");
 const std::string V_FEEDBACK("feedback");
 const std::string V_ADAPTIVE("adaptive");
+const std::string V_BANDIT("bandit");
 const std::string V_LIBUV("libuv");
 const std::string V_EPOLL("epoll");
 const std::string V_KQUEUE("kqueue");
@@ -169,6 +170,8 @@ PrefPtr PREF_CONNECT_TIMEOUT = makePref("connect-timeout");
 PrefPtr PREF_MAX_TRIES = makePref("max-tries");
 // values: 1*digit
 PrefPtr PREF_AUTO_SAVE_INTERVAL = makePref("auto-save-interval");
+// values: true | false
+PrefPtr PREF_JOURNAL_CONTROL_FILE = makePref("journal-control-file");
 // values: a string that your file system recognizes as a file name.
 PrefPtr PREF_LOG = makePref("log");
 // values: a string that your file system recognizes as a directory.
@@ -191,6 +194,10 @@ PrefPtr PREF_MAX_OVERALL_DOWNLOAD_LIMIT =
 // value: 1*digit
 PrefPtr PREF_MAX_DOWNLOAD_LIMIT = makePref("max-download-limit");
 // value: 1*digit
+PrefPtr PREF_BANDWIDTH_WEIGHT = makePref("bandwidth-weight");
+// value: 1*digit
+PrefPtr PREF_SPEED_LIMIT_BURST = makePref("speed-limit-burst");
+// value: 1*digit
 PrefPtr PREF_STARTUP_IDLE_TIME = makePref("startup-idle-time");
 // value: prealloc | fallc | none
 PrefPtr PREF_FILE_ALLOCATION = makePref("file-allocation");
@@ -258,6 +265,8 @@ PrefPtr PREF_EVENT_POLL = makePref("event-poll");
 PrefPtr PREF_ENABLE_RPC = makePref("enable-rpc");
 // value: 1*digit
 PrefPtr PREF_RPC_LISTEN_PORT = makePref("rpc-listen-port");
+// value: string that your file system recognizes as a file name.
+PrefPtr PREF_RPC_LISTEN_UNIX = makePref("rpc-listen-unix");
 // value: string
 PrefPtr PREF_RPC_USER = makePref("rpc-user");
 // value: string
@@ -304,6 +313,8 @@ PrefPtr PREF_MAX_RESUME_FAILURE_TRIES = makePref("max-resume-failure-tries");
 PrefPtr PREF_SAVE_SESSION = makePref("save-session");
 // value: 1*digit
 PrefPtr PREF_MAX_CONNECTION_PER_SERVER = makePref("max-connection-per-server");
+// value: true | false
+PrefPtr PREF_ADAPTIVE_CONNECTION = makePref("adaptive-connection");
 // value: 1*digit
 PrefPtr PREF_MIN_SPLIT_SIZE = makePref("min-split-size");
 // value: true | false
@@ -328,6 +339,8 @@ PrefPtr PREF_TRUNCATE_CONSOLE_READOUT = makePref("truncate-console-readout");
 PrefPtr PREF_PAUSE = makePref("pause");
 // value: default | full
 PrefPtr PREF_DOWNLOAD_RESULT = makePref("download-result");
+// value: string
+PrefPtr PREF_DOWNLOAD_RESULT_ARCHIVE = makePref("download-result-archive");
 // value: true | false
 PrefPtr PREF_HASH_CHECK_ONLY = makePref("hash-check-only");
 // values: hashType=digest
@@ -359,6 +372,14 @@ PrefPtr PREF_MIN_TLS_VERSION = makePref("min-tls-version");
 PrefPtr PREF_SOCKET_RECV_BUFFER_SIZE = makePref("socket-recv-buffer-size");
 // value: 1*digit
 PrefPtr PREF_MAX_MMAP_LIMIT = makePref("max-mmap-limit");
+// values: 1*digit
+PrefPtr PREF_DNS_CACHE_TTL = makePref("dns-cache-ttl");
+// values: 1*digit
+PrefPtr PREF_DNS_NEGATIVE_CACHE_TTL = makePref("dns-negative-cache-ttl");
+// value: string that your file system recognizes as a file name.
+PrefPtr PREF_DNS_CACHE_FILE = makePref("dns-cache-file");
+// values: true | false
+PrefPtr PREF_ENABLE_KTLS = makePref("enable-ktls");
 
 /**
  * FTP related preferences
@@ -389,8 +410,12 @@ PrefPtr PREF_SAVE_COOKIES = makePref("save-cookies");
 PrefPtr PREF_ENABLE_HTTP_KEEP_ALIVE = makePref("enable-http-keep-alive");
 // values: true | false
 PrefPtr PREF_ENABLE_HTTP_PIPELINING = makePref("enable-http-pipelining");
+// values: true | false
+PrefPtr PREF_ENABLE_HTTP2 = makePref("enable-http2");
 // value: 1*digit
 PrefPtr PREF_MAX_HTTP_PIPELINING = makePref("max-http-pipelining");
+// value: 1*digit
+PrefPtr PREF_MAX_HTTP_RANGES = makePref("max-http-ranges");
 // value: string
 PrefPtr PREF_HEADER = makePref("header");
 // value: string that your file system recognizes as a file name.
@@ -90,6 +90,7 @@ extern const std::string V_ERROR;
 extern const std::string V_INORDER;
 extern const std::string V_FEEDBACK;
 extern const std::string V_ADAPTIVE;
+extern const std::string V_BANDIT;
 extern const std::string V_LIBUV;
 extern const std::string V_EPOLL;
 extern const std::string V_KQUEUE;
@@ -126,6 +127,8 @@ extern PrefPtr PREF_CONNECT_TIMEOUT;
 extern PrefPtr PREF_MAX_TRIES;
 // values: 1*digit
 extern PrefPtr PREF_AUTO_SAVE_INTERVAL;
+// values: true | false
+extern PrefPtr PREF_JOURNAL_CONTROL_FILE;
 // values: a string that your file system recognizes as a file name.
 extern PrefPtr PREF_LOG;
 // values: a string that your file system recognizes as a directory.
@@ -145,6 +148,10 @@ extern PrefPtr PREF_PIECE_LENGTH;
 // value: 1*digit
 extern PrefPtr PREF_MAX_DOWNLOAD_LIMIT;
 // value: 1*digit
+extern PrefPtr PREF_BANDWIDTH_WEIGHT;
+// value: 1*digit
+extern PrefPtr PREF_SPEED_LIMIT_BURST;
+// value: 1*digit
 extern PrefPtr PREF_STARTUP_IDLE_TIME;
 // value: prealloc | falloc | none
 extern PrefPtr PREF_FILE_ALLOCATION;
@@ -214,6 +221,8 @@ extern PrefPtr PREF_EVENT_POLL;
 extern PrefPtr PREF_ENABLE_RPC;
 // value: 1*digit
 extern PrefPtr PREF_RPC_LISTEN_PORT;
+// value: string that your file system recognizes as a file name.
+extern PrefPtr PREF_RPC_LISTEN_UNIX;
 // value: string
 extern PrefPtr PREF_RPC_USER;
 // value: string
@@ -260,6 +269,8 @@ extern PrefPtr PREF_MAX_RESUME_FAILURE_TRIES;
 extern PrefPtr PREF_SAVE_SESSION;
 // value: 1*digit
 extern PrefPtr PREF_MAX_CONNECTION_PER_SERVER;
+// value: true | false
+extern PrefPtr PREF_ADAPTIVE_CONNECTION;
 // value: 1*digit
 extern PrefPtr PREF_MIN_SPLIT_SIZE;
 // value: true | false
@@ -284,6 +295,8 @@ extern PrefPtr PREF_TRUNCATE_CONSOLE_READOUT;
 extern PrefPtr PREF_PAUSE;
 // value: default | full
 extern PrefPtr PREF_DOWNLOAD_RESULT;
+// value: string
+extern PrefPtr PREF_DOWNLOAD_RESULT_ARCHIVE;
 // value: true | false
 extern PrefPtr PREF_HASH_CHECK_ONLY;
 // values: hashType=digest
@@ -316,6 +329,14 @@ extern PrefPtr PREF_MIN_TLS_VERSION;
 extern PrefPtr PREF_SOCKET_RECV_BUFFER_SIZE;
 // value: 1*digit
 extern PrefPtr PREF_MAX_MMAP_LIMIT;
+// values: 1*digit
+extern PrefPtr PREF_DNS_CACHE_TTL;
+// values: 1*digit
+extern PrefPtr PREF_DNS_NEGATIVE_CACHE_TTL;
+// value: string that your file system recognizes as a file name.
+extern PrefPtr PREF_DNS_CACHE_FILE;
+// values: true | false
+extern PrefPtr PREF_ENABLE_KTLS;
 
 /**
  * FTP related preferences
@@ -346,8 +367,12 @@ extern PrefPtr PREF_SAVE_COOKIES;
 extern PrefPtr PREF_ENABLE_HTTP_KEEP_ALIVE;
 // values: true | false
 extern PrefPtr PREF_ENABLE_HTTP_PIPELINING;
+// values: true | false
+extern PrefPtr PREF_ENABLE_HTTP2;
 // value: 1*digit
 extern PrefPtr PREF_MAX_HTTP_PIPELINING;
+// value: 1*digit
+extern PrefPtr PREF_MAX_HTTP_RANGES;
 // value: string
 extern PrefPtr PREF_HEADER;
 // value: string that your file system recognizes as a file name.
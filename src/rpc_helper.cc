@@ -77,7 +77,9 @@ RpcResponse createJsonRpcErrorResponse(int code, const std::string& msg,
                           std::move(id)};
 }
 
-RpcResponse processJsonRpcRequest(Dict* jsondict, DownloadEngine* e)
+namespace {
+RpcResponse processRpcRequest(Dict* jsondict, DownloadEngine* e,
+                              WebSocketSession* wsSession, bool jsonStream)
 {
   auto id = jsondict->popValue("id");
   if (!id) {
@@ -102,8 +104,23 @@ RpcResponse processJsonRpcRequest(Dict* jsondict, DownloadEngine* e)
   }
   A2_LOG_INFO(fmt("Executing RPC method %s", methodName->s().c_str()));
   RpcRequest req = {methodName->s(), std::move(params), std::move(id), true};
+  req.jsonStream = jsonStream;
+  req.wsSession = wsSession;
   return getMethod(methodName->s())->execute(std::move(req), e);
 }
+} // namespace
+
+RpcResponse processJsonRpcRequest(Dict* jsondict, DownloadEngine* e,
+                                  WebSocketSession* wsSession)
+{
+  return processRpcRequest(jsondict, e, wsSession, true);
+}
+
+RpcResponse processMsgpackRpcRequest(Dict* dict, DownloadEngine* e,
+                                     WebSocketSession* wsSession)
+{
+  return processRpcRequest(dict, e, wsSession, false);
+}
 
 } // namespace rpc
 
@@ -62,8 +62,17 @@ RpcRequest xmlParseMemory(const char* xml, size_t size);
 RpcResponse createJsonRpcErrorResponse(int code, const std::string& msg,
                                        std::unique_ptr<ValueBase> id);
 
-// Processes JSON-RPC request |jsondict| and returns the result.
-RpcResponse processJsonRpcRequest(Dict* jsondict, DownloadEngine* e);
+// Processes JSON-RPC request |jsondict| and returns the result.  If
+// the request was received over WebSocket, |wsSession| is the
+// session.
+RpcResponse processJsonRpcRequest(Dict* jsondict, DownloadEngine* e,
+                                  WebSocketSession* wsSession = nullptr);
+
+// Processes MessagePack-RPC request |dict|, which has the same
+// structure as JSON-RPC one, and returns the result.  The result is
+// always held in param, so that it can be encoded by toMsgpack().
+RpcResponse processMsgpackRpcRequest(Dict* dict, DownloadEngine* e,
+                                     WebSocketSession* wsSession = nullptr);
 
 } // namespace rpc
 
@@ -203,7 +203,9 @@
     "                              length. If hash check fails, file is\n" \
     "                              re-downloaded from scratch. If both piece hashes\n" \
     "                              and a hash of entire file are provided, only\n" \
-    "                              piece hashes are used.")
+    "                              piece hashes are used. Completed files whose\n" \
+    "                              size, mtime and inode are unchanged since the\n" \
+    "                              control file was saved are not hashed again.")
 #define TEXT_BT_HASH_CHECK_SEED                                         \
   _(" --bt-hash-check-seed[=true|false] If true is given, after hash check using\n" \
     "                              --check-integrity option and file is complete,\n" \
@@ -476,6 +478,13 @@
     "                              already been tested, returns mirrors which has to\n" \
     "                              be tested again. Otherwise, it doesn't select\n" \
     "                              anymore mirrors. Like 'feedback', it uses a\n" \
+    "                              performance profile of servers.\n"   \
+    "                              If 'bandit' is given, aria2 keeps moving average\n" \
+    "                              of download speed, connect time, time to first\n" \
+    "                              byte and failure rate for each server, and\n" \
+    "                              selects the server with the best expected\n" \
+    "                              throughput while occasionally trying less\n" \
+    "                              evaluated servers. The model is a part of\n" \
     "                              performance profile of servers.")
 #define TEXT_SERVER_STAT_OF                                             \
   _(" --server-stat-of=FILE        Specify the filename to which performance profile\n" \
@@ -495,6 +504,22 @@
     "                              If 0 is given, a control file is not saved during\n" \
     "                              download. aria2 saves a control file when it stops\n" \
     "                              regardless of the value.")
+#define TEXT_JOURNAL_CONTROL_FILE                                       \
+  _(" --journal-control-file[=true|false] Append the progress to a control\n" \
+    "                              file(*.aria2) instead of rewriting the whole\n" \
+    "                              file on each save. The file is compacted when\n" \
+    "                              the appended records outgrow it. Control files\n" \
+    "                              written with this option cannot be read by\n" \
+    "                              older versions of aria2.")
+#define TEXT_BANDWIDTH_WEIGHT                                           \
+  _(" --bandwidth-weight=NUM       Set the weight of this download when it shares\n" \
+    "                              bandwidth limited by\n"              \
+    "                              --max-overall-download-limit or\n"   \
+    "                              --max-overall-upload-limit with other downloads.\n" \
+    "                              A download with weight 2 gets twice as much\n" \
+    "                              bandwidth as a download with weight 1. The\n" \
+    "                              bandwidth unused by a download is shared by the\n" \
+    "                              others.")
 #define TEXT_CERTIFICATE                                                \
   _(" --certificate=FILE           Use the client certificate in FILE.\n" \
     "                              The certificate must be in PEM format.\n" \
@@ -628,6 +653,13 @@
     "                              given, these headers are not sent and you can add\n" \
     "                              Cache-Control header with a directive you like\n" \
     "                              using --header option.")
+#define TEXT_MAX_HTTP_RANGES                    \
+  _(" --max-http-ranges=<NUM>      Request up to NUM missing pieces of a file in one\n" \
+    "                              HTTP request using multiple byte ranges. The\n" \
+    "                              server returns them in a multipart/byteranges\n" \
+    "                              response. If the server does not support it,\n" \
+    "                              aria2 falls back to one range per request.\n" \
+    "                              1 disables this feature.")
 #define TEXT_BT_METADATA_ONLY                   \
   _(" --bt-metadata-only[=true|false] Download metadata only. The file(s) described\n" \
     "                              in metadata will not be downloaded. This option\n" \
@@ -711,6 +743,18 @@
 #define TEXT_MAX_CONNECTION_PER_SERVER          \
   _(" -x, --max-connection-per-server=NUM The maximum number of connections to one\n" \
     "                              server for each download.")
+#define TEXT_ADAPTIVE_CONNECTION                \
+  _(" --adaptive-connection[=true|false] Adjust the number of connections to each\n" \
+    "                              server while downloading. aria2 adds a\n" \
+    "                              connection while the aggregate download speed\n" \
+    "                              from the server keeps rising, and halves the\n" \
+    "                              number of connections when the server responds\n" \
+    "                              with 429 or 503, or the speed of each connection\n" \
+    "                              drops sharply. The number of connections is\n" \
+    "                              bounded by --max-connection-per-server and\n" \
+    "                              --split. The number is remembered for each\n" \
+    "                              server as a part of performance profile of\n" \
+    "                              servers.")
 #define TEXT_MIN_SPLIT_SIZE                     \
   _(" -k, --min-split-size=SIZE    aria2 does not split less than 2*SIZE byte range.\n" \
     "                              For example, let's consider downloading 20MiB\n" \
@@ -810,6 +854,11 @@
 #define TEXT_RPC_LISTEN_PORT                                        \
   _(" --rpc-listen-port=PORT       Specify a port number for JSON-RPC/XML-RPC server\n" \
     "                              to listen to.")
+#define TEXT_RPC_LISTEN_UNIX                                        \
+  _(" --rpc-listen-unix=PATH       Listen incoming JSON-RPC/XML-RPC requests on the\n" \
+    "                              Unix domain socket created at PATH instead of\n" \
+    "                              TCP ports. The socket is only accessible by the\n" \
+    "                              user running aria2.")
 #define TEXT_SHOW_CONSOLE_READOUT                                       \
   _(" --show-console-readout[=true|false] Show console readout.")
 #define TEXT_METALINK_BASE_URI                  \
@@ -865,6 +914,13 @@
     "                              path/URI. The percentage of progress and\n" \
     "                              path/URI are printed for each requested file in\n" \
     "                              each row.")
+#define TEXT_DOWNLOAD_RESULT_ARCHIVE            \
+  _(" --download-result-archive=FILE Keep download results removed by\n" \
+    "                              --max-download-result option in a compact\n" \
+    "                              archive instead of discarding them. Older\n" \
+    "                              archived results are written to FILE. FILE is\n" \
+    "                              truncated when it is first written in a session.\n" \
+    "                              The archived results are available via RPC.")
 #define TEXT_HASH_CHECK_ONLY                    \
   _(" --hash-check-only[=true|false] If true is given, after hash check using\n" \
     "                              --check-integrity option, abort download whether\n" \
@@ -1050,6 +1106,12 @@
     "                              Specifing 0 will disable this option. This value\n" \
     "                              will be set to socket file descriptor using\n" \
     "                              SO_RCVBUF socket option with setsockopt() call.")
+#define TEXT_SPEED_LIMIT_BURST                                          \
+  _(" --speed-limit-burst=SIZE     Set the number of bytes which can be transferred\n" \
+    "                              at once without waiting when a speed limit is\n" \
+    "                              set. 0 means the amount of 1 second at the\n" \
+    "                              limit.\n"                            \
+    "                              You can append K or M(1K = 1024, 1M = 1024K).")
 #define TEXT_BT_ENABLE_HOOK_AFTER_HASH_CHECK                            \
   _(" --bt-enable-hook-after-hash-check[=true|false] Allow hook command invocation\n" \
     "                              after hash check (see -V option) in BitTorrent\n" \
@@ -1066,5 +1128,32 @@
     "                              size of those files. If file size is strictly\n" \
     "                              greater than the size specified in this option,\n" \
     "                              mmap will be disabled.")
+#define TEXT_DNS_CACHE_TTL                                              \
+  _(" --dns-cache-ttl=SEC          Set the time in seconds to keep resolved\n" \
+    "                              addresses in DNS cache when name resolver does\n" \
+    "                              not tell their TTL. If asynchronous DNS is\n" \
+    "                              enabled, TTL returned by DNS server is used.\n" \
+    "                              Cached addresses are refreshed in background\n" \
+    "                              shortly before they expire.")
+#define TEXT_DNS_NEGATIVE_CACHE_TTL                                     \
+  _(" --dns-negative-cache-ttl=SEC Set the time in seconds to remember failed name\n" \
+    "                              resolution. During this period, name resolution\n" \
+    "                              for the same host fails immediately. Specify 0\n" \
+    "                              to disable negative caching.")
+#define TEXT_DNS_CACHE_FILE                                             \
+  _(" --dns-cache-file=FILE        Load DNS cache from FILE at startup and save it\n" \
+    "                              to FILE when aria2 exits. Entries already\n" \
+    "                              expired are not loaded.")
+#define TEXT_ENABLE_KTLS                                                \
+  _(" --enable-ktls[=true|false]   Offload TLS record encryption and decryption\n" \
+    "                              to the kernel (Linux kTLS) when the TLS library,\n" \
+    "                              kernel and negotiated cipher support it. If not\n" \
+    "                              supported, TLS is processed in user space as\n" \
+    "                              usual.")
+#define TEXT_ENABLE_HTTP2                                               \
+  _(" --enable-http2[=true|false]  Use HTTP/2 for segmented HTTPS downloads if the\n" \
+    "                              server supports it. Segments of the same\n" \
+    "                              server are downloaded as concurrent streams of\n" \
+    "                              one connection.")
 
 // clang-format on
@@ -0,0 +1,123 @@
+#include "AdaptiveConnectionControl.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "ServerStatMan.h"
+#include "ServerStat.h"
+
+namespace aria2 {
+
+class AdaptiveConnectionControlTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(AdaptiveConnectionControlTest);
+  CPPUNIT_TEST(testGetLevel);
+  CPPUNIT_TEST(testUpdate_increase);
+  CPPUNIT_TEST(testUpdate_takeBack);
+  CPPUNIT_TEST(testUpdate_notSaturated);
+  CPPUNIT_TEST(testUpdate_perConnectionDrop);
+  CPPUNIT_TEST(testOnOverload);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  std::shared_ptr<ServerStatMan> ssm;
+
+public:
+  void setUp() { ssm = std::make_shared<ServerStatMan>(); }
+
+  void testGetLevel();
+  void testUpdate_increase();
+  void testUpdate_takeBack();
+  void testUpdate_notSaturated();
+  void testUpdate_perConnectionDrop();
+  void testOnOverload();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(AdaptiveConnectionControlTest);
+
+void AdaptiveConnectionControlTest::testGetLevel()
+{
+  auto mirror = std::make_shared<ServerStat>("mirror", "http");
+  mirror->setConnectionLevel(5);
+  ssm->add(mirror);
+  auto slow = std::make_shared<ServerStat>("slow", "http");
+  slow->setConnectionLevel(1);
+  ssm->add(slow);
+
+  AdaptiveConnectionControl control(4, ssm);
+  CPPUNIT_ASSERT_EQUAL(2, control.getLevel("localhost", "http"));
+  CPPUNIT_ASSERT(ssm->find("localhost", "http"));
+  CPPUNIT_ASSERT_EQUAL(4, control.getLevel("mirror", "http"));
+  CPPUNIT_ASSERT_EQUAL(1, control.getLevel("slow", "http"));
+
+  AdaptiveConnectionControl single(1, ssm);
+  CPPUNIT_ASSERT_EQUAL(1, single.getLevel("localhost", "http"));
+}
+
+void AdaptiveConnectionControlTest::testUpdate_increase()
+{
+  AdaptiveConnectionControl control(4, ssm);
+  CPPUNIT_ASSERT(control.update("localhost", "http", 100, 2, Timer(10_s)));
+  CPPUNIT_ASSERT_EQUAL(3, control.getLevel("localhost", "http"));
+  // Not settled yet
+  CPPUNIT_ASSERT(!control.update("localhost", "http", 200, 3, Timer(11_s)));
+  CPPUNIT_ASSERT(control.update("localhost", "http", 150, 3, Timer(14_s)));
+  CPPUNIT_ASSERT_EQUAL(4, control.getLevel("localhost", "http"));
+  // Reached the maximum level.
+  CPPUNIT_ASSERT(!control.update("localhost", "http", 200, 4, Timer(18_s)));
+  CPPUNIT_ASSERT_EQUAL(4, control.getLevel("localhost", "http"));
+  CPPUNIT_ASSERT_EQUAL(4,
+                       ssm->find("localhost", "http")->getConnectionLevel());
+}
+
+void AdaptiveConnectionControlTest::testUpdate_takeBack()
+{
+  AdaptiveConnectionControl control(8, ssm);
+  CPPUNIT_ASSERT(control.update("localhost", "http", 100, 2, Timer(10_s)));
+  // The 3rd connection did not increase speed.
+  CPPUNIT_ASSERT(!control.update("localhost", "http", 105, 3, Timer(14_s)));
+  CPPUNIT_ASSERT_EQUAL(2, control.getLevel("localhost", "http"));
+  CPPUNIT_ASSERT(!control.update("localhost", "http", 100, 2, Timer(20_s)));
+  CPPUNIT_ASSERT_EQUAL(2, control.getLevel("localhost", "http"));
+  // Probe again after a while.
+  CPPUNIT_ASSERT(control.update("localhost", "http", 100, 2, Timer(50_s)));
+  CPPUNIT_ASSERT_EQUAL(3, control.getLevel("localhost", "http"));
+}
+
+void AdaptiveConnectionControlTest::testUpdate_notSaturated()
+{
+  AdaptiveConnectionControl control(8, ssm);
+  CPPUNIT_ASSERT(!control.update("localhost", "http", 100, 1, Timer(10_s)));
+  CPPUNIT_ASSERT_EQUAL(2, control.getLevel("localhost", "http"));
+  CPPUNIT_ASSERT(!control.update("localhost", "http", 100, 0, Timer(10_s)));
+  CPPUNIT_ASSERT_EQUAL(2, control.getLevel("localhost", "http"));
+}
+
+void AdaptiveConnectionControlTest::testUpdate_perConnectionDrop()
+{
+  AdaptiveConnectionControl control(8, ssm);
+  CPPUNIT_ASSERT(control.update("localhost", "http", 400, 2, Timer(10_s)));
+  CPPUNIT_ASSERT(control.update("localhost", "http", 600, 3, Timer(14_s)));
+  CPPUNIT_ASSERT_EQUAL(4, control.getLevel("localhost", "http"));
+  // The server throttles connections.
+  CPPUNIT_ASSERT(!control.update("localhost", "http", 300, 4, Timer(18_s)));
+  CPPUNIT_ASSERT_EQUAL(2, control.getLevel("localhost", "http"));
+}
+
+void AdaptiveConnectionControlTest::testOnOverload()
+{
+  AdaptiveConnectionControl control(8, ssm);
+  CPPUNIT_ASSERT(control.update("localhost", "http", 100, 2, Timer(10_s)));
+  CPPUNIT_ASSERT(control.update("localhost", "http", 200, 3, Timer(14_s)));
+  CPPUNIT_ASSERT_EQUAL(4, control.getLevel("localhost", "http"));
+  control.onOverload("localhost", "http", Timer(20_s));
+  CPPUNIT_ASSERT_EQUAL(2, control.getLevel("localhost", "http"));
+  // Other connections got the same response at once.
+  control.onOverload("localhost", "http", Timer(21_s));
+  CPPUNIT_ASSERT_EQUAL(2, control.getLevel("localhost", "http"));
+  control.onOverload("localhost", "http", Timer(30_s));
+  CPPUNIT_ASSERT_EQUAL(1, control.getLevel("localhost", "http"));
+  CPPUNIT_ASSERT_EQUAL(1,
+                       ssm->find("localhost", "http")->getConnectionLevel());
+}
+
+} // namespace aria2
@@ -18,6 +18,7 @@ class Aria2ApiTest : public CppUnit::TestFixture {
 
   CPPUNIT_TEST_SUITE(Aria2ApiTest);
   CPPUNIT_TEST(testAddUri);
+  CPPUNIT_TEST(testAddUris);
   CPPUNIT_TEST(testAddMetalink);
   CPPUNIT_TEST(testAddTorrent);
   CPPUNIT_TEST(testRemovePause);
@@ -40,6 +41,7 @@ public:
   void tearDown() { sessionFinal(session_); }
 
   void testAddUri();
+  void testAddUris();
   void testAddMetalink();
   void testAddTorrent();
   void testRemovePause();
@@ -72,6 +74,36 @@ void Aria2ApiTest::testAddUri()
   CPPUNIT_ASSERT_EQUAL(-1, addUri(session_, &gid, uris, options));
 }
 
+void Aria2ApiTest::testAddUris()
+{
+  std::vector<A2Gid> gids;
+  std::vector<UriItem> items(2);
+  items[0].uris.push_back("http://localhost/1");
+  items[1].uris.push_back("http://localhost/2");
+  items[1].options.push_back(KeyVals::value_type("dir", "/sink2"));
+  KeyVals options = {{"dir", "/sink"}};
+  CPPUNIT_ASSERT_EQUAL(0, addUris(session_, &gids, items, options));
+  CPPUNIT_ASSERT_EQUAL((size_t)2, gids.size());
+
+  for (size_t i = 0; i < 2; ++i) {
+    DownloadHandle* hd = getDownloadHandle(session_, gids[i]);
+    CPPUNIT_ASSERT(hd);
+    FileData file = hd->getFile(1);
+    CPPUNIT_ASSERT_EQUAL(items[i].uris[0], file.uris[0].uri);
+    CPPUNIT_ASSERT_EQUAL(std::string(i == 0 ? "/sink" : "/sink2"),
+                         hd->getOption("dir"));
+    deleteDownloadHandle(hd);
+  }
+
+  gids.clear();
+  items[1].options.push_back(KeyVals::value_type("file-allocation", "foo"));
+  CPPUNIT_ASSERT_EQUAL(-1, addUris(session_, &gids, items, options));
+  CPPUNIT_ASSERT(gids.empty());
+  auto& rgman =
+      session_->context->reqinfo->getDownloadEngine()->getRequestGroupMan();
+  CPPUNIT_ASSERT_EQUAL((size_t)2, rgman->getReservedGroups().size());
+}
+
 void Aria2ApiTest::testAddMetalink()
 {
   std::string metalinkPath = A2_TEST_DIR "/metalink4.xml";
@@ -0,0 +1,164 @@
+#include "BanditURISelector.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "ServerStatMan.h"
+#include "ServerStat.h"
+#include "FileEntry.h"
+
+namespace aria2 {
+
+class BanditURISelectorTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(BanditURISelectorTest);
+  CPPUNIT_TEST(testSelect_withoutServerStat);
+  CPPUNIT_TEST(testSelect);
+  CPPUNIT_TEST(testSelect_latency);
+  CPPUNIT_TEST(testSelect_failureRate);
+  CPPUNIT_TEST(testSelect_explore);
+  CPPUNIT_TEST(testSelect_withUsedHosts);
+  CPPUNIT_TEST(testSelect_skipErrorHost);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  FileEntry fileEntry_;
+
+  std::shared_ptr<ServerStatMan> ssm;
+
+  std::shared_ptr<BanditURISelector> sel;
+
+  std::shared_ptr<ServerStat> addServerStat(const std::string& host,
+                                            const std::string& protocol,
+                                            int speed, int samples)
+  {
+    auto ss = std::make_shared<ServerStat>(host, protocol);
+    ss->setEwmaSpeed(speed);
+    ss->setSamples(samples);
+    ssm->add(ss);
+    return ss;
+  }
+
+public:
+  void setUp()
+  {
+    fileEntry_.setUris(
+        {"http://alpha/file", "ftp://alpha/file", "http://bravo/file"});
+
+    ssm = std::make_shared<ServerStatMan>();
+    sel = std::make_shared<BanditURISelector>(ssm);
+  }
+
+  void tearDown() {}
+
+  void testSelect_withoutServerStat();
+
+  void testSelect();
+
+  void testSelect_latency();
+
+  void testSelect_failureRate();
+
+  void testSelect_explore();
+
+  void testSelect_withUsedHosts();
+
+  void testSelect_skipErrorHost();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(BanditURISelectorTest);
+
+void BanditURISelectorTest::testSelect_withoutServerStat()
+{
+  std::vector<std::pair<size_t, std::string>> usedHosts;
+  // Without ServerStat and usedHosts, selector returns first URI
+  CPPUNIT_ASSERT_EQUAL(std::string("http://alpha/file"),
+                       sel->select(&fileEntry_, usedHosts));
+  CPPUNIT_ASSERT_EQUAL((size_t)2, fileEntry_.getRemainingUris().size());
+}
+
+void BanditURISelectorTest::testSelect()
+{
+  addServerStat("alpha", "http", 100000, 50);
+  addServerStat("alpha", "ftp", 80000, 50);
+  addServerStat("bravo", "http", 500000, 50);
+  std::vector<std::pair<size_t, std::string>> usedHosts;
+
+  CPPUNIT_ASSERT_EQUAL(std::string("http://bravo/file"),
+                       sel->select(&fileEntry_, usedHosts));
+  CPPUNIT_ASSERT_EQUAL(std::string("http://alpha/file"),
+                       sel->select(&fileEntry_, usedHosts));
+  CPPUNIT_ASSERT_EQUAL(std::string("ftp://alpha/file"),
+                       sel->select(&fileEntry_, usedHosts));
+  CPPUNIT_ASSERT_EQUAL((size_t)0, fileEntry_.getRemainingUris().size());
+}
+
+void BanditURISelectorTest::testSelect_latency()
+{
+  addServerStat("alpha", "http", 1000000, 50);
+  addServerStat("alpha", "ftp", 100000, 50);
+  // bravo is faster, but it takes 3 seconds before the first byte
+  // arrives.
+  auto bravo = addServerStat("bravo", "http", 2000000, 50);
+  bravo->setConnectTime(1000);
+  bravo->setTimeToFirstByte(2000);
+  std::vector<std::pair<size_t, std::string>> usedHosts;
+
+  CPPUNIT_ASSERT_EQUAL(std::string("http://alpha/file"),
+                       sel->select(&fileEntry_, usedHosts));
+}
+
+void BanditURISelectorTest::testSelect_failureRate()
+{
+  auto alpha = addServerStat("alpha", "http", 500000, 50);
+  alpha->setFailureRate(0.9);
+  addServerStat("alpha", "ftp", 100000, 50);
+  addServerStat("bravo", "http", 200000, 50);
+  std::vector<std::pair<size_t, std::string>> usedHosts;
+
+  CPPUNIT_ASSERT_EQUAL(std::string("http://bravo/file"),
+                       sel->select(&fileEntry_, usedHosts));
+}
+
+void BanditURISelectorTest::testSelect_explore()
+{
+  addServerStat("alpha", "http", 200000, 100);
+  addServerStat("alpha", "ftp", 100000, 100);
+  // bravo is slightly slower, but it is sampled only once.
+  addServerStat("bravo", "http", 180000, 1);
+  std::vector<std::pair<size_t, std::string>> usedHosts;
+
+  CPPUNIT_ASSERT_EQUAL(std::string("http://bravo/file"),
+                       sel->select(&fileEntry_, usedHosts));
+}
+
+void BanditURISelectorTest::testSelect_withUsedHosts()
+{
+  addServerStat("alpha", "http", 500000, 50);
+  addServerStat("alpha", "ftp", 100000, 50);
+  addServerStat("bravo", "http", 100000, 50);
+  std::vector<std::pair<size_t, std::string>> usedHosts;
+  usedHosts.push_back(std::make_pair(1, "alpha"));
+
+  CPPUNIT_ASSERT_EQUAL(std::string("http://bravo/file"),
+                       sel->select(&fileEntry_, usedHosts));
+
+  usedHosts.push_back(std::make_pair(1, "bravo"));
+  // All hosts are used, so the best one is selected.
+  CPPUNIT_ASSERT_EQUAL(std::string("http://alpha/file"),
+                       sel->select(&fileEntry_, usedHosts));
+}
+
+void BanditURISelectorTest::testSelect_skipErrorHost()
+{
+  auto alphaHTTP = addServerStat("alpha", "http", 500000, 50);
+  alphaHTTP->setError();
+  auto alphaFTP = addServerStat("alpha", "ftp", 500000, 50);
+  alphaFTP->setError();
+  std::vector<std::pair<size_t, std::string>> usedHosts;
+
+  CPPUNIT_ASSERT_EQUAL(std::string("http://bravo/file"),
+                       sel->select(&fileEntry_, usedHosts));
+  CPPUNIT_ASSERT_EQUAL((size_t)2, fileEntry_.getRemainingUris().size());
+}
+
+} // namespace aria2
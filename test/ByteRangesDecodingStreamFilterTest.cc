@@ -0,0 +1,224 @@
+#include "ByteRangesDecodingStreamFilter.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "DlAbortEx.h"
+#include "DlRetryEx.h"
+#include "Request.h"
+#include "Piece.h"
+#include "PiecedSegment.h"
+#include "Range.h"
+#include "ByteArrayDiskWriter.h"
+#include "SinkStreamFilter.h"
+#include "a2functional.h"
+
+namespace aria2 {
+
+class ByteRangesDecodingStreamFilterTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(ByteRangesDecodingStreamFilterTest);
+  CPPUNIT_TEST(testTransform);
+  CPPUNIT_TEST(testTransform_oneByteAtATime);
+  CPPUNIT_TEST(testTransform_singlePart);
+  CPPUNIT_TEST(testTransform_missingRange);
+  CPPUNIT_TEST(testTransform_outOfOrder);
+  CPPUNIT_TEST(testTransform_mergedParts);
+  CPPUNIT_TEST(testTransform_noContentRange);
+  CPPUNIT_TEST(testTransform_entityLengthMismatch);
+  CPPUNIT_TEST(testGetName);
+  CPPUNIT_TEST_SUITE_END();
+
+  std::unique_ptr<ByteRangesDecodingStreamFilter> filter_;
+  std::shared_ptr<ByteArrayDiskWriter> writer_;
+  std::shared_ptr<Segment> segment1_;
+  std::shared_ptr<Segment> segment3_;
+  std::shared_ptr<Request> req_;
+  std::string body_;
+
+public:
+  void setUp()
+  {
+    writer_ = std::make_shared<ByteArrayDiskWriter>();
+    auto sinkFilter = make_unique<SinkStreamFilter>();
+    sinkFilter->init();
+    filter_ =
+        make_unique<ByteRangesDecodingStreamFilter>("XYZ", 0, 32,
+                                                    std::move(sinkFilter));
+    filter_->init();
+    req_ = std::make_shared<Request>();
+    req_->setMaxRanges(5);
+    filter_->setRequest(req_);
+    segment1_ =
+        std::make_shared<PiecedSegment>(8, std::make_shared<Piece>(1, 8));
+    segment3_ =
+        std::make_shared<PiecedSegment>(8, std::make_shared<Piece>(3, 8));
+    body_ = "\r\n"
+            "--XYZ\r\n"
+            "Content-Type: text/plain\r\n"
+            "Content-Range: bytes 8-15/32\r\n"
+            "\r\n"
+            "abcdefgh\r\n"
+            "--XYZ\r\n"
+            "content-range: bytes 24-31/32\r\n"
+            "\r\n"
+            "ABCDEFGH\r\n"
+            "--XYZ--\r\n";
+  }
+
+  ssize_t transform(const std::shared_ptr<Segment>& segment,
+                    const std::string& data)
+  {
+    return filter_->transform(
+        writer_, segment, reinterpret_cast<const unsigned char*>(data.data()),
+        data.size());
+  }
+
+  void testTransform();
+  void testTransform_oneByteAtATime();
+  void testTransform_singlePart();
+  void testTransform_missingRange();
+  void testTransform_outOfOrder();
+  void testTransform_mergedParts();
+  void testTransform_noContentRange();
+  void testTransform_entityLengthMismatch();
+  void testGetName();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(ByteRangesDecodingStreamFilterTest);
+
+void ByteRangesDecodingStreamFilterTest::testTransform()
+{
+  CPPUNIT_ASSERT_EQUAL((ssize_t)8, transform(segment1_, body_));
+  // Stops at the beginning of the data of the next segment.
+  auto pos = body_.find("ABCDEFGH");
+  CPPUNIT_ASSERT_EQUAL(pos, filter_->getBytesProcessed());
+  CPPUNIT_ASSERT(segment1_->complete());
+  CPPUNIT_ASSERT(!filter_->finished());
+
+  CPPUNIT_ASSERT_EQUAL((ssize_t)8, transform(segment3_, body_.substr(pos)));
+  CPPUNIT_ASSERT_EQUAL(body_.size() - pos, filter_->getBytesProcessed());
+  CPPUNIT_ASSERT(segment3_->complete());
+  CPPUNIT_ASSERT(filter_->finished());
+  CPPUNIT_ASSERT_EQUAL(std::string(8, '\0') + "abcdefgh" +
+                           std::string(8, '\0') + "ABCDEFGH",
+                       writer_->getString());
+}
+
+void ByteRangesDecodingStreamFilterTest::testTransform_oneByteAtATime()
+{
+  auto segment = segment1_;
+  for (size_t i = 0; i < body_.size();) {
+    transform(segment, body_.substr(i, 1));
+    if (filter_->getBytesProcessed() == 0) {
+      CPPUNIT_ASSERT(segment1_->complete());
+      segment = segment3_;
+      continue;
+    }
+    ++i;
+  }
+  CPPUNIT_ASSERT(segment3_->complete());
+  CPPUNIT_ASSERT(filter_->finished());
+  CPPUNIT_ASSERT_EQUAL(std::string("abcdefgh"),
+                       writer_->getString().substr(8, 8));
+  CPPUNIT_ASSERT_EQUAL(std::string("ABCDEFGH"),
+                       writer_->getString().substr(24));
+}
+
+void ByteRangesDecodingStreamFilterTest::testTransform_singlePart()
+{
+  // The server coalesced the ranges into one, including the gap
+  // between them.
+  filter_->setSinglePart(Range(8, 31, 32));
+  std::string data = "abcdefgh--gap---ABCDEFGH";
+  CPPUNIT_ASSERT_EQUAL((ssize_t)8, transform(segment1_, data));
+  CPPUNIT_ASSERT_EQUAL((size_t)8, filter_->getBytesProcessed());
+  CPPUNIT_ASSERT(!filter_->finished());
+  CPPUNIT_ASSERT_EQUAL((ssize_t)8, transform(segment3_, data.substr(8)));
+  CPPUNIT_ASSERT_EQUAL((size_t)16, filter_->getBytesProcessed());
+  CPPUNIT_ASSERT(filter_->finished());
+  CPPUNIT_ASSERT_EQUAL(std::string("ABCDEFGH"),
+                       writer_->getString().substr(24));
+}
+
+void ByteRangesDecodingStreamFilterTest::testTransform_missingRange()
+{
+  // The part for segment1_ is missing.
+  try {
+    transform(segment1_, body_.substr(body_.find("--XYZ\r\ncontent-range")));
+    CPPUNIT_FAIL("exception must be thrown.");
+  }
+  catch (DlRetryEx& e) {
+  }
+  // Falls back to single range requests.
+  CPPUNIT_ASSERT_EQUAL(1, req_->getMaxRanges());
+}
+
+void ByteRangesDecodingStreamFilterTest::testTransform_outOfOrder()
+{
+  std::string body = "--XYZ\r\n"
+                     "Content-Range: bytes 24-31/32\r\n"
+                     "\r\n"
+                     "ABCDEFGH\r\n"
+                     "--XYZ\r\n"
+                     "Content-Range: bytes 8-15/32\r\n"
+                     "\r\n"
+                     "abcdefgh\r\n"
+                     "--XYZ--\r\n";
+  try {
+    transform(segment1_, body);
+    CPPUNIT_FAIL("exception must be thrown.");
+  }
+  catch (DlRetryEx& e) {
+  }
+  CPPUNIT_ASSERT_EQUAL(1, req_->getMaxRanges());
+  CPPUNIT_ASSERT_EQUAL((int64_t)0, segment1_->getWrittenLength());
+}
+
+void ByteRangesDecodingStreamFilterTest::testTransform_mergedParts()
+{
+  // The server merged the ranges into one part, including the gap
+  // between them.
+  std::string body = "--XYZ\r\n"
+                     "Content-Range: bytes 8-31/32\r\n"
+                     "\r\n"
+                     "abcdefgh--gap---ABCDEFGH\r\n"
+                     "--XYZ--\r\n";
+  CPPUNIT_ASSERT_EQUAL((ssize_t)8, transform(segment1_, body));
+  CPPUNIT_ASSERT(segment1_->complete());
+  auto pos = filter_->getBytesProcessed();
+  CPPUNIT_ASSERT_EQUAL((ssize_t)8, transform(segment3_, body.substr(pos)));
+  CPPUNIT_ASSERT(segment3_->complete());
+  CPPUNIT_ASSERT(filter_->finished());
+  CPPUNIT_ASSERT_EQUAL(std::string(8, '\0') + "abcdefgh" +
+                           std::string(8, '\0') + "ABCDEFGH",
+                       writer_->getString());
+  CPPUNIT_ASSERT_EQUAL(5, req_->getMaxRanges());
+}
+
+void ByteRangesDecodingStreamFilterTest::testTransform_noContentRange()
+{
+  try {
+    transform(segment1_, "--XYZ\r\nContent-Type: text/plain\r\n\r\nabcdefgh");
+    CPPUNIT_FAIL("exception must be thrown.");
+  }
+  catch (DlAbortEx& e) {
+  }
+}
+
+void ByteRangesDecodingStreamFilterTest::testTransform_entityLengthMismatch()
+{
+  try {
+    transform(segment1_, "--XYZ\r\nContent-Range: bytes 8-15/33\r\n\r\n");
+    CPPUNIT_FAIL("exception must be thrown.");
+  }
+  catch (DlAbortEx& e) {
+  }
+}
+
+void ByteRangesDecodingStreamFilterTest::testGetName()
+{
+  CPPUNIT_ASSERT_EQUAL(std::string("ByteRangesDecodingStreamFilter"),
+                       filter_->getName());
+}
+
+} // namespace aria2
@@ -2,6 +2,8 @@
 
 #include <cppunit/extensions/HelperMacros.h>
 
+#include "wallclock.h"
+
 namespace aria2 {
 
 class DNSCacheTest : public CppUnit::TestFixture {
@@ -11,6 +13,11 @@ class DNSCacheTest : public CppUnit::TestFixture {
   CPPUNIT_TEST(testMarkBad);
   CPPUNIT_TEST(testPutBadAddr);
   CPPUNIT_TEST(testRemove);
+  CPPUNIT_TEST(testExpiry);
+  CPPUNIT_TEST(testUpdate);
+  CPPUNIT_TEST(testNegative);
+  CPPUNIT_TEST(testStartRefresh);
+  CPPUNIT_TEST(testSaveLoad);
   CPPUNIT_TEST_SUITE_END();
 
   DNSCache cache_;
@@ -18,6 +25,7 @@ class DNSCacheTest : public CppUnit::TestFixture {
 public:
   void setUp()
   {
+    global::wallclock().reset();
     cache_ = DNSCache();
     cache_.put("www", "192.168.0.1", 80);
     cache_.put("www", "::1", 80);
@@ -29,6 +37,11 @@ public:
   void testMarkBad();
   void testPutBadAddr();
   void testRemove();
+  void testExpiry();
+  void testUpdate();
+  void testNegative();
+  void testStartRefresh();
+  void testSaveLoad();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(DNSCacheTest);
@@ -61,4 +74,100 @@ void DNSCacheTest::testRemove()
   CPPUNIT_ASSERT_EQUAL(std::string(""), cache_.find("www", 80));
 }
 
+void DNSCacheTest::testExpiry()
+{
+  cache_.put("short", "192.168.0.3", 80, 10_s);
+  CPPUNIT_ASSERT_EQUAL(std::string("192.168.0.3"), cache_.find("short", 80));
+  global::wallclock().advance(10_s);
+  CPPUNIT_ASSERT_EQUAL(std::string(""), cache_.find("short", 80));
+  // Default TTL is 300 seconds
+  CPPUNIT_ASSERT_EQUAL(std::string("192.168.0.1"), cache_.find("www", 80));
+  global::wallclock().advance(290_s);
+  CPPUNIT_ASSERT_EQUAL(std::string(""), cache_.find("www", 80));
+  cache_.removeExpired();
+  CPPUNIT_ASSERT_EQUAL((size_t)0, cache_.size());
+  global::wallclock().reset();
+}
+
+void DNSCacheTest::testUpdate()
+{
+  cache_.markBad("www", "192.168.0.1", 80);
+  std::vector<std::string> addrs{"192.168.0.1", "192.168.0.2"};
+  cache_.update("www", addrs, 80, 60_s);
+  // Bad address is kept bad; ::1 is gone.
+  std::vector<std::string> res;
+  cache_.findAll(std::back_inserter(res), "www", 80);
+  CPPUNIT_ASSERT_EQUAL((size_t)1, res.size());
+  CPPUNIT_ASSERT_EQUAL(std::string("192.168.0.2"), res[0]);
+
+  cache_.markBad("www", "192.168.0.2", 80);
+  CPPUNIT_ASSERT_EQUAL(std::string(""), cache_.find("www", 80));
+  // All addresses are bad, so they are all made good again.
+  cache_.update("www", addrs, 80, 60_s);
+  CPPUNIT_ASSERT_EQUAL(std::string("192.168.0.1"), cache_.find("www", 80));
+}
+
+void DNSCacheTest::testNegative()
+{
+  // Negative caching is disabled by default.
+  cache_.putNegative("bad", 80, "NXDOMAIN");
+  CPPUNIT_ASSERT(!cache_.findNegative("bad", 80));
+
+  cache_.setNegativeTTL(5_s);
+  cache_.putNegative("bad", 80, "NXDOMAIN");
+  auto error = cache_.findNegative("bad", 80);
+  CPPUNIT_ASSERT(error);
+  CPPUNIT_ASSERT_EQUAL(std::string("NXDOMAIN"), *error);
+  CPPUNIT_ASSERT_EQUAL(std::string(""), cache_.find("bad", 80));
+  // Valid positive entry is not overwritten.
+  cache_.putNegative("www", 80, "NXDOMAIN");
+  CPPUNIT_ASSERT(!cache_.findNegative("www", 80));
+  CPPUNIT_ASSERT_EQUAL(std::string("192.168.0.1"), cache_.find("www", 80));
+
+  global::wallclock().advance(5_s);
+  CPPUNIT_ASSERT(!cache_.findNegative("bad", 80));
+  // Successful resolution replaces negative entry.
+  cache_.putNegative("bad", 80, "NXDOMAIN");
+  cache_.put("bad", "192.168.0.4", 80);
+  CPPUNIT_ASSERT(!cache_.findNegative("bad", 80));
+  CPPUNIT_ASSERT_EQUAL(std::string("192.168.0.4"), cache_.find("bad", 80));
+  global::wallclock().reset();
+}
+
+void DNSCacheTest::testStartRefresh()
+{
+  cache_.put("short", "192.168.0.3", 80, 100_s);
+  CPPUNIT_ASSERT(!cache_.startRefresh("short", 80));
+  CPPUNIT_ASSERT(!cache_.startRefresh("none", 80));
+  global::wallclock().advance(91_s);
+  CPPUNIT_ASSERT(cache_.startRefresh("short", 80));
+  // Refresh is started only once.
+  CPPUNIT_ASSERT(!cache_.startRefresh("short", 80));
+  cache_.update("short", std::vector<std::string>{"192.168.0.3"}, 80, 100_s);
+  CPPUNIT_ASSERT(!cache_.startRefresh("short", 80));
+  global::wallclock().reset();
+}
+
+void DNSCacheTest::testSaveLoad()
+{
+  std::string filename = A2_TEST_OUT_DIR "/aria2_DNSCacheTest_testSaveLoad";
+  cache_.put("short", "192.168.0.3", 80, 1_s);
+  global::wallclock().advance(1_s);
+  cache_.markBad("www", "::1", 80);
+  CPPUNIT_ASSERT(cache_.save(filename));
+
+  DNSCache cache;
+  CPPUNIT_ASSERT(cache.load(filename));
+  CPPUNIT_ASSERT_EQUAL((size_t)3, cache.size());
+  std::vector<std::string> res;
+  cache.findAll(std::back_inserter(res), "www", 80);
+  CPPUNIT_ASSERT_EQUAL((size_t)1, res.size());
+  CPPUNIT_ASSERT_EQUAL(std::string("192.168.0.1"), res[0]);
+  CPPUNIT_ASSERT_EQUAL(std::string("192.168.0.1"), cache.find("ftp", 21));
+  CPPUNIT_ASSERT_EQUAL(std::string("192.168.1.2"), cache.find("proxy", 8080));
+  // Expired entry was not saved.
+  CPPUNIT_ASSERT_EQUAL(std::string(""), cache.find("short", 80));
+  global::wallclock().reset();
+}
+
 } // namespace aria2
@@ -13,6 +13,10 @@
 #include "Piece.h"
 #include "FileEntry.h"
 #include "array_fun.h"
+#include "File.h"
+#include "BitfieldMan.h"
+#include "TestUtil.h"
+#include "TimeA2.h"
 #ifdef ENABLE_BITTORRENT
 #include "MockPeerStorage.h"
 #include "BtRuntime.h"
@@ -37,6 +41,8 @@ class DefaultBtProgressInfoFileTest : public CppUnit::TestFixture {
   CPPUNIT_TEST(testLoad_nonBt_compat);
 #endif // !WORDS_BIGENDIAN
   CPPUNIT_TEST(testLoad_nonBt_pieceLengthShorter);
+  CPPUNIT_TEST(testSave_journal);
+  CPPUNIT_TEST(testLoad_fileStamps);
   CPPUNIT_TEST(testUpdateFilename);
   CPPUNIT_TEST_SUITE_END();
 
@@ -99,6 +105,8 @@ public:
   void testLoad_nonBt_compat();
 #endif // !WORDS_BIGENDIAN
   void testLoad_nonBt_pieceLengthShorter();
+  void testSave_journal();
+  void testLoad_fileStamps();
   void testUpdateFilename();
 };
 
@@ -248,7 +256,7 @@ void DefaultBtProgressInfoFileTest::testSave()
 
   unsigned char extension[4];
   in.read((char*)extension, sizeof(extension));
-  CPPUNIT_ASSERT_EQUAL(std::string("00000001"),
+  CPPUNIT_ASSERT_EQUAL(std::string("00000003"),
                        util::toHex(extension, sizeof(extension)));
 
   uint32_t infoHashLength;
@@ -443,6 +451,126 @@ void DefaultBtProgressInfoFileTest::testLoad_nonBt_pieceLengthShorter()
   CPPUNIT_ASSERT_EQUAL((size_t)0, pieceStorage_->countInFlightPiece());
 }
 
+void DefaultBtProgressInfoFileTest::testSave_journal()
+{
+  initializeMembers(1_k, 80_k);
+  std::shared_ptr<DownloadContext> dctx(
+      new DownloadContext(1_k, 80_k, A2_TEST_OUT_DIR "/save-journal"));
+  File(A2_TEST_OUT_DIR "/save-journal.aria2").remove();
+
+  for (size_t i = 0; i < 10; ++i) {
+    bitfield_->setBit(i);
+  }
+  std::shared_ptr<Piece> p1(new Piece(10, 1_k));
+  std::vector<std::shared_ptr<Piece>> inFlightPieces{p1};
+  pieceStorage_->addInFlightPiece(inFlightPieces);
+
+  // Start with a file of version 0001, which is converted on the
+  // first save with journal enabled.
+  {
+    DefaultBtProgressInfoFile infoFile(dctx, pieceStorage_, option_.get());
+    infoFile.save();
+  }
+  option_->put(PREF_JOURNAL_CONTROL_FILE, A2_V_TRUE);
+  File file(A2_TEST_OUT_DIR "/save-journal.aria2");
+  {
+    BitfieldMan bitfield(1_k, 80_k);
+    auto pieceStorage = std::make_shared<MockPieceStorage>();
+    pieceStorage->setBitfield(&bitfield);
+    DefaultBtProgressInfoFile infoFile(dctx, pieceStorage, option_.get());
+    infoFile.load();
+    infoFile.save();
+    std::ifstream in(file.getPath().c_str(), std::ios::binary);
+    unsigned char version[2];
+    in.read((char*)version, sizeof(version));
+    CPPUNIT_ASSERT_EQUAL(std::string("0002"),
+                         util::toHex(version, sizeof(version)));
+  }
+  int64_t checkpointLength = file.size();
+  {
+    BitfieldMan bitfield(1_k, 80_k);
+    auto pieceStorage = std::make_shared<MockPieceStorage>();
+    pieceStorage->setBitfield(&bitfield);
+    DefaultBtProgressInfoFile infoFile(dctx, pieceStorage, option_.get());
+    // Continues the journal of the loaded file.
+    infoFile.load();
+    infoFile.save();
+    CPPUNIT_ASSERT_EQUAL(checkpointLength, file.size());
+
+    bitfield.setBit(11);
+    bitfield.setBit(12);
+    inFlightPieces.clear();
+    pieceStorage->getInFlightPieces(inFlightPieces);
+    inFlightPieces[0]->completeBlock(0);
+    infoFile.save();
+    // record length, upload length, 2 indexes and 1 in-flight piece
+    CPPUNIT_ASSERT_EQUAL(checkpointLength + 4 + 8 + 4 + 2 * 4 + 4 + 13,
+                         file.size());
+  }
+  // Simulate the record torn by crash.
+  {
+    std::ofstream out(file.getPath().c_str(),
+                      std::ios::binary | std::ios::app);
+    out.write("\0\0\0\x40\0", 5);
+  }
+
+  BitfieldMan bitfield(1_k, 80_k);
+  auto pieceStorage = std::make_shared<MockPieceStorage>();
+  pieceStorage->setBitfield(&bitfield);
+  DefaultBtProgressInfoFile infoFile(dctx, pieceStorage, option_.get());
+  infoFile.load();
+
+  CPPUNIT_ASSERT_EQUAL(std::string("ffd80000000000000000"),
+                       util::toHex(bitfield.getBitfield(),
+                                   bitfield.getBitfieldLength()));
+  inFlightPieces.clear();
+  pieceStorage->getInFlightPieces(inFlightPieces);
+  CPPUNIT_ASSERT_EQUAL((size_t)1, inFlightPieces.size());
+  CPPUNIT_ASSERT_EQUAL((size_t)10, inFlightPieces[0]->getIndex());
+  CPPUNIT_ASSERT(inFlightPieces[0]->hasBlock(0));
+
+  // The broken tail is replaced with a new checkpoint.
+  infoFile.save();
+  CPPUNIT_ASSERT_EQUAL(checkpointLength, file.size());
+}
+
+void DefaultBtProgressInfoFileTest::testLoad_fileStamps()
+{
+  initializeMembers(1_k, 80_k);
+  std::string path = A2_TEST_OUT_DIR "/load-fileStamps";
+  createFile(path, 80_k);
+  std::shared_ptr<DownloadContext> dctx(new DownloadContext(1_k, 80_k, path));
+  bitfield_->setAllBit();
+
+  DefaultBtProgressInfoFile infoFile(dctx, pieceStorage_, option_.get());
+  infoFile.save();
+  CPPUNIT_ASSERT(!infoFile.getUnchangedPieces());
+  {
+    DefaultBtProgressInfoFile infoFile(dctx, pieceStorage_, option_.get());
+    infoFile.load();
+    CPPUNIT_ASSERT(infoFile.getUnchangedPieces());
+    CPPUNIT_ASSERT(infoFile.getUnchangedPieces()->isAllBitSet());
+  }
+  // Change mtime of the file
+  File(path).utime(Time(1000), Time(1000));
+  {
+    DefaultBtProgressInfoFile infoFile(dctx, pieceStorage_, option_.get());
+    infoFile.load();
+    CPPUNIT_ASSERT(infoFile.getUnchangedPieces());
+    CPPUNIT_ASSERT_EQUAL((int64_t)0,
+                         infoFile.getUnchangedPieces()->getCompletedLength());
+  }
+  // File stamps are not saved for incomplete file.
+  bitfield_->unsetBit(79);
+  infoFile.save();
+  {
+    DefaultBtProgressInfoFile infoFile(dctx, pieceStorage_, option_.get());
+    infoFile.load();
+    CPPUNIT_ASSERT_EQUAL((int64_t)0,
+                         infoFile.getUnchangedPieces()->getCompletedLength());
+  }
+}
+
 void DefaultBtProgressInfoFileTest::testSave_nonBt()
 {
   initializeMembers(1_k, 80_k);
@@ -480,7 +608,7 @@ void DefaultBtProgressInfoFileTest::testSave_nonBt()
 
   unsigned char extension[4];
   in.read((char*)extension, sizeof(extension));
-  CPPUNIT_ASSERT_EQUAL(std::string("00000000"),
+  CPPUNIT_ASSERT_EQUAL(std::string("00000002"),
                        util::toHex(extension, sizeof(extension)));
 
   uint32_t infoHashLength;
@@ -77,6 +77,23 @@ void DirectDiskAdaptorTest::testWriteCache()
   cache.cacheData(createDataCell(4, "efg"));
   adaptor->writeCache(&cache);
   CPPUNIT_ASSERT_EQUAL(std::string("abc?efg"), dw->getString());
+
+  // DataCell larger than internal buffer
+  cache.clear();
+  dw->setString("");
+  std::string data3(40_k, '3');
+  cache.cacheData(createDataCell(5, data3.c_str()));
+  cache.cacheData(createDataCell(5 + data3.size(), "xyz"));
+  adaptor->writeCache(&cache);
+  CPPUNIT_ASSERT_EQUAL(data3 + "xyz", dw->getString().substr(5));
+
+  // Gap after unaligned start
+  cache.clear();
+  dw->setString(std::string(20, '?'));
+  cache.cacheData(createDataCell(5, "abc"));
+  cache.cacheData(createDataCell(10, "efg"));
+  adaptor->writeCache(&cache);
+  CPPUNIT_ASSERT_EQUAL(std::string("?????abc??efg???????"), dw->getString());
 }
 
 } // namespace aria2
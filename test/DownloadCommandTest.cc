@@ -0,0 +1,247 @@
+#include "DownloadCommand.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "DownloadEngine.h"
+#include "SelectEventPoll.h"
+#include "RequestGroupMan.h"
+#include "RequestGroup.h"
+#include "DownloadContext.h"
+#include "PieceStorage.h"
+#include "DiskAdaptor.h"
+#include "FileEntry.h"
+#include "Request.h"
+#include "SocketCore.h"
+#include "SocketRecvBuffer.h"
+#include "Option.h"
+#include "OptionParser.h"
+#include "Command.h"
+#include "File.h"
+#include "SegmentMan.h"
+#include "Segment.h"
+#include "TimerA2.h"
+#include "wallclock.h"
+#include "GroupId.h"
+#include "a2functional.h"
+#include "prefs.h"
+#include "TestUtil.h"
+
+namespace aria2 {
+
+class DownloadCommandTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(DownloadCommandTest);
+  CPPUNIT_TEST(testReceiveToWrCache);
+  CPPUNIT_TEST(testReceiveToWrCache_partial);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void testReceiveToWrCache();
+  void testReceiveToWrCache_partial();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(DownloadCommandTest);
+
+namespace {
+// Requests the whole file, so that one connection downloads all
+// segments in turn.
+class TestDownloadCommand : public DownloadCommand {
+public:
+  TestDownloadCommand(cuid_t cuid, const std::shared_ptr<Request>& req,
+                      const std::shared_ptr<FileEntry>& fileEntry,
+                      RequestGroup* requestGroup, DownloadEngine* e,
+                      const std::shared_ptr<SocketCore>& s)
+      : DownloadCommand(cuid, req, fileEntry, requestGroup, e, s,
+                        std::make_shared<SocketRecvBuffer>(s))
+  {
+  }
+
+protected:
+  virtual int64_t getRequestEndOffset() const CXX11_OVERRIDE
+  {
+    return getFileEntry()->getLength();
+  }
+};
+} // namespace
+
+namespace {
+// Sends data to the download command and closes the connection.
+class TestServerCommand : public Command {
+private:
+  DownloadEngine* e_;
+  std::shared_ptr<SocketCore> socket_;
+  std::string data_;
+  size_t offset_;
+  Timer timer_;
+
+public:
+  TestServerCommand(DownloadEngine* e,
+                    const std::shared_ptr<SocketCore>& socket,
+                    std::string data)
+      : Command(e->newCUID()),
+        e_(e),
+        socket_(socket),
+        data_(std::move(data)),
+        offset_(0),
+        timer_(global::wallclock())
+  {
+    setStatusRealtime();
+  }
+
+  virtual bool execute() CXX11_OVERRIDE
+  {
+    offset_ +=
+        socket_->writeData(data_.data() + offset_, data_.size() - offset_);
+    if (offset_ == data_.size() || timer_.difference(global::wallclock()) >=
+                                       std::chrono::seconds(10)) {
+      socket_->closeConnection();
+      return true;
+    }
+    e_->setNoWait(true);
+    e_->addCommand(std::unique_ptr<Command>(this));
+    return false;
+  }
+};
+} // namespace
+
+namespace {
+const int64_t PIECE_LENGTH = 64_k;
+const int64_t TOTAL_LENGTH = 160_k;
+
+struct DownloadResult {
+  std::string data;
+  bool finished;
+  int64_t completedLength;
+  int64_t sessionDownloadLength;
+  // The written length of the last segment, remembered by SegmentMan
+  // when the download stopped.
+  int64_t lastSegmentWrittenLength;
+};
+
+// Downloads [PIECE_LENGTH, PIECE_LENGTH + sendLength) of the file whose
+// first piece is already done.  Unless |diskCache| is "0", the data
+// is read into the write disk cache directly.
+DownloadResult download(const std::string& name, const std::string& diskCache,
+                        const std::string& body, size_t sendLength)
+{
+  auto option = std::make_shared<Option>();
+  OptionParser::getInstance()->parseDefaultValues(*option);
+  option->put(PREF_DIR, A2_TEST_OUT_DIR);
+  option->put(PREF_DISK_CACHE, diskCache);
+  option->put(PREF_MAX_TRIES, "1");
+  auto e = make_unique<DownloadEngine>(make_unique<SelectEventPoll>());
+  e->setOption(option.get());
+  auto rgman = make_unique<RequestGroupMan>(
+      std::vector<std::shared_ptr<RequestGroup>>{}, 1, option.get());
+  rgman->initWrDiskCache();
+
+  auto path = A2_TEST_OUT_DIR "/" + name;
+  File(path).remove();
+  auto dctx =
+      std::make_shared<DownloadContext>(PIECE_LENGTH, TOTAL_LENGTH, path);
+  auto group = std::make_shared<RequestGroup>(GroupId::create(), option);
+  group->setDownloadContext(dctx);
+  group->setRequestGroupMan(rgman.get());
+  group->initPieceStorage();
+  auto pieceStorage = group->getPieceStorage();
+  CPPUNIT_ASSERT_EQUAL(diskCache != "0", !!pieceStorage->getWrDiskCache());
+  pieceStorage->getDiskAdaptor()->initAndOpenFile();
+  pieceStorage->markPiecesDone(PIECE_LENGTH);
+  e->setRequestGroupMan(std::move(rgman));
+
+  SocketCore listener;
+  listener.bind("127.0.0.1", 0, AF_INET);
+  listener.beginListen();
+  auto socket = std::make_shared<SocketCore>();
+  socket->establishConnection("127.0.0.1", listener.getAddrInfo().port);
+  CPPUNIT_ASSERT(listener.isReadable(5));
+  std::shared_ptr<SocketCore> peer = listener.acceptConnection();
+  peer->setNonBlockingMode();
+  CPPUNIT_ASSERT(socket->isWritable(5));
+  socket->setNonBlockingMode();
+
+  auto req = std::make_shared<Request>();
+  req->setUri("http://localhost/" + name);
+  auto cuid = e->newCUID();
+  // The segment is acquired by the command which sent the request.
+  CPPUNIT_ASSERT(group->getSegmentMan()->getSegment(cuid, 0));
+  e->addCommand(make_unique<TestDownloadCommand>(
+      cuid, req, dctx->getFirstFileEntry(), group.get(), e.get(), socket));
+  e->addCommand(make_unique<TestServerCommand>(
+      e.get(), peer, body.substr(PIECE_LENGTH, sendLength)));
+  e->run();
+
+  DownloadResult res;
+  res.finished = group->downloadFinished();
+  res.completedLength = group->getCompletedLength();
+  res.sessionDownloadLength = dctx->getNetStat().getSessionDownloadLength();
+  auto lastSegment = group->getSegmentMan()->getSegmentWithIndex(
+      e->newCUID(), TOTAL_LENGTH / PIECE_LENGTH);
+  res.lastSegmentWrittenLength =
+      lastSegment ? lastSegment->getWrittenLength() : -1;
+  pieceStorage->flushWrDiskCacheEntry();
+  pieceStorage->getDiskAdaptor()->closeFile();
+  res.data = readFile(path);
+  return res;
+}
+} // namespace
+
+namespace {
+std::string createBody()
+{
+  std::string body;
+  for (int64_t i = 0; i < TOTAL_LENGTH; ++i) {
+    body += static_cast<char>(i * 7 % 251);
+  }
+  return body;
+}
+} // namespace
+
+void DownloadCommandTest::testReceiveToWrCache()
+{
+  auto body = createBody();
+  auto direct = download("aria2_DownloadCommandTest_testReceiveToWrCache",
+                         "1M", body, TOTAL_LENGTH - PIECE_LENGTH);
+  auto buffered =
+      download("aria2_DownloadCommandTest_testReceiveToWrCache_buffered", "0",
+               body, TOTAL_LENGTH - PIECE_LENGTH);
+  for (auto& res : {direct, buffered}) {
+    CPPUNIT_ASSERT(res.finished);
+    CPPUNIT_ASSERT_EQUAL(TOTAL_LENGTH, res.completedLength);
+    CPPUNIT_ASSERT_EQUAL(TOTAL_LENGTH - PIECE_LENGTH,
+                         res.sessionDownloadLength);
+    CPPUNIT_ASSERT_EQUAL((size_t)TOTAL_LENGTH, res.data.size());
+    // The first piece was done before the download, so it is not
+    // touched.
+    CPPUNIT_ASSERT(std::string(PIECE_LENGTH, '\0') ==
+                   res.data.substr(0, PIECE_LENGTH));
+    CPPUNIT_ASSERT(body.substr(PIECE_LENGTH) == res.data.substr(PIECE_LENGTH));
+  }
+}
+
+void DownloadCommandTest::testReceiveToWrCache_partial()
+{
+  auto body = createBody();
+  // The connection is closed in the middle of the last piece, which
+  // is 32KiB long.  One 16KiB block of it is completed.
+  size_t sendLength = PIECE_LENGTH + 20000;
+  auto direct =
+      download("aria2_DownloadCommandTest_testReceiveToWrCache_partial", "1M",
+               body, sendLength);
+  auto buffered = download(
+      "aria2_DownloadCommandTest_testReceiveToWrCache_partial_buffered", "0",
+      body, sendLength);
+  for (auto& res : {direct, buffered}) {
+    CPPUNIT_ASSERT(!res.finished);
+    CPPUNIT_ASSERT_EQUAL(PIECE_LENGTH * 2 + 16_k, res.completedLength);
+    CPPUNIT_ASSERT_EQUAL((int64_t)sendLength, res.sessionDownloadLength);
+    CPPUNIT_ASSERT_EQUAL((int64_t)20000, res.lastSegmentWrittenLength);
+    CPPUNIT_ASSERT(body.substr(PIECE_LENGTH, sendLength) ==
+                   res.data.substr(PIECE_LENGTH, sendLength));
+    CPPUNIT_ASSERT_EQUAL(std::string::npos,
+                         res.data.find_first_not_of('\0', PIECE_LENGTH +
+                                                              sendLength));
+  }
+}
+
+} // namespace aria2
@@ -0,0 +1,200 @@
+#include "DownloadResultArchive.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "DownloadResult.h"
+#include "FileEntry.h"
+#include "File.h"
+#include "TestUtil.h"
+
+namespace aria2 {
+
+class DownloadResultArchiveTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(DownloadResultArchiveTest);
+  CPPUNIT_TEST(testAddAndGet);
+  CPPUNIT_TEST(testSpill);
+  CPPUNIT_TEST(testRemove);
+  CPPUNIT_TEST(testRemove_many);
+  CPPUNIT_TEST(testClear);
+  CPPUNIT_TEST_SUITE_END();
+
+  std::string filename_;
+
+public:
+  void setUp()
+  {
+    filename_ = A2_TEST_OUT_DIR "/aria2_DownloadResultArchiveTest";
+    File(filename_).remove();
+  }
+
+  void testAddAndGet();
+  void testSpill();
+  void testRemove();
+  void testRemove_many();
+  void testClear();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(DownloadResultArchiveTest);
+
+namespace {
+// Adds n download results to archive and returns their GIDs.  The
+// results are released after they are archived like
+// RequestGroupMan does.
+std::vector<a2_gid_t> addResults(DownloadResultArchive& archive, size_t n)
+{
+  std::vector<a2_gid_t> gids;
+  for (size_t i = 0; i < n; ++i) {
+    auto dr = createDownloadResult(error_code::FINISHED,
+                                   "http://host/" + util::uitos(i));
+    gids.push_back(dr->gid->getNumericId());
+    archive.add(*dr);
+  }
+  return gids;
+}
+} // namespace
+
+void DownloadResultArchiveTest::testAddAndGet()
+{
+  DownloadResultArchive archive(filename_, 10);
+  auto dr = createDownloadResult(error_code::NETWORK_PROBLEM, "http://host/");
+  auto gid = dr->gid->getNumericId();
+  dr->belongsTo = 100;
+  dr->followedBy.push_back(200);
+  dr->totalLength = 1_m;
+  dr->completedLength = 256_k;
+  dr->uploadLength = 1_k;
+  dr->pieceLength = 256_k;
+  dr->numPieces = 4;
+  dr->bitfield = std::string(1, '\x80');
+  dr->infoHash = "0123456789abcdef0123";
+  dr->dir = "/tmp";
+  dr->resultMessage = "failed";
+  dr->sessionTime = std::chrono::milliseconds(1500);
+  dr->fileEntries[0]->getSpentUris().push_back("http://used/");
+  dr->fileEntries[0]->setRequested(false);
+  archive.add(*dr);
+  dr.reset();
+  CPPUNIT_ASSERT_EQUAL((size_t)1, archive.size());
+  CPPUNIT_ASSERT(!archive.get(gid + 1));
+
+  dr = archive.get(gid);
+  CPPUNIT_ASSERT(dr);
+  CPPUNIT_ASSERT_EQUAL(gid, dr->gid->getNumericId());
+  CPPUNIT_ASSERT(dr->option);
+  CPPUNIT_ASSERT_EQUAL((a2_gid_t)100, dr->belongsTo);
+  CPPUNIT_ASSERT_EQUAL((size_t)1, dr->followedBy.size());
+  CPPUNIT_ASSERT_EQUAL((a2_gid_t)200, dr->followedBy[0]);
+  CPPUNIT_ASSERT_EQUAL(error_code::NETWORK_PROBLEM, dr->result);
+  CPPUNIT_ASSERT_EQUAL((int64_t)1_m, dr->totalLength);
+  CPPUNIT_ASSERT_EQUAL((int64_t)256_k, dr->completedLength);
+  CPPUNIT_ASSERT_EQUAL((int64_t)1_k, dr->uploadLength);
+  CPPUNIT_ASSERT_EQUAL((int32_t)256_k, dr->pieceLength);
+  CPPUNIT_ASSERT_EQUAL((size_t)4, dr->numPieces);
+  CPPUNIT_ASSERT_EQUAL(std::string(1, '\x80'), dr->bitfield);
+  CPPUNIT_ASSERT_EQUAL(std::string("0123456789abcdef0123"), dr->infoHash);
+  CPPUNIT_ASSERT_EQUAL(std::string("/tmp"), dr->dir);
+  CPPUNIT_ASSERT_EQUAL(std::string("failed"), dr->resultMessage);
+  CPPUNIT_ASSERT_EQUAL((int64_t)1500, (int64_t)dr->sessionTime.count());
+  CPPUNIT_ASSERT_EQUAL((size_t)1, dr->fileEntries.size());
+  auto& fe = dr->fileEntries[0];
+  CPPUNIT_ASSERT_EQUAL(std::string("/tmp/path"), fe->getPath());
+  CPPUNIT_ASSERT_EQUAL((int64_t)1, fe->getLength());
+  CPPUNIT_ASSERT(!fe->isRequested());
+  CPPUNIT_ASSERT_EQUAL((size_t)1, fe->getSpentUris().size());
+  CPPUNIT_ASSERT_EQUAL(std::string("http://used/"), fe->getSpentUris()[0]);
+  CPPUNIT_ASSERT_EQUAL((size_t)1, fe->getRemainingUris().size());
+  CPPUNIT_ASSERT_EQUAL(std::string("http://host/"),
+                       fe->getRemainingUris()[0]);
+  // The GID is in use while the restored result is alive.
+  CPPUNIT_ASSERT(!archive.get(gid));
+}
+
+void DownloadResultArchiveTest::testSpill()
+{
+  DownloadResultArchive archive(filename_, 4);
+  auto gids = addResults(archive, 11);
+  CPPUNIT_ASSERT_EQUAL((size_t)11, archive.size());
+  CPPUNIT_ASSERT(archive.countInMemory() <= 4);
+  CPPUNIT_ASSERT(File(filename_).size() > 0);
+
+  auto drs = archive.get(0, 11);
+  CPPUNIT_ASSERT_EQUAL((size_t)11, drs.size());
+  for (size_t i = 0; i < drs.size(); ++i) {
+    CPPUNIT_ASSERT_EQUAL(gids[i], drs[i]->gid->getNumericId());
+    CPPUNIT_ASSERT_EQUAL(std::string("http://host/") + util::uitos(i),
+                         drs[i]->fileEntries[0]->getRemainingUris()[0]);
+  }
+  drs.clear();
+  drs = archive.get(9, 20);
+  CPPUNIT_ASSERT_EQUAL((size_t)2, drs.size());
+  CPPUNIT_ASSERT_EQUAL(gids[9], drs[0]->gid->getNumericId());
+  drs.clear();
+  CPPUNIT_ASSERT_EQUAL(gids[0], archive.get(gids[0])->gid->getNumericId());
+  CPPUNIT_ASSERT_EQUAL((ssize_t)7, archive.find(gids[7]));
+}
+
+void DownloadResultArchiveTest::testRemove()
+{
+  DownloadResultArchive archive(filename_, 4);
+  auto gids = addResults(archive, 8);
+  CPPUNIT_ASSERT(archive.remove(gids[1]));
+  CPPUNIT_ASSERT(archive.remove(gids[6]));
+  CPPUNIT_ASSERT(!archive.remove(gids[6]));
+  CPPUNIT_ASSERT_EQUAL((size_t)6, archive.size());
+  CPPUNIT_ASSERT(!archive.get(gids[1]));
+  CPPUNIT_ASSERT_EQUAL((ssize_t)-1, archive.find(gids[1]));
+  CPPUNIT_ASSERT_EQUAL((ssize_t)1, archive.find(gids[2]));
+  CPPUNIT_ASSERT_EQUAL((ssize_t)5, archive.find(gids[7]));
+  // Removed records are not written to the file.
+  addResults(archive, 4);
+  auto drs = archive.get(1, 6);
+  CPPUNIT_ASSERT_EQUAL((size_t)5, drs.size());
+  CPPUNIT_ASSERT_EQUAL(gids[2], drs[0]->gid->getNumericId());
+  CPPUNIT_ASSERT_EQUAL(gids[7], drs[4]->gid->getNumericId());
+}
+
+void DownloadResultArchiveTest::testRemove_many()
+{
+  DownloadResultArchive archive(filename_, 16);
+  auto gids = addResults(archive, 100);
+  std::vector<a2_gid_t> kept;
+  for (size_t i = 0; i < gids.size(); ++i) {
+    if (i % 3 == 0 || i % 7 == 0) {
+      CPPUNIT_ASSERT(archive.remove(gids[i]));
+    }
+    else {
+      kept.push_back(gids[i]);
+    }
+  }
+  // Results added after the removals are counted as well.
+  auto added = addResults(archive, 5);
+  kept.insert(std::end(kept), std::begin(added), std::end(added));
+  CPPUNIT_ASSERT_EQUAL(kept.size(), archive.size());
+  for (size_t i = 0; i < kept.size(); ++i) {
+    CPPUNIT_ASSERT_EQUAL((ssize_t)i, archive.find(kept[i]));
+    auto drs = archive.get(i, i + 1);
+    CPPUNIT_ASSERT_EQUAL((size_t)1, drs.size());
+    CPPUNIT_ASSERT_EQUAL(kept[i], drs[0]->gid->getNumericId());
+  }
+  auto drs = archive.get(10, 20);
+  CPPUNIT_ASSERT_EQUAL((size_t)10, drs.size());
+  for (size_t i = 0; i < drs.size(); ++i) {
+    CPPUNIT_ASSERT_EQUAL(kept[10 + i], drs[i]->gid->getNumericId());
+  }
+}
+
+void DownloadResultArchiveTest::testClear()
+{
+  DownloadResultArchive archive(filename_, 2);
+  auto gids = addResults(archive, 5);
+  archive.clear();
+  CPPUNIT_ASSERT_EQUAL((size_t)0, archive.size());
+  CPPUNIT_ASSERT(!archive.get(gids[0]));
+  CPPUNIT_ASSERT(archive.get(0, 5).empty());
+  gids = addResults(archive, 3);
+  CPPUNIT_ASSERT_EQUAL((size_t)3, archive.size());
+  CPPUNIT_ASSERT_EQUAL(gids[0], archive.get(0, 1)[0]->gid->getNumericId());
+}
+
+} // namespace aria2
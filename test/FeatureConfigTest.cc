@@ -89,6 +89,10 @@ void FeatureConfigTest::testFeatureSummary()
 #ifdef HAVE_LIBSSH2
       "SFTP",
 #endif // HAVE_LIBSSH2
+
+#ifdef ENABLE_HTTP2
+      "HTTP/2",
+#endif // ENABLE_HTTP2
   };
 
   std::string featuresString =
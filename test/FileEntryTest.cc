@@ -4,6 +4,8 @@
 
 #include "InorderURISelector.h"
 #include "util.h"
+#include "PeerStat.h"
+#include "HostConnectionRegistry.h"
 
 namespace aria2 {
 
@@ -16,6 +18,9 @@ class FileEntryTest : public CppUnit::TestFixture {
   CPPUNIT_TEST(testGetRequest_withoutUriReuse);
   CPPUNIT_TEST(testGetRequest_withUniqueProtocol);
   CPPUNIT_TEST(testGetRequest_withReferer);
+  CPPUNIT_TEST(testGetPooledRequest);
+  CPPUNIT_TEST(testMaxConnectionPerHost);
+  CPPUNIT_TEST(testHostConnectionRegistry);
   CPPUNIT_TEST(testReuseUri);
   CPPUNIT_TEST(testAddUri);
   CPPUNIT_TEST(testAddUris);
@@ -33,6 +38,9 @@ public:
   void testGetRequest_withoutUriReuse();
   void testGetRequest_withUniqueProtocol();
   void testGetRequest_withReferer();
+  void testGetPooledRequest();
+  void testMaxConnectionPerHost();
+  void testHostConnectionRegistry();
   void testReuseUri();
   void testAddUri();
   void testAddUris();
@@ -184,6 +192,96 @@ void FileEntryTest::testGetRequest_withReferer()
   CPPUNIT_ASSERT_EQUAL(req->getUri(), req->getReferer());
 }
 
+void FileEntryTest::testGetPooledRequest()
+{
+  auto fileEntry = createFileEntry();
+  fileEntry->setMaxConnectionPerServer(2);
+  InorderURISelector selector{};
+  std::vector<std::pair<size_t, std::string>> usedHosts;
+  auto req1 = fileEntry->getRequest(&selector, true, usedHosts);
+  req1->initPeerStat(1);
+  auto req2 = fileEntry->getRequest(&selector, true, usedHosts);
+  req2->initPeerStat(2);
+  fileEntry->poolRequest(req1);
+  fileEntry->poolRequest(req2);
+
+  CPPUNIT_ASSERT(!fileEntry->getPooledRequest(3));
+  CPPUNIT_ASSERT(req2 == fileEntry->getPooledRequest(2));
+  CPPUNIT_ASSERT_EQUAL((size_t)1, fileEntry->countPooledRequest());
+  CPPUNIT_ASSERT(!fileEntry->getPooledRequest(2));
+}
+
+void FileEntryTest::testMaxConnectionPerHost()
+{
+  FileEntry fileEntry;
+  fileEntry.setUris(std::vector<std::string>{"http://localhost/aria2.zip",
+                                             "http://localhost/aria2.zip",
+                                             "http://mirror/aria2.zip"});
+  fileEntry.setMaxConnectionPerServer(3);
+  fileEntry.setMaxConnectionPerHost("localhost", 1);
+  fileEntry.setMaxConnectionPerHost("mirror", 5);
+  CPPUNIT_ASSERT_EQUAL(1, fileEntry.getMaxConnectionPerHost("localhost"));
+  CPPUNIT_ASSERT_EQUAL(3, fileEntry.getMaxConnectionPerHost("mirror"));
+  CPPUNIT_ASSERT_EQUAL(3, fileEntry.getMaxConnectionPerHost("unknown"));
+
+  InorderURISelector selector{};
+  std::vector<std::pair<size_t, std::string>> usedHosts;
+  auto req1 = fileEntry.getRequest(&selector, false, usedHosts);
+  CPPUNIT_ASSERT_EQUAL(std::string("localhost"), req1->getHost());
+  auto req2 = fileEntry.getRequest(&selector, false, usedHosts);
+  CPPUNIT_ASSERT_EQUAL(std::string("mirror"), req2->getHost());
+  CPPUNIT_ASSERT(!fileEntry.isConnectionLimitExceeded(req1));
+
+  fileEntry.setMaxConnectionPerHost("localhost", 2);
+  auto req3 = fileEntry.getRequest(&selector, false, usedHosts);
+  CPPUNIT_ASSERT_EQUAL(std::string("localhost"), req3->getHost());
+  CPPUNIT_ASSERT(!fileEntry.isConnectionLimitExceeded(req1));
+
+  fileEntry.setMaxConnectionPerHost("localhost", 1);
+  CPPUNIT_ASSERT(fileEntry.isConnectionLimitExceeded(req1));
+  fileEntry.poolRequest(req3);
+  CPPUNIT_ASSERT(!fileEntry.isConnectionLimitExceeded(req1));
+}
+
+void FileEntryTest::testHostConnectionRegistry()
+{
+  auto fileEntry = createFileEntry();
+  fileEntry->setMaxConnectionPerServer(2);
+  InorderURISelector selector{};
+  std::vector<std::pair<size_t, std::string>> usedHosts;
+  auto req1 = fileEntry->getRequest(&selector, false, usedHosts);
+  CPPUNIT_ASSERT_EQUAL((size_t)1, fileEntry->countInFlightRequest("localhost"));
+
+  // Requests already in-flight are accounted when registry is set.
+  HostConnectionRegistry registry;
+  fileEntry->setHostConnectionRegistry(&registry);
+  CPPUNIT_ASSERT_EQUAL((size_t)1, registry.countConnection("localhost"));
+
+  auto req2 = fileEntry->getRequest(&selector, false, usedHosts);
+  CPPUNIT_ASSERT_EQUAL(std::string("ftp"), req2->getProtocol());
+  CPPUNIT_ASSERT_EQUAL((size_t)2, fileEntry->countInFlightRequest("localhost"));
+  CPPUNIT_ASSERT_EQUAL((size_t)2, registry.countConnection("localhost"));
+  auto req3 = fileEntry->getRequest(&selector, false, usedHosts);
+  CPPUNIT_ASSERT_EQUAL((size_t)1, registry.countConnection("mirror"));
+
+  fileEntry->poolRequest(req1);
+  CPPUNIT_ASSERT_EQUAL((size_t)1, fileEntry->countInFlightRequest("localhost"));
+  CPPUNIT_ASSERT_EQUAL((size_t)1, registry.countConnection("localhost"));
+  // Removing request which is not in-flight does not change count.
+  CPPUNIT_ASSERT(!fileEntry->removeRequest(req1));
+  CPPUNIT_ASSERT_EQUAL((size_t)1, registry.countConnection("localhost"));
+
+  auto req4 = fileEntry->getPooledRequest(0);
+  CPPUNIT_ASSERT(!req4);
+  req4 = fileEntry->getRequest(&selector, false, usedHosts);
+  CPPUNIT_ASSERT(req1 == req4);
+  CPPUNIT_ASSERT_EQUAL((size_t)2, registry.countConnection("localhost"));
+
+  fileEntry->releaseRuntimeResource();
+  CPPUNIT_ASSERT_EQUAL((size_t)0, registry.countHost());
+  CPPUNIT_ASSERT_EQUAL((size_t)0, fileEntry->countInFlightRequest("localhost"));
+}
+
 void FileEntryTest::testReuseUri()
 {
   InorderURISelector selector{};
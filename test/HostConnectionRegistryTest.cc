@@ -0,0 +1,78 @@
+#include "HostConnectionRegistry.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "ServerStatMan.h"
+#include "ServerStat.h"
+
+namespace aria2 {
+
+class HostConnectionRegistryTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(HostConnectionRegistryTest);
+  CPPUNIT_TEST(testAddAndRemove);
+  CPPUNIT_TEST(testGetUsedHosts);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void setUp() {}
+
+  void tearDown() {}
+
+  void testAddAndRemove();
+  void testGetUsedHosts();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(HostConnectionRegistryTest);
+
+void HostConnectionRegistryTest::testAddAndRemove()
+{
+  HostConnectionRegistry registry;
+  registry.add("localhost", "http");
+  registry.add("localhost", "http");
+  registry.add("mirror", "ftp");
+  CPPUNIT_ASSERT_EQUAL((size_t)2, registry.countHost());
+  CPPUNIT_ASSERT_EQUAL((size_t)2, registry.countConnection("localhost"));
+  CPPUNIT_ASSERT_EQUAL((size_t)1, registry.countConnection("mirror"));
+  CPPUNIT_ASSERT_EQUAL((size_t)0, registry.countConnection("unknown"));
+  CPPUNIT_ASSERT_EQUAL(std::string("ftp"),
+                       registry.getEntries().find("mirror")->second.protocol);
+
+  registry.remove("localhost");
+  CPPUNIT_ASSERT_EQUAL((size_t)1, registry.countConnection("localhost"));
+  registry.remove("mirror");
+  CPPUNIT_ASSERT_EQUAL((size_t)0, registry.countConnection("mirror"));
+  CPPUNIT_ASSERT_EQUAL((size_t)1, registry.countHost());
+  // Removing unknown host is no-op.
+  registry.remove("unknown");
+  CPPUNIT_ASSERT_EQUAL((size_t)1, registry.countHost());
+}
+
+void HostConnectionRegistryTest::testGetUsedHosts()
+{
+  HostConnectionRegistry registry;
+  registry.add("slow", "http");
+  registry.add("fast", "http");
+  registry.add("busy", "http");
+  registry.add("busy", "http");
+
+  ServerStatMan serverStatMan;
+  auto fast = std::make_shared<ServerStat>("fast", "http");
+  fast->setDownloadSpeed(1000);
+  serverStatMan.add(fast);
+  auto slow = std::make_shared<ServerStat>("slow", "http");
+  slow->setDownloadSpeed(10);
+  serverStatMan.add(slow);
+
+  std::vector<std::pair<size_t, std::string>> usedHosts;
+  registry.getUsedHosts(usedHosts, &serverStatMan);
+  CPPUNIT_ASSERT_EQUAL((size_t)3, usedHosts.size());
+  CPPUNIT_ASSERT_EQUAL((size_t)1, usedHosts[0].first);
+  CPPUNIT_ASSERT_EQUAL(std::string("fast"), usedHosts[0].second);
+  CPPUNIT_ASSERT_EQUAL((size_t)1, usedHosts[1].first);
+  CPPUNIT_ASSERT_EQUAL(std::string("slow"), usedHosts[1].second);
+  CPPUNIT_ASSERT_EQUAL((size_t)2, usedHosts[2].first);
+  CPPUNIT_ASSERT_EQUAL(std::string("busy"), usedHosts[2].second);
+}
+
+} // namespace aria2
@@ -0,0 +1,414 @@
+#include "Http2Session.h"
+
+#include <cstring>
+#include <array>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "Http2RequestCommand.h"
+#include "DownloadEngine.h"
+#include "SelectEventPoll.h"
+#include "RequestGroupMan.h"
+#include "RequestGroup.h"
+#include "DownloadContext.h"
+#include "PieceStorage.h"
+#include "DiskAdaptor.h"
+#include "FileEntry.h"
+#include "Request.h"
+#include "SocketCore.h"
+#include "AuthConfigFactory.h"
+#include "Option.h"
+#include "OptionParser.h"
+#include "Command.h"
+#include "File.h"
+#include "SegmentMan.h"
+#include "Segment.h"
+#include "TimerA2.h"
+#include "wallclock.h"
+#include "prefs.h"
+#include "util.h"
+#include "fmt.h"
+#include "TestUtil.h"
+
+namespace aria2 {
+
+class Http2SessionTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(Http2SessionTest);
+  CPPUNIT_TEST(testCreateHttp2RequestHeaders);
+  CPPUNIT_TEST(testCreateHttp2RequestHeaders_te);
+  CPPUNIT_TEST(testStreamBuffer);
+  CPPUNIT_TEST(testDownload);
+  CPPUNIT_TEST(testDownload_contentEncoding);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void testCreateHttp2RequestHeaders();
+  void testCreateHttp2RequestHeaders_te();
+  void testStreamBuffer();
+  void testDownload();
+  void testDownload_contentEncoding();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(Http2SessionTest);
+
+void Http2SessionTest::testCreateHttp2RequestHeaders()
+{
+  std::string request = "GET /dir/file?q=1 HTTP/1.1\r\n"
+                        "User-Agent: aria2\r\n"
+                        "Accept: */*\r\n"
+                        "Host: example.org:8443\r\n"
+                        "Pragma: no-cache\r\n"
+                        "Connection: close\r\n"
+                        "Keep-Alive: timeout=5\r\n"
+                        "Range: bytes=100-199\r\n"
+                        "\r\n";
+  auto nva = createHttp2RequestHeaders(request, "https");
+  CPPUNIT_ASSERT_EQUAL((size_t)8, nva.size());
+  CPPUNIT_ASSERT_EQUAL(std::string(":method"), nva[0].first);
+  CPPUNIT_ASSERT_EQUAL(std::string("GET"), nva[0].second);
+  CPPUNIT_ASSERT_EQUAL(std::string(":scheme"), nva[1].first);
+  CPPUNIT_ASSERT_EQUAL(std::string("https"), nva[1].second);
+  CPPUNIT_ASSERT_EQUAL(std::string(":authority"), nva[2].first);
+  CPPUNIT_ASSERT_EQUAL(std::string("example.org:8443"), nva[2].second);
+  CPPUNIT_ASSERT_EQUAL(std::string(":path"), nva[3].first);
+  CPPUNIT_ASSERT_EQUAL(std::string("/dir/file?q=1"), nva[3].second);
+  CPPUNIT_ASSERT_EQUAL(std::string("user-agent"), nva[4].first);
+  CPPUNIT_ASSERT_EQUAL(std::string("aria2"), nva[4].second);
+  CPPUNIT_ASSERT_EQUAL(std::string("accept"), nva[5].first);
+  CPPUNIT_ASSERT_EQUAL(std::string("*/*"), nva[5].second);
+  CPPUNIT_ASSERT_EQUAL(std::string("pragma"), nva[6].first);
+  CPPUNIT_ASSERT_EQUAL(std::string("range"), nva[7].first);
+  CPPUNIT_ASSERT_EQUAL(std::string("bytes=100-199"), nva[7].second);
+
+  CPPUNIT_ASSERT(createHttp2RequestHeaders("", "https").empty());
+}
+
+void Http2SessionTest::testCreateHttp2RequestHeaders_te()
+{
+  auto nva = createHttp2RequestHeaders("GET / HTTP/1.1\r\n"
+                                       "TE: gzip\r\n"
+                                       "Host: example.org\r\n"
+                                       "\r\n",
+                                       "https");
+  CPPUNIT_ASSERT_EQUAL((size_t)4, nva.size());
+  CPPUNIT_ASSERT_EQUAL(std::string("/"), nva[3].second);
+
+  nva = createHttp2RequestHeaders("GET / HTTP/1.1\r\n"
+                                  "TE: trailers\r\n"
+                                  "\r\n",
+                                  "https");
+  CPPUNIT_ASSERT_EQUAL((size_t)5, nva.size());
+  CPPUNIT_ASSERT_EQUAL(std::string("te"), nva[4].first);
+  CPPUNIT_ASSERT_EQUAL(std::string("trailers"), nva[4].second);
+}
+
+void Http2SessionTest::testStreamBuffer()
+{
+  Http2Stream stream(nullptr);
+  CPPUNIT_ASSERT(stream.bufferEmpty());
+  CPPUNIT_ASSERT(!stream.closed());
+  stream.append(reinterpret_cast<const unsigned char*>("0123456789"), 10);
+  CPPUNIT_ASSERT_EQUAL((size_t)10, stream.getBufferLength());
+  stream.drain(3);
+  CPPUNIT_ASSERT_EQUAL((size_t)7, stream.getBufferLength());
+  CPPUNIT_ASSERT_EQUAL(std::string("3456789"),
+                       std::string(stream.getBuffer(),
+                                   stream.getBuffer() +
+                                       stream.getBufferLength()));
+  stream.drain(4);
+  stream.append(reinterpret_cast<const unsigned char*>("ab"), 2);
+  CPPUNIT_ASSERT_EQUAL(std::string("789ab"),
+                       std::string(stream.getBuffer(),
+                                   stream.getBuffer() +
+                                       stream.getBufferLength()));
+  stream.drain(5);
+  CPPUNIT_ASSERT(stream.bufferEmpty());
+  stream.close(NGHTTP2_CANCEL);
+  CPPUNIT_ASSERT(stream.closed());
+  CPPUNIT_ASSERT_EQUAL((uint32_t)NGHTTP2_CANCEL, stream.getErrorCode());
+}
+
+namespace {
+// The request received by Http2TestServerCommand.
+struct Http2TestRequest {
+  std::string path;
+  std::string range;
+  bool acceptEncoding;
+  Http2TestRequest() : acceptEncoding(false) {}
+};
+} // namespace
+
+namespace {
+// Server side of an HTTP/2 connection driven by DownloadEngine.  It
+// answers the request with the requested range of body and finishes
+// when the stream is closed.
+class Http2TestServerCommand : public Command {
+public:
+  Http2TestServerCommand(DownloadEngine* e, std::shared_ptr<SocketCore> socket,
+                         const std::string& body,
+                         const std::string& contentEncoding,
+                         Http2TestRequest* request)
+      : Command(e->newCUID()),
+        e_(e),
+        socket_(std::move(socket)),
+        session_(nullptr),
+        body_(body),
+        contentEncoding_(contentEncoding),
+        request_(request),
+        bodyPos_(0),
+        bodyEnd_(0),
+        closed_(false)
+  {
+    setStatusRealtime();
+    nghttp2_session_callbacks* callbacks;
+    nghttp2_session_callbacks_new(&callbacks);
+    nghttp2_session_callbacks_set_on_header_callback(callbacks,
+                                                     onHeaderCallback);
+    nghttp2_session_callbacks_set_on_frame_recv_callback(callbacks,
+                                                         onFrameRecvCallback);
+    nghttp2_session_callbacks_set_on_stream_close_callback(
+        callbacks, onStreamCloseCallback);
+    nghttp2_session_server_new(&session_, callbacks, this);
+    nghttp2_session_callbacks_del(callbacks);
+    nghttp2_submit_settings(session_, NGHTTP2_FLAG_NONE, nullptr, 0);
+  }
+
+  ~Http2TestServerCommand() { nghttp2_session_del(session_); }
+
+  virtual bool execute() CXX11_OVERRIDE
+  {
+    std::array<unsigned char, 16_k> buf;
+    for (;;) {
+      size_t len = buf.size();
+      socket_->readData(buf.data(), len);
+      if (len == 0) {
+        break;
+      }
+      CPPUNIT_ASSERT(nghttp2_session_mem_recv(session_, buf.data(), len) >= 0);
+    }
+    for (;;) {
+      const uint8_t* data;
+      auto n = nghttp2_session_mem_send(session_, &data);
+      CPPUNIT_ASSERT(n >= 0);
+      if (n == 0) {
+        break;
+      }
+      CPPUNIT_ASSERT_EQUAL(static_cast<ssize_t>(n),
+                           socket_->writeData(data, n));
+    }
+    if (closed_) {
+      return true;
+    }
+    if (start_.difference(global::wallclock()) >= 10_s) {
+      CPPUNIT_FAIL("HTTP/2 exchange timed out");
+    }
+    e_->setNoWait(true);
+    e_->addCommand(std::unique_ptr<Command>(this));
+    return false;
+  }
+
+private:
+  static int onHeaderCallback(nghttp2_session* session,
+                              const nghttp2_frame* frame, const uint8_t* name,
+                              size_t namelen, const uint8_t* value,
+                              size_t valuelen, uint8_t flags, void* userData)
+  {
+    auto request = static_cast<Http2TestServerCommand*>(userData)->request_;
+    auto hdName = reinterpret_cast<const char*>(name);
+    std::string hdValue(reinterpret_cast<const char*>(value), valuelen);
+    if (strcmp(hdName, ":path") == 0) {
+      request->path = hdValue;
+    }
+    else if (strcmp(hdName, "range") == 0) {
+      request->range = hdValue;
+    }
+    else if (strcmp(hdName, "accept-encoding") == 0) {
+      request->acceptEncoding = true;
+    }
+    return 0;
+  }
+
+  static int onFrameRecvCallback(nghttp2_session* session,
+                                 const nghttp2_frame* frame, void* userData)
+  {
+    if (frame->hd.type == NGHTTP2_HEADERS &&
+        (frame->hd.flags & NGHTTP2_FLAG_END_STREAM)) {
+      static_cast<Http2TestServerCommand*>(userData)->respond(
+          frame->hd.stream_id);
+    }
+    return 0;
+  }
+
+  static int onStreamCloseCallback(nghttp2_session* session, int32_t streamId,
+                                   uint32_t errorCode, void* userData)
+  {
+    static_cast<Http2TestServerCommand*>(userData)->closed_ = true;
+    return 0;
+  }
+
+  static ssize_t readCallback(nghttp2_session* session, int32_t streamId,
+                              uint8_t* buf, size_t length, uint32_t* dataFlags,
+                              nghttp2_data_source* source, void* userData)
+  {
+    auto server = static_cast<Http2TestServerCommand*>(userData);
+    auto n = std::min(length, server->bodyEnd_ - server->bodyPos_);
+    memcpy(buf, server->body_.data() + server->bodyPos_, n);
+    server->bodyPos_ += n;
+    if (server->bodyPos_ == server->bodyEnd_) {
+      *dataFlags |= NGHTTP2_DATA_FLAG_EOF;
+    }
+    return n;
+  }
+
+  void respond(int32_t streamId)
+  {
+    // Only "bytes=FIRST-LAST" is supported.
+    auto& range = request_->range;
+    CPPUNIT_ASSERT(util::startsWith(range, "bytes="));
+    auto p = util::divide(std::begin(range) + 6, std::end(range), '-');
+    int64_t first, last;
+    CPPUNIT_ASSERT(util::parseLLIntNoThrow(
+        first, std::string(p.first.first, p.first.second)));
+    CPPUNIT_ASSERT(util::parseLLIntNoThrow(
+        last, std::string(p.second.first, p.second.second)));
+    bodyPos_ = first;
+    bodyEnd_ = last + 1;
+    std::vector<std::pair<std::string, std::string>> hds{
+        {":status", "206"},
+        {"content-length", util::uitos(bodyEnd_ - bodyPos_)},
+        {"content-range",
+         fmt("bytes %lu-%lu/%lu", static_cast<unsigned long>(bodyPos_),
+             static_cast<unsigned long>(bodyEnd_ - 1),
+             static_cast<unsigned long>(body_.size()))}};
+    if (!contentEncoding_.empty()) {
+      hds.emplace_back("content-encoding", contentEncoding_);
+    }
+    std::vector<nghttp2_nv> nva;
+    for (auto& hd : hds) {
+      nva.push_back({reinterpret_cast<uint8_t*>(&hd.first[0]),
+                     reinterpret_cast<uint8_t*>(&hd.second[0]),
+                     hd.first.size(), hd.second.size(), NGHTTP2_NV_FLAG_NONE});
+    }
+    nghttp2_data_provider prd;
+    prd.read_callback = readCallback;
+    CPPUNIT_ASSERT_EQUAL(0, nghttp2_submit_response(session_, streamId,
+                                                    nva.data(), nva.size(),
+                                                    &prd));
+  }
+
+  DownloadEngine* e_;
+  std::shared_ptr<SocketCore> socket_;
+  nghttp2_session* session_;
+  std::string body_;
+  std::string contentEncoding_;
+  Http2TestRequest* request_;
+  Timer start_;
+  size_t bodyPos_;
+  size_t bodyEnd_;
+  bool closed_;
+};
+} // namespace
+
+namespace {
+// Downloads the 300 bytes file name, whose first 100 bytes piece is
+// already done, from Http2TestServerCommand over a loopback
+// connection.  The server adds Content-Encoding if contentEncoding is
+// not empty.
+struct Http2DownloadTest {
+  std::shared_ptr<Option> option;
+  std::unique_ptr<DownloadEngine> e;
+  std::shared_ptr<RequestGroup> group;
+  std::string body;
+  std::string path;
+  Http2TestRequest request;
+
+  Http2DownloadTest(const std::string& name,
+                    const std::string& contentEncoding)
+      : option(std::make_shared<Option>()),
+        path(A2_TEST_OUT_DIR "/" + name)
+  {
+    OptionParser::getInstance()->parseDefaultValues(*option);
+    option->put(PREF_DIR, A2_TEST_OUT_DIR);
+    option->put(PREF_HTTP_ACCEPT_GZIP, A2_V_TRUE);
+    option->put(PREF_MAX_TRIES, "1");
+    option->put(PREF_TIMEOUT, "10");
+    e = make_unique<DownloadEngine>(make_unique<SelectEventPoll>());
+    e->setOption(option.get());
+    e->setRequestGroupMan(make_unique<RequestGroupMan>(
+        std::vector<std::shared_ptr<RequestGroup>>{}, 1, option.get()));
+    e->setAuthConfigFactory(make_unique<AuthConfigFactory>());
+
+    for (int i = 0; body.size() < 300; ++i) {
+      body += util::itos(i % 10);
+    }
+    File(path).remove();
+    auto dctx = std::make_shared<DownloadContext>(100, 300, path);
+    group = std::make_shared<RequestGroup>(GroupId::create(), option);
+    group->setDownloadContext(dctx);
+    group->initPieceStorage();
+    group->getPieceStorage()->getDiskAdaptor()->initAndOpenFile();
+    group->getPieceStorage()->markPiecesDone(100);
+
+    SocketCore listener;
+    listener.bind("127.0.0.1", 0, AF_INET);
+    listener.beginListen();
+    auto socket = std::make_shared<SocketCore>();
+    socket->establishConnection("127.0.0.1", listener.getAddrInfo().port);
+    CPPUNIT_ASSERT(listener.isReadable(5));
+    std::shared_ptr<SocketCore> peer = listener.acceptConnection();
+    peer->setNonBlockingMode();
+    CPPUNIT_ASSERT(socket->isWritable(5));
+
+    auto session = std::make_shared<Http2Session>(socket, e.get());
+    session->init();
+    auto req = std::make_shared<Request>();
+    req->setUri("https://localhost/" + name);
+    // The segment is acquired by the command which established the
+    // connection.
+    auto cuid = e->newCUID();
+    CPPUNIT_ASSERT(group->getSegmentMan()->getSegment(cuid, 0));
+    e->addCommand(make_unique<Http2RequestCommand>(
+        cuid, req, dctx->getFirstFileEntry(), group.get(), e.get(), session));
+    e->addCommand(make_unique<Http2TestServerCommand>(
+        e.get(), peer, body, contentEncoding, &request));
+  }
+
+  // Returns the content of the downloaded file.
+  std::string run()
+  {
+    e->run();
+    group->getPieceStorage()->getDiskAdaptor()->closeFile();
+    return readFile(path);
+  }
+};
+} // namespace
+
+void Http2SessionTest::testDownload()
+{
+  Http2DownloadTest test("aria2_Http2SessionTest_testDownload", "");
+  auto data = test.run();
+  CPPUNIT_ASSERT_EQUAL(
+      std::string("/aria2_Http2SessionTest_testDownload"), test.request.path);
+  // The request starts from the first missing piece.
+  CPPUNIT_ASSERT_EQUAL(std::string("bytes=100-299"), test.request.range);
+  // The response body is written as is.
+  CPPUNIT_ASSERT(!test.request.acceptEncoding);
+  CPPUNIT_ASSERT(test.group->downloadFinished());
+  CPPUNIT_ASSERT_EQUAL((size_t)300, data.size());
+  CPPUNIT_ASSERT(std::string(100, '\0') == data.substr(0, 100));
+  CPPUNIT_ASSERT(test.body.substr(100) == data.substr(100));
+}
+
+void Http2SessionTest::testDownload_contentEncoding()
+{
+  Http2DownloadTest test("aria2_Http2SessionTest_testDownload_contentEncoding",
+                         "gzip");
+  auto data = test.run();
+  CPPUNIT_ASSERT_EQUAL(std::string("bytes=100-299"), test.request.range);
+  CPPUNIT_ASSERT(!test.group->downloadFinished());
+  CPPUNIT_ASSERT_EQUAL((int64_t)100, test.group->getCompletedLength());
+  // Nothing is written.
+  CPPUNIT_ASSERT_EQUAL(std::string::npos, data.find_first_not_of('\0'));
+}
+
+} // namespace aria2
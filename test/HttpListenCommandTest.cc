@@ -0,0 +1,104 @@
+#include "HttpListenCommand.h"
+
+#include <unistd.h>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "DownloadEngine.h"
+#include "SelectEventPoll.h"
+#include "SocketCore.h"
+#include "Option.h"
+#include "a2io.h"
+
+namespace aria2 {
+
+class HttpListenCommandTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(HttpListenCommandTest);
+#ifdef HAVE_SYS_UN_H
+  CPPUNIT_TEST(testBindPath);
+  CPPUNIT_TEST(testBindPath_stale);
+  CPPUNIT_TEST(testBindPath_replaced);
+#endif // HAVE_SYS_UN_H
+  CPPUNIT_TEST_SUITE_END();
+
+  std::unique_ptr<Option> option_;
+  std::unique_ptr<DownloadEngine> e_;
+  std::string path_;
+
+public:
+  void setUp()
+  {
+    option_ = make_unique<Option>();
+    e_ = make_unique<DownloadEngine>(make_unique<SelectEventPoll>());
+    e_->setOption(option_.get());
+    path_ = A2_TEST_OUT_DIR "/aria2_HttpListenCommandTest.sock";
+    unlink(path_.c_str());
+  }
+
+  void tearDown() { unlink(path_.c_str()); }
+
+#ifdef HAVE_SYS_UN_H
+  void testBindPath();
+  void testBindPath_stale();
+  void testBindPath_replaced();
+#endif // HAVE_SYS_UN_H
+
+private:
+  std::unique_ptr<HttpListenCommand> createCommand()
+  {
+    return make_unique<HttpListenCommand>(e_->newCUID(), e_.get(), AF_UNIX,
+                                          false);
+  }
+
+  bool exists()
+  {
+    a2_struct_stat fstat;
+    return a2stat(path_.c_str(), &fstat) == 0;
+  }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(HttpListenCommandTest);
+
+#ifdef HAVE_SYS_UN_H
+void HttpListenCommandTest::testBindPath()
+{
+  auto command = createCommand();
+  CPPUNIT_ASSERT(command->bindPath(path_));
+  // Someone is listening on the socket, so it must not be replaced.
+  auto other = createCommand();
+  CPPUNIT_ASSERT(!other->bindPath(path_));
+  other.reset();
+  CPPUNIT_ASSERT(exists());
+
+  command.reset();
+  CPPUNIT_ASSERT(!exists());
+}
+
+void HttpListenCommandTest::testBindPath_stale()
+{
+  {
+    // Bound, but not listening, like the socket left by a process
+    // which has gone.
+    SocketCore socket;
+    socket.bindUnix(path_);
+  }
+  CPPUNIT_ASSERT(exists());
+  auto command = createCommand();
+  CPPUNIT_ASSERT(command->bindPath(path_));
+}
+
+void HttpListenCommandTest::testBindPath_replaced()
+{
+  auto command = createCommand();
+  CPPUNIT_ASSERT(command->bindPath(path_));
+  unlink(path_.c_str());
+  SocketCore socket;
+  socket.bindUnix(path_);
+  // The socket at path_ is not ours anymore.
+  command.reset();
+  CPPUNIT_ASSERT(exists());
+}
+#endif // HAVE_SYS_UN_H
+
+} // namespace aria2
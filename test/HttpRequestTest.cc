@@ -32,6 +32,7 @@ class HttpRequestTest : public CppUnit::TestFixture {
   CPPUNIT_TEST(testCreateRequest_head);
   CPPUNIT_TEST(testCreateRequest_ipv6LiteralAddr);
   CPPUNIT_TEST(testCreateRequest_endOffsetOverride);
+  CPPUNIT_TEST(testCreateRequest_multiRange);
   CPPUNIT_TEST(testCreateRequest_wantDigest);
   CPPUNIT_TEST(testCreateProxyRequest);
   CPPUNIT_TEST(testIsRangeSatisfied);
@@ -63,6 +64,7 @@ public:
   void testCreateRequest_head();
   void testCreateRequest_ipv6LiteralAddr();
   void testCreateRequest_endOffsetOverride();
+  void testCreateRequest_multiRange();
   void testCreateRequest_wantDigest();
   void testCreateProxyRequest();
   void testIsRangeSatisfied();
@@ -594,6 +596,55 @@ void HttpRequestTest::testCreateRequest_endOffsetOverride()
   CPPUNIT_ASSERT_EQUAL(expectedText, httpRequest.createRequest());
 }
 
+void HttpRequestTest::testCreateRequest_multiRange()
+{
+  auto request = std::make_shared<Request>();
+  request->setUri("http://localhost/myfile");
+  HttpRequest httpRequest;
+  httpRequest.disableContentEncoding();
+  httpRequest.setRequest(request);
+  httpRequest.setAuthConfigFactory(authConfigFactory_.get());
+  httpRequest.setOption(option_.get());
+  httpRequest.setNoWantDigest(true);
+  auto fileEntry = std::make_shared<FileEntry>("file", 10_k - 1, 0);
+  httpRequest.setFileEntry(fileEntry);
+  std::vector<std::shared_ptr<Segment>> segments;
+  for (auto index : {9, 3, 2, 6}) {
+    segments.push_back(std::make_shared<PiecedSegment>(
+        1_k, std::make_shared<Piece>(index, 1_k)));
+  }
+  segments[2]->updateWrittenLength(100);
+  httpRequest.setRangeSegments(segments);
+
+  CPPUNIT_ASSERT(httpRequest.isMultiRange());
+  CPPUNIT_ASSERT(segments[2] == httpRequest.getSegment());
+  CPPUNIT_ASSERT_EQUAL((int64_t)2148, httpRequest.getStartByte());
+  // The last segment is truncated by the end of file
+  CPPUNIT_ASSERT_EQUAL((int64_t)10_k - 2, httpRequest.getEndByte());
+  auto ranges = httpRequest.getRanges();
+  CPPUNIT_ASSERT_EQUAL((size_t)3, ranges.size());
+  CPPUNIT_ASSERT(Range(2148, 4_k - 1, 10_k - 1) == ranges[0]);
+  CPPUNIT_ASSERT(Range(6_k, 7_k - 1, 10_k - 1) == ranges[1]);
+  CPPUNIT_ASSERT(Range(9_k, 10_k - 2, 10_k - 1) == ranges[2]);
+
+  std::string expectedText = "GET /myfile HTTP/1.1\r\n"
+                             "User-Agent: aria2\r\n"
+                             "Accept: */*\r\n"
+                             "Host: localhost\r\n"
+                             "Pragma: no-cache\r\n"
+                             "Cache-Control: no-cache\r\n"
+                             "Connection: close\r\n"
+                             "Range: bytes=2148-4095,6144-7167,9216-10238\r\n"
+                             "\r\n";
+  CPPUNIT_ASSERT_EQUAL(expectedText, httpRequest.createRequest());
+
+  // The server may coalesce ranges or return only the first one.
+  CPPUNIT_ASSERT(httpRequest.isRangeSatisfied(Range(2148, 4095, 10_k - 1)));
+  CPPUNIT_ASSERT(httpRequest.isRangeSatisfied(Range(2148, 10238, 10_k - 1)));
+  CPPUNIT_ASSERT(!httpRequest.isRangeSatisfied(Range(2048, 4095, 10_k - 1)));
+  CPPUNIT_ASSERT(!httpRequest.isRangeSatisfied(Range(2148, 10239, 10_k)));
+}
+
 void HttpRequestTest::testCreateRequest_wantDigest()
 {
   auto request = std::make_shared<Request>();
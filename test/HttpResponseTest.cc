@@ -32,6 +32,7 @@ class HttpResponseTest : public CppUnit::TestFixture {
   // CPPUNIT_TEST(testGetContentLength_range);
   CPPUNIT_TEST(testGetEntityLength);
   CPPUNIT_TEST(testGetContentType);
+  CPPUNIT_TEST(testGetByteRangesBoundary);
   CPPUNIT_TEST(testDetermineFilename_without_ContentDisposition);
   CPPUNIT_TEST(testDetermineFilename_with_ContentDisposition_zero_length);
   CPPUNIT_TEST(testDetermineFilename_with_ContentDisposition);
@@ -48,6 +49,7 @@ class HttpResponseTest : public CppUnit::TestFixture {
   CPPUNIT_TEST(testValidateResponse_good_range);
   CPPUNIT_TEST(testValidateResponse_bad_range);
   CPPUNIT_TEST(testValidateResponse_chunked);
+  CPPUNIT_TEST(testValidateResponse_byteRanges);
   CPPUNIT_TEST(testValidateResponse_withIfModifiedSince);
   CPPUNIT_TEST(testProcessRedirect);
   CPPUNIT_TEST(testRetrieveCookie);
@@ -64,6 +66,7 @@ public:
   void testGetContentLength_contentLength();
   void testGetEntityLength();
   void testGetContentType();
+  void testGetByteRangesBoundary();
   void testDetermineFilename_without_ContentDisposition();
   void testDetermineFilename_with_ContentDisposition_zero_length();
   void testDetermineFilename_with_ContentDisposition();
@@ -80,6 +83,7 @@ public:
   void testValidateResponse_good_range();
   void testValidateResponse_bad_range();
   void testValidateResponse_chunked();
+  void testValidateResponse_byteRanges();
   void testValidateResponse_withIfModifiedSince();
   void testProcessRedirect();
   void testRetrieveCookie();
@@ -136,6 +140,29 @@ void HttpResponseTest::testGetContentType()
                        httpResponse.getContentType());
 }
 
+void HttpResponseTest::testGetByteRangesBoundary()
+{
+  HttpResponse httpResponse;
+  auto httpHeader = make_unique<HttpHeader>();
+  httpHeader->put(HttpHeader::CONTENT_TYPE,
+                  "multipart/byteranges; boundary=THIS_STRING_SEPARATES");
+  httpResponse.setHttpHeader(std::move(httpHeader));
+  CPPUNIT_ASSERT_EQUAL(std::string("THIS_STRING_SEPARATES"),
+                       httpResponse.getByteRangesBoundary());
+
+  httpResponse.getHttpHeader()->clearField();
+  httpResponse.getHttpHeader()->put(HttpHeader::CONTENT_TYPE,
+                                    "Multipart/ByteRanges;charset=x;"
+                                    "Boundary=\"a b\"");
+  CPPUNIT_ASSERT_EQUAL(std::string("a b"),
+                       httpResponse.getByteRangesBoundary());
+
+  httpResponse.getHttpHeader()->clearField();
+  httpResponse.getHttpHeader()->put(HttpHeader::CONTENT_TYPE,
+                                    "text/plain; boundary=abc");
+  CPPUNIT_ASSERT_EQUAL(std::string(), httpResponse.getByteRangesBoundary());
+}
+
 void HttpResponseTest::testDetermineFilename_without_ContentDisposition()
 {
   HttpResponse httpResponse;
@@ -374,6 +401,47 @@ void HttpResponseTest::testValidateResponse()
   }
 }
 
+void HttpResponseTest::testValidateResponse_byteRanges()
+{
+  HttpResponse httpResponse;
+
+  httpResponse.setHttpHeader(make_unique<HttpHeader>());
+
+  auto httpRequest = make_unique<HttpRequest>();
+  auto fileEntry = std::make_shared<FileEntry>("file", 10_m, 0);
+  httpRequest->setFileEntry(fileEntry);
+  httpRequest->setRangeSegments(
+      {std::make_shared<PiecedSegment>(1_m, std::make_shared<Piece>(1, 1_m)),
+       std::make_shared<PiecedSegment>(1_m, std::make_shared<Piece>(5, 1_m))});
+  auto request = std::make_shared<Request>();
+  request->setUri("http://localhost/archives/aria2-1.0.0.tar.bz2");
+  httpRequest->setRequest(request);
+  httpResponse.setHttpRequest(std::move(httpRequest));
+  httpResponse.getHttpHeader()->setStatusCode(206);
+  httpResponse.getHttpHeader()->put(HttpHeader::CONTENT_TYPE,
+                                    "multipart/byteranges; boundary=abc");
+  httpResponse.getHttpHeader()->put(HttpHeader::CONTENT_LENGTH, "2097400");
+  // Content-Range is checked in each part.
+  httpResponse.validateResponse();
+
+  // Single range response to multiple range request
+  httpResponse.setHttpHeader(make_unique<HttpHeader>());
+  httpResponse.getHttpHeader()->setStatusCode(206);
+  httpResponse.getHttpHeader()->put(HttpHeader::CONTENT_RANGE,
+                                    "bytes 1048576-2097151/10485760");
+  httpResponse.validateResponse();
+
+  httpResponse.getHttpHeader()->clearField();
+  httpResponse.getHttpHeader()->put(HttpHeader::CONTENT_RANGE,
+                                    "bytes 1048576-7340032/10485760");
+  try {
+    httpResponse.validateResponse();
+    CPPUNIT_FAIL("exception must be thrown.");
+  }
+  catch (Exception& e) {
+  }
+}
+
 void HttpResponseTest::testValidateResponse_good_range()
 {
   HttpResponse httpResponse;
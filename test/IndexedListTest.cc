@@ -22,6 +22,7 @@ class IndexedListTest : public CppUnit::TestFixture {
   CPPUNIT_TEST(testPopFront);
   CPPUNIT_TEST(testMove);
   CPPUNIT_TEST(testGet);
+  CPPUNIT_TEST(testFind);
   CPPUNIT_TEST(testInsert);
   CPPUNIT_TEST(testInsert_keyFunc);
   CPPUNIT_TEST(testIterator);
@@ -38,6 +39,7 @@ public:
   void testPopFront();
   void testMove();
   void testGet();
+  void testFind();
   void testInsert();
   void testInsert_keyFunc();
   void testIterator();
@@ -233,6 +235,19 @@ void IndexedListTest::testGet()
   CPPUNIT_ASSERT_EQUAL(&a, list.get(123));
 }
 
+void IndexedListTest::testFind()
+{
+  IndexedList<int, int*> list;
+  int a = 1000;
+  int b = 1;
+  list.push_back(123, &a);
+  list.push_back(1, &b);
+  const auto& clist = list;
+  CPPUNIT_ASSERT(clist.end() == clist.find(1000));
+  CPPUNIT_ASSERT(clist.begin() + 1 == clist.find(1));
+  CPPUNIT_ASSERT_EQUAL(&b, *clist.find(1));
+}
+
 namespace {
 struct KeyFunc {
   int n;
@@ -0,0 +1,117 @@
+#include "InlineChecksumValidator.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "TestUtil.h"
+#include "DownloadContext.h"
+#include "DefaultPieceStorage.h"
+#include "Option.h"
+#include "DiskAdaptor.h"
+#include "IteratableChecksumValidator.h"
+#include "MessageDigest.h"
+
+namespace aria2 {
+
+class InlineChecksumValidatorTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(InlineChecksumValidatorTest);
+  CPPUNIT_TEST(testUpdate);
+  CPPUNIT_TEST(testUpdate_fail);
+  CPPUNIT_TEST(testCatchUp);
+  CPPUNIT_TEST(testPopMessageDigest);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  Option option_;
+  std::shared_ptr<DownloadContext> dctx_;
+  std::shared_ptr<DefaultPieceStorage> ps_;
+  std::string data_;
+
+public:
+  void setUp()
+  {
+    dctx_ = std::make_shared<DownloadContext>(
+        100, 250, A2_TEST_DIR "/chunkChecksumTestFile250.txt");
+    dctx_->setDigest("sha-1",
+                     fromHex("898a81b8e0181280ae2ee1b81e269196d91e869a"));
+    ps_ = std::make_shared<DefaultPieceStorage>(dctx_, &option_);
+    ps_->initStorage();
+    ps_->getDiskAdaptor()->enableReadOnly();
+    ps_->getDiskAdaptor()->openFile();
+    data_ = readFile(A2_TEST_DIR "/chunkChecksumTestFile250.txt");
+  }
+
+  void testUpdate();
+  void testUpdate_fail();
+  void testCatchUp();
+  void testPopMessageDigest();
+
+  const unsigned char* data(size_t offset) const
+  {
+    return reinterpret_cast<const unsigned char*>(data_.data()) + offset;
+  }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(InlineChecksumValidatorTest);
+
+void InlineChecksumValidatorTest::testUpdate()
+{
+  InlineChecksumValidator validator(dctx_, ps_);
+  validator.update(data(0), 60, 0);
+  CPPUNIT_ASSERT_EQUAL((int64_t)60, validator.getOffset());
+  // Not contiguous; ignored.
+  validator.update(data(200), 50, 200);
+  CPPUNIT_ASSERT_EQUAL((int64_t)60, validator.getOffset());
+  // Overlaps the hashed range; only the new part is hashed.
+  validator.update(data(40), 60, 40);
+  CPPUNIT_ASSERT_EQUAL((int64_t)100, validator.getOffset());
+  validator.update(data(100), 150, 100);
+  CPPUNIT_ASSERT(validator.finished());
+  CPPUNIT_ASSERT(!dctx_->isChecksumVerificationNeeded());
+}
+
+void InlineChecksumValidatorTest::testUpdate_fail()
+{
+  dctx_->setDigest("sha-1", fromHex(std::string(40, '0')));
+  InlineChecksumValidator validator(dctx_, ps_);
+  validator.update(data(0), 250, 0);
+  CPPUNIT_ASSERT(validator.finished());
+  CPPUNIT_ASSERT(dctx_->isChecksumVerificationNeeded());
+}
+
+void InlineChecksumValidatorTest::testCatchUp()
+{
+  InlineChecksumValidator validator(dctx_, ps_);
+  validator.update(data(0), 50, 0);
+  ps_->markPiecesDone(250);
+  ps_->markPieceMissing(1);
+  validator.catchUp(1000);
+  // Stops at the missing piece.
+  CPPUNIT_ASSERT_EQUAL((int64_t)100, validator.getOffset());
+  ps_->markPiecesDone(250);
+  validator.catchUp(80);
+  CPPUNIT_ASSERT_EQUAL((int64_t)180, validator.getOffset());
+  CPPUNIT_ASSERT(!validator.finished());
+  validator.catchUp(1000);
+  CPPUNIT_ASSERT(validator.finished());
+  CPPUNIT_ASSERT(!dctx_->isChecksumVerificationNeeded());
+}
+
+void InlineChecksumValidatorTest::testPopMessageDigest()
+{
+  InlineChecksumValidator validator(dctx_, ps_);
+  validator.update(data(0), 120, 0);
+
+  IteratableChecksumValidator iv(dctx_, ps_);
+  iv.init();
+  iv.resume(validator.popMessageDigest(), validator.getOffset());
+  CPPUNIT_ASSERT(validator.finished());
+  CPPUNIT_ASSERT_EQUAL((int64_t)120, iv.getCurrentOffset());
+  while (!iv.finished()) {
+    iv.validateChunk();
+  }
+  CPPUNIT_ASSERT(ps_->downloadFinished());
+  CPPUNIT_ASSERT(!dctx_->isChecksumVerificationNeeded());
+}
+
+} // namespace aria2
@@ -9,6 +9,7 @@
 #include "DiskAdaptor.h"
 #include "FileEntry.h"
 #include "PieceSelector.h"
+#include "BitfieldMan.h"
 
 namespace aria2 {
 
@@ -17,6 +18,7 @@ class IteratableChunkChecksumValidatorTest : public CppUnit::TestFixture {
   CPPUNIT_TEST_SUITE(IteratableChunkChecksumValidatorTest);
   CPPUNIT_TEST(testValidate);
   CPPUNIT_TEST(testValidate_readError);
+  CPPUNIT_TEST(testValidate_unchangedPieces);
   CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -27,6 +29,7 @@ public:
 
   void testValidate();
   void testValidate_readError();
+  void testValidate_unchangedPieces();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(IteratableChunkChecksumValidatorTest);
@@ -106,4 +109,36 @@ void IteratableChunkChecksumValidatorTest::testValidate_readError()
   CPPUNIT_ASSERT(!ps->hasPiece(4));
 }
 
+void IteratableChunkChecksumValidatorTest::testValidate_unchangedPieces()
+{
+  Option option;
+  std::shared_ptr<DownloadContext> dctx(new DownloadContext(
+      100, 250, A2_TEST_DIR "/chunkChecksumTestFile250.txt"));
+  std::deque<std::string> badHashes(&csArray[0], &csArray[3]);
+  badHashes[0] = fromHex("ffffffffffffffffffffffffffffffffffffffff");
+  badHashes[1] = fromHex("ffffffffffffffffffffffffffffffffffffffff");
+  dctx->setPieceHashes("sha-1", badHashes.begin(), badHashes.end());
+  std::shared_ptr<DefaultPieceStorage> ps(
+      new DefaultPieceStorage(dctx, &option));
+  ps->initStorage();
+  ps->getDiskAdaptor()->enableReadOnly();
+  ps->getDiskAdaptor()->openFile();
+  ps->completePiece(ps->getPiece(0));
+
+  // Piece #0 and #1 are not hashed, and keep their state.
+  BitfieldMan unchangedPieces(100, 250);
+  unchangedPieces.setBit(0);
+  unchangedPieces.setBit(1);
+
+  IteratableChunkChecksumValidator validator(dctx, ps);
+  validator.init();
+  validator.setUnchangedPieces(unchangedPieces);
+
+  validator.validateChunk();
+  CPPUNIT_ASSERT(validator.finished());
+  CPPUNIT_ASSERT(ps->hasPiece(0));
+  CPPUNIT_ASSERT(!ps->hasPiece(1));
+  CPPUNIT_ASSERT(ps->hasPiece(2));
+}
+
 } // namespace aria2
@@ -14,12 +14,14 @@ class JsonTest : public CppUnit::TestFixture {
   CPPUNIT_TEST_SUITE(JsonTest);
   CPPUNIT_TEST(testEncode);
   CPPUNIT_TEST(testDecodeGetParams);
+  CPPUNIT_TEST(testJsonWriter);
   CPPUNIT_TEST_SUITE_END();
 
 private:
 public:
   void testEncode();
   void testDecodeGetParams();
+  void testJsonWriter();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(JsonTest);
@@ -105,4 +107,29 @@ void JsonTest::testDecodeGetParams()
   }
 }
 
+void JsonTest::testJsonWriter()
+{
+  std::string out;
+  json::JsonWriter w(out);
+  w.beginArray();
+  w.beginObject();
+  w.put("name", "aria\"2");
+  auto files = List::g();
+  files->append(String::g("aria2c"));
+  files->append(Integer::g(1));
+  w.put("files", std::move(files));
+  w.key("empty");
+  w.beginObject();
+  w.endObject();
+  w.endObject();
+  w.value("x");
+  w.beginArray();
+  w.endArray();
+  w.endArray();
+  CPPUNIT_ASSERT_EQUAL(std::string("[{\"name\":\"aria\\\"2\","
+                                   "\"files\":[\"aria2c\",1],"
+                                   "\"empty\":{}},\"x\",[]]"),
+                       out);
+}
+
 } // namespace aria2
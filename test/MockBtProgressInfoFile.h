@@ -26,6 +26,11 @@ public:
   virtual void removeFile() CXX11_OVERRIDE {}
 
   virtual void updateFilename() CXX11_OVERRIDE {}
+
+  virtual const BitfieldMan* getUnchangedPieces() CXX11_OVERRIDE
+  {
+    return nullptr;
+  }
 };
 
 } // namespace aria2
@@ -0,0 +1,155 @@
+#include "msgpack.h"
+
+#include <limits>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "RecoverableException.h"
+
+namespace aria2 {
+
+class MsgpackTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(MsgpackTest);
+  CPPUNIT_TEST(testEncode);
+  CPPUNIT_TEST(testDecode);
+  CPPUNIT_TEST(testDecode_error);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void testEncode();
+  void testDecode();
+  void testDecode_error();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(MsgpackTest);
+
+namespace {
+std::unique_ptr<ValueBase> decode(const std::string& s)
+{
+  return msgpack::decode(reinterpret_cast<const unsigned char*>(s.data()),
+                         s.size());
+}
+} // namespace
+
+void MsgpackTest::testEncode()
+{
+  {
+    auto dict = Dict::g();
+    dict->put("a", Integer::g(1));
+    dict->put("b", "xyz");
+    auto list = List::g();
+    list->append(Bool::gTrue());
+    list->append(Null::g());
+    dict->put("c", std::move(list));
+    CPPUNIT_ASSERT_EQUAL(std::string("\x83\xa1" "a\x01\xa1" "b\xa3" "xyz"
+                                     "\xa1" "c\x92\xc3\xc0"),
+                         msgpack::encode(dict.get()));
+  }
+  {
+    auto list = List::g();
+    list->append(Integer::g(-1));
+    list->append(Integer::g(-33));
+    list->append(Integer::g(200));
+    list->append(Integer::g(70000));
+    list->append(Integer::g(1LL << 40));
+    CPPUNIT_ASSERT_EQUAL(std::string("\x95\xff\xd0\xdf\xcc\xc8"
+                                     "\xce\x00\x01\x11\x70"
+                                     "\xd3\x00\x00\x01\x00\x00\x00\x00\x00",
+                                     20),
+                         msgpack::encode(list.get()));
+  }
+  {
+    std::string out;
+    msgpack::Packer packer(out);
+    packer.packBin(std::string(300, 'a'));
+    CPPUNIT_ASSERT_EQUAL(std::string("\xc5\x01\x2c"), out.substr(0, 3));
+    CPPUNIT_ASSERT_EQUAL((size_t)303, out.size());
+  }
+}
+
+void MsgpackTest::testDecode()
+{
+  {
+    auto dict = Dict::g();
+    dict->put("method", "aria2.tellStatus");
+    auto params = List::g();
+    params->append(Integer::g(-100000));
+    params->append(Integer::g(1LL << 50));
+    params->append(std::string(40, 'x'));
+    dict->put("params", std::move(params));
+    auto vlb = decode(msgpack::encode(dict.get()));
+    auto res = downcast<Dict>(vlb);
+    CPPUNIT_ASSERT(res);
+    CPPUNIT_ASSERT_EQUAL(std::string("aria2.tellStatus"),
+                         downcast<String>(res->get("method"))->s());
+    auto resParams = downcast<List>(res->get("params"));
+    CPPUNIT_ASSERT_EQUAL((size_t)3, resParams->size());
+    CPPUNIT_ASSERT_EQUAL((Integer::ValueType)-100000,
+                         downcast<Integer>(resParams->get(0))->i());
+    CPPUNIT_ASSERT_EQUAL((Integer::ValueType)(1LL << 50),
+                         downcast<Integer>(resParams->get(1))->i());
+    CPPUNIT_ASSERT_EQUAL(std::string(40, 'x'),
+                         downcast<String>(resParams->get(2))->s());
+  }
+  {
+    // uint 64 is an integer
+    auto vlb = decode(std::string("\xcf\x20\x89\xb0\x5e\xcc\xa3\xd8\x29", 9));
+    CPPUNIT_ASSERT_EQUAL((Integer::ValueType)0x2089b05ecca3d829LL,
+                         downcast<Integer>(vlb)->i());
+  }
+  {
+    auto vlb = decode(std::string("\xcf\x7f\xff\xff\xff\xff\xff\xff\xff", 9));
+    CPPUNIT_ASSERT_EQUAL(std::numeric_limits<Integer::ValueType>::max(),
+                         downcast<Integer>(vlb)->i());
+  }
+  {
+    // uint 64 which does not fit in int64_t is a GID
+    auto vlb = decode(std::string("\xcf\xd2\x89\xb0\x5e\xcc\xa3\xd8\x29", 9));
+    CPPUNIT_ASSERT_EQUAL(std::string("d289b05ecca3d829"),
+                         downcast<String>(vlb)->s());
+  }
+  {
+    // bin is decoded as String
+    auto vlb = decode(std::string("\xc4\x02\x00\xff", 4));
+    CPPUNIT_ASSERT_EQUAL(std::string("\x00\xff", 2),
+                         downcast<String>(vlb)->s());
+  }
+  {
+    // float 64 1.5
+    auto vlb =
+        decode(std::string("\xcb\x3f\xf8\x00\x00\x00\x00\x00\x00", 9));
+    CPPUNIT_ASSERT_EQUAL((Integer::ValueType)1,
+                         downcast<Integer>(vlb)->i());
+  }
+}
+
+void MsgpackTest::testDecode_error()
+{
+  std::vector<std::string> inputs{
+      // truncated str
+      "\xa3xy",
+      // truncated map
+      "\x81\xa1" "a",
+      // non-string map key
+      std::string("\x81\x01\x02"),
+      // trailing data
+      std::string("\x01\x02"),
+      // ext is not supported
+      std::string("\xd4\x01\x00", 3),
+      // array claiming more elements than bytes
+      std::string("\xdd\xff\xff\xff\xff"),
+      // too deep
+      std::string(100, '\x91') + '\xc0',
+  };
+  for (auto& s : inputs) {
+    try {
+      decode(s);
+      CPPUNIT_FAIL("exception must be thrown");
+    }
+    catch (RecoverableException& e) {
+    }
+  }
+}
+
+} // namespace aria2
@@ -19,6 +19,8 @@ class OptionTest : public CppUnit::TestFixture {
   CPPUNIT_TEST(testMerge);
   CPPUNIT_TEST(testParent);
   CPPUNIT_TEST(testRemove);
+  CPPUNIT_TEST(testAllPrefs);
+  CPPUNIT_TEST(testInternedValue);
   CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -33,6 +35,8 @@ public:
   void testMerge();
   void testParent();
   void testRemove();
+  void testAllPrefs();
+  void testInternedValue();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(OptionTest);
@@ -148,4 +152,49 @@ void OptionTest::testRemove()
   CPPUNIT_ASSERT(parent->defined(PREF_TIMEOUT));
 }
 
+void OptionTest::testAllPrefs()
+{
+  Option op;
+  size_t count = option::countOption();
+  // Insert in the reverse order to shift the values already stored.
+  for (size_t i = count - 1; i > 0; --i) {
+    op.put(option::i2p(i), option::i2p(i)->k);
+  }
+  for (size_t i = 1; i < count; ++i) {
+    CPPUNIT_ASSERT_EQUAL(std::string(option::i2p(i)->k),
+                         op.get(option::i2p(i)));
+  }
+  for (size_t i = 1; i < count; i += 2) {
+    op.removeLocal(option::i2p(i));
+  }
+  for (size_t i = 1; i < count; ++i) {
+    if (i % 2) {
+      CPPUNIT_ASSERT(!op.definedLocal(option::i2p(i)));
+      CPPUNIT_ASSERT_EQUAL(std::string(), op.get(option::i2p(i)));
+    }
+    else {
+      CPPUNIT_ASSERT_EQUAL(std::string(option::i2p(i)->k),
+                           op.get(option::i2p(i)));
+    }
+  }
+  Option copy;
+  copy.merge(op);
+  op.clear();
+  CPPUNIT_ASSERT(!op.defined(option::i2p(2)));
+  CPPUNIT_ASSERT_EQUAL(std::string(option::i2p(2)->k),
+                       copy.get(option::i2p(2)));
+}
+
+void OptionTest::testInternedValue()
+{
+  Option a, b;
+  std::string dir = "/downloads";
+  a.put(PREF_DIR, dir);
+  b.put(PREF_DIR, dir);
+  CPPUNIT_ASSERT(&a.get(PREF_DIR) == &b.get(PREF_DIR));
+  b.put(PREF_DIR, "/tmp");
+  CPPUNIT_ASSERT_EQUAL(dir, a.get(PREF_DIR));
+  CPPUNIT_ASSERT_EQUAL(std::string("/tmp"), b.get(PREF_DIR));
+}
+
 } // namespace aria2
@@ -0,0 +1,131 @@
+#include "RateLimiter.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "wallclock.h"
+
+namespace aria2 {
+
+class RateLimiterTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(RateLimiterTest);
+  CPPUNIT_TEST(testUnlimited);
+  CPPUNIT_TEST(testGetAllowance);
+  CPPUNIT_TEST(testHierarchy);
+  CPPUNIT_TEST(testWeight);
+  CPPUNIT_TEST(testBorrow);
+  CPPUNIT_TEST(testSetParent);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void setUp() { global::wallclock().reset(); }
+
+  void tearDown() { global::wallclock().reset(); }
+
+  void testUnlimited();
+  void testGetAllowance();
+  void testHierarchy();
+  void testWeight();
+  void testBorrow();
+  void testSetParent();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(RateLimiterTest);
+
+void RateLimiterTest::testUnlimited()
+{
+  RateLimiter root;
+  RateLimiter leaf(&root);
+  CPPUNIT_ASSERT(!leaf.limited());
+  CPPUNIT_ASSERT_EQUAL((size_t)1000000, leaf.getAllowance(1000000));
+  leaf.consume(1000000);
+  CPPUNIT_ASSERT_EQUAL((size_t)1000000, leaf.getAllowance(1000000));
+}
+
+void RateLimiterTest::testGetAllowance()
+{
+  RateLimiter limiter(nullptr, 100000);
+  CPPUNIT_ASSERT(limiter.limited());
+  // Starts with full bucket.
+  CPPUNIT_ASSERT_EQUAL((size_t)100000, limiter.getAllowance(1000000));
+  limiter.consume(120000);
+  CPPUNIT_ASSERT(limiter.exhausted());
+  global::wallclock().advance(100_ms);
+  // Still in debt.
+  CPPUNIT_ASSERT_EQUAL((size_t)0, limiter.getAllowance(1000000));
+  global::wallclock().advance(400_ms);
+  CPPUNIT_ASSERT_EQUAL((size_t)30000, limiter.getAllowance(1000000));
+  global::wallclock().advance(10_s);
+  // Capped by burst.
+  CPPUNIT_ASSERT_EQUAL((size_t)100000, limiter.getAllowance(1000000));
+  limiter.setBurst(50000);
+  global::wallclock().advance(1_s);
+  CPPUNIT_ASSERT_EQUAL((size_t)50000, limiter.getAllowance(1000000));
+}
+
+void RateLimiterTest::testHierarchy()
+{
+  RateLimiter root(nullptr, 100000);
+  RateLimiter group(&root, 20000);
+  RateLimiter leaf(&group);
+  CPPUNIT_ASSERT(leaf.limited());
+  // The tighter limit of group wins.
+  CPPUNIT_ASSERT_EQUAL((size_t)20000, leaf.getAllowance(1000000));
+  leaf.consume(20000);
+  CPPUNIT_ASSERT_EQUAL((size_t)0, leaf.getAllowance(1000000));
+  group.setRate(0);
+  // Now only root limits.
+  CPPUNIT_ASSERT_EQUAL((size_t)80000, leaf.getAllowance(1000000));
+}
+
+void RateLimiterTest::testWeight()
+{
+  RateLimiter root(nullptr, 30000);
+  RateLimiter a(&root);
+  RateLimiter b(&root);
+  a.setWeight(2);
+  a.getAllowance(0);
+  b.getAllowance(0);
+  a.consume(30000);
+  global::wallclock().advance(500_ms);
+  a.getAllowance(0);
+  b.getAllowance(0);
+  global::wallclock().advance(500_ms);
+  // 30000 bytes per second are shared at 2:1.
+  CPPUNIT_ASSERT_EQUAL((size_t)20000, a.getAllowance(1000000));
+  CPPUNIT_ASSERT_EQUAL((size_t)10000, b.getAllowance(1000000));
+  a.consume(20000);
+  // a cannot use the share of b.
+  CPPUNIT_ASSERT_EQUAL((size_t)0, a.getAllowance(1000000));
+  CPPUNIT_ASSERT_EQUAL((size_t)10000, b.getAllowance(1000000));
+}
+
+void RateLimiterTest::testBorrow()
+{
+  RateLimiter root(nullptr, 30000);
+  RateLimiter a(&root);
+  RateLimiter b(&root);
+  a.getAllowance(0);
+  b.getAllowance(0);
+  a.consume(30000);
+  global::wallclock().advance(2_s);
+  // b has been idle, so a can use all bandwidth.
+  CPPUNIT_ASSERT_EQUAL((size_t)30000, a.getAllowance(1000000));
+  CPPUNIT_ASSERT_EQUAL((size_t)0, b.getAllowance(1000000));
+}
+
+void RateLimiterTest::testSetParent()
+{
+  RateLimiter leaf;
+  {
+    RateLimiter root(nullptr, 10000);
+    leaf.setParent(&root);
+    CPPUNIT_ASSERT(leaf.limited());
+    CPPUNIT_ASSERT_EQUAL(&root, leaf.getParent());
+  }
+  // Destroying parent detaches its children.
+  CPPUNIT_ASSERT(!leaf.getParent());
+  CPPUNIT_ASSERT(!leaf.limited());
+}
+
+} // namespace aria2
@@ -97,6 +97,18 @@ void RequestGroupManTest::testIsSameFileBeingDownloaded()
   dctx2->getFirstFileEntry()->setPath("aria2.tar.gz");
 
   CPPUNIT_ASSERT(!gm.isSameFileBeingDownloaded(rg1.get()));
+
+  gm.updateFilePathIndex(rg2.get());
+  CPPUNIT_ASSERT(gm.isFilePathBeingDownloaded("aria2.tar.gz", rg1->getGID()));
+  CPPUNIT_ASSERT(!gm.isFilePathBeingDownloaded("aria2.tar.gz", rg2->getGID()));
+
+  dctx2->getFirstFileEntry()->setPath("aria2.tar.bz2");
+  gm.updateFilePathIndex(rg2.get());
+  CPPUNIT_ASSERT(gm.isSameFileBeingDownloaded(rg1.get()));
+  CPPUNIT_ASSERT(!gm.isFilePathBeingDownloaded("aria2.tar.gz", rg1->getGID()));
+
+  gm.removeFilePathIndex(rg2->getGID());
+  CPPUNIT_ASSERT(!gm.isSameFileBeingDownloaded(rg1.get()));
 }
 
 void RequestGroupManTest::testGetInitialCommands()
@@ -238,6 +250,10 @@ void RequestGroupManTest::testFillRequestGroupFromReserver_uriParser()
   itr = rgman_->getReservedGroups().begin();
   CPPUNIT_ASSERT_EQUAL(rgs[0]->getGID(), (*itr)->getGID());
   CPPUNIT_ASSERT_EQUAL((size_t)3, rgman_->getRequestGroups().size());
+  // Started downloads have their DownloadContext created.
+  for (auto& rg : rgman_->getRequestGroups()) {
+    CPPUNIT_ASSERT(!rg->isPending());
+  }
 }
 
 void RequestGroupManTest::testInsertReservedGroup()
@@ -7,6 +7,7 @@
 #include "FileEntry.h"
 #include "PieceStorage.h"
 #include "DownloadResult.h"
+#include "prefs.h"
 
 namespace aria2 {
 
@@ -15,6 +16,7 @@ class RequestGroupTest : public CppUnit::TestFixture {
   CPPUNIT_TEST_SUITE(RequestGroupTest);
   CPPUNIT_TEST(testGetFirstFilePath);
   CPPUNIT_TEST(testCreateDownloadResult);
+  CPPUNIT_TEST(testPendingUris);
   CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -25,6 +27,7 @@ public:
 
   void testGetFirstFilePath();
   void testCreateDownloadResult();
+  void testPendingUris();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(RequestGroupTest);
@@ -91,4 +94,37 @@ void RequestGroupTest::testCreateDownloadResult()
   }
 }
 
+void RequestGroupTest::testPendingUris()
+{
+  option_->put(PREF_DIR, "/tmp");
+  option_->put(PREF_OUT, "myfile");
+  option_->put(PREF_PIECE_LENGTH, "1048576");
+  option_->put(PREF_MAX_CONNECTION_PER_SERVER, "2");
+  RequestGroup group(GroupId::create(), option_);
+  group.setPendingUris({"http://host/file", "http://mirror/file"}, true);
+  CPPUNIT_ASSERT(group.isPending());
+
+  auto result = group.createDownloadResult();
+  CPPUNIT_ASSERT(group.isPending());
+  CPPUNIT_ASSERT_EQUAL((size_t)1, result->fileEntries.size());
+  CPPUNIT_ASSERT_EQUAL(std::string("/tmp/myfile"),
+                       result->fileEntries[0]->getPath());
+  CPPUNIT_ASSERT_EQUAL((size_t)2,
+                       result->fileEntries[0]->getRemainingUris().size());
+  CPPUNIT_ASSERT_EQUAL((int32_t)1_m, result->pieceLength);
+
+  auto ctx = group.peekDownloadContext();
+  CPPUNIT_ASSERT(group.isPending());
+  CPPUNIT_ASSERT(!ctx->getOwnerRequestGroup());
+
+  auto& dctx = group.getDownloadContext();
+  CPPUNIT_ASSERT(!group.isPending());
+  CPPUNIT_ASSERT_EQUAL(&group, dctx->getOwnerRequestGroup());
+  CPPUNIT_ASSERT_EQUAL(std::string("http://host/file"),
+                       dctx->getFirstFileEntry()->getRemainingUris().front());
+  CPPUNIT_ASSERT_EQUAL(
+      2, dctx->getFirstFileEntry()->getMaxConnectionPerServer());
+  CPPUNIT_ASSERT_EQUAL(std::string("/tmp/myfile"), group.getFirstFilePath());
+}
+
 } // namespace aria2
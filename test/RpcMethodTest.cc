@@ -12,6 +12,8 @@
 #include "OptionHandler.h"
 #include "RpcRequest.h"
 #include "RpcResponse.h"
+#include "rpc_helper.h"
+#include "msgpack.h"
 #include "prefs.h"
 #include "TestUtil.h"
 #include "DownloadContext.h"
@@ -41,6 +43,8 @@ class RpcMethodTest : public CppUnit::TestFixture {
   CPPUNIT_TEST(testAddUri_withBadOption);
   CPPUNIT_TEST(testAddUri_withPosition);
   CPPUNIT_TEST(testAddUri_withBadPosition);
+  CPPUNIT_TEST(testAddUris);
+  CPPUNIT_TEST(testAddUris_withBadItem);
 #ifdef ENABLE_BITTORRENT
   CPPUNIT_TEST(testAddTorrent);
   CPPUNIT_TEST(testAddTorrent_withoutTorrent);
@@ -64,6 +68,14 @@ class RpcMethodTest : public CppUnit::TestFixture {
   CPPUNIT_TEST(testTellStatus_withoutGid);
   CPPUNIT_TEST(testTellWaiting);
   CPPUNIT_TEST(testTellWaiting_fail);
+  CPPUNIT_TEST(testTellWaiting_cursor);
+  CPPUNIT_TEST(testTellWaiting_json);
+  CPPUNIT_TEST(testTellStopped_archive);
+  CPPUNIT_TEST(testTellStatus_json);
+  CPPUNIT_TEST(testTellStatus_msgpack);
+#ifdef ENABLE_WEBSOCKET
+  CPPUNIT_TEST(testSubscribe_withoutWebSocket);
+#endif // ENABLE_WEBSOCKET
   CPPUNIT_TEST(testGetVersion);
   CPPUNIT_TEST(testNoSuchMethod);
   CPPUNIT_TEST(testGatherStoppedDownload);
@@ -107,6 +119,8 @@ public:
   void testAddUri_withBadOption();
   void testAddUri_withPosition();
   void testAddUri_withBadPosition();
+  void testAddUris();
+  void testAddUris_withBadItem();
 #ifdef ENABLE_BITTORRENT
   void testAddTorrent();
   void testAddTorrent_withoutTorrent();
@@ -130,6 +144,14 @@ public:
   void testTellStatus_withoutGid();
   void testTellWaiting();
   void testTellWaiting_fail();
+  void testTellWaiting_cursor();
+  void testTellWaiting_json();
+  void testTellStopped_archive();
+  void testTellStatus_json();
+  void testTellStatus_msgpack();
+#ifdef ENABLE_WEBSOCKET
+  void testSubscribe_withoutWebSocket();
+#endif // ENABLE_WEBSOCKET
   void testGetVersion();
   void testNoSuchMethod();
   void testGatherStoppedDownload();
@@ -316,6 +338,101 @@ void RpcMethodTest::testAddUri_withBadPosition()
   CPPUNIT_ASSERT_EQUAL(1, res.code);
 }
 
+void RpcMethodTest::testAddUris()
+{
+  AddUrisRpcMethod m;
+  auto req1 = createReq(AddUriRpcMethod::getMethodName());
+  auto urisParam = List::g();
+  urisParam->append("http://uri0");
+  req1.params->append(std::move(urisParam));
+  AddUriRpcMethod().execute(std::move(req1), e_.get());
+
+  auto req = createReq(AddUrisRpcMethod::getMethodName());
+  auto itemsParam = List::g();
+  auto item1 = List::g();
+  item1->append("http://uri1");
+  itemsParam->append(std::move(item1));
+  auto item2 = Dict::g();
+  auto uris2 = List::g();
+  uris2->append("http://uri2");
+  item2->put("uris", std::move(uris2));
+  auto opts2 = Dict::g();
+  opts2->put(PREF_DIR->k, "/sink2");
+  item2->put("options", std::move(opts2));
+  itemsParam->append(std::move(item2));
+  req.params->append(std::move(itemsParam));
+  auto opt = Dict::g();
+  opt->put(PREF_DIR->k, "/sink");
+  req.params->append(std::move(opt));
+  req.params->append(Integer::g(0));
+  auto res = m.execute(std::move(req), e_.get());
+  CPPUNIT_ASSERT_EQUAL(0, res.code);
+
+  const List* gids = downcast<List>(res.param);
+  CPPUNIT_ASSERT(gids);
+  CPPUNIT_ASSERT_EQUAL((size_t)2, gids->size());
+  auto rgman = e_->getRequestGroupMan().get();
+  CPPUNIT_ASSERT_EQUAL((size_t)3, rgman->getReservedGroups().size());
+  const char* expectedUris[] = {"http://uri1", "http://uri2", "http://uri0"};
+  for (size_t i = 0; i < 3; ++i) {
+    CPPUNIT_ASSERT_EQUAL(std::string(expectedUris[i]),
+                         getReservedGroup(rgman, i)
+                             ->getDownloadContext()
+                             ->getFirstFileEntry()
+                             ->getRemainingUris()[0]);
+  }
+  for (size_t i = 0; i < 2; ++i) {
+    CPPUNIT_ASSERT_EQUAL(GroupId::toHex(getReservedGroup(rgman, i)->getGID()),
+                         downcast<String>(gids->get(i))->s());
+  }
+  CPPUNIT_ASSERT_EQUAL(std::string("/sink"),
+                       getReservedGroup(rgman, 0)->getOption()->get(PREF_DIR));
+  CPPUNIT_ASSERT_EQUAL(std::string("/sink2"),
+                       getReservedGroup(rgman, 1)->getOption()->get(PREF_DIR));
+}
+
+void RpcMethodTest::testAddUris_withBadItem()
+{
+  AddUrisRpcMethod m;
+  {
+    auto req = createReq(AddUrisRpcMethod::getMethodName());
+    auto itemsParam = List::g();
+    auto item1 = List::g();
+    item1->append("http://uri1");
+    itemsParam->append(std::move(item1));
+    itemsParam->append(List::g());
+    req.params->append(std::move(itemsParam));
+    auto res = m.execute(std::move(req), e_.get());
+    CPPUNIT_ASSERT_EQUAL(1, res.code);
+  }
+  {
+    auto req = createReq(AddUrisRpcMethod::getMethodName());
+    auto itemsParam = List::g();
+    auto item1 = Dict::g();
+    auto uris1 = List::g();
+    uris1->append("http://uri1");
+    item1->put("uris", std::move(uris1));
+    auto opts1 = Dict::g();
+    opts1->put(PREF_FILE_ALLOCATION->k, "badvalue");
+    item1->put("options", std::move(opts1));
+    itemsParam->append(std::move(item1));
+    req.params->append(std::move(itemsParam));
+    auto res = m.execute(std::move(req), e_.get());
+    CPPUNIT_ASSERT_EQUAL(1, res.code);
+  }
+  {
+    auto req = createReq(AddUrisRpcMethod::getMethodName());
+    auto itemsParam = List::g();
+    itemsParam->append("http://uri1");
+    req.params->append(std::move(itemsParam));
+    auto res = m.execute(std::move(req), e_.get());
+    CPPUNIT_ASSERT_EQUAL(1, res.code);
+  }
+  // Nothing is added if any item is invalid.
+  CPPUNIT_ASSERT_EQUAL((size_t)0,
+                       e_->getRequestGroupMan()->getReservedGroups().size());
+}
+
 #ifdef ENABLE_BITTORRENT
 namespace {
 RpcRequest createAddTorrentReq()
@@ -793,6 +910,15 @@ void RpcMethodTest::testTellWaiting()
   CPPUNIT_ASSERT_EQUAL(
       GroupId::toHex(getReservedGroup(rgman.get(), 2)->getGID()),
       getString(downcast<Dict>(resParams->get(1)), "gid"));
+  // Waiting downloads added by URIs are reported without creating
+  // their DownloadContext.
+  CPPUNIT_ASSERT(getReservedGroup(rgman.get(), 1)->isPending());
+  {
+    auto files = downcast<List>(downcast<Dict>(resParams->get(0))->get("files"));
+    auto uris = downcast<List>(downcast<Dict>(files->get(0))->get("uris"));
+    CPPUNIT_ASSERT_EQUAL(std::string("http://2/"),
+                         getString(downcast<Dict>(uris->get(0)), "uri"));
+  }
   // waiting.size() == offset+num
   req = createReq(TellWaitingRpcMethod::getMethodName());
   req.params->append(Integer::g(1));
@@ -891,6 +1017,181 @@ void RpcMethodTest::testTellWaiting_fail()
   CPPUNIT_ASSERT_EQUAL(1, res.code);
 }
 
+void RpcMethodTest::testTellWaiting_cursor()
+{
+  for (int i = 0; i < 4; ++i) {
+    addUri("http://" + util::itos(i) + "/", e_);
+  }
+  auto rgman = e_->getRequestGroupMan().get();
+  TellWaitingRpcMethod m;
+  // Empty cursor starts from the first item
+  auto req = createReq(TellWaitingRpcMethod::getMethodName());
+  req.params->append("");
+  req.params->append(Integer::g(2));
+  auto res = m.execute(std::move(req), e_.get());
+  CPPUNIT_ASSERT_EQUAL(0, res.code);
+  const List* resParams = downcast<List>(res.param);
+  CPPUNIT_ASSERT_EQUAL((size_t)2, resParams->size());
+  auto cursor = getString(downcast<Dict>(resParams->get(1)), "gid");
+  CPPUNIT_ASSERT_EQUAL(GroupId::toHex(getReservedGroup(rgman, 1)->getGID()),
+                       cursor);
+  req = createReq(TellWaitingRpcMethod::getMethodName());
+  req.params->append(cursor);
+  req.params->append(Integer::g(10));
+  res = m.execute(std::move(req), e_.get());
+  CPPUNIT_ASSERT_EQUAL(0, res.code);
+  resParams = downcast<List>(res.param);
+  CPPUNIT_ASSERT_EQUAL((size_t)2, resParams->size());
+  CPPUNIT_ASSERT_EQUAL(GroupId::toHex(getReservedGroup(rgman, 2)->getGID()),
+                       getString(downcast<Dict>(resParams->get(0)), "gid"));
+  CPPUNIT_ASSERT_EQUAL(GroupId::toHex(getReservedGroup(rgman, 3)->getGID()),
+                       getString(downcast<Dict>(resParams->get(1)), "gid"));
+  // Cursor at the last item
+  req = createReq(TellWaitingRpcMethod::getMethodName());
+  req.params->append(GroupId::toHex(getReservedGroup(rgman, 3)->getGID()));
+  req.params->append(Integer::g(10));
+  res = m.execute(std::move(req), e_.get());
+  CPPUNIT_ASSERT_EQUAL(0, res.code);
+  CPPUNIT_ASSERT_EQUAL((size_t)0, downcast<List>(res.param)->size());
+  // Invalid cursor
+  req = createReq(TellWaitingRpcMethod::getMethodName());
+  req.params->append("foo");
+  req.params->append(Integer::g(10));
+  res = m.execute(std::move(req), e_.get());
+  CPPUNIT_ASSERT_EQUAL(1, res.code);
+  // Cursor which is not in the list
+  req = createReq(TellWaitingRpcMethod::getMethodName());
+  req.params->append("0123456789abcdef");
+  req.params->append(Integer::g(10));
+  res = m.execute(std::move(req), e_.get());
+  CPPUNIT_ASSERT_EQUAL(1, res.code);
+}
+
+void RpcMethodTest::testTellWaiting_json()
+{
+  for (int i = 0; i < 3; ++i) {
+    addUri("http://" + util::itos(i) + "/", e_);
+  }
+  auto rgman = e_->getRequestGroupMan().get();
+  TellWaitingRpcMethod m;
+  auto req = createReq(TellWaitingRpcMethod::getMethodName());
+  req.params->append(Integer::g(-1));
+  req.params->append(Integer::g(2));
+  auto keys = List::g();
+  keys->append("gid");
+  req.params->append(std::move(keys));
+  req.jsonStream = true;
+  auto res = m.execute(std::move(req), e_.get());
+  CPPUNIT_ASSERT_EQUAL(0, res.code);
+  CPPUNIT_ASSERT(!res.param);
+  CPPUNIT_ASSERT_EQUAL(
+      "[{\"gid\":\"" +
+          GroupId::toHex(getReservedGroup(rgman, 2)->getGID()) +
+          "\"},{\"gid\":\"" +
+          GroupId::toHex(getReservedGroup(rgman, 1)->getGID()) + "\"}]",
+      res.json);
+}
+
+void RpcMethodTest::testTellStatus_json()
+{
+  addUri("http://localhost/", e_);
+  auto group = getReservedGroup(e_->getRequestGroupMan().get(), 0);
+  TellStatusRpcMethod m;
+  auto req = createReq(TellStatusRpcMethod::getMethodName());
+  req.params->append(GroupId::toHex(group->getGID()));
+  auto keys = List::g();
+  keys->append("gid");
+  keys->append("status");
+  keys->append("totalLength");
+  req.params->append(std::move(keys));
+  req.jsonStream = true;
+  auto res = m.execute(std::move(req), e_.get());
+  CPPUNIT_ASSERT_EQUAL(0, res.code);
+  CPPUNIT_ASSERT_EQUAL("{\"status\":\"waiting\",\"gid\":\"" +
+                           GroupId::toHex(group->getGID()) +
+                           "\",\"totalLength\":\"0\"}",
+                       res.json);
+  // Errors are still reported through param
+  req = createReq(TellStatusRpcMethod::getMethodName());
+  req.params->append("0123456789abcdef");
+  req.jsonStream = true;
+  res = m.execute(std::move(req), e_.get());
+  CPPUNIT_ASSERT_EQUAL(1, res.code);
+  CPPUNIT_ASSERT(res.param);
+}
+
+namespace {
+// Processes MessagePack-RPC request calling |methodName| with
+// |params|, which is an encoded array.
+RpcResponse processMsgpack(const std::string& methodName,
+                           const std::string& params, DownloadEngine* e)
+{
+  std::string data;
+  msgpack::Packer packer(data);
+  packer.packMapHeader(3);
+  packer.packStr("id");
+  packer.packInt(1);
+  packer.packStr("method");
+  packer.packStr(methodName);
+  packer.packStr("params");
+  data += params;
+  auto req = msgpack::decode(
+      reinterpret_cast<const unsigned char*>(data.data()), data.size());
+  return processMsgpackRpcRequest(downcast<Dict>(req), e);
+}
+} // namespace
+
+void RpcMethodTest::testTellStatus_msgpack()
+{
+  // The latter does not fit in int64_t.
+  for (a2_gid_t gid : {0x2089b05ecca3d829ULL, 0xd289b05ecca3d829ULL}) {
+    auto group = std::make_shared<RequestGroup>(GroupId::import(gid), option_);
+    group->setDownloadContext(
+        std::make_shared<DownloadContext>(0, 0, "aria2.tar.bz2"));
+    e_->getRequestGroupMan()->addReservedGroup(group);
+    std::string encodedGid;
+    msgpack::Packer(encodedGid).packUint64(gid);
+
+    std::string params;
+    msgpack::Packer packer(params);
+    packer.packArrayHeader(2);
+    packer.packStr(GroupId::toHex(gid));
+    packer.packArrayHeader(1);
+    packer.packStr("gid");
+    auto res = processMsgpack("aria2.tellStatus", params, e_.get());
+    CPPUNIT_ASSERT_EQUAL(0, res.code);
+    auto data = toMsgpack(res);
+    // The result {"gid": GID} comes last.
+    auto resultGid = data.substr(data.size() - encodedGid.size());
+    CPPUNIT_ASSERT_EQUAL("\x81\xa3gid" + encodedGid,
+                         data.substr(data.size() - 5 - encodedGid.size()));
+
+    // The client sends back the GID as it is.
+    res = processMsgpack("aria2.remove", "\x91" + resultGid, e_.get());
+    CPPUNIT_ASSERT_EQUAL(0, res.code);
+    data = toMsgpack(res);
+    CPPUNIT_ASSERT_EQUAL("\xa6result" + encodedGid,
+                         data.substr(data.size() - 7 - encodedGid.size()));
+    CPPUNIT_ASSERT(!e_->getRequestGroupMan()->findGroup(gid));
+  }
+}
+
+#ifdef ENABLE_WEBSOCKET
+void RpcMethodTest::testSubscribe_withoutWebSocket()
+{
+  SubscribeRpcMethod m;
+  auto req = createReq(SubscribeRpcMethod::getMethodName());
+  req.params->append(List::g());
+  auto res = m.execute(std::move(req), e_.get());
+  CPPUNIT_ASSERT_EQUAL(1, res.code);
+  UnsubscribeRpcMethod um;
+  req = createReq(UnsubscribeRpcMethod::getMethodName());
+  req.params->append("1");
+  res = um.execute(std::move(req), e_.get());
+  CPPUNIT_ASSERT_EQUAL(1, res.code);
+}
+#endif // ENABLE_WEBSOCKET
+
 void RpcMethodTest::testGetVersion()
 {
   GetVersionRpcMethod m;
@@ -910,6 +1211,76 @@ void RpcMethodTest::testGetVersion()
   CPPUNIT_ASSERT_EQUAL(featureSummary() + ", ", features);
 }
 
+void RpcMethodTest::testTellStopped_archive()
+{
+  option_->put(PREF_MAX_DOWNLOAD_RESULT, "2");
+  option_->put(PREF_DOWNLOAD_RESULT_ARCHIVE,
+               A2_TEST_OUT_DIR "/aria2_RpcMethodTest_archive");
+  e_->setRequestGroupMan(make_unique<RequestGroupMan>(
+      std::vector<std::shared_ptr<RequestGroup>>{}, 1, option_.get()));
+  auto rgman = e_->getRequestGroupMan().get();
+  std::vector<std::string> gids;
+  for (int i = 0; i < 5; ++i) {
+    auto dr = createDownloadResult(error_code::FINISHED,
+                                   "http://" + util::itos(i) + "/");
+    gids.push_back(dr->gid->toHex());
+    rgman->addDownloadResult(dr);
+  }
+  CPPUNIT_ASSERT_EQUAL((size_t)2, rgman->getDownloadResults().size());
+  CPPUNIT_ASSERT_EQUAL((size_t)5, rgman->countDownloadResult());
+
+  TellStoppedRpcMethod m;
+  auto req = createReq(TellStoppedRpcMethod::getMethodName());
+  req.params->append(Integer::g(1));
+  req.params->append(Integer::g(3));
+  auto res = m.execute(std::move(req), e_.get());
+  CPPUNIT_ASSERT_EQUAL(0, res.code);
+  const List* resParams = downcast<List>(res.param);
+  CPPUNIT_ASSERT_EQUAL((size_t)3, resParams->size());
+  for (size_t i = 0; i < 3; ++i) {
+    CPPUNIT_ASSERT_EQUAL(gids[i + 1],
+                         getString(downcast<Dict>(resParams->get(i)), "gid"));
+  }
+  // Negative offset returns from the most recent one.
+  req = createReq(TellStoppedRpcMethod::getMethodName());
+  req.params->append(Integer::g(-1));
+  req.params->append(Integer::g(4));
+  res = m.execute(std::move(req), e_.get());
+  CPPUNIT_ASSERT_EQUAL(0, res.code);
+  resParams = downcast<List>(res.param);
+  CPPUNIT_ASSERT_EQUAL((size_t)4, resParams->size());
+  CPPUNIT_ASSERT_EQUAL(gids[4],
+                       getString(downcast<Dict>(resParams->get(0)), "gid"));
+  CPPUNIT_ASSERT_EQUAL(gids[1],
+                       getString(downcast<Dict>(resParams->get(3)), "gid"));
+  // Cursor in the archive
+  req = createReq(TellStoppedRpcMethod::getMethodName());
+  req.params->append(gids[1]);
+  req.params->append(Integer::g(10));
+  res = m.execute(std::move(req), e_.get());
+  CPPUNIT_ASSERT_EQUAL(0, res.code);
+  resParams = downcast<List>(res.param);
+  CPPUNIT_ASSERT_EQUAL((size_t)3, resParams->size());
+  CPPUNIT_ASSERT_EQUAL(gids[2],
+                       getString(downcast<Dict>(resParams->get(0)), "gid"));
+
+  // tellStatus finds the archived download.
+  TellStatusRpcMethod st;
+  req = createReq(TellStatusRpcMethod::getMethodName());
+  req.params->append(gids[0]);
+  res = st.execute(std::move(req), e_.get());
+  CPPUNIT_ASSERT_EQUAL(0, res.code);
+  CPPUNIT_ASSERT_EQUAL(std::string("complete"),
+                       getString(downcast<Dict>(res.param), "status"));
+
+  a2_gid_t gid;
+  CPPUNIT_ASSERT_EQUAL(0, GroupId::toNumericId(gid, gids[0].c_str()));
+  CPPUNIT_ASSERT(rgman->removeDownloadResult(gid));
+  CPPUNIT_ASSERT_EQUAL((size_t)4, rgman->countDownloadResult());
+  rgman->purgeDownloadResult();
+  CPPUNIT_ASSERT_EQUAL((size_t)0, rgman->countDownloadResult());
+}
+
 void RpcMethodTest::testGatherStoppedDownload()
 {
   std::vector<std::shared_ptr<FileEntry>> fileEntries;
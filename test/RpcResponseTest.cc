@@ -9,6 +9,7 @@ namespace rpc {
 class RpcResponseTest : public CppUnit::TestFixture {
   CPPUNIT_TEST_SUITE(RpcResponseTest);
   CPPUNIT_TEST(testToJson);
+  CPPUNIT_TEST(testToMsgpack);
 #ifdef ENABLE_XML_RPC
   CPPUNIT_TEST(testToXml);
 #endif // ENABLE_XML_RPC
@@ -16,6 +17,7 @@ class RpcResponseTest : public CppUnit::TestFixture {
 
 public:
   void testToJson();
+  void testToMsgpack();
 #ifdef ENABLE_XML_RPC
   void testToXml();
 #endif // ENABLE_XML_RPC
@@ -67,6 +69,16 @@ void RpcResponseTest::testToJson()
                                      "})"),
                          s);
   }
+  {
+    // result already encoded in JSON
+    RpcResponse res(0, RpcResponse::AUTHORIZED, std::string("[{\"a\":\"1\"}]"),
+                    Integer::g(7));
+    std::string s = toJson(res, "", false);
+    CPPUNIT_ASSERT_EQUAL(std::string("{\"id\":7,"
+                                     "\"jsonrpc\":\"2.0\","
+                                     "\"result\":[{\"a\":\"1\"}]}"),
+                         s);
+  }
   {
     // batch response
     std::string s = toJsonBatch(results, "", false);
@@ -97,6 +109,29 @@ void RpcResponseTest::testToJson()
   }
 }
 
+void RpcResponseTest::testToMsgpack()
+{
+  auto param = Dict::g();
+  param->put("bitfield", "80ff");
+  param->put("gid", Gid::g(0x2089b05ecca3d829ULL));
+  // Only Gid is encoded as uint 64.
+  param->put("name", "2089b05ecca3d829");
+  RpcResponse res(0, RpcResponse::AUTHORIZED, std::move(param), Integer::g(9));
+  CPPUNIT_ASSERT_EQUAL(std::string("\x83\xa2id\x09\xa7jsonrpc\xa3" "2.0"
+                                   "\xa6result\x83"
+                                   "\xa8" "bitfield\xc4\x02\x80\xff"
+                                   "\xa3gid\xcf\x20\x89\xb0\x5e\xcc\xa3\xd8\x29"
+                                   "\xa4name\xb0" "2089b05ecca3d829"),
+                       toMsgpack(res));
+  // The result of aria2.addUri
+  RpcResponse gidRes(0, RpcResponse::AUTHORIZED, Gid::g(0x2089b05ecca3d829ULL),
+                     Null::g());
+  CPPUNIT_ASSERT_EQUAL(std::string("\x83\xa2id\xc0\xa7jsonrpc\xa3" "2.0"
+                                   "\xa6result"
+                                   "\xcf\x20\x89\xb0\x5e\xcc\xa3\xd8\x29"),
+                       toMsgpack(gidRes));
+}
+
 #ifdef ENABLE_XML_RPC
 void RpcResponseTest::testToXml()
 {
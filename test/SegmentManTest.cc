@@ -10,6 +10,7 @@
 #include "PieceSelector.h"
 #include "FileEntry.h"
 #include "PeerStat.h"
+#include "wallclock.h"
 
 namespace aria2 {
 
@@ -23,6 +24,7 @@ class SegmentManTest : public CppUnit::TestFixture {
   CPPUNIT_TEST(testCancelAllSegments);
   CPPUNIT_TEST(testGetPeerStat);
   CPPUNIT_TEST(testGetCleanSegmentIfOwnerIsIdle);
+  CPPUNIT_TEST(testStealSegment);
   CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -49,6 +51,7 @@ public:
   void testCancelAllSegments();
   void testGetPeerStat();
   void testGetCleanSegmentIfOwnerIsIdle();
+  void testStealSegment();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(SegmentManTest);
@@ -195,4 +198,43 @@ void SegmentManTest::testGetCleanSegmentIfOwnerIsIdle()
   CPPUNIT_ASSERT(!segmentMan_->getCleanSegmentIfOwnerIsIdle(5, 1));
 }
 
+void SegmentManTest::testStealSegment()
+{
+  global::wallclock().reset();
+  auto seg0 = segmentMan_->getSegmentWithIndex(1, 0);
+  auto seg1 = segmentMan_->getSegmentWithIndex(2, 1);
+  seg1->updateWrittenLength(512_k);
+  std::vector<std::shared_ptr<PeerStat>> peerStats;
+  for (cuid_t cuid = 1; cuid <= 3; ++cuid) {
+    auto ps = std::make_shared<PeerStat>(cuid);
+    ps->downloadStart();
+    segmentMan_->registerPeerStat(ps);
+    peerStats.push_back(ps);
+  }
+  // Owners are still in grace period.
+  peerStats[2]->updateDownload(1_m);
+  global::wallclock().advance(1_s);
+  CPPUNIT_ASSERT(!segmentMan_->stealSegment(3));
+
+  global::wallclock().advance(10_s);
+  peerStats[0]->updateDownload(100_k);
+  peerStats[1]->updateDownload(10_k);
+  peerStats[2]->updateDownload(1_m);
+  global::wallclock().advance(1_s);
+  // No PeerStat for CUID#4
+  CPPUNIT_ASSERT(!segmentMan_->stealSegment(4));
+  // The segment of the slowest connection is stolen.
+  auto seg = segmentMan_->stealSegment(3);
+  CPPUNIT_ASSERT(seg);
+  CPPUNIT_ASSERT_EQUAL((size_t)1, seg->getIndex());
+  CPPUNIT_ASSERT_EQUAL((int64_t)512_k, seg->getWrittenLength());
+  std::vector<std::shared_ptr<Segment>> segments;
+  segmentMan_->getInFlightSegment(segments, 2);
+  CPPUNIT_ASSERT(segments.empty());
+  // CUID#1 is slower than CUID#3
+  CPPUNIT_ASSERT(!segmentMan_->stealSegment(1));
+
+  global::wallclock().reset();
+}
+
 } // namespace aria2
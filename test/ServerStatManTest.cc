@@ -1,6 +1,7 @@
 #include "ServerStatMan.h"
 
 #include <iostream>
+#include <clocale>
 
 #include <cppunit/extensions/HelperMacros.h>
 
@@ -18,6 +19,7 @@ class ServerStatManTest : public CppUnit::TestFixture {
   CPPUNIT_TEST(testAddAndFind);
   CPPUNIT_TEST(testSave);
   CPPUNIT_TEST(testLoad);
+  CPPUNIT_TEST(testSaveAndLoad_failureRateLocale);
   CPPUNIT_TEST(testRemoveStaleServerStat);
   CPPUNIT_TEST_SUITE_END();
 
@@ -29,6 +31,7 @@ public:
   void testAddAndFind();
   void testSave();
   void testLoad();
+  void testSaveAndLoad_failureRateLocale();
   void testRemoveStaleServerStat();
 };
 
@@ -118,7 +121,10 @@ void ServerStatManTest::testLoad()
       "host=localhost, protocol=http, dl_speed=25000, sc_avg_speed=101, "
       "mc_avg_speed=102, last_updated=1210000000, counter=6, status=OK\n"
       "host=mirror, protocol=http, dl_speed=0, last_updated=1210000002, "
-      "status=ERROR\n";
+      "status=ERROR\n"
+      "host=mirror, protocol=ftp, dl_speed=0, last_updated=1210000003, "
+      "status=OK, ewma_speed=50000, conn_time=30, ttfb=120, "
+      "fail_rate=0.25, samples=7, conn_level=4\n";
   BufferedFile fp(filename, BufferedFile::WRITE);
   CPPUNIT_ASSERT_EQUAL((size_t)in.size(), fp.write(in.data(), in.size()));
   CPPUNIT_ASSERT(fp.close() != EOF);
@@ -141,6 +147,49 @@ void ServerStatManTest::testLoad()
   std::shared_ptr<ServerStat> mirror = ssm.find("mirror", "http");
   CPPUNIT_ASSERT(mirror);
   CPPUNIT_ASSERT_EQUAL(ServerStat::A2_ERROR, mirror->getStatus());
+
+  std::shared_ptr<ServerStat> mirror_ftp = ssm.find("mirror", "ftp");
+  CPPUNIT_ASSERT(mirror_ftp);
+  CPPUNIT_ASSERT_EQUAL(50000, mirror_ftp->getEwmaSpeed());
+  CPPUNIT_ASSERT_EQUAL(30, mirror_ftp->getConnectTime());
+  CPPUNIT_ASSERT_EQUAL(120, mirror_ftp->getTimeToFirstByte());
+  CPPUNIT_ASSERT_EQUAL(0.25, mirror_ftp->getFailureRate());
+  CPPUNIT_ASSERT_EQUAL(7, mirror_ftp->getSamples());
+  CPPUNIT_ASSERT_EQUAL(4, mirror_ftp->getConnectionLevel());
+  CPPUNIT_ASSERT_EQUAL(0, localhost_http->getConnectionLevel());
+  CPPUNIT_ASSERT_EQUAL(0, localhost_http->getSamples());
+}
+
+void ServerStatManTest::testSaveAndLoad_failureRateLocale()
+{
+  const char* filename =
+      A2_TEST_OUT_DIR "/aria2_ServerStatManTest_testSaveAndLoad_locale";
+  std::string oldLocale = setlocale(LC_NUMERIC, nullptr);
+  // Use the locale whose decimal separator is comma if available.
+  const char* locales[] = {"de_DE.UTF-8", "de_DE.utf8", "fr_FR.UTF-8",
+                           "fr_FR.utf8"};
+  for (auto locale : locales) {
+    if (setlocale(LC_NUMERIC, locale)) {
+      break;
+    }
+  }
+  auto ss = std::make_shared<ServerStat>("mirror", "http");
+  ss->setEwmaSpeed(50000);
+  ss->setFailureRate(0.125);
+  ss->setSamples(3);
+  ServerStatMan ssm;
+  ssm.add(ss);
+  bool saved = ssm.save(filename);
+  ServerStatMan ssm2;
+  bool loaded = ssm2.load(filename);
+  setlocale(LC_NUMERIC, oldLocale.c_str());
+
+  CPPUNIT_ASSERT(saved);
+  CPPUNIT_ASSERT(loaded);
+  auto mirror = ssm2.find("mirror", "http");
+  CPPUNIT_ASSERT(mirror);
+  CPPUNIT_ASSERT_EQUAL(0.125, mirror->getFailureRate());
+  CPPUNIT_ASSERT_EQUAL(3, mirror->getSamples());
 }
 
 void ServerStatManTest::testRemoveStaleServerStat()
@@ -15,6 +15,7 @@ class ServerStatTest : public CppUnit::TestFixture {
   CPPUNIT_TEST_SUITE(ServerStatTest);
   CPPUNIT_TEST(testSetStatus);
   CPPUNIT_TEST(testToString);
+  CPPUNIT_TEST(testUpdateModel);
   CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -24,6 +25,7 @@ public:
 
   void testSetStatus();
   void testToString();
+  void testUpdateModel();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(ServerStatTest);
@@ -69,6 +71,56 @@ void ServerStatTest::testToString()
                   " sc_avg_speed=0, mc_avg_speed=0,"
                   " last_updated=1210000000, counter=0, status=ERROR"),
       localhost_ftp.toString());
+
+  ServerStat mirror_http("mirror", "http");
+  mirror_http.setLastUpdated(Time(1210000000));
+  mirror_http.setEwmaSpeed(50000);
+  mirror_http.setConnectTime(30);
+  mirror_http.setTimeToFirstByte(120);
+  mirror_http.setFailureRate(0.25);
+  mirror_http.setSamples(7);
+  mirror_http.setConnectionLevel(4);
+
+  CPPUNIT_ASSERT_EQUAL(
+      std::string("host=mirror, protocol=http, dl_speed=0,"
+                  " sc_avg_speed=0, mc_avg_speed=0,"
+                  " last_updated=1210000000, counter=0, status=OK,"
+                  " ewma_speed=50000, conn_time=30, ttfb=120,"
+                  " fail_rate=0.2500, samples=7, conn_level=4"),
+      mirror_http.toString());
+}
+
+void ServerStatTest::testUpdateModel()
+{
+  ServerStat ss("localhost", "http");
+  ss.updateEwmaSpeed(100000);
+  CPPUNIT_ASSERT_EQUAL(100000, ss.getEwmaSpeed());
+  CPPUNIT_ASSERT_EQUAL(1, ss.getSamples());
+  ss.updateEwmaSpeed(200000);
+  CPPUNIT_ASSERT_EQUAL(130000, ss.getEwmaSpeed());
+  CPPUNIT_ASSERT_EQUAL(2, ss.getSamples());
+  CPPUNIT_ASSERT_EQUAL(0.0, ss.getFailureRate());
+
+  // setError() alone does not feed the model.
+  ss.setError();
+  CPPUNIT_ASSERT(ss.isError());
+  CPPUNIT_ASSERT_EQUAL(2, ss.getSamples());
+  CPPUNIT_ASSERT_EQUAL(0.0, ss.getFailureRate());
+
+  ss.addFailure();
+  CPPUNIT_ASSERT_EQUAL(3, ss.getSamples());
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(0.2, ss.getFailureRate(), 1e-9);
+
+  ss.updateEwmaSpeed(130000);
+  CPPUNIT_ASSERT(ss.isOK());
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(0.16, ss.getFailureRate(), 1e-9);
+
+  ss.updateConnectTime(100);
+  CPPUNIT_ASSERT_EQUAL(100, ss.getConnectTime());
+  ss.updateConnectTime(200);
+  CPPUNIT_ASSERT_EQUAL(130, ss.getConnectTime());
+  ss.updateTimeToFirstByte(0);
+  CPPUNIT_ASSERT_EQUAL(1, ss.getTimeToFirstByte());
 }
 
 } // namespace aria2
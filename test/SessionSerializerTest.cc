@@ -15,6 +15,7 @@
 #include "FileEntry.h"
 #include "SelectEventPoll.h"
 #include "DownloadEngine.h"
+#include "util.h"
 
 namespace aria2 {
 
@@ -23,11 +24,13 @@ class SessionSerializerTest : public CppUnit::TestFixture {
   CPPUNIT_TEST_SUITE(SessionSerializerTest);
   CPPUNIT_TEST(testSave);
   CPPUNIT_TEST(testSaveErrorDownload);
+  CPPUNIT_TEST(testCreateEntries);
   CPPUNIT_TEST_SUITE_END();
 
 public:
   void testSave();
   void testSaveErrorDownload();
+  void testCreateEntries();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(SessionSerializerTest);
@@ -155,4 +158,48 @@ void SessionSerializerTest::testSaveErrorDownload()
   CPPUNIT_ASSERT_EQUAL(std::string("http://error\t"), line);
 }
 
+void SessionSerializerTest::testCreateEntries()
+{
+  std::vector<std::shared_ptr<RequestGroup>> result;
+  std::shared_ptr<Option> option(new Option());
+  option->put(PREF_DIR, "/tmp");
+  option->put(PREF_MAX_DOWNLOAD_RESULT, "10");
+  createRequestGroupForUri(result, option, {"http://host/1"});
+  createRequestGroupForUri(result, option, {"http://host/2"});
+  RequestGroupMan rgman{result, 1, option.get()};
+  auto dr = createDownloadResult(error_code::TIME_OUT, "http://error");
+  rgman.addDownloadResult(dr);
+  SessionSerializer s(&rgman);
+
+  auto entries = s.createEntries();
+  CPPUNIT_ASSERT_EQUAL((size_t)3, entries.size());
+  CPPUNIT_ASSERT_EQUAL(dr->gid->getNumericId(), entries[0]->gid);
+  CPPUNIT_ASSERT_EQUAL(std::string("http://host/2\t\n") +
+                           fmt(" gid=%s\n", GroupId::toHex(
+                                                  result[1]->getGID())
+                                                  .c_str()) +
+                           " dir=/tmp\n",
+                       entries[2]->text);
+
+  // Unchanged downloads reuse their entries.
+  auto next = s.createEntries();
+  CPPUNIT_ASSERT(sameSessionEntries(entries, next));
+  for (size_t i = 0; i < entries.size(); ++i) {
+    CPPUNIT_ASSERT(entries[i] == next[i]);
+  }
+
+  result[1]->setPauseRequested(true);
+  next = s.createEntries();
+  CPPUNIT_ASSERT(!sameSessionEntries(entries, next));
+  CPPUNIT_ASSERT(entries[1] == next[1]);
+  CPPUNIT_ASSERT(util::endsWith(next[2]->text, " pause=true\n"));
+
+  entries = next;
+  result[0]->getOption()->put(PREF_OUT, "out");
+  result[0]->markSessionDirty();
+  next = s.createEntries();
+  CPPUNIT_ASSERT(!sameSessionEntries(entries, next));
+  CPPUNIT_ASSERT(util::endsWith(next[1]->text, " out=out\n"));
+}
+
 } // namespace aria2
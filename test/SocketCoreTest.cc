@@ -1,11 +1,17 @@
 #include "SocketCore.h"
 
 #include <cstring>
+#include <unistd.h>
 #include <iostream>
 #include <cppunit/extensions/HelperMacros.h>
 
 #include "a2functional.h"
 #include "Exception.h"
+#include "util.h"
+#ifdef ENABLE_SSL
+#include "TLSContext.h"
+#include "TLSSession.h"
+#endif // ENABLE_SSL
 
 namespace aria2 {
 
@@ -14,6 +20,13 @@ class SocketCoreTest : public CppUnit::TestFixture {
   CPPUNIT_TEST_SUITE(SocketCoreTest);
   CPPUNIT_TEST(testWriteAndReadDatagram);
   CPPUNIT_TEST(testGetSocketError);
+#ifdef HAVE_SYS_UN_H
+  CPPUNIT_TEST(testBindUnix);
+#endif // HAVE_SYS_UN_H
+#ifdef ENABLE_SSL
+  CPPUNIT_TEST(testTLSLoopback);
+  CPPUNIT_TEST(testTLSLoopback_ktls);
+#endif // ENABLE_SSL
   CPPUNIT_TEST(testInetNtop);
   CPPUNIT_TEST(testInetPton);
   CPPUNIT_TEST(testGetBinAddr);
@@ -23,10 +36,25 @@ class SocketCoreTest : public CppUnit::TestFixture {
 public:
   void setUp() {}
 
-  void tearDown() {}
+  void tearDown()
+  {
+#ifdef ENABLE_SSL
+    SocketCore::setClientTLSContext(nullptr);
+    SocketCore::setServerTLSContext(nullptr);
+#endif // ENABLE_SSL
+  }
 
   void testWriteAndReadDatagram();
   void testGetSocketError();
+#ifdef HAVE_SYS_UN_H
+  void testBindUnix();
+#endif // HAVE_SYS_UN_H
+#ifdef ENABLE_SSL
+  // Returns the kTLS status of the client side.
+  int runTLSLoopback(bool ktls);
+  void testTLSLoopback();
+  void testTLSLoopback_ktls();
+#endif // ENABLE_SSL
   void testInetNtop();
   void testInetPton();
   void testGetBinAddr();
@@ -86,6 +114,168 @@ void SocketCoreTest::testGetSocketError()
   CPPUNIT_ASSERT_EQUAL(std::string(""), s.getSocketError());
 }
 
+#ifdef HAVE_SYS_UN_H
+void SocketCoreTest::testBindUnix()
+{
+  std::string path = A2_TEST_OUT_DIR "/aria2_SocketCoreTest_testBindUnix";
+  unlink(path.c_str());
+  SocketCore s;
+  s.bindUnix(path);
+  s.beginListen();
+  CPPUNIT_ASSERT_EQUAL(AF_UNIX, s.getAddressFamily());
+
+  sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  memcpy(addr.sun_path, path.c_str(), path.size());
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  CPPUNIT_ASSERT(fd != -1);
+  CPPUNIT_ASSERT_EQUAL(
+      0, connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)));
+  auto peer = s.acceptConnection();
+  CPPUNIT_ASSERT_EQUAL((ssize_t)5, write(fd, "hello", 5));
+  char buf[8];
+  size_t len = sizeof(buf);
+  peer->readData(buf, len);
+  CPPUNIT_ASSERT_EQUAL(std::string("hello"), std::string(buf, len));
+  close(fd);
+  unlink(path.c_str());
+
+  // Too long path
+  try {
+    s.bindUnix(std::string(sizeof(addr.sun_path), 'a'));
+    CPPUNIT_FAIL("exception must be thrown.");
+  }
+  catch (Exception& e) {
+    // success
+  }
+}
+#endif // HAVE_SYS_UN_H
+
+#ifdef ENABLE_SSL
+int SocketCoreTest::runTLSLoopback(bool ktls)
+{
+  std::shared_ptr<TLSContext> svctx(
+      TLSContext::make(TLS_SERVER, TLS_PROTO_TLS12));
+  CPPUNIT_ASSERT(svctx->addCredentialFile(A2_TEST_DIR "/tls-server.crt",
+                                          A2_TEST_DIR "/tls-server.key"));
+  svctx->setKTLS(ktls);
+  std::shared_ptr<TLSContext> clctx(
+      TLSContext::make(TLS_CLIENT, TLS_PROTO_TLS12));
+  clctx->setVerifyPeer(false);
+  clctx->setKTLS(ktls);
+  SocketCore::setServerTLSContext(svctx);
+  SocketCore::setClientTLSContext(clctx);
+
+  SocketCore server;
+  server.bind("127.0.0.1", 0, AF_INET);
+  server.beginListen();
+  SocketCore client;
+  client.establishConnection("127.0.0.1", server.getAddrInfo().port);
+  CPPUNIT_ASSERT(server.isReadable(5));
+  auto peer = server.acceptConnection();
+  CPPUNIT_ASSERT(client.isWritable(5));
+
+  bool clientDone = false, serverDone = false;
+  for (int i = 0; i < 1000 && !(clientDone && serverDone); ++i) {
+    if (!clientDone) {
+      clientDone = client.tlsConnect("");
+    }
+    if (!serverDone) {
+      serverDone = peer->tlsAccept();
+    }
+    if (!(clientDone && serverDone)) {
+      client.isReadable(0);
+      peer->isReadable(0);
+      usleep(1000);
+    }
+  }
+  CPPUNIT_ASSERT(clientDone);
+  CPPUNIT_ASSERT(serverDone);
+
+  // Larger than a TLS record to exercise record reassembly
+  std::string data;
+  for (int i = 0; data.size() < 100000; ++i) {
+    data += util::itos(i);
+  }
+  std::string received;
+  size_t written = 0;
+  for (int i = 0; i < 10000 && received.size() < data.size(); ++i) {
+    if (written < data.size()) {
+      auto n = peer->writeData(data.data() + written, data.size() - written);
+      if (n > 0) {
+        written += n;
+      }
+    }
+    char buf[16_k];
+    size_t len = sizeof(buf);
+    client.readData(buf, len);
+    received.append(buf, len);
+    if (len == 0) {
+      client.isReadable(0);
+      usleep(1000);
+    }
+  }
+  CPPUNIT_ASSERT(data == received);
+
+  // The other direction
+  CPPUNIT_ASSERT_EQUAL((ssize_t)5, client.writeData("hello", 5));
+  char buf[8];
+  size_t len = 0;
+  for (int i = 0; i < 1000 && len == 0; ++i) {
+    len = sizeof(buf);
+    peer->readData(buf, len);
+    if (len == 0) {
+      peer->isReadable(0);
+      usleep(1000);
+    }
+  }
+  CPPUNIT_ASSERT_EQUAL(std::string("hello"), std::string(buf, len));
+  return client.getKTLSStatus();
+}
+
+void SocketCoreTest::testTLSLoopback()
+{
+  CPPUNIT_ASSERT_EQUAL(0, runTLSLoopback(false));
+}
+
+namespace {
+// Returns false if the kernel cannot attach the TLS upper layer
+// protocol to a TCP connection.  Returns true if it can or it is not
+// known.
+bool kernelSupportsKTLS()
+{
+#ifdef TCP_ULP
+  SocketCore server;
+  server.bind("127.0.0.1", 0, AF_INET);
+  server.beginListen();
+  SocketCore client;
+  client.establishConnection("127.0.0.1", server.getAddrInfo().port);
+  CPPUNIT_ASSERT(client.isWritable(5));
+  return setsockopt(client.getSockfd(), SOL_TCP, TCP_ULP, "tls",
+                    sizeof("tls")) == 0;
+#else  // !TCP_ULP
+  return true;
+#endif // !TCP_ULP
+}
+} // namespace
+
+void SocketCoreTest::testTLSLoopback_ktls()
+{
+  // Whether kTLS is actually used also depends on the TLS library and
+  // the negotiated cipher.  runTLSLoopback() checks that the data go
+  // through either way.
+  auto ktls = runTLSLoopback(true);
+  if (!kernelSupportsKTLS()) {
+    // Falls back to the TLS library in user space.
+    CPPUNIT_ASSERT_EQUAL(0, ktls);
+  }
+  else {
+    CPPUNIT_ASSERT_EQUAL(0, ktls & ~(TLS_KTLS_RECV | TLS_KTLS_SEND));
+  }
+}
+#endif // ENABLE_SSL
+
 void SocketCoreTest::testInetNtop()
 {
   char dest[NI_MAXHOST];
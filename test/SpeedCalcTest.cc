@@ -2,19 +2,31 @@
 #include <string>
 #include <cppunit/extensions/HelperMacros.h>
 
+#include "wallclock.h"
+
 namespace aria2 {
 
 class SpeedCalcTest : public CppUnit::TestFixture {
 
   CPPUNIT_TEST_SUITE(SpeedCalcTest);
   CPPUNIT_TEST(testUpdate);
+  CPPUNIT_TEST(testCalculateSpeed);
+  CPPUNIT_TEST(testCalculateSpeed_stale);
+  CPPUNIT_TEST(testCalculateInstantSpeed);
+  CPPUNIT_TEST(testCalculateSmoothedSpeed);
   CPPUNIT_TEST_SUITE_END();
 
 private:
 public:
-  void setUp() {}
+  void setUp() { global::wallclock().reset(); }
+
+  void tearDown() { global::wallclock().reset(); }
 
   void testUpdate();
+  void testCalculateSpeed();
+  void testCalculateSpeed_stale();
+  void testCalculateInstantSpeed();
+  void testCalculateSmoothedSpeed();
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(SpeedCalcTest);
@@ -25,4 +37,67 @@ void SpeedCalcTest::testUpdate()
   calc.update(1000);
 }
 
+void SpeedCalcTest::testCalculateSpeed()
+{
+  SpeedCalc calc;
+  calc.reset();
+  CPPUNIT_ASSERT_EQUAL(0, calc.calculateSpeed());
+  calc.update(1000);
+  global::wallclock().advance(500_ms);
+  calc.update(1000);
+  CPPUNIT_ASSERT_EQUAL(4000, calc.calculateSpeed());
+  global::wallclock().advance(1500_ms);
+  CPPUNIT_ASSERT_EQUAL(1000, calc.calculateSpeed());
+  CPPUNIT_ASSERT_EQUAL(4000, calc.getMaxSpeed());
+}
+
+void SpeedCalcTest::testCalculateSpeed_stale()
+{
+  SpeedCalc calc;
+  calc.reset();
+  for (int i = 0; i < 20; ++i) {
+    calc.update(1000);
+    global::wallclock().advance(1_s);
+  }
+  // Only the last 15 slots are in the window; the current one is
+  // still empty.
+  CPPUNIT_ASSERT_EQUAL(1000, calc.calculateSpeed());
+  global::wallclock().advance(15_s);
+  CPPUNIT_ASSERT_EQUAL(0, calc.calculateSpeed());
+  // Far apart updates only expire the slots once.
+  global::wallclock().advance(1000_s);
+  calc.update(500);
+  global::wallclock().advance(500_ms);
+  CPPUNIT_ASSERT_EQUAL(1000, calc.calculateSpeed());
+  CPPUNIT_ASSERT_EQUAL(19, calc.calculateAvgSpeed());
+}
+
+void SpeedCalcTest::testCalculateInstantSpeed()
+{
+  SpeedCalc calc;
+  calc.reset();
+  calc.update(3000);
+  CPPUNIT_ASSERT_EQUAL(0, calc.calculateInstantSpeed());
+  global::wallclock().advance(1_s);
+  CPPUNIT_ASSERT_EQUAL(3000, calc.calculateInstantSpeed());
+  calc.update(5000);
+  global::wallclock().advance(2_s);
+  CPPUNIT_ASSERT_EQUAL(0, calc.calculateInstantSpeed());
+}
+
+void SpeedCalcTest::testCalculateSmoothedSpeed()
+{
+  SpeedCalc calc;
+  calc.reset();
+  for (int i = 0; i < 60; ++i) {
+    calc.update(1000);
+    global::wallclock().advance(1_s);
+  }
+  CPPUNIT_ASSERT_EQUAL(1000, calc.calculateSmoothedSpeed());
+  global::wallclock().advance(1_s);
+  CPPUNIT_ASSERT_EQUAL(700, calc.calculateSmoothedSpeed());
+  global::wallclock().advance(100_s);
+  CPPUNIT_ASSERT_EQUAL(0, calc.calculateSmoothedSpeed());
+}
+
 } // namespace aria2
@@ -0,0 +1,76 @@
+#include "TLSSessionCache.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+namespace aria2 {
+
+class TLSSessionCacheTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(TLSSessionCacheTest);
+  CPPUNIT_TEST(testPutFind);
+  CPPUNIT_TEST(testEvict);
+  CPPUNIT_TEST(testRemove);
+  CPPUNIT_TEST(testCountHandshake);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void testPutFind();
+  void testEvict();
+  void testRemove();
+  void testCountHandshake();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TLSSessionCacheTest);
+
+void TLSSessionCacheTest::testPutFind()
+{
+  TLSSessionCache cache;
+  auto key = makeTLSSessionCacheKey("example.org", 443);
+  CPPUNIT_ASSERT_EQUAL(std::string("example.org:443"), key);
+  CPPUNIT_ASSERT_EQUAL(std::string(""), cache.find(key));
+  cache.put(key, "alpha");
+  CPPUNIT_ASSERT_EQUAL(std::string("alpha"), cache.find(key));
+  cache.put(key, "bravo");
+  CPPUNIT_ASSERT_EQUAL(std::string("bravo"), cache.find(key));
+  CPPUNIT_ASSERT_EQUAL((size_t)1, cache.size());
+  // Empty session is ignored
+  cache.put("example.org:8443", "");
+  CPPUNIT_ASSERT_EQUAL((size_t)1, cache.size());
+}
+
+void TLSSessionCacheTest::testEvict()
+{
+  TLSSessionCache cache(2);
+  cache.put("a:443", "alpha");
+  cache.put("b:443", "bravo");
+  cache.put("c:443", "charlie");
+  CPPUNIT_ASSERT_EQUAL((size_t)2, cache.size());
+  CPPUNIT_ASSERT_EQUAL(std::string(""), cache.find("a:443"));
+  CPPUNIT_ASSERT_EQUAL(std::string("bravo"), cache.find("b:443"));
+  CPPUNIT_ASSERT_EQUAL(std::string("charlie"), cache.find("c:443"));
+}
+
+void TLSSessionCacheTest::testRemove()
+{
+  TLSSessionCache cache(2);
+  cache.put("a:443", "alpha");
+  cache.put("b:443", "bravo");
+  cache.remove("a:443");
+  cache.remove("z:443");
+  CPPUNIT_ASSERT_EQUAL((size_t)1, cache.size());
+  cache.put("c:443", "charlie");
+  CPPUNIT_ASSERT_EQUAL(std::string("bravo"), cache.find("b:443"));
+  CPPUNIT_ASSERT_EQUAL(std::string("charlie"), cache.find("c:443"));
+}
+
+void TLSSessionCacheTest::testCountHandshake()
+{
+  TLSSessionCache cache;
+  cache.countHandshake(false);
+  cache.countHandshake(true);
+  cache.countHandshake(true);
+  CPPUNIT_ASSERT_EQUAL((uint64_t)3, cache.getNumHandshake());
+  CPPUNIT_ASSERT_EQUAL((uint64_t)2, cache.getNumResumed());
+}
+
+} // namespace aria2
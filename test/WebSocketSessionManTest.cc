@@ -0,0 +1,264 @@
+#include "WebSocketSessionMan.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "WebSocketSession.h"
+#include "DownloadEngine.h"
+#include "SelectEventPoll.h"
+#include "Option.h"
+#include "RequestGroupMan.h"
+#include "RequestGroup.h"
+#include "DownloadContext.h"
+#include "ValueBaseJsonParser.h"
+#include "prefs.h"
+#include "util.h"
+
+namespace aria2 {
+
+namespace rpc {
+
+namespace {
+// Records the messages instead of queuing them to the sessions.
+class MockWebSocketSessionMan : public WebSocketSessionMan {
+public:
+  struct Message {
+    WebSocketSessions sessions;
+    std::string msg;
+  };
+
+  std::vector<Message> messages;
+
+private:
+  virtual void sendMessage(const WebSocketSessions& sessions,
+                           const std::string& msg) CXX11_OVERRIDE
+  {
+    messages.push_back(Message{sessions, msg});
+  }
+};
+} // namespace
+
+class WebSocketSessionManTest : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(WebSocketSessionManTest);
+  CPPUNIT_TEST(testPushSubscriptions_changedOnly);
+  CPPUNIT_TEST(testPushSubscriptions_removed);
+  CPPUNIT_TEST(testPushSubscriptions_snapshot);
+  CPPUNIT_TEST(testPushSubscriptions_shared);
+  CPPUNIT_TEST_SUITE_END();
+
+  std::shared_ptr<Option> option_;
+  std::unique_ptr<DownloadEngine> e_;
+  std::vector<std::shared_ptr<RequestGroup>> groups_;
+  MockWebSocketSessionMan man_;
+
+public:
+  void setUp()
+  {
+    option_ = std::make_shared<Option>();
+    option_->put(PREF_DIR, "/tmp");
+    e_ = make_unique<DownloadEngine>(make_unique<SelectEventPoll>());
+    e_->setOption(option_.get());
+    groups_.clear();
+    for (int i = 0; i < 2; ++i) {
+      auto group = std::make_shared<RequestGroup>(GroupId::create(),
+                                                  util::copy(option_));
+      group->setDownloadContext(
+          std::make_shared<DownloadContext>(0, 0, "aria2.tar.bz2"));
+      groups_.push_back(group);
+    }
+    setActive(groups_);
+  }
+
+  void testPushSubscriptions_changedOnly();
+  void testPushSubscriptions_removed();
+  void testPushSubscriptions_snapshot();
+  void testPushSubscriptions_shared();
+
+private:
+  void setActive(const std::vector<std::shared_ptr<RequestGroup>>& groups)
+  {
+    auto rgman = make_unique<RequestGroupMan>(
+        std::vector<std::shared_ptr<RequestGroup>>{}, 1, option_.get());
+    for (auto& group : groups) {
+      rgman->addRequestGroup(group);
+    }
+    e_->setRequestGroupMan(std::move(rgman));
+  }
+
+  std::shared_ptr<WebSocketSession> createSession()
+  {
+    return std::make_shared<WebSocketSession>(nullptr, e_.get());
+  }
+
+  std::string subscribe(const std::shared_ptr<WebSocketSession>& session)
+  {
+    return man_.subscribe(session, {"connections", "dir"},
+                          std::chrono::seconds(0));
+  }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(WebSocketSessionManTest);
+
+namespace {
+// Returns params[0] of the notification msg.
+std::unique_ptr<ValueBase> decodeParams(const std::string& msg)
+{
+  json::ValueBaseJsonParser parser;
+  ssize_t error;
+  auto root = parser.parseFinal(msg.c_str(), msg.size(), error);
+  auto params = downcast<List>(downcast<Dict>(root)->get("params"));
+  CPPUNIT_ASSERT(params);
+  return std::move(*params->begin());
+}
+} // namespace
+
+namespace {
+const List* getList(const ValueBase* params, const std::string& key)
+{
+  return downcast<List>(downcast<Dict>(params)->get(key));
+}
+} // namespace
+
+namespace {
+std::string getString(const ValueBase* dict, const std::string& key)
+{
+  auto s = downcast<String>(downcast<Dict>(dict)->get(key));
+  return s ? s->s() : "";
+}
+} // namespace
+
+void WebSocketSessionManTest::testPushSubscriptions_changedOnly()
+{
+  auto session = createSession();
+  auto id = subscribe(session);
+
+  man_.pushSubscriptions(e_.get());
+  CPPUNIT_ASSERT_EQUAL((size_t)1, man_.messages.size());
+  auto params = decodeParams(man_.messages[0].msg);
+  CPPUNIT_ASSERT_EQUAL(id, getString(params.get(), "subscription"));
+  auto changed = getList(params.get(), "changed");
+  CPPUNIT_ASSERT_EQUAL((size_t)2, changed->size());
+  for (size_t i = 0; i < 2; ++i) {
+    auto entry = changed->get(i);
+    CPPUNIT_ASSERT_EQUAL(GroupId::toHex(groups_[i]->getGID()),
+                         getString(entry, "gid"));
+    CPPUNIT_ASSERT_EQUAL(std::string("0"), getString(entry, "connections"));
+    CPPUNIT_ASSERT_EQUAL(std::string("/tmp"), getString(entry, "dir"));
+  }
+  auto global = downcast<Dict>(downcast<Dict>(params.get())->get("global"));
+  CPPUNIT_ASSERT_EQUAL(std::string("2"), getString(global, "numActive"));
+
+  // Nothing changed, so nothing is sent.
+  man_.pushSubscriptions(e_.get());
+  CPPUNIT_ASSERT_EQUAL((size_t)1, man_.messages.size());
+
+  groups_[1]->increaseStreamConnection();
+  man_.pushSubscriptions(e_.get());
+  CPPUNIT_ASSERT_EQUAL((size_t)2, man_.messages.size());
+  params = decodeParams(man_.messages[1].msg);
+  changed = getList(params.get(), "changed");
+  CPPUNIT_ASSERT_EQUAL((size_t)1, changed->size());
+  auto entry = downcast<Dict>(changed->get(0));
+  CPPUNIT_ASSERT_EQUAL((size_t)2, entry->size());
+  CPPUNIT_ASSERT_EQUAL(GroupId::toHex(groups_[1]->getGID()),
+                       getString(entry, "gid"));
+  CPPUNIT_ASSERT_EQUAL(std::string("1"), getString(entry, "connections"));
+  global = downcast<Dict>(downcast<Dict>(params.get())->get("global"));
+  CPPUNIT_ASSERT(global->empty());
+  CPPUNIT_ASSERT(getList(params.get(), "removed")->empty());
+}
+
+void WebSocketSessionManTest::testPushSubscriptions_removed()
+{
+  auto session = createSession();
+  subscribe(session);
+  man_.pushSubscriptions(e_.get());
+  CPPUNIT_ASSERT_EQUAL((size_t)1, man_.messages.size());
+
+  setActive({groups_[1]});
+  man_.pushSubscriptions(e_.get());
+  CPPUNIT_ASSERT_EQUAL((size_t)2, man_.messages.size());
+  auto params = decodeParams(man_.messages[1].msg);
+  CPPUNIT_ASSERT(getList(params.get(), "changed")->empty());
+  auto removed = getList(params.get(), "removed");
+  CPPUNIT_ASSERT_EQUAL((size_t)1, removed->size());
+  CPPUNIT_ASSERT_EQUAL(GroupId::toHex(groups_[0]->getGID()),
+                       downcast<String>(removed->get(0))->s());
+  auto global = downcast<Dict>(downcast<Dict>(params.get())->get("global"));
+  CPPUNIT_ASSERT_EQUAL(std::string("1"), getString(global, "numActive"));
+
+  // The removed download is reported only once.
+  man_.pushSubscriptions(e_.get());
+  CPPUNIT_ASSERT_EQUAL((size_t)2, man_.messages.size());
+}
+
+void WebSocketSessionManTest::testPushSubscriptions_snapshot()
+{
+  auto session1 = createSession();
+  auto id = subscribe(session1);
+  man_.pushSubscriptions(e_.get());
+  groups_[0]->increaseStreamConnection();
+  man_.pushSubscriptions(e_.get());
+  CPPUNIT_ASSERT_EQUAL((size_t)2, man_.messages.size());
+
+  auto session2 = createSession();
+  CPPUNIT_ASSERT_EQUAL(id, subscribe(session2));
+  // session2 gets the complete state seen by session1 so far.  Nothing
+  // changed since the last push, so session1 gets nothing.
+  man_.pushSubscriptions(e_.get());
+  CPPUNIT_ASSERT_EQUAL((size_t)3, man_.messages.size());
+  auto& snapshot = man_.messages[2];
+  CPPUNIT_ASSERT_EQUAL((size_t)1, snapshot.sessions.size());
+  CPPUNIT_ASSERT(session2 == *snapshot.sessions.begin());
+  auto params = decodeParams(snapshot.msg);
+  CPPUNIT_ASSERT_EQUAL(id, getString(params.get(), "subscription"));
+  auto changed = getList(params.get(), "changed");
+  CPPUNIT_ASSERT_EQUAL((size_t)2, changed->size());
+  for (size_t i = 0; i < 2; ++i) {
+    auto entry = changed->get(i);
+    auto gid = getString(entry, "gid");
+    CPPUNIT_ASSERT_EQUAL(std::string("/tmp"), getString(entry, "dir"));
+    CPPUNIT_ASSERT_EQUAL(
+        std::string(gid == GroupId::toHex(groups_[0]->getGID()) ? "1" : "0"),
+        getString(entry, "connections"));
+  }
+  auto global = downcast<Dict>(downcast<Dict>(params.get())->get("global"));
+  CPPUNIT_ASSERT_EQUAL(std::string("2"), getString(global, "numActive"));
+
+  // The snapshot is sent once.
+  man_.pushSubscriptions(e_.get());
+  CPPUNIT_ASSERT_EQUAL((size_t)3, man_.messages.size());
+}
+
+void WebSocketSessionManTest::testPushSubscriptions_shared()
+{
+  auto session1 = createSession();
+  auto session2 = createSession();
+  auto session3 = createSession();
+  auto id = subscribe(session1);
+  CPPUNIT_ASSERT_EQUAL(id, subscribe(session2));
+  // Different keys or interval make another subscription.
+  auto otherId =
+      man_.subscribe(session3, {"connections"}, std::chrono::seconds(0));
+  CPPUNIT_ASSERT(id != otherId);
+  CPPUNIT_ASSERT(id != man_.subscribe(session3, {"connections", "dir"},
+                                      std::chrono::seconds(1)));
+
+  man_.pushSubscriptions(e_.get());
+  // One message for each subscription
+  CPPUNIT_ASSERT_EQUAL((size_t)3, man_.messages.size());
+  auto& shared = man_.messages[0];
+  CPPUNIT_ASSERT_EQUAL((size_t)2, shared.sessions.size());
+  CPPUNIT_ASSERT(shared.sessions.count(session1));
+  CPPUNIT_ASSERT(shared.sessions.count(session2));
+  auto params = decodeParams(shared.msg);
+  CPPUNIT_ASSERT_EQUAL(id, getString(params.get(), "subscription"));
+  params = decodeParams(man_.messages[1].msg);
+  CPPUNIT_ASSERT_EQUAL(otherId, getString(params.get(), "subscription"));
+  auto entry = downcast<Dict>(getList(params.get(), "changed")->get(0));
+  CPPUNIT_ASSERT(!entry->containsKey("dir"));
+}
+
+} // namespace rpc
+
+} // namespace aria2
@@ -66,6 +66,30 @@ void WrDiskCacheEntryTest::testAppend()
   CPPUNIT_ASSERT_EQUAL((size_t)6, e.getSize());
 
   CPPUNIT_ASSERT_EQUAL((size_t)0, e.append(7, (const unsigned char*)"FOO", 3));
+
+  auto buf = e.getAppendBuffer(6);
+  CPPUNIT_ASSERT_EQUAL((size_t)0, buf.second);
+
+  WrDiskCacheEntry e2(adaptor_);
+  cell = new WrDiskCacheEntry::DataCell{};
+  cell->goff = 0;
+  cell->data = new unsigned char[offset + capacity];
+  memcpy(cell->data, "??foo", 5);
+  cell->offset = offset;
+  cell->len = 3;
+  cell->capacity = capacity;
+  e2.cacheData(cell);
+  buf = e2.getAppendBuffer(3);
+  CPPUNIT_ASSERT(cell->data + offset + 3 == buf.first);
+  CPPUNIT_ASSERT_EQUAL((size_t)3, buf.second);
+  memcpy(buf.first, "bar", 3);
+  e2.commitAppend(3);
+  CPPUNIT_ASSERT_EQUAL((size_t)6, cell->len);
+  CPPUNIT_ASSERT_EQUAL((size_t)6, e2.getSize());
+  CPPUNIT_ASSERT_EQUAL(std::string("foobar"),
+                       std::string(cell->data + offset, cell->data + 8));
+  CPPUNIT_ASSERT_EQUAL((size_t)0, e2.getAppendBuffer(6).second);
+  CPPUNIT_ASSERT_EQUAL((size_t)0, e2.getAppendBuffer(4).second);
 }
 
 void WrDiskCacheEntryTest::testClear()